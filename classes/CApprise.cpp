@@ -76,11 +76,16 @@ namespace Antik::File
                 m_watchDepth = watchDepth;
                 if (watchDepth != -1)
                 {
-                    m_watchDepth += std::count(watchFolder.begin(), watchFolder.end(), '/');
+                    m_watchDepth += std::count(m_watchFolder.begin(), m_watchFolder.end(), '/');
                 }
             }
+            // Create metrics (including those of notifier)
+            m_metrics = std::make_shared<CMetrics>();
+            m_eventsDelivered = &m_metrics->counter("events_delivered");
+            m_eventDeliveryLatency = &m_metrics->histogram("event_delivery_latency_us");
+            m_metrics->addSource("notifier", m_fileEventNotifier->getMetrics());
             // Set watch depth for notifier
-            m_fileEventNotifier->setWatchDepth(watchDepth);
+            m_fileEventNotifier->setWatchDepth(m_watchDepth);
             // Add non empty watch folder
             if (!m_watchFolder.empty())
             {
@@ -127,6 +132,13 @@ namespace Antik::File
         }
     }
     //
+    // Return watcher metrics.
+    //
+    std::shared_ptr<CMetrics> CApprise::getMetrics(void)
+    {
+        return (m_metrics);
+    }
+    //
     // Add watch (file or directory)
     //
     void CApprise::addWatch(const std::string &filePath)
@@ -162,6 +174,30 @@ namespace Antik::File
         try
         {
             m_fileEventNotifier->getNextEvent(evt);
+            if (evt.id != IApprise::Event_none)
+            {
+                m_eventsDelivered->add();
+                m_eventDeliveryLatency->record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - evt.time).count());
+            }
+        }
+        catch (const std::exception &e)
+        {
+            throw Exception(e.what());
+        }
+    }
+    //
+    // Get next event from notifier; waiting at most timeout for one (Event_none on timeout).
+    //
+    void CApprise::getNextEvent(CApprise::Event &evt, std::chrono::milliseconds timeout)
+    {
+        try
+        {
+            m_fileEventNotifier->getNextEvent(evt, timeout);
+            if (evt.id != IApprise::Event_none)
+            {
+                m_eventsDelivered->add();
+                m_eventDeliveryLatency->record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - evt.time).count());
+            }
         }
         catch (const std::exception &e)
         {
@@ -187,14 +223,15 @@ namespace Antik::File
         }
     }
     //
-    // Stop watching for file events
+    // Stop watching for file events (may be called more than once and from more than one thread).
     //
     void CApprise::stopWatching(void)
     {
         try
         {
             m_fileEventNotifier->stopEventGeneration();
-            if (m_watcherThread)
+            std::unique_lock<std::mutex> locker(m_watcherThreadMutex);
+            if (m_watcherThread && m_watcherThread->joinable())
             {
                 m_watcherThread->join();
             }
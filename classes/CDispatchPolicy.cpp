@@ -0,0 +1,167 @@
+//
+// Class: CDispatchPolicy
+//
+// Description: Task dispatch policies that order the files queued for CTask action
+// workers (the default without one is first in first out).
+//
+// CFairDispatchPolicy gives each directory files are queued from an equal share of
+// the workers by round-robin between them; the n'th file queued from a directory is
+// dispatched in round n (counted from when the directory last had nothing queued) so
+// one producer dumping a large number of files into its directory does not hold up
+// any other. CPriorityDispatchPolicy dispatches by a priority for each file extension
+// and optionally smallest file first within a priority. CDeadlineDispatchPolicy gives
+// each file a deadline (time queued plus a deadline for its extension) and dispatches
+// earliest deadline first.
+//
+// Dependencies: C20++               - Language standard features used.
+//               Class CPath         - File path manipulation.
+//               Linux               - stat.
+//
+// =================
+// CLASS DEFINITIONS
+// =================
+#include "CDispatchPolicy.hpp"
+#include "CPath.hpp"
+// ====================
+// CLASS IMPLEMENTATION
+// ====================
+//
+// C++ STL
+//
+#include <algorithm>
+//
+// Linux
+//
+#include <sys/stat.h>
+// =========
+// NAMESPACE
+// =========
+namespace Antik::File
+{
+    // ===========================
+    // PRIVATE TYPES AND CONSTANTS
+    // ===========================
+    // Directories tracked before those with nothing queued are forgotten
+    const std::size_t CFairDispatchPolicy::kPruneDirectories{1024};
+    // ==========================
+    // PUBLIC TYPES AND CONSTANTS
+    // ==========================
+    // ========================
+    // PRIVATE STATIC VARIABLES
+    // ========================
+    // =======================
+    // PUBLIC STATIC VARIABLES
+    // =======================
+    // ===============
+    // PRIVATE METHODS
+    // ===============
+    // ==============
+    // PUBLIC METHODS
+    // ==============
+    //
+    // CFairDispatchPolicy constructor
+    //
+    CFairDispatchPolicy::CFairDispatchPolicy() : m_pruneDirectories{kPruneDirectories}
+    {
+    }
+    //
+    // CFairDispatchPolicy destructor
+    //
+    CFairDispatchPolicy::~CFairDispatchPolicy()
+    {
+    }
+    //
+    // Rank file by the round it is dispatched in; the round after the last file queued
+    // from its directory (or the current round if that has passed).
+    //
+    IDispatchPolicy::Rank CFairDispatchPolicy::rank(const std::string &filePath, [[maybe_unused]] std::chrono::steady_clock::time_point received)
+    {
+        std::int64_t &nextRound{m_nextRound[CPath(filePath).parentPath().toString()]};
+        nextRound = std::max(nextRound, m_round) + 1;
+        return (Rank{nextRound, 0});
+    }
+    //
+    // Advance current round; forgetting directories with nothing queued once enough are tracked.
+    //
+    void CFairDispatchPolicy::dispatched([[maybe_unused]] const std::string &filePath, const Rank &rank)
+    {
+        m_round = std::max(m_round, rank.primary - 1);
+        if (m_nextRound.size() >= m_pruneDirectories)
+        {
+            for (auto directory = m_nextRound.begin(); directory != m_nextRound.end();)
+            {
+                directory = (directory->second <= m_round) ? m_nextRound.erase(directory) : std::next(directory);
+            }
+            m_pruneDirectories = std::max(kPruneDirectories, m_nextRound.size() * 2);
+        }
+    }
+    //
+    // CPriorityDispatchPolicy constructor
+    //
+    CPriorityDispatchPolicy::CPriorityDispatchPolicy(const std::unordered_map<std::string, int> &extensionPriorities, int defaultPriority, bool smallestFirst)
+        : m_extensionPriorities{extensionPriorities}, m_defaultPriority{defaultPriority}, m_smallestFirst{smallestFirst}
+    {
+    }
+    //
+    // CPriorityDispatchPolicy destructor
+    //
+    CPriorityDispatchPolicy::~CPriorityDispatchPolicy()
+    {
+    }
+    //
+    // Rank file by its extension priority and then (if requested) its size.
+    //
+    IDispatchPolicy::Rank CPriorityDispatchPolicy::rank(const std::string &filePath, [[maybe_unused]] std::chrono::steady_clock::time_point received)
+    {
+        Rank fileRank{m_defaultPriority, 0};
+        auto extensionPriority = m_extensionPriorities.find(CPath(filePath).extension());
+        if (extensionPriority != m_extensionPriorities.end())
+        {
+            fileRank.primary = extensionPriority->second;
+        }
+        struct stat fileStat;
+        if (m_smallestFirst && (stat(filePath.c_str(), &fileStat) == 0))
+        {
+            fileRank.secondary = static_cast<std::int64_t>(fileStat.st_size);
+        }
+        return (fileRank);
+    }
+    //
+    // Nothing to do on dispatch.
+    //
+    void CPriorityDispatchPolicy::dispatched([[maybe_unused]] const std::string &filePath, [[maybe_unused]] const Rank &rank)
+    {
+    }
+    //
+    // CDeadlineDispatchPolicy constructor
+    //
+    CDeadlineDispatchPolicy::CDeadlineDispatchPolicy(std::chrono::milliseconds defaultDeadline, const std::unordered_map<std::string, std::chrono::milliseconds> &extensionDeadlines)
+        : m_defaultDeadline{defaultDeadline}, m_extensionDeadlines{extensionDeadlines}
+    {
+    }
+    //
+    // CDeadlineDispatchPolicy destructor
+    //
+    CDeadlineDispatchPolicy::~CDeadlineDispatchPolicy()
+    {
+    }
+    //
+    // Rank file by its deadline (steady clock nanoseconds).
+    //
+    IDispatchPolicy::Rank CDeadlineDispatchPolicy::rank(const std::string &filePath, std::chrono::steady_clock::time_point received)
+    {
+        std::chrono::milliseconds deadline{m_defaultDeadline};
+        auto extensionDeadline = m_extensionDeadlines.find(CPath(filePath).extension());
+        if (extensionDeadline != m_extensionDeadlines.end())
+        {
+            deadline = extensionDeadline->second;
+        }
+        return (Rank{std::chrono::duration_cast<std::chrono::nanoseconds>((received + deadline).time_since_epoch()).count(), 0});
+    }
+    //
+    // Nothing to do on dispatch.
+    //
+    void CDeadlineDispatchPolicy::dispatched([[maybe_unused]] const std::string &filePath, [[maybe_unused]] const Rank &rank)
+    {
+    }
+} // namespace Antik::File
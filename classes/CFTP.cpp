@@ -4,7 +4,9 @@
 // Description: A class to connect to an FTP server using provided credentials
 // and enable the uploading/downloading of files along with assorted other commands.
 //
-// Note: TLS/SSL connections are supported.
+// Note: TLS/SSL connections are supported. Sessions may share an io service and run
+// connect/disconnect, get/put file and list asynchronously (completion handlers) so that
+// many servers can be driven by a few threads.
 //
 // Dependencies:   C20++        - Language standard features used.
 //                 CSocket   -  - Used to talk to FTP server.
@@ -21,6 +23,23 @@
 //
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cerrno>
+#include <cstring>
+//
+// Boost CRC
+//
+#include <boost/crc.hpp>
+//
+// OpenSSL message digests
+//
+#include <openssl/evp.h>
+//
+// Linux
+//
+#include <unistd.h>
 // =======
 // IMPORTS
 // =======
@@ -32,6 +51,10 @@ namespace Antik::FTP
     // ===========================
     // PRIVATE TYPES AND CONSTANTS
     // ===========================
+    // Control channel read size
+    const std::size_t CFTP::kControlReadSize{4 * 1024};
+    // Most pipelined commands awaiting a reply
+    const std::size_t CFTP::kPipelineDepth{64};
     // ==========================
     // PUBLIC TYPES AND CONSTANTS
     // ==========================
@@ -94,11 +117,21 @@ namespace Antik::FTP
         return (portCommand);
     }
     //
-    // Download a file from FTP server to local system.
+    // Download a file from FTP server to local system (written from offset on if
+    // resuming a transfer).
     //
-    void CFTP::downloadFile(const std::string &file)
+    void CFTP::downloadFile(const std::string &file, std::uint64_t offset)
     {
-        std::ofstream localFile{file, std::ofstream::trunc | std::ofstream::binary};
+        std::ofstream localFile;
+        if (offset == 0)
+        {
+            localFile.open(file, std::ofstream::trunc | std::ofstream::binary);
+        }
+        else
+        {
+            localFile.open(file, std::ofstream::in | std::ofstream::out | std::ofstream::binary);
+            localFile.seekp(offset);
+        }
         do
         {
             size_t bytesRead = m_dataChannelSocket.read(m_ioBuffer.get(), m_ioBufferSize);
@@ -110,13 +143,42 @@ namespace Antik::FTP
         localFile.close();
     }
     //
-    // Upload file from local system to FTP server,
+    // Download part of a file from FTP server written at its offset in an open local file.
+    // Reads no further than the end of the segment; returns true if the server closed
+    // the data channel (end of file reached) before then.
+    //
+    bool CFTP::downloadSegment(int localFile, std::uint64_t offset, std::uint64_t length, std::uint64_t &bytesTransferred)
+    {
+        while (bytesTransferred < length)
+        {
+            size_t bytesRead = m_dataChannelSocket.read(m_ioBuffer.get(), static_cast<size_t>(std::min<std::uint64_t>(m_ioBufferSize, length - bytesTransferred)));
+            for (size_t bytesWritten = 0; bytesWritten < bytesRead;)
+            {
+                ssize_t written = pwrite(localFile, &m_ioBuffer.get()[bytesWritten], bytesRead - bytesWritten, static_cast<off_t>(offset + bytesTransferred));
+                if (written < 0)
+                {
+                    throw std::runtime_error(std::string("Local file write failed: ") + std::strerror(errno));
+                }
+                bytesWritten += written;
+                bytesTransferred += written;
+            }
+            if (m_dataChannelSocket.closedByRemotePeer())
+            {
+                return (true);
+            }
+        }
+        return (false);
+    }
+    //
+    // Upload file from local system to FTP server (read from offset on if resuming a
+    // transfer).
     //
-    void CFTP::uploadFile(const std::string &file)
+    void CFTP::uploadFile(const std::string &file, std::uint64_t offset)
     {
         std::ifstream localFile{file, std::ifstream::binary};
         if (localFile)
         {
+            localFile.seekg(offset);
             do
             {
                 localFile.read(m_ioBuffer.get(), m_ioBufferSize);
@@ -154,10 +216,10 @@ namespace Antik::FTP
     //
     // Transfer (upload/download) file over data channel.
     //
-    void CFTP::transferOnDataChannel(const std::string &file, DataTransferType transferType)
+    void CFTP::transferOnDataChannel(const std::string &file, DataTransferType transferType, std::uint64_t offset)
     {
         std::string unusedResponse;
-        transferOnDataChannel(file, unusedResponse, transferType);
+        transferOnDataChannel(file, unusedResponse, transferType, offset);
     }
     //
     // Transfer (command response) file over data channel.
@@ -170,7 +232,7 @@ namespace Antik::FTP
     //
     // Transfer (file upload/ file download/ command response) over data channel.
     //
-    void CFTP::transferOnDataChannel(const std::string &file, std::string &commandRespnse, DataTransferType transferType)
+    void CFTP::transferOnDataChannel(const std::string &file, std::string &commandRespnse, DataTransferType transferType, std::uint64_t offset)
     {
         try
         {
@@ -180,10 +242,10 @@ namespace Antik::FTP
                 switch (transferType)
                 {
                 case DataTransferType::download:
-                    downloadFile(file);
+                    downloadFile(file, offset);
                     break;
                 case DataTransferType::upload:
-                    uploadFile(file);
+                    uploadFile(file, offset);
                     break;
                 case DataTransferType::commandResponse:
                     downloadCommandResponse(commandRespnse);
@@ -201,107 +263,757 @@ namespace Antik::FTP
         m_dataChannelSocket.cleanup();
     }
     //
+    // Transfer part of a file over data channel into an open local file. If the end of the
+    // segment is reached before the end of file then the data channel is dropped and the
+    // transfer aborted (ABOR); the server replies first to the RETR (226/426) then the ABOR.
+    //
+    void CFTP::transferSegmentOnDataChannel(int localFile, std::uint64_t offset, std::uint64_t length, std::uint64_t &bytesTransferred)
+    {
+        try
+        {
+            if ((m_commandStatusCode == 125) || (m_commandStatusCode == 150))
+            {
+                m_dataChannelSocket.waitUntilConnected();
+                if (downloadSegment(localFile, offset, length, bytesTransferred))
+                {
+                    m_dataChannelSocket.close();
+                    ftpResponse();
+                }
+                else
+                {
+                    m_dataChannelSocket.abort();
+                    m_lastCommand = "ABOR";
+                    ftpSend(m_lastCommand + "\r\n");
+                    ftpResponse();
+                    ftpResponse();
+                }
+            }
+        }
+        catch (const std::exception &e)
+        {
+            m_dataChannelSocket.cleanup();
+            throw;
+        }
+        m_dataChannelSocket.cleanup();
+    }
+    //
+    // Write command line(s) to control channel.
+    //
+    void CFTP::ftpSend(const std::string &commandLines)
+    {
+        size_t commandLength = commandLines.size();
+        do
+        {
+            commandLength -= m_controlChannelSocket.write(&commandLines[commandLines.size() - commandLength], commandLength);
+        } while (commandLength != 0);
+    }
+    //
     // Send FTP over control channel. Append "\r\n" to command for transmission then remove
     // from m_lastCommand.
     //
     void CFTP::ftpCommand(const std::string &command)
     {
         m_lastCommand = command + "\r\n";
-        size_t commandLength = m_lastCommand.size();
-        do
-        {
-            commandLength -= m_controlChannelSocket.write(&m_lastCommand[m_lastCommand.size() - commandLength], commandLength);
-        } while (commandLength != 0);
+        ftpSend(m_lastCommand);
         m_lastCommand.pop_back();
         m_lastCommand.pop_back();
         ftpResponse();
     }
     //
+    // Send FTP commands over control channel without waiting for the reply to each
+    // before sending the next and return their replies (in command order). Commands
+    // are written a window at a time and the window topped up once half of its
+    // replies have been read, so the server is never left with more than a window
+    // of replies queued waiting to be read. Only commands answered on the control
+    // channel alone may be pipelined (not ones that use the data channel). If sending
+    // or reading a reply fails part way then the replies still outstanding would be
+    // read as those of later commands; so the control channel is closed and the
+    // connection reset before the failure is passed on.
+    //
+    void CFTP::ftpCommands(const std::vector<std::string> &commands, std::vector<CommandReply> &replies)
+    {
+        std::size_t commandsSent{0};
+        replies.clear();
+        replies.reserve(commands.size());
+        try
+        {
+            while (replies.size() < commands.size())
+            {
+                if ((commandsSent < commands.size()) && ((commandsSent - replies.size()) <= (kPipelineDepth / 2)))
+                {
+                    std::string commandLines;
+                    while ((commandsSent < commands.size()) && ((commandsSent - replies.size()) < kPipelineDepth))
+                    {
+                        commandLines += commands[commandsSent++] + "\r\n";
+                    }
+                    ftpSend(commandLines);
+                    m_lastCommand = commands[commandsSent - 1];
+                }
+                ftpResponse();
+                replies.push_back({m_commandStatusCode, m_commandResponse});
+            }
+        }
+        catch (const std::exception &e)
+        {
+            try
+            {
+                m_controlChannelSocket.close();
+            }
+            catch (...)
+            {
+            }
+            resetConnection();
+            throw;
+        }
+    }
+    //
+    // Append next line of a command response (including its "\r\n") from the control
+    // channel to m_commandResponse and return where it starts. The channel is read a
+    // buffer at a time rather than a byte at a time; any bytes read past the end of the
+    // line (the start of a later reply) are kept for the next call.
+    //
+    std::size_t CFTP::ftpResponseLine()
+    {
+        std::size_t lineStart;
+        while (!bufferedResponseLine(lineStart))
+        {
+            std::size_t bufferEnd{extendControlBuffer()};
+            m_controlBuffer.resize(bufferEnd + m_controlChannelSocket.read(&m_controlBuffer[bufferEnd], kControlReadSize));
+            if (m_controlChannelSocket.closedByRemotePeer())
+            {
+                throw std::runtime_error("Control channel connection closed by peer.");
+            }
+        }
+        return (lineStart);
+    }
+    //
+    // If the control buffer holds a whole line then append it to m_commandResponse,
+    // pass back where it starts and return true.
+    //
+    bool CFTP::bufferedResponseLine(std::size_t &lineStart)
+    {
+        std::size_t lineEnd{m_controlBuffer.find('\n', m_controlBufferPosition)};
+        if (lineEnd == std::string::npos)
+        {
+            return (false);
+        }
+        lineStart = m_commandResponse.size();
+        m_commandResponse.append(m_controlBuffer, m_controlBufferPosition, lineEnd - m_controlBufferPosition + 1);
+        m_controlBufferPosition = lineEnd + 1;
+        return (true);
+    }
+    //
+    // Discard lines already returned from the control buffer and make room to read the
+    // next chunk after any partial line; returns where it is to be read to.
+    //
+    std::size_t CFTP::extendControlBuffer()
+    {
+        m_controlBuffer.erase(0, m_controlBufferPosition);
+        m_controlBufferPosition = 0;
+        std::size_t bufferEnd{m_controlBuffer.size()};
+        m_controlBuffer.resize(bufferEnd + kControlReadSize);
+        return (bufferEnd);
+    }
+    //
     // Read FTP command response from control channel (return its status code).
     // It gathers the whole response even if it is extended (ie. starts with "ddd-"
-    // and ends with a line starting ddd. Can get multiple replies in a single read
-    // so just read single characters.
+    // and ends with a line starting "ddd "); only the start of each new line is
+    // checked for the end of an extended response.
     //
     void CFTP::ftpResponse()
     {
         m_commandResponse.clear();
-        do
+        ftpResponseLine();
+        if ((m_commandResponse.size() > 3) && (m_commandResponse[3] == '-'))
         {
+            std::string lastLineStart{m_commandResponse.substr(0, 3) + " "};
+            std::size_t lineStart;
             do
             {
-                char byte[1];
-                if (m_controlChannelSocket.read(&byte[0], 1))
-                {
-                    m_commandResponse.append(1, byte[0]);
-                    if (byte[0] == '\n')
-                    {
-                        break;
-                    }
-                }
-            } while (!m_controlChannelSocket.closedByRemotePeer());
-            if (m_commandResponse[3] == '-')
+                lineStart = ftpResponseLine();
+            } while (m_commandResponse.compare(lineStart, lastLineStart.size(), lastLineStart) != 0);
+        }
+        ftpResponseStatusCode();
+    }
+    //
+    // Set status code from command response just read.
+    //
+    void CFTP::ftpResponseStatusCode()
+    {
+        try
+        {
+            m_commandStatusCode = std::stoi(m_commandResponse);
+        }
+        catch (const std::exception &e)
+        {
+            throw std::runtime_error("Invalid FTP command response status code.");
+        }
+    }
+    //
+    // Send transfer mode to used over data channel.
+    //
+    bool CFTP::sendTransferMode()
+    {
+        // Data channel resumes control channel TLS session (saves a full handshake per
+        // transfer and some servers insist on it)
+        if (m_dataChannelSocket.isSslEnabled())
+        {
+            m_dataChannelSocket.setTlsSession(m_controlChannelSocket.getTlsSession());
+        }
+        if (m_passiveMode)
+        {
+            ftpCommand("PASV");
+            if (m_commandStatusCode == 227)
             {
-                if (m_commandResponse.rfind("\r\n" + m_commandResponse.substr(0, 3) + " ") != std::string::npos)
+                extractPassiveAddressPort(m_commandResponse);
+                m_dataChannelSocket.connect();
+            }
+            return (m_commandStatusCode == 227);
+        }
+        else
+        {
+            m_dataChannelSocket.setHostAddress(Antik::Network::CSocket::localIPAddress());
+            m_dataChannelSocket.listenForConnection();
+            ftpCommand(createPortCommand());
+            return (m_commandStatusCode == 200);
+        }
+    }
+    //
+    // Parse an MLST/MLSD entry ("fact=value;...; name") into file information. Fact
+    // names and type values are case insensitive (RFC 3659) so are lowercased; any
+    // facts not recognised or with a bad value are ignored. Facts contain no spaces
+    // so are only split from the name (which may) at the first "; " when the entry
+    // (after the single leading space of an MLST reply) starts with them; otherwise
+    // the entry is just the space separator and name.
+    //
+    void CFTP::parseFacts(const std::string &entry, FileInfo &fileInfo)
+    {
+        auto toLower = [](std::string value) {
+            std::transform(value.begin(), value.end(), value.begin(), [](unsigned char ch) { return std::tolower(ch); });
+            return (value);
+        };
+        std::string facts{entry};
+        while (!facts.empty() && ((facts.back() == '\r') || (facts.back() == '\n')))
+        {
+            facts.pop_back();
+        }
+        fileInfo = FileInfo();
+        std::size_t factsStart{((facts.size() > 1) && (facts[0] == ' ') && (facts[1] != ' ')) ? 1U : 0U};
+        std::size_t factsEnd{facts.find("; ", factsStart)};
+        if ((factsEnd == std::string::npos) || (facts.find(' ', factsStart) != factsEnd + 1) ||
+            (facts.find('=', factsStart) > factsEnd))
+        {
+            fileInfo.name = (!facts.empty() && (facts[0] == ' ')) ? facts.substr(1) : facts;
+            return;
+        }
+        fileInfo.name = facts.substr(factsEnd + 2);
+        facts = facts.substr(factsStart, factsEnd - factsStart);
+        std::string fact;
+        std::istringstream factStream{facts};
+        while (std::getline(factStream, fact, ';'))
+        {
+            std::size_t valueStart = fact.find('=');
+            if (valueStart == std::string::npos)
+            {
+                continue;
+            }
+            std::string factName{toLower(fact.substr(0, valueStart))};
+            std::string factValue{fact.substr(valueStart + 1)};
+            if (factName == "type")
+            {
+                fileInfo.type = toLower(factValue);
+            }
+            else if (factName == "size")
+            {
+                std::uint64_t size{0};
+                auto [end, error] = std::from_chars(factValue.data(), factValue.data() + factValue.size(), size);
+                if ((error == std::errc()) && (end == factValue.data() + factValue.size()))
                 {
-                    break;
+                    fileInfo.size = size;
                 }
             }
-        } while ((m_commandResponse[3] == '-') && (!m_controlChannelSocket.closedByRemotePeer()));
-        if (m_controlChannelSocket.closedByRemotePeer())
+            else if ((factName == "modify") && (factValue.size() >= 14) && (factValue.find_first_not_of("0123456789") >= 14))
+            {
+                fileInfo.modify = DateTime(factValue);
+            }
+            else if (factName == "perm")
+            {
+                fileInfo.perm = factValue;
+            }
+        }
+    }
+    //
+    // Return true if MLST response is for a directory.
+    //
+    bool CFTP::mlstIsDirectory(const std::string &mlstResponse)
+    {
+        FileInfo fileInfo;
+        std::string entry{mlstResponse.substr(mlstResponse.find('\n') + 1)};
+        parseFacts(entry.substr(0, entry.find('\n')), fileInfo);
+        return (fileInfo.isDirectory());
+    }
+    //
+    // Return true if STAT response lists a directory.
+    //
+    bool CFTP::statIsDirectory(const std::string &statResponse)
+    {
+        size_t dirPosition = statResponse.find("\r\n") + 2;
+        return ((dirPosition != std::string::npos) && (statResponse[dirPosition] == 'd'));
+    }
+    //
+    // Return true if STAT response is not empty; if it is file does not exist.
+    //
+    bool CFTP::statFileExists(const std::string &statResponse)
+    {
+        size_t statusCodePosition = statResponse.find("\r\n") + 2;
+        return ((statusCodePosition != std::string::npos) && (statResponse[statusCodePosition] != '2'));
+    }
+    //
+    // Return size of local file (0 if it does not exist).
+    //
+    std::uint64_t CFTP::localFileSize(const std::string &localFilePath)
+    {
+        std::ifstream localFile{localFilePath, std::ifstream::binary | std::ifstream::ate};
+        return (localFile ? static_cast<std::uint64_t>(localFile.tellg()) : 0);
+    }
+    //
+    // Return CRC32 of the first length bytes of a local file.
+    //
+    std::uint32_t CFTP::localFileCRC(const std::string &localFilePath, std::uint64_t length)
+    {
+        boost::crc_32_type crc;
+        std::ifstream localFile{localFilePath, std::ifstream::binary};
+        while (localFile && (length != 0))
         {
-            throw std::runtime_error("Control channel connection closed by peer.");
+            localFile.read(m_ioBuffer.get(), static_cast<std::streamsize>(std::min<std::uint64_t>(m_ioBufferSize, length)));
+            crc.process_bytes(m_ioBuffer.get(), localFile.gcount());
+            length -= localFile.gcount();
         }
+        return (crc.checksum());
+    }
+    //
+    // Return message digest (lowercase hex) of a local file.
+    //
+    std::string CFTP::localFileHash(const std::string &localFilePath, const EVP_MD *digestType)
+    {
+        std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> digestContext{EVP_MD_CTX_new(), EVP_MD_CTX_free};
+        unsigned char digest[EVP_MAX_MD_SIZE];
+        unsigned int digestLength{0};
+        std::ifstream localFile{localFilePath, std::ifstream::binary};
+        if (!digestContext || !EVP_DigestInit_ex(digestContext.get(), digestType, nullptr))
+        {
+            throw std::runtime_error("Could not create message digest.");
+        }
+        while (localFile)
+        {
+            localFile.read(m_ioBuffer.get(), m_ioBufferSize);
+            EVP_DigestUpdate(digestContext.get(), m_ioBuffer.get(), localFile.gcount());
+        }
+        EVP_DigestFinal_ex(digestContext.get(), digest, &digestLength);
+        std::ostringstream digestHex;
+        for (unsigned int byte = 0; byte < digestLength; byte++)
+        {
+            digestHex << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(digest[byte]);
+        }
+        return (digestHex.str());
+    }
+    //
+    // Parse a CRC32 (hex; any quotes around it ignored). Returns false if it is not valid.
+    //
+    bool CFTP::parseCRC(std::string crcField, std::uint32_t &crc)
+    {
+        crcField.erase(std::remove(crcField.begin(), crcField.end(), '"'), crcField.end());
+        if (crcField.empty() || (crcField.size() > 8) || (crcField.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos))
+        {
+            return (false);
+        }
+        crc = static_cast<std::uint32_t>(std::stoul(crcField, nullptr, 16));
+        return (true);
+    }
+    //
+    // Return true if the CRC32 at the end of the XCRC reply just read matches that of
+    // the first length bytes of a local file (false if the reply CRC is not valid).
+    //
+    bool CFTP::responseCRCMatches(const std::string &localFilePath, std::uint64_t length)
+    {
+        std::string crcField;
+        std::string responseField;
+        std::istringstream responseStream{m_commandResponse.substr(3)};
+        while (responseStream >> responseField)
+        {
+            crcField = responseField;
+        }
+        std::uint32_t crc{0};
+        return (parseCRC(crcField, crc) && (crc == localFileCRC(localFilePath, length)));
+    }
+    //
+    // Return true if the first length bytes of a remote and local file have the same
+    // CRC32 (XCRC); a partial transfer is only resumed if they do.
+    //
+    bool CFTP::partialFileMatches(const std::string &remoteFilePath, const std::string &localFilePath, std::uint64_t length)
+    {
+        ftpCommand("XCRC " + remoteFilePath + " 0 " + std::to_string(length));
+        if (m_commandStatusCode != 250)
+        {
+            return (false);
+        }
+        return (responseCRCMatches(localFilePath, length));
+    }
+    //
+    // Reset connection state once control channel closed.
+    //
+    void CFTP::resetConnection(void)
+    {
+        m_connected = false;
+        m_controlChannelSocket.setSslEnabled(false);
+        m_controlBuffer.clear();
+        m_controlBufferPosition = 0;
+        m_dataChannelSocket.setSslEnabled(false);
+        m_dataChannelSocket.setTlsSession(nullptr);
+        // Free IO Buffer
+        m_ioBuffer.reset();
+    }
+    //
+    // Get FTP server features list.
+    //
+    void CFTP::ftpServerFeatures(void)
+    {
+        ftpCommand("FEAT");
+        parseServerFeatures();
+    }
+    //
+    // Parse server features list from FEAT command response.
+    //
+    void CFTP::parseServerFeatures(void)
+    {
+        if (m_commandStatusCode == 211)
+        {
+            std::string feature;
+            std::istringstream featureResponseStream{m_commandResponse};
+            std::getline(featureResponseStream, feature, '\n');
+            m_serverFeatures.clear();
+            while (std::getline(featureResponseStream, feature, '\n'))
+            {
+                feature.pop_back();
+                m_serverFeatures.push_back(feature.substr(1));
+            }
+            m_serverFeatures.pop_back();
+        }
+    }
+    //
+    // Start an asynchronous command (only one may be in progress at a time).
+    //
+    void CFTP::asyncStart(AsyncHandler handler)
+    {
+        if (m_asyncHandler)
+        {
+            throw std::logic_error("Asynchronous command already in progress.");
+        }
+        if (!handler)
+        {
+            throw std::logic_error("No asynchronous command completion handler.");
+        }
+        m_asyncHandler = handler;
+    }
+    //
+    // Run a step of an asynchronous command; any exception thrown completes the command
+    // (passing it to the handler).
+    //
+    void CFTP::asyncStep(const AsyncStep &step)
+    {
         try
         {
-            m_commandStatusCode = std::stoi(m_commandResponse);
+            step();
+        }
+        catch (const std::exception &e)
+        {
+            asyncComplete(std::make_exception_ptr(Exception(e.what())));
+        }
+    }
+    //
+    // Complete an asynchronous command. The data channel is cleaned up (dropped on
+    // failure) and the handler posted to the io service with any exception and the
+    // status code; so that it runs outside of the command and may start another.
+    //
+    void CFTP::asyncComplete(std::exception_ptr commandException)
+    {
+        AsyncHandler handler{std::move(m_asyncHandler)};
+        m_asyncHandler = nullptr;
+        try
+        {
+            if (commandException)
+            {
+                m_dataChannelSocket.abort();
+            }
+            else
+            {
+                m_dataChannelSocket.cleanup();
+            }
         }
         catch (const std::exception &e)
         {
-            throw std::runtime_error("Invalid FTP command response status code.");
         }
+        if (handler)
+        {
+            boost::asio::post(m_controlChannelSocket.getIoService(), [handler, commandException, statusCode = m_commandStatusCode]() {
+                handler(commandException, statusCode);
+            });
+        }
+    }
+    //
+    // Throw on a socket error passed to an asynchronous handler.
+    //
+    void CFTP::asyncCheck(const boost::system::error_code &error)
+    {
+        if (error)
+        {
+            throw std::runtime_error(error.message());
+        }
+    }
+    //
+    // Send FTP command over control channel asynchronously and read its response.
+    //
+    void CFTP::asyncFtpCommand(const std::string &command, AsyncStep next)
+    {
+        m_lastCommand = command + "\r\n";
+        m_controlChannelSocket.asyncWrite(m_lastCommand.data(), m_lastCommand.size(), [this, next](const boost::system::error_code &writeError, std::size_t) {
+            asyncStep([&]() {
+                m_lastCommand.pop_back();
+                m_lastCommand.pop_back();
+                asyncCheck(writeError);
+                asyncFtpResponse(next);
+            });
+        });
+    }
+    //
+    // Read FTP command response from control channel asynchronously (whole of any
+    // extended response) and set its status code.
+    //
+    void CFTP::asyncFtpResponse(AsyncStep next)
+    {
+        m_commandResponse.clear();
+        asyncFtpResponseLine([this, next](std::size_t) {
+            if ((m_commandResponse.size() > 3) && (m_commandResponse[3] == '-'))
+            {
+                asyncFtpExtendedResponse(m_commandResponse.substr(0, 3) + " ", next);
+            }
+            else
+            {
+                ftpResponseStatusCode();
+                next();
+            }
+        });
+    }
+    //
+    // Read lines of an extended response asynchronously until its last.
+    //
+    void CFTP::asyncFtpExtendedResponse(const std::string &lastLineStart, AsyncStep next)
+    {
+        asyncFtpResponseLine([this, lastLineStart, next](std::size_t lineStart) {
+            if (m_commandResponse.compare(lineStart, lastLineStart.size(), lastLineStart) != 0)
+            {
+                asyncFtpExtendedResponse(lastLineStart, next);
+            }
+            else
+            {
+                ftpResponseStatusCode();
+                next();
+            }
+        });
+    }
+    //
+    // Append next line of a command response to m_commandResponse asynchronously;
+    // reading the control channel only if a whole line is not already buffered.
+    //
+    void CFTP::asyncFtpResponseLine(std::function<void(std::size_t)> next)
+    {
+        std::size_t lineStart;
+        if (bufferedResponseLine(lineStart))
+        {
+            next(lineStart);
+            return;
+        }
+        std::size_t bufferEnd{extendControlBuffer()};
+        m_controlChannelSocket.asyncRead(&m_controlBuffer[bufferEnd], kControlReadSize, [this, bufferEnd, next](const boost::system::error_code &readError, std::size_t bytesRead) {
+            asyncStep([&]() {
+                m_controlBuffer.resize(bufferEnd + bytesRead);
+                if (m_controlChannelSocket.closedByRemotePeer())
+                {
+                    throw std::runtime_error("Control channel connection closed by peer.");
+                }
+                asyncCheck(readError);
+                asyncFtpResponseLine(next);
+            });
+        });
     }
     //
-    // Send transfer mode to used over data channel.
+    // Negotiate TLS on control channel asynchronously then login.
     //
-    bool CFTP::sendTransferMode()
+    void CFTP::asyncSecureConnection(void)
+    {
+        asyncFtpCommand("AUTH TLS", [this]() {
+            if (m_commandStatusCode != 234)
+            {
+                asyncLogin();
+                return;
+            }
+            m_controlChannelSocket.setSslEnabled(true);
+            m_controlChannelSocket.asyncTlsHandshake([this](const boost::system::error_code &handshakeError) {
+                asyncStep([&]() {
+                    asyncCheck(handshakeError);
+                    m_dataChannelSocket.setSslEnabled(true);
+                    asyncFtpCommand("PBSZ 0", [this]() {
+                        if (m_commandStatusCode != 200)
+                        {
+                            asyncLogin();
+                            return;
+                        }
+                        asyncFtpCommand("PROT P", [this]() { asyncLogin(); });
+                    });
+                });
+            });
+        });
+    }
+    //
+    // Login to server asynchronously (completes connect).
+    //
+    void CFTP::asyncLogin(void)
+    {
+        m_connected = true;
+        asyncFtpCommand("USER " + m_userName, [this]() {
+            if (m_commandStatusCode != 331)
+            {
+                asyncComplete(nullptr);
+                return;
+            }
+            asyncFtpCommand("PASS " + m_userPassword, [this]() { asyncComplete(nullptr); });
+        });
+    }
+    //
+    // Send transfer mode to used over data channel asynchronously (passing on whether
+    // the server accepted it).
+    //
+    void CFTP::asyncSendTransferMode(std::function<void(bool)> next)
     {
+        if (m_dataChannelSocket.isSslEnabled())
+        {
+            m_dataChannelSocket.setTlsSession(m_controlChannelSocket.getTlsSession());
+        }
         if (m_passiveMode)
         {
-            ftpCommand("PASV");
-            if (m_commandStatusCode == 227)
-            {
+            asyncFtpCommand("PASV", [this, next]() {
+                if (m_commandStatusCode != 227)
+                {
+                    next(false);
+                    return;
+                }
                 extractPassiveAddressPort(m_commandResponse);
-                m_dataChannelSocket.connect();
-            }
-            return (m_commandStatusCode == 227);
+                m_dataChannelSocket.asyncConnect([this, next](const boost::system::error_code &connectError) {
+                    asyncStep([&]() {
+                        asyncCheck(connectError);
+                        next(true);
+                    });
+                });
+            });
         }
         else
         {
             m_dataChannelSocket.setHostAddress(Antik::Network::CSocket::localIPAddress());
             m_dataChannelSocket.listenForConnection();
-            ftpCommand(createPortCommand());
-            return (m_commandStatusCode == 200);
+            asyncFtpCommand(createPortCommand(), [this, next]() { next(m_commandStatusCode == 200); });
         }
     }
     //
-    // Get FTP server features list.
+    // Send command that transfers over the data channel asynchronously; run the passed
+    // transfer once the data channel is connected then close it and read the final
+    // response to complete the command.
     //
-    void CFTP::ftpServerFeatures(void)
+    void CFTP::asyncTransferOnDataChannel(const std::string &commandLine, std::function<void(AsyncStep)> transfer)
     {
-        ftpCommand("FEAT");
-        if (m_commandStatusCode == 211)
-        {
-            std::string feature;
-            std::istringstream featureResponseStream{m_commandResponse};
-            std::getline(featureResponseStream, feature, '\n');
-            m_serverFeatures.clear();
-            while (std::getline(featureResponseStream, feature, '\n'))
+        asyncSendTransferMode([this, commandLine, transfer](bool transferModeSet) {
+            if (!transferModeSet)
             {
-                feature.pop_back();
-                m_serverFeatures.push_back(feature.substr(1));
+                asyncComplete(nullptr);
+                return;
             }
-            m_serverFeatures.pop_back();
+            asyncFtpCommand(commandLine, [this, transfer]() {
+                if ((m_commandStatusCode != 125) && (m_commandStatusCode != 150))
+                {
+                    asyncComplete(nullptr);
+                    return;
+                }
+                m_dataChannelSocket.asyncWaitUntilConnected([this, transfer](const boost::system::error_code &connectError) {
+                    asyncStep([&]() {
+                        asyncCheck(connectError);
+                        transfer([this]() {
+                            m_dataChannelSocket.asyncClose([this](const boost::system::error_code &) {
+                                asyncStep([&]() { asyncFtpResponse([this]() { asyncComplete(nullptr); }); });
+                            });
+                        });
+                    });
+                });
+            });
+        });
+    }
+    //
+    // Download a file from FTP server to local system asynchronously.
+    //
+    void CFTP::asyncDownloadFile(std::shared_ptr<std::ofstream> localFile, AsyncStep next)
+    {
+        m_dataChannelSocket.asyncRead(m_ioBuffer.get(), m_ioBufferSize, [this, localFile, next](const boost::system::error_code &readError, std::size_t bytesRead) {
+            asyncStep([&]() {
+                if (bytesRead)
+                {
+                    localFile->write(m_ioBuffer.get(), bytesRead);
+                }
+                if (m_dataChannelSocket.closedByRemotePeer())
+                {
+                    localFile->close();
+                    next();
+                    return;
+                }
+                asyncCheck(readError);
+                asyncDownloadFile(localFile, next);
+            });
+        });
+    }
+    //
+    // Upload file from local system to FTP server asynchronously.
+    //
+    void CFTP::asyncUploadFile(std::shared_ptr<std::ifstream> localFile, AsyncStep next)
+    {
+        localFile->read(m_ioBuffer.get(), m_ioBufferSize);
+        std::size_t bytesToWrite = localFile->gcount();
+        if (bytesToWrite == 0)
+        {
+            localFile->close();
+            next();
+            return;
         }
+        m_dataChannelSocket.asyncWrite(m_ioBuffer.get(), bytesToWrite, [this, localFile, next](const boost::system::error_code &writeError, std::size_t) {
+            asyncStep([&]() {
+                asyncCheck(writeError);
+                asyncUploadFile(localFile, next);
+            });
+        });
+    }
+    //
+    // Download response to command over data channel asynchronously.
+    //
+    void CFTP::asyncDownloadCommandResponse(std::string &commandResponse, AsyncStep next)
+    {
+        m_dataChannelSocket.asyncRead(m_ioBuffer.get(), m_ioBufferSize, [this, &commandResponse, next](const boost::system::error_code &readError, std::size_t bytesRead) {
+            asyncStep([&]() {
+                commandResponse.append(m_ioBuffer.get(), bytesRead);
+                if (m_dataChannelSocket.closedByRemotePeer())
+                {
+                    next();
+                    return;
+                }
+                asyncCheck(readError);
+                asyncDownloadCommandResponse(commandResponse, next);
+            });
+        });
     }
     // ==============
     // PUBLIC METHODS
@@ -323,6 +1035,24 @@ namespace Antik::FTP
         m_serverPort = serverPort;
     }
     //
+    // Copy server, account and transfer settings from another CFTP (eg. to open another
+    // session to the same server). Its connection and the binary transfer flag (which is
+    // only set while connected) are not copied.
+    //
+    void CFTP::copySettings(const CFTP &ftpServer)
+    {
+        if (m_connected)
+        {
+            throw Exception("Cannot copy settings while connected.");
+        }
+        m_serverName = ftpServer.m_serverName;
+        m_serverPort = ftpServer.m_serverPort;
+        m_userName = ftpServer.m_userName;
+        m_userPassword = ftpServer.m_userPassword;
+        m_passiveMode = ftpServer.m_passiveMode;
+        m_sslEnabled = ftpServer.m_sslEnabled;
+    }
+    //
     // Get current connection status with server
     //
     bool CFTP::isConnected(void) const
@@ -385,6 +1115,8 @@ namespace Antik::FTP
             ;
             m_controlChannelSocket.setHostAddress(m_serverName);
             m_controlChannelSocket.setHostPort(m_serverPort);
+            m_controlBuffer.clear();
+            m_controlBufferPosition = 0;
             m_controlChannelSocket.connect();
             ftpResponse();
             if (m_commandStatusCode == 220)
@@ -434,10 +1166,7 @@ namespace Antik::FTP
             ftpCommand("QUIT");
             m_connected = false;
             m_controlChannelSocket.close();
-            m_controlChannelSocket.setSslEnabled(false);
-            m_dataChannelSocket.setSslEnabled(false);
-            // Free IO Buffer
-            m_ioBuffer.reset();
+            resetConnection();
             return (m_commandStatusCode);
         }
         catch (const std::exception &e)
@@ -487,6 +1216,250 @@ namespace Antik::FTP
         }
     }
     //
+    // Transfer part of a file (length bytes from offset) from the server into the same
+    // place in an open local file using REST/RETR; the transfer is aborted once the part
+    // has been read. The number of bytes written is passed back (so that a failed part
+    // may be resumed from where it got to) and 226 returned if the whole part was (or
+    // the end of the file was reached). Requires a binary transfer type.
+    //
+    std::uint16_t CFTP::getFileSegment(const std::string &remoteFilePath, int localFile, std::uint64_t offset, std::uint64_t length, std::uint64_t &bytesTransferred)
+    {
+        try
+        {
+            if (!m_connected)
+            {
+                throw std::logic_error("Already connected to a server.");
+            }
+            bytesTransferred = 0;
+            if (sendTransferMode())
+            {
+                ftpCommand("REST " + std::to_string(offset));
+                if (m_commandStatusCode == 350)
+                {
+                    ftpCommand("RETR " + remoteFilePath);
+                    transferSegmentOnDataChannel(localFile, offset, length, bytesTransferred);
+                    if ((bytesTransferred == length) && ((m_commandStatusCode == 225) || (m_commandStatusCode == 226)))
+                    {
+                        m_commandStatusCode = 226;
+                    }
+                }
+                else
+                {
+                    m_dataChannelSocket.cleanup();
+                }
+            }
+            return (m_commandStatusCode);
+        }
+        catch (const std::exception &e)
+        {
+            throw Exception(e.what());
+        }
+    }
+    //
+    // Transfer a file from the server to a local file resuming any earlier transfer that
+    // did not complete; the download restarting (REST) from the end of any partial local
+    // file. If verify is set then (if the server supports XCRC) the partial file is only
+    // resumed if it matches the start of the remote file and the whole file is checked
+    // once transferred (see verifyFile()). Requires a binary transfer type.
+    //
+    std::uint16_t CFTP::resumeGetFile(const std::string &remoteFilePath, const std::string &localFilePath, bool verify)
+    {
+        try
+        {
+            if (!m_connected)
+            {
+                throw std::logic_error("Already connected to a server.");
+            }
+            std::uint64_t remoteSize{0};
+            std::uint64_t localSize{localFileSize(localFilePath)};
+            ftpCommand("SIZE " + remoteFilePath);
+            if (m_commandStatusCode != 213)
+            {
+                return (m_commandStatusCode);
+            }
+            remoteSize = std::stoull(m_commandResponse.substr(m_commandResponse.find(' ') + 1));
+            if ((localSize > remoteSize) ||
+                (verify && (localSize != 0) && serverFeature("XCRC") && !partialFileMatches(remoteFilePath, localFilePath, localSize)))
+            {
+                localSize = 0;
+            }
+            if ((localSize == 0) || (localSize < remoteSize))
+            {
+                if (localSize == 0)
+                {
+                    std::ofstream localFile{localFilePath, std::ofstream::binary};
+                    if (!localFile)
+                    {
+                        m_commandStatusCode = 550;
+                        throw std::runtime_error("Local file " + localFilePath + " could not be created.");
+                    }
+                }
+                if (!sendTransferMode())
+                {
+                    return (m_commandStatusCode);
+                }
+                if (localSize != 0)
+                {
+                    ftpCommand("REST " + std::to_string(localSize));
+                    if (m_commandStatusCode != 350)
+                    {
+                        m_dataChannelSocket.cleanup();
+                        return (m_commandStatusCode);
+                    }
+                }
+                ftpCommand("RETR " + remoteFilePath);
+                transferOnDataChannel(localFilePath, DataTransferType::download, localSize);
+            }
+            else
+            {
+                m_commandStatusCode = 226; // Already transferred
+            }
+            if ((m_commandStatusCode == 226) && verify && isVerifySupported())
+            {
+                if (!verifyFile(remoteFilePath, localFilePath))
+                {
+                    throw std::runtime_error("Local file " + localFilePath + " does not match " + remoteFilePath + ".");
+                }
+                m_commandStatusCode = 226;
+            }
+            return (m_commandStatusCode);
+        }
+        catch (const std::exception &e)
+        {
+            throw Exception(e.what());
+        }
+    }
+    //
+    // Transfer a file to the server from a local file resuming any earlier transfer that
+    // did not complete; the rest of the local file being appended (APPE) to any partial
+    // remote file. If verify is set then (if the server supports XCRC) the partial file is
+    // only resumed if it matches the start of the local file and the whole file is checked
+    // once transferred (see verifyFile()). Requires a binary transfer type.
+    //
+    std::uint16_t CFTP::resumePutFile(const std::string &remoteFilePath, const std::string &localFilePath, bool verify)
+    {
+        try
+        {
+            if (!m_connected)
+            {
+                throw std::logic_error("Already connected to a server.");
+            }
+            std::ifstream localFile{localFilePath, std::ifstream::binary};
+            if (!localFile)
+            {
+                m_commandStatusCode = 550;
+                throw std::runtime_error("Local file " + localFilePath + " does not exist.");
+            }
+            localFile.close();
+            std::uint64_t remoteSize{0};
+            std::uint64_t localSize{localFileSize(localFilePath)};
+            ftpCommand("SIZE " + remoteFilePath);
+            if (m_commandStatusCode == 213)
+            {
+                remoteSize = std::stoull(m_commandResponse.substr(m_commandResponse.find(' ') + 1));
+            }
+            if ((remoteSize > localSize) ||
+                (verify && (remoteSize != 0) && serverFeature("XCRC") && !partialFileMatches(remoteFilePath, localFilePath, remoteSize)))
+            {
+                remoteSize = 0;
+            }
+            if ((remoteSize == 0) || (remoteSize < localSize))
+            {
+                if (!sendTransferMode())
+                {
+                    return (m_commandStatusCode);
+                }
+                ftpCommand(((remoteSize != 0) ? "APPE " : "STOR ") + remoteFilePath);
+                transferOnDataChannel(localFilePath, DataTransferType::upload, remoteSize);
+            }
+            else
+            {
+                m_commandStatusCode = 226; // Already transferred
+            }
+            if ((m_commandStatusCode == 226) && verify && isVerifySupported())
+            {
+                if (!verifyFile(remoteFilePath, localFilePath))
+                {
+                    throw std::runtime_error("Remote file " + remoteFilePath + " does not match " + localFilePath + ".");
+                }
+                m_commandStatusCode = 226;
+            }
+            return (m_commandStatusCode);
+        }
+        catch (const std::exception &e)
+        {
+            throw Exception(e.what());
+        }
+    }
+    //
+    // Return true if server supports a command (HASH or XCRC) used to verify files.
+    //
+    bool CFTP::isVerifySupported()
+    {
+        return (serverFeature("HASH") || serverFeature("XCRC"));
+    }
+    //
+    // Return true if a remote file and local file have the same checksum; using HASH
+    // (with the server's current hash algorithm) if supported otherwise XCRC (CRC32).
+    // A HASH algorithm that cannot be computed locally falls back to XCRC if supported.
+    // A failed or unparsable reply counts as a mismatch. Throws if the server supports
+    // neither.
+    //
+    bool CFTP::verifyFile(const std::string &remoteFilePath, const std::string &localFilePath)
+    {
+        try
+        {
+            if (!m_connected)
+            {
+                throw std::logic_error("Already connected to a server.");
+            }
+            bool hashSupported{serverFeature("HASH")};
+            if (hashSupported)
+            {
+                // Reply "213 <algorithm> <range> <hash> <file>"
+                ftpCommand("HASH " + remoteFilePath);
+                if (m_commandStatusCode != 213)
+                {
+                    return (false);
+                }
+                std::string algorithm, range, hash;
+                std::istringstream hashReply{m_commandResponse.substr(4)};
+                hashReply >> algorithm >> range >> hash;
+                std::transform(algorithm.begin(), algorithm.end(), algorithm.begin(), [](unsigned char ch) { return std::toupper(ch); });
+                if (algorithm == "CRC32")
+                {
+                    std::uint32_t crc{0};
+                    return (parseCRC(hash, crc) && (crc == localFileCRC(localFilePath, localFileSize(localFilePath))));
+                }
+                const EVP_MD *digestType = EVP_get_digestbyname(algorithm.c_str());
+                if (digestType != nullptr)
+                {
+                    std::transform(hash.begin(), hash.end(), hash.begin(), [](unsigned char ch) { return std::tolower(ch); });
+                    return (hash == localFileHash(localFilePath, digestType));
+                }
+            }
+            // No HASH or its algorithm cannot be computed locally
+            if (serverFeature("XCRC"))
+            {
+                ftpCommand("XCRC " + remoteFilePath);
+                if (m_commandStatusCode == 250)
+                {
+                    return (responseCRCMatches(localFilePath, localFileSize(localFilePath)));
+                }
+                return (false);
+            }
+            if (hashSupported)
+            {
+                return (false);
+            }
+            throw std::runtime_error("Server does not support file verification.");
+        }
+        catch (const std::exception &e)
+        {
+            throw Exception(e.what());
+        }
+    }
+    //
     // Transfer a file to the server from a local file.
     //
     std::uint16_t CFTP::putFile(const std::string &remoteFilePath, const std::string &localFilePath)
@@ -581,10 +1554,62 @@ namespace Antik::FTP
         }
     }
     //
-    // Produce a file information list for the directory passed in or for the current
-    // working directory if none is.
+    // Produce a file information list for the directory passed in or for the current
+    // working directory if none is.
+    //
+    std::uint16_t CFTP::listDirectory(const std::string &directoryPath, std::string &listOutput)
+    {
+        try
+        {
+            if (!m_connected)
+            {
+                throw std::logic_error("Already connected to a server.");
+            }
+            listOutput.clear();
+            if (sendTransferMode())
+            {
+                ftpCommand("MLSD " + directoryPath);
+                transferOnDataChannel(listOutput);
+            }
+            return (m_commandStatusCode);
+        }
+        catch (const std::exception &e)
+        {
+            throw Exception(e.what());
+        }
+    }
+    //
+    // Produce file information for the file passed in or for the current
+    // working directory if none is. Note: Reply is sent on control and not
+    // the data channel.
+    //
+    std::uint16_t CFTP::listFile(const std::string &filePath, std::string &listOutput)
+    {
+        try
+        {
+            if (!m_connected)
+            {
+                throw std::logic_error("Already connected to a server.");
+            }
+            listOutput.clear();
+            ftpCommand("MLST " + filePath);
+            if (m_commandStatusCode == 250)
+            {
+                listOutput = m_commandResponse.substr(m_commandResponse.find('\n') + 1);
+                listOutput = listOutput.substr(0, listOutput.find('\r'));
+            }
+            return (m_commandStatusCode);
+        }
+        catch (const std::exception &e)
+        {
+            throw Exception(e.what());
+        }
+    }
+    //
+    // Produce file information (parsed from MLSD facts) for each file in the directory
+    // passed in or in the current working directory if none is.
     //
-    std::uint16_t CFTP::listDirectory(const std::string &directoryPath, std::string &listOutput)
+    std::uint16_t CFTP::listDirectory(const std::string &directoryPath, FileInfoList &fileInfoList)
     {
         try
         {
@@ -592,11 +1617,25 @@ namespace Antik::FTP
             {
                 throw std::logic_error("Already connected to a server.");
             }
-            listOutput.clear();
+            fileInfoList.clear();
             if (sendTransferMode())
             {
+                std::string listOutput;
                 ftpCommand("MLSD " + directoryPath);
                 transferOnDataChannel(listOutput);
+                if (m_commandStatusCode == 226)
+                {
+                    std::string entry;
+                    std::istringstream listOutputStream{listOutput};
+                    while (std::getline(listOutputStream, entry, '\n'))
+                    {
+                        if (!entry.empty() && (entry != "\r"))
+                        {
+                            fileInfoList.emplace_back();
+                            parseFacts(entry, fileInfoList.back());
+                        }
+                    }
+                }
             }
             return (m_commandStatusCode);
         }
@@ -606,11 +1645,10 @@ namespace Antik::FTP
         }
     }
     //
-    // Produce file information for the file passed in or for the current
-    // working directory if none is. Note: Reply is sent on control and not
-    // the data channel.
+    // Produce file information (parsed from MLST facts) for the file passed in or for
+    // the current working directory if none is.
     //
-    std::uint16_t CFTP::listFile(const std::string &filePath, std::string &listOutput)
+    std::uint16_t CFTP::listFile(const std::string &filePath, FileInfo &fileInfo)
     {
         try
         {
@@ -618,12 +1656,12 @@ namespace Antik::FTP
             {
                 throw std::logic_error("Already connected to a server.");
             }
-            listOutput.clear();
+            fileInfo = FileInfo();
             ftpCommand("MLST " + filePath);
             if (m_commandStatusCode == 250)
             {
-                listOutput = m_commandResponse.substr(m_commandResponse.find('\n') + 1);
-                listOutput = listOutput.substr(0, listOutput.find('\r'));
+                std::string entry{m_commandResponse.substr(m_commandResponse.find('\n') + 1)};
+                parseFacts(entry.substr(0, entry.find('\n')), fileInfo);
             }
             return (m_commandStatusCode);
         }
@@ -633,6 +1671,13 @@ namespace Antik::FTP
         }
     }
     //
+    // Return true if server supports MLST/MLSD (advertised as feature "MLST").
+    //
+    bool CFTP::isMLSTSupported()
+    {
+        return (serverFeature("MLST"));
+    }
+    //
     // Make remote FTP server directory
     //
     std::uint16_t CFTP::makeDirectory(const std::string &directoryName)
@@ -684,7 +1729,7 @@ namespace Antik::FTP
             ftpCommand("SIZE " + fileName);
             if (m_commandStatusCode == 213)
             {
-                fileSize = std::stoi(m_commandResponse.substr(m_commandResponse.find(' ') + 1));
+                fileSize = std::stoull(m_commandResponse.substr(m_commandResponse.find(' ') + 1));
             }
             return (m_commandStatusCode);
         }
@@ -694,6 +1739,42 @@ namespace Antik::FTP
         }
     }
     //
+    // Fetch the size of each of a list of files (commands pipelined). Returns the status
+    // code for each file; its size is only valid if that is 213.
+    //
+    std::vector<std::uint16_t> CFTP::fileSize(const FileList &fileNames, std::vector<size_t> &fileSizes)
+    {
+        try
+        {
+            if (!m_connected)
+            {
+                throw std::logic_error("Already connected to a server.");
+            }
+            std::vector<std::string> commands;
+            std::vector<CommandReply> replies;
+            std::vector<std::uint16_t> statusCodes;
+            for (auto &fileName : fileNames)
+            {
+                commands.push_back("SIZE " + fileName);
+            }
+            ftpCommands(commands, replies);
+            fileSizes.assign(fileNames.size(), 0);
+            for (std::size_t fileNo = 0; fileNo < replies.size(); fileNo++)
+            {
+                if (replies[fileNo].statusCode == 213)
+                {
+                    fileSizes[fileNo] = std::stoull(replies[fileNo].response.substr(replies[fileNo].response.find(' ') + 1));
+                }
+                statusCodes.push_back(replies[fileNo].statusCode);
+            }
+            return (statusCodes);
+        }
+        catch (const std::exception &e)
+        {
+            throw Exception(e.what());
+        }
+    }
+    //
     // Delete remote FTP server file
     //
     std::uint16_t CFTP::deleteFile(const std::string &fileName)
@@ -809,6 +1890,42 @@ namespace Antik::FTP
         }
     }
     //
+    // Fetch last modified date/time of each of a list of files (commands pipelined).
+    // Returns the status code for each file; its date/time is only valid if that is 213.
+    //
+    std::vector<std::uint16_t> CFTP::getModifiedDateTime(const FileList &filePaths, std::vector<DateTime> &modifiedDateTimes)
+    {
+        try
+        {
+            if (!m_connected)
+            {
+                throw std::logic_error("Already connected to a server.");
+            }
+            std::vector<std::string> commands;
+            std::vector<CommandReply> replies;
+            std::vector<std::uint16_t> statusCodes;
+            for (auto &filePath : filePaths)
+            {
+                commands.push_back("MDTM " + filePath);
+            }
+            ftpCommands(commands, replies);
+            modifiedDateTimes.assign(filePaths.size(), DateTime());
+            for (std::size_t fileNo = 0; fileNo < replies.size(); fileNo++)
+            {
+                if (replies[fileNo].statusCode == 213)
+                {
+                    modifiedDateTimes[fileNo] = DateTime(replies[fileNo].response.substr(replies[fileNo].response.find(' ') + 1));
+                }
+                statusCodes.push_back(replies[fileNo].statusCode);
+            }
+            return (statusCodes);
+        }
+        catch (const std::exception &e)
+        {
+            throw Exception(e.what());
+        }
+    }
+    //
     // Return true if passed in file is a directory false for a file.
     //
     bool CFTP::isDirectory(const std::string &fileName)
@@ -823,23 +1940,14 @@ namespace Antik::FTP
             ftpCommand("MLST " + fileName);
             if (m_commandStatusCode == 250)
             {
-                size_t dirPosition = m_commandResponse.find("Type=dir;");
-                if (dirPosition != std::string::npos)
-                {
-                    return (true);
-                }
+                return (mlstIsDirectory(m_commandResponse));
             }
             else if (m_commandStatusCode == 500)
             {
                 ftpCommand("STAT " + fileName);
                 if ((m_commandStatusCode == 213) || (m_commandStatusCode == 212))
                 {
-                    size_t dirPosition = m_commandResponse.find("\r\n") + 2;
-                    if ((dirPosition != std::string::npos) &&
-                        (m_commandResponse[dirPosition] == 'd'))
-                    {
-                        return (true);
-                    }
+                    return (statIsDirectory(m_commandResponse));
                 }
             }
             return (false);
@@ -869,16 +1977,9 @@ namespace Antik::FTP
             else if (m_commandStatusCode == 500)
             {
                 ftpCommand("STAT " + fileName);
-                // If 212/213 returned check the response is not empty; if it is
-                // file does not exist.
                 if ((m_commandStatusCode == 213) || (m_commandStatusCode == 212))
                 {
-                    size_t statusCodePosition = m_commandResponse.find("\r\n") + 2;
-                    if ((statusCodePosition != std::string::npos) &&
-                        (m_commandResponse[statusCodePosition] != '2'))
-                    {
-                        return (true);
-                    }
+                    return (statFileExists(m_commandResponse));
                 }
             }
             return (false);
@@ -889,6 +1990,125 @@ namespace Antik::FTP
         }
     }
     //
+    // Return for each of a list of files true if it is a directory (commands pipelined).
+    //
+    std::vector<bool> CFTP::isDirectory(const FileList &fileNames)
+    {
+        try
+        {
+            if (!m_connected)
+            {
+                throw std::logic_error("Already connected to a server.");
+            }
+            std::vector<bool> directories(fileNames.size(), false);
+            std::vector<std::string> commands;
+            std::vector<CommandReply> replies;
+            std::vector<std::size_t> statFiles;
+            // Try MLST first then STAT for files the server does not support it on
+            for (auto &fileName : fileNames)
+            {
+                commands.push_back("MLST " + fileName);
+            }
+            ftpCommands(commands, replies);
+            commands.clear();
+            for (std::size_t fileNo = 0; fileNo < replies.size(); fileNo++)
+            {
+                if (replies[fileNo].statusCode == 250)
+                {
+                    directories[fileNo] = mlstIsDirectory(replies[fileNo].response);
+                }
+                else if (replies[fileNo].statusCode == 500)
+                {
+                    commands.push_back("STAT " + fileNames[fileNo]);
+                    statFiles.push_back(fileNo);
+                }
+            }
+            ftpCommands(commands, replies);
+            for (std::size_t statNo = 0; statNo < replies.size(); statNo++)
+            {
+                if ((replies[statNo].statusCode == 213) || (replies[statNo].statusCode == 212))
+                {
+                    directories[statFiles[statNo]] = statIsDirectory(replies[statNo].response);
+                }
+            }
+            return (directories);
+        }
+        catch (const std::exception &e)
+        {
+            throw Exception(e.what());
+        }
+    }
+    //
+    // Return for each of a list of files true if it exists (commands pipelined).
+    //
+    std::vector<bool> CFTP::fileExists(const FileList &fileNames)
+    {
+        try
+        {
+            if (!m_connected)
+            {
+                throw std::logic_error("Already connected to a server.");
+            }
+            std::vector<bool> exists(fileNames.size(), false);
+            std::vector<std::string> commands;
+            std::vector<CommandReply> replies;
+            std::vector<std::size_t> statFiles;
+            // Try MLST first then STAT for files the server does not support it on
+            for (auto &fileName : fileNames)
+            {
+                commands.push_back("MLST " + fileName);
+            }
+            ftpCommands(commands, replies);
+            commands.clear();
+            for (std::size_t fileNo = 0; fileNo < replies.size(); fileNo++)
+            {
+                if (replies[fileNo].statusCode == 250)
+                {
+                    exists[fileNo] = true;
+                }
+                else if (replies[fileNo].statusCode == 500)
+                {
+                    commands.push_back("STAT " + fileNames[fileNo]);
+                    statFiles.push_back(fileNo);
+                }
+            }
+            ftpCommands(commands, replies);
+            for (std::size_t statNo = 0; statNo < replies.size(); statNo++)
+            {
+                if ((replies[statNo].statusCode == 213) || (replies[statNo].statusCode == 212))
+                {
+                    exists[statFiles[statNo]] = statFileExists(replies[statNo].response);
+                }
+            }
+            return (exists);
+        }
+        catch (const std::exception &e)
+        {
+            throw Exception(e.what());
+        }
+    }
+    //
+    // Send a list of commands without waiting for the reply to each before sending the
+    // next (replies returned in command order). Only commands answered solely on the
+    // control channel may be pipelined. Returns the status code of the last reply.
+    //
+    std::uint16_t CFTP::pipelineCommands(const std::vector<std::string> &commands, std::vector<CommandReply> &replies)
+    {
+        try
+        {
+            if (!m_connected)
+            {
+                throw std::logic_error("Already connected to a server.");
+            }
+            ftpCommands(commands, replies);
+            return (m_commandStatusCode);
+        }
+        catch (const std::exception &e)
+        {
+            throw Exception(e.what());
+        }
+    }
+    //
     // Move up a directory
     //
     std::uint16_t CFTP::cdUp()
@@ -908,6 +2128,26 @@ namespace Antik::FTP
         }
     }
     //
+    // Send no operation command; keeps an idle control connection from being timed
+    // out by the server (or any firewall/NAT between) and checks that it is alive.
+    //
+    std::uint16_t CFTP::noOperation()
+    {
+        try
+        {
+            if (!m_connected)
+            {
+                throw std::logic_error("Already connected to a server.");
+            }
+            ftpCommand("NOOP");
+            return (m_commandStatusCode);
+        }
+        catch (const std::exception &e)
+        {
+            throw Exception(e.what());
+        }
+    }
+    //
     // BinaryTransfer == true set binary transfer otherwise set ASCII
     //
     void CFTP::setBinaryTransfer(bool binaryTransfer)
@@ -964,12 +2204,194 @@ namespace Antik::FTP
         }
     }
     //
+    // Return true if server lists a feature; case insensitive and either the whole feature
+    // line or its leading words (eg. "MLST" matches "MLST type*;size*;", "REST STREAM"
+    // matches "REST STREAM").
+    //
+    bool CFTP::serverFeature(const std::string &feature)
+    {
+        auto equalNoCase = [](unsigned char lhs, unsigned char rhs) { return (std::toupper(lhs) == std::toupper(rhs)); };
+        for (auto &serverFeature : getServerFeatures())
+        {
+            if ((serverFeature.size() >= feature.size()) &&
+                std::equal(feature.begin(), feature.end(), serverFeature.begin(), equalNoCase) &&
+                ((serverFeature.size() == feature.size()) || (serverFeature[feature.size()] == ' ')))
+            {
+                return (true);
+            }
+        }
+        return (false);
+    }
+    //
+    // Connect to server and login asynchronously.
+    //
+    void CFTP::asyncConnect(AsyncHandler handler)
+    {
+        try
+        {
+            if (m_connected)
+            {
+                throw std::logic_error("Already connected to a server.");
+            }
+            asyncStart(handler);
+            asyncStep([this]() {
+                m_ioBuffer = std::make_unique<char[]>(m_ioBufferSize);
+                m_dataChannelSocket.setHostAddress(Antik::Network::CSocket::localIPAddress());
+                m_controlChannelSocket.setHostAddress(m_serverName);
+                m_controlChannelSocket.setHostPort(m_serverPort);
+                m_controlBuffer.clear();
+                m_controlBufferPosition = 0;
+                m_controlChannelSocket.asyncConnect([this](const boost::system::error_code &connectError) {
+                    asyncStep([&]() {
+                        asyncCheck(connectError);
+                        asyncFtpResponse([this]() {
+                            if (m_commandStatusCode != 220)
+                            {
+                                asyncComplete(nullptr);
+                                return;
+                            }
+                            asyncFtpCommand("FEAT", [this]() {
+                                parseServerFeatures();
+                                if (m_sslEnabled)
+                                {
+                                    asyncSecureConnection();
+                                }
+                                else
+                                {
+                                    asyncLogin();
+                                }
+                            });
+                        });
+                    });
+                });
+            });
+        }
+        catch (const std::exception &e)
+        {
+            throw Exception(e.what());
+        }
+    }
+    //
+    // Disconnect from server asynchronously.
+    //
+    void CFTP::asyncDisconnect(AsyncHandler handler)
+    {
+        try
+        {
+            if (!m_connected)
+            {
+                throw std::logic_error("Already connected to a server.");
+            }
+            asyncStart(handler);
+            asyncStep([this]() {
+                asyncFtpCommand("QUIT", [this]() {
+                    m_connected = false;
+                    m_controlChannelSocket.asyncClose([this](const boost::system::error_code &closeError) {
+                        asyncStep([&]() {
+                            resetConnection();
+                            asyncCheck(closeError);
+                            asyncComplete(nullptr);
+                        });
+                    });
+                });
+            });
+        }
+        catch (const std::exception &e)
+        {
+            throw Exception(e.what());
+        }
+    }
+    //
+    // Transfer a file from the server to a local file asynchronously.
+    //
+    void CFTP::asyncGetFile(const std::string &remoteFilePath, const std::string &localFilePath, AsyncHandler handler)
+    {
+        try
+        {
+            if (!m_connected)
+            {
+                throw std::logic_error("Already connected to a server.");
+            }
+            asyncStart(handler);
+            asyncStep([&]() {
+                auto localFile{std::make_shared<std::ofstream>(localFilePath, std::ofstream::binary)};
+                if (!*localFile)
+                {
+                    m_commandStatusCode = 550;
+                    throw std::runtime_error("Local file " + localFilePath + " could not be created.");
+                }
+                asyncTransferOnDataChannel("RETR " + remoteFilePath, [this, localFile](AsyncStep next) { asyncDownloadFile(localFile, next); });
+            });
+        }
+        catch (const std::exception &e)
+        {
+            throw Exception(e.what());
+        }
+    }
+    //
+    // Transfer a local file to the server asynchronously.
+    //
+    void CFTP::asyncPutFile(const std::string &remoteFilePath, const std::string &localFilePath, AsyncHandler handler)
+    {
+        try
+        {
+            if (!m_connected)
+            {
+                throw std::logic_error("Already connected to a server.");
+            }
+            asyncStart(handler);
+            asyncStep([&]() {
+                auto localFile{std::make_shared<std::ifstream>(localFilePath, std::ifstream::binary)};
+                if (!*localFile)
+                {
+                    m_commandStatusCode = 550;
+                    throw std::runtime_error("Local file " + localFilePath + " does not exist.");
+                }
+                asyncTransferOnDataChannel("STOR " + remoteFilePath, [this, localFile](AsyncStep next) { asyncUploadFile(localFile, next); });
+            });
+        }
+        catch (const std::exception &e)
+        {
+            throw Exception(e.what());
+        }
+    }
+    //
+    // Produce a directory listing asynchronously for the file/directory passed in or for
+    // the current working directory if none is. The listing string must remain valid
+    // until the command completes.
+    //
+    void CFTP::asyncList(const std::string &directoryPath, std::string &listOutput, AsyncHandler handler)
+    {
+        try
+        {
+            if (!m_connected)
+            {
+                throw std::logic_error("Already connected to a server.");
+            }
+            listOutput.clear();
+            asyncStart(handler);
+            asyncStep([&]() {
+                asyncTransferOnDataChannel("LIST " + directoryPath, [this, &listOutput](AsyncStep next) { asyncDownloadCommandResponse(listOutput, next); });
+            });
+        }
+        catch (const std::exception &e)
+        {
+            throw Exception(e.what());
+        }
+    }
+    //
     // Main CFTP object constructor.
     //
     CFTP::CFTP()
     {
     }
     //
+    // CFTP object constructor for a session sharing an io service.
+    //
+    CFTP::CFTP(boost::asio::io_service &ioService) : m_controlChannelSocket{ioService}, m_dataChannelSocket{ioService}
+    {
+    }
+    //
     // CFTP Destructor
     //
     CFTP::~CFTP()
@@ -0,0 +1,484 @@
+//
+// Class: CFTPPool
+//
+// Description: A pool of connected and logged in CFTP sessions to one FTP server so
+// that frequent small jobs do not each pay for connect, TLS negotiation and login.
+// A session is checked out as a handle that returns it to the pool when destroyed.
+// Idle sessions are kept warm with NOOP keepalives (and closed after being idle too
+// long if required) by a background thread, checked on checkout by changing back to
+// the login (home) directory and transparently reconnected if they have been dropped
+// by the server.
+//
+// Dependencies:   C20++        - Language standard features used.
+//                 CFTP         - FTP sessions pooled.
+//
+// =================
+// CLASS DEFINITIONS
+// =================
+#include "CFTPPool.hpp"
+// ====================
+// CLASS IMPLEMENTATION
+// ====================
+//
+// C++ STL
+//
+#include <algorithm>
+// =======
+// IMPORTS
+// =======
+// =========
+// NAMESPACE
+// =========
+namespace Antik::FTP
+{
+    // ===========================
+    // PRIVATE TYPES AND CONSTANTS
+    // ===========================
+    // ==========================
+    // PUBLIC TYPES AND CONSTANTS
+    // ==========================
+    // ========================
+    // PRIVATE STATIC VARIABLES
+    // ========================
+    // =======================
+    // PUBLIC STATIC VARIABLES
+    // =======================
+    // ===============
+    // PRIVATE METHODS
+    // ===============
+    //
+    // Connect and login a new session using pool settings; recording the login
+    // directory of the first so that sessions can be reset to it on checkout.
+    //
+    std::unique_ptr<CFTP> CFTPPool::openSession(void)
+    {
+        auto ftpServer{std::make_unique<CFTP>()};
+        ftpServer->copySettings(m_settings);
+        if (ftpServer->connect() != 230)
+        {
+            throw Exception("Unable to login to server [" + ftpServer->getCommandResponse() + "]");
+        }
+        ftpServer->setBinaryTransfer(m_options.binaryTransfer);
+        std::string homeDirectory;
+        if (ftpServer->getCurrentWoringDirectory(homeDirectory) == 257)
+        {
+            std::unique_lock<std::mutex> locker(m_poolMutex);
+            if (m_homeDirectory.empty())
+            {
+                m_homeDirectory = homeDirectory;
+            }
+        }
+        return (ftpServer);
+    }
+    //
+    // Reconnect a session found dropped. If that fails it is forgotten (so that
+    // another may be opened in its place later) and the failure passed on.
+    //
+    std::unique_ptr<CFTP> CFTPPool::reopenSession(void)
+    {
+        try
+        {
+            auto ftpServer{openSession()};
+            std::unique_lock<std::mutex> locker(m_poolMutex);
+            m_reconnectCount++;
+            return (ftpServer);
+        }
+        catch (const std::exception &e)
+        {
+            sessionClosed();
+            throw;
+        }
+    }
+    //
+    // Return true if an idle session is still alive; resetting it for reuse by returning
+    // to the home directory (or just sending a NOOP if that is not known) and restoring
+    // the pool transfer type.
+    //
+    bool CFTPPool::validSession(CFTP &ftpServer)
+    {
+        try
+        {
+            std::string homeDirectory;
+            {
+                std::unique_lock<std::mutex> locker(m_poolMutex);
+                homeDirectory = m_homeDirectory;
+            }
+            if (!homeDirectory.empty())
+            {
+                if (ftpServer.changeWorkingDirectory(homeDirectory) != 250)
+                {
+                    return (false);
+                }
+            }
+            else if (ftpServer.noOperation() != 200)
+            {
+                return (false);
+            }
+            if (ftpServer.isBinaryTransfer() != m_options.binaryTransfer)
+            {
+                ftpServer.setBinaryTransfer(m_options.binaryTransfer);
+            }
+            return (ftpServer.isBinaryTransfer() == m_options.binaryTransfer);
+        }
+        catch (const std::exception &e)
+        {
+            return (false);
+        }
+    }
+    //
+    // Return a session to the pool; closing it instead if it is to be discarded, no
+    // longer connected or the pool is being destroyed.
+    //
+    void CFTPPool::checkin(std::unique_ptr<CFTP> ftpServer, bool discard)
+    {
+        if (!ftpServer)
+        {
+            return;
+        }
+        if (discard || !ftpServer->isConnected())
+        {
+            // Dropped without QUIT as a discarded session may not respond
+            ftpServer.reset();
+            sessionClosed();
+            return;
+        }
+        std::unique_lock<std::mutex> locker(m_poolMutex);
+        if (!m_running)
+        {
+            locker.unlock();
+            try
+            {
+                ftpServer->disconnect();
+            }
+            catch (const std::exception &e)
+            {
+            }
+            ftpServer.reset();
+            sessionClosed();
+            return;
+        }
+        auto now{Clock::now()};
+        m_idleSessions.push_back({std::move(ftpServer), now, now});
+        m_sessionAvailable.notify_one();
+    }
+    //
+    // Forget a session that has been closed and wake anybody waiting to open one (or
+    // the destructor waiting for checked out sessions to be returned).
+    //
+    void CFTPPool::sessionClosed(void)
+    {
+        std::unique_lock<std::mutex> locker(m_poolMutex);
+        m_sessionCount--;
+        m_sessionAvailable.notify_all();
+    }
+    //
+    // Return time between keepalive/idle timeout checks (half the shortest enabled).
+    //
+    std::chrono::milliseconds CFTPPool::keepAliveTick(void) const
+    {
+        std::chrono::milliseconds tick{0};
+        for (auto interval : {m_options.keepAlive, m_options.maxIdle})
+        {
+            if ((interval.count() > 0) && ((tick.count() == 0) || (interval < tick)))
+            {
+                tick = interval;
+            }
+        }
+        return (std::max(tick / 2, std::chrono::milliseconds(1)));
+    }
+    //
+    // Keepalive loop. Idle sessions past the maximum idle time are closed and those not
+    // active for the keepalive interval are taken out of the pool and sent a NOOP; any
+    // that fail are reconnected (or forgotten if that fails) before being put back in
+    // order of last use.
+    //
+    void CFTPPool::keepAlive(void)
+    {
+        std::unique_lock<std::mutex> locker(m_poolMutex);
+        while (m_running)
+        {
+            m_keepAliveWaiting.wait_for(locker, keepAliveTick());
+            if (!m_running)
+            {
+                break;
+            }
+            auto now{Clock::now()};
+            std::vector<IdleSession> expiredSessions;
+            std::vector<IdleSession> staleSessions;
+            for (auto idleSession = m_idleSessions.begin(); idleSession != m_idleSessions.end();)
+            {
+                if ((m_options.maxIdle.count() > 0) && (now - idleSession->lastUsed >= m_options.maxIdle))
+                {
+                    expiredSessions.push_back(std::move(*idleSession));
+                    idleSession = m_idleSessions.erase(idleSession);
+                }
+                else if ((m_options.keepAlive.count() > 0) && (now - idleSession->lastActive >= m_options.keepAlive))
+                {
+                    staleSessions.push_back(std::move(*idleSession));
+                    idleSession = m_idleSessions.erase(idleSession);
+                }
+                else
+                {
+                    idleSession++;
+                }
+            }
+            if (expiredSessions.empty() && staleSessions.empty())
+            {
+                continue;
+            }
+            locker.unlock();
+            for (auto &expiredSession : expiredSessions)
+            {
+                try
+                {
+                    expiredSession.ftpServer->disconnect();
+                }
+                catch (const std::exception &e)
+                {
+                }
+                expiredSession.ftpServer.reset();
+                sessionClosed();
+            }
+            for (auto &staleSession : staleSessions)
+            {
+                bool alive{false};
+                try
+                {
+                    alive = (staleSession.ftpServer->noOperation() == 200);
+                }
+                catch (const std::exception &e)
+                {
+                }
+                if (!alive)
+                {
+                    staleSession.ftpServer.reset();
+                    try
+                    {
+                        staleSession.ftpServer = reopenSession();
+                    }
+                    catch (const std::exception &e)
+                    {
+                    }
+                }
+                staleSession.lastActive = Clock::now();
+            }
+            locker.lock();
+            for (auto &staleSession : staleSessions)
+            {
+                if (staleSession.ftpServer)
+                {
+                    auto position = std::upper_bound(m_idleSessions.begin(), m_idleSessions.end(), staleSession.lastUsed,
+                                                     [](const Clock::time_point &lastUsed, const IdleSession &idleSession) { return (lastUsed < idleSession.lastUsed); });
+                    m_idleSessions.insert(position, std::move(staleSession));
+                    m_sessionAvailable.notify_one();
+                }
+            }
+        }
+    }
+    // ==============
+    // PUBLIC METHODS
+    // ==============
+    //
+    // Session handle constructor (checked out session).
+    //
+    CFTPPool::Session::Session(CFTPPool *pool, std::unique_ptr<CFTP> ftpServer) : m_pool{pool}, m_ftpServer{std::move(ftpServer)}
+    {
+    }
+    CFTPPool::Session::Session(Session &&other) noexcept : m_pool{other.m_pool}, m_ftpServer{std::move(other.m_ftpServer)}, m_discard{other.m_discard}
+    {
+        other.m_pool = nullptr;
+    }
+    CFTPPool::Session &CFTPPool::Session::operator=(Session &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            m_pool = other.m_pool;
+            m_ftpServer = std::move(other.m_ftpServer);
+            m_discard = other.m_discard;
+            other.m_pool = nullptr;
+        }
+        return (*this);
+    }
+    //
+    // Session handle destructor; session returned to pool.
+    //
+    CFTPPool::Session::~Session()
+    {
+        release();
+    }
+    CFTP *CFTPPool::Session::operator->() const
+    {
+        return (m_ftpServer.get());
+    }
+    CFTP &CFTPPool::Session::operator*() const
+    {
+        return (*m_ftpServer);
+    }
+    CFTPPool::Session::operator bool() const
+    {
+        return (static_cast<bool>(m_ftpServer));
+    }
+    //
+    // Mark session to be closed rather than returned to the pool (eg. after a failure
+    // that may have left it in an unknown state).
+    //
+    void CFTPPool::Session::discard()
+    {
+        m_discard = true;
+    }
+    //
+    // Return session to the pool (handle then empty).
+    //
+    void CFTPPool::Session::release()
+    {
+        if (m_pool && m_ftpServer)
+        {
+            try
+            {
+                m_pool->checkin(std::move(m_ftpServer), m_discard);
+            }
+            catch (const std::exception &e)
+            {
+            }
+        }
+        m_pool = nullptr;
+        m_ftpServer.reset();
+        m_discard = false;
+    }
+    //
+    // Main CFTPPool object constructor (default pool options).
+    //
+    CFTPPool::CFTPPool(const CFTP &ftpServer) : CFTPPool(ftpServer, Options())
+    {
+    }
+    //
+    // CFTPPool object constructor. Sessions use server, account and transfer
+    // settings copied from the passed CFTP; they are opened on demand.
+    //
+    CFTPPool::CFTPPool(const CFTP &ftpServer, const Options &options) : m_options{options}
+    {
+        m_settings.copySettings(ftpServer);
+        m_options.maxSessions = std::max(m_options.maxSessions, std::size_t(1));
+        if ((m_options.keepAlive.count() > 0) || (m_options.maxIdle.count() > 0))
+        {
+            m_keepAliveThread = std::make_unique<std::thread>(&CFTPPool::keepAlive, this);
+        }
+    }
+    //
+    // CFTPPool Destructor. Idle sessions are logged out and any still checked out waited
+    // for; they are logged out as their handles are released. Sessions being reconnected
+    // (on checkout or by keepalive) are counted as open so are also waited for.
+    //
+    CFTPPool::~CFTPPool()
+    {
+        {
+            std::unique_lock<std::mutex> locker(m_poolMutex);
+            m_running = false;
+            m_keepAliveWaiting.notify_all();
+        }
+        if (m_keepAliveThread)
+        {
+            m_keepAliveThread->join();
+        }
+        closeIdleSessions();
+        std::unique_lock<std::mutex> locker(m_poolMutex);
+        m_sessionAvailable.wait(locker, [this]() { return (m_sessionCount == 0); });
+    }
+    //
+    // Check out a connected and logged in session; the most recently used idle one if
+    // any (validated if required and reconnected if it has been dropped) otherwise a
+    // new one if the pool is not at its maximum size. If it is then wait for a session
+    // to be returned.
+    //
+    CFTPPool::Session CFTPPool::checkout(void)
+    {
+        try
+        {
+            std::unique_ptr<CFTP> ftpServer;
+            {
+                std::unique_lock<std::mutex> locker(m_poolMutex);
+                m_sessionAvailable.wait(locker, [this]() { return (!m_idleSessions.empty() || (m_sessionCount < m_options.maxSessions)); });
+                if (!m_idleSessions.empty())
+                {
+                    ftpServer = std::move(m_idleSessions.back().ftpServer);
+                    m_idleSessions.pop_back();
+                }
+                else
+                {
+                    m_sessionCount++;
+                }
+            }
+            if (!ftpServer)
+            {
+                try
+                {
+                    ftpServer = openSession();
+                }
+                catch (const std::exception &e)
+                {
+                    sessionClosed();
+                    throw;
+                }
+            }
+            else if (m_options.validateOnCheckout && !validSession(*ftpServer))
+            {
+                ftpServer.reset();
+                ftpServer = reopenSession();
+            }
+            return (Session(this, std::move(ftpServer)));
+        }
+        catch (const std::exception &e)
+        {
+            throw Exception(e.what());
+        }
+    }
+    //
+    // Logout and close all idle sessions.
+    //
+    void CFTPPool::closeIdleSessions(void)
+    {
+        std::vector<IdleSession> idleSessions;
+        {
+            std::unique_lock<std::mutex> locker(m_poolMutex);
+            idleSessions = std::move(m_idleSessions);
+            m_idleSessions.clear();
+        }
+        for (auto &idleSession : idleSessions)
+        {
+            try
+            {
+                idleSession.ftpServer->disconnect();
+            }
+            catch (const std::exception &e)
+            {
+            }
+            idleSession.ftpServer.reset();
+            sessionClosed();
+        }
+    }
+    //
+    // Return number of sessions open (idle and checked out).
+    //
+    std::size_t CFTPPool::getSessionCount(void) const
+    {
+        std::unique_lock<std::mutex> locker(m_poolMutex);
+        return (m_sessionCount);
+    }
+    //
+    // Return number of sessions idle in pool.
+    //
+    std::size_t CFTPPool::getIdleSessionCount(void) const
+    {
+        std::unique_lock<std::mutex> locker(m_poolMutex);
+        return (m_idleSessions.size());
+    }
+    //
+    // Return number of dropped sessions reconnected.
+    //
+    std::size_t CFTPPool::getReconnectCount(void) const
+    {
+        std::unique_lock<std::mutex> locker(m_poolMutex);
+        return (m_reconnectCount);
+    }
+} // namespace Antik::FTP
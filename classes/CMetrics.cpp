@@ -0,0 +1,320 @@
+//
+// Class: CMetrics
+//
+// Description: Lightweight metrics registry of counters, gauges and histograms that
+// may be updated lock free from any thread (only registering a metric takes a lock).
+// Histograms use HDR style log-linear buckets so that values covering many orders of
+// magnitude (for example latencies in microseconds) are recorded in a fixed number
+// of buckets to a bounded relative error. The metrics of other objects may be included
+// under a name prefix so that, for example, a task exports the metrics of its watcher
+// and file event notifier as well as its own. A snapshot of all metrics can be taken
+// and exported as text (one "name value" per line) or JSON.
+//
+// Dependencies: C20++               - Language standard features used.
+//
+// =================
+// CLASS DEFINITIONS
+// =================
+#include "CMetrics.hpp"
+// ====================
+// CLASS IMPLEMENTATION
+// ====================
+//
+// C++ STL
+//
+#include <sstream>
+#include <algorithm>
+// =========
+// NAMESPACE
+// =========
+namespace Antik::File
+{
+    // ===========================
+    // PRIVATE TYPES AND CONSTANTS
+    // ===========================
+    // ==========================
+    // PUBLIC TYPES AND CONSTANTS
+    // ==========================
+    // ========================
+    // PRIVATE STATIC VARIABLES
+    // ========================
+    // =======================
+    // PUBLIC STATIC VARIABLES
+    // =======================
+    // ===============
+    // PRIVATE METHODS
+    // ===============
+    //
+    // Raise gauge high water mark to value if higher.
+    //
+    void CMetrics::Gauge::updateMaximum(std::int64_t value) noexcept
+    {
+        std::int64_t maximum{m_maximum.load(std::memory_order_relaxed)};
+        while ((value > maximum) && !m_maximum.compare_exchange_weak(maximum, value, std::memory_order_relaxed))
+        {
+        }
+    }
+    //
+    // Value at passed percentile from a copy of histogram bucket counts (reported as
+    // the highest value of its bucket but no more than the largest value recorded).
+    //
+    std::uint64_t CMetrics::percentile(const std::vector<std::uint64_t> &bucketCounts, std::uint64_t count, std::uint64_t maximum, double percent)
+    {
+        if (count == 0)
+        {
+            return (0);
+        }
+        std::uint64_t rank{static_cast<std::uint64_t>((percent / 100.0) * static_cast<double>(count) + 0.5)};
+        rank = std::clamp(rank, static_cast<std::uint64_t>(1), count);
+        std::uint64_t seen{0};
+        for (std::size_t index = 0; index < bucketCounts.size(); index++)
+        {
+            if ((seen += bucketCounts[index]) >= rank)
+            {
+                return (std::min(Histogram::bucketHighest(index), maximum));
+            }
+        }
+        return (maximum);
+    }
+    //
+    // Add snapshot of metrics (and those of included sources) to passed snapshot.
+    //
+    void CMetrics::snapshot(const std::string &prefix, Snapshot &metricsSnapshot) const
+    {
+        std::vector<std::pair<std::string, std::shared_ptr<CMetrics>>> sources;
+        {
+            std::unique_lock<std::mutex> locker(m_metricsMutex);
+            for (auto &counter : m_counters)
+            {
+                metricsSnapshot.counters[prefix + counter.first] = counter.second->value();
+            }
+            for (auto &gauge : m_gauges)
+            {
+                metricsSnapshot.gauges[prefix + gauge.first] = {gauge.second->value(), gauge.second->maximum()};
+            }
+            for (auto &histogram : m_histograms)
+            {
+                HistogramSnapshot &histogramSnapshot{metricsSnapshot.histograms[prefix + histogram.first]};
+                std::vector<std::uint64_t> bucketCounts(Histogram::kBuckets);
+                for (std::size_t index = 0; index < Histogram::kBuckets; index++)
+                {
+                    histogramSnapshot.count += (bucketCounts[index] = histogram.second->bucketCount(index));
+                }
+                histogramSnapshot.sum = histogram.second->sum();
+                histogramSnapshot.maximum = histogram.second->maximum();
+                histogramSnapshot.p50 = percentile(bucketCounts, histogramSnapshot.count, histogramSnapshot.maximum, 50.0);
+                histogramSnapshot.p90 = percentile(bucketCounts, histogramSnapshot.count, histogramSnapshot.maximum, 90.0);
+                histogramSnapshot.p99 = percentile(bucketCounts, histogramSnapshot.count, histogramSnapshot.maximum, 99.0);
+                histogramSnapshot.p999 = percentile(bucketCounts, histogramSnapshot.count, histogramSnapshot.maximum, 99.9);
+            }
+            sources = m_sources;
+        }
+        for (auto &source : sources)
+        {
+            source.second->snapshot(prefix + source.first + ".", metricsSnapshot);
+        }
+    }
+    // ==============
+    // PUBLIC METHODS
+    // ==============
+    //
+    // Set gauge value.
+    //
+    void CMetrics::Gauge::set(std::int64_t value) noexcept
+    {
+        m_value.store(value, std::memory_order_relaxed);
+        updateMaximum(value);
+    }
+    //
+    // Add to gauge value.
+    //
+    void CMetrics::Gauge::add(std::int64_t delta) noexcept
+    {
+        updateMaximum(m_value.fetch_add(delta, std::memory_order_relaxed) + delta);
+    }
+    //
+    // Bucket index for a value; values below 2*kSubBuckets have their own bucket and
+    // each power of 2 above that is split into kSubBuckets buckets.
+    //
+    std::size_t CMetrics::Histogram::bucketIndex(std::uint64_t value) noexcept
+    {
+        if (value < kSubBuckets)
+        {
+            return (static_cast<std::size_t>(value));
+        }
+        int bucketGroup{(63 - __builtin_clzll(value)) - kSubBucketBits + 1};
+        return ((static_cast<std::size_t>(bucketGroup) * kSubBuckets) + static_cast<std::size_t>(value >> (bucketGroup - 1)) - kSubBuckets);
+    }
+    //
+    // Highest value recorded in a bucket.
+    //
+    std::uint64_t CMetrics::Histogram::bucketHighest(std::size_t index) noexcept
+    {
+        std::size_t bucketGroup{index / kSubBuckets};
+        std::uint64_t subBucket{index % kSubBuckets};
+        if (bucketGroup == 0)
+        {
+            return (subBucket);
+        }
+        return (((kSubBuckets + subBucket) << (bucketGroup - 1)) + ((static_cast<std::uint64_t>(1) << (bucketGroup - 1)) - 1));
+    }
+    //
+    // Record a value in histogram.
+    //
+    void CMetrics::Histogram::record(std::uint64_t value) noexcept
+    {
+        m_buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        m_sum.fetch_add(value, std::memory_order_relaxed);
+        std::uint64_t maximum{m_maximum.load(std::memory_order_relaxed)};
+        while ((value > maximum) && !m_maximum.compare_exchange_weak(maximum, value, std::memory_order_relaxed))
+        {
+        }
+    }
+    //
+    // Constructor
+    //
+    CMetrics::CMetrics()
+    {
+    }
+    //
+    // Destructor
+    //
+    CMetrics::~CMetrics()
+    {
+    }
+    //
+    // Register (or find existing) counter.
+    //
+    CMetrics::Counter &CMetrics::counter(const std::string &name)
+    {
+        std::unique_lock<std::mutex> locker(m_metricsMutex);
+        auto &metric = m_counters[name];
+        if (!metric)
+        {
+            metric = std::make_unique<Counter>();
+        }
+        return (*metric);
+    }
+    //
+    // Register (or find existing) gauge.
+    //
+    CMetrics::Gauge &CMetrics::gauge(const std::string &name)
+    {
+        std::unique_lock<std::mutex> locker(m_metricsMutex);
+        auto &metric = m_gauges[name];
+        if (!metric)
+        {
+            metric = std::make_unique<Gauge>();
+        }
+        return (*metric);
+    }
+    //
+    // Register (or find existing) histogram.
+    //
+    CMetrics::Histogram &CMetrics::histogram(const std::string &name)
+    {
+        std::unique_lock<std::mutex> locker(m_metricsMutex);
+        auto &metric = m_histograms[name];
+        if (!metric)
+        {
+            metric = std::make_unique<Histogram>();
+        }
+        return (*metric);
+    }
+    //
+    // Include another objects metrics under a name prefix.
+    //
+    void CMetrics::addSource(const std::string &prefix, std::shared_ptr<CMetrics> source)
+    {
+        if (source == nullptr)
+        {
+            return;
+        }
+        std::unique_lock<std::mutex> locker(m_metricsMutex);
+        m_sources.emplace_back(prefix, source);
+    }
+    //
+    // Take a snapshot of all metrics.
+    //
+    CMetrics::Snapshot CMetrics::snapshot(void) const
+    {
+        Snapshot metricsSnapshot;
+        snapshot("", metricsSnapshot);
+        return (metricsSnapshot);
+    }
+    //
+    // Export metrics as text; one "name value" per line with histograms exported
+    // as their count, sum, maximum and percentiles.
+    //
+    std::string CMetrics::exportText(void) const
+    {
+        Snapshot metricsSnapshot{snapshot()};
+        std::ostringstream metricsText;
+        for (auto &counter : metricsSnapshot.counters)
+        {
+            metricsText << counter.first << " " << counter.second << "\n";
+        }
+        for (auto &gauge : metricsSnapshot.gauges)
+        {
+            metricsText << gauge.first << " " << gauge.second.value << "\n";
+            metricsText << gauge.first << ".max " << gauge.second.maximum << "\n";
+        }
+        for (auto &histogram : metricsSnapshot.histograms)
+        {
+            metricsText << histogram.first << ".count " << histogram.second.count << "\n";
+            metricsText << histogram.first << ".sum " << histogram.second.sum << "\n";
+            metricsText << histogram.first << ".max " << histogram.second.maximum << "\n";
+            metricsText << histogram.first << ".p50 " << histogram.second.p50 << "\n";
+            metricsText << histogram.first << ".p90 " << histogram.second.p90 << "\n";
+            metricsText << histogram.first << ".p99 " << histogram.second.p99 << "\n";
+            metricsText << histogram.first << ".p999 " << histogram.second.p999 << "\n";
+        }
+        return (metricsText.str());
+    }
+    //
+    // Export metrics as a JSON object with "counters", "gauges" and "histograms" members.
+    //
+    std::string CMetrics::exportJSON(void) const
+    {
+        Snapshot metricsSnapshot{snapshot()};
+        std::ostringstream metricsJSON;
+        auto quoted = [](const std::string &name) {
+            std::string quotedName{"\""};
+            for (auto ch : name)
+            {
+                if ((ch == '"') || (ch == '\\'))
+                {
+                    quotedName += '\\';
+                }
+                quotedName += ch;
+            }
+            return (quotedName + "\"");
+        };
+        const char *separator{""};
+        metricsJSON << "{\"counters\":{";
+        for (auto &counter : metricsSnapshot.counters)
+        {
+            metricsJSON << separator << quoted(counter.first) << ":" << counter.second;
+            separator = ",";
+        }
+        separator = "";
+        metricsJSON << "},\"gauges\":{";
+        for (auto &gauge : metricsSnapshot.gauges)
+        {
+            metricsJSON << separator << quoted(gauge.first) << ":{\"value\":" << gauge.second.value << ",\"max\":" << gauge.second.maximum << "}";
+            separator = ",";
+        }
+        separator = "";
+        metricsJSON << "},\"histograms\":{";
+        for (auto &histogram : metricsSnapshot.histograms)
+        {
+            metricsJSON << separator << quoted(histogram.first) << ":{\"count\":" << histogram.second.count
+                        << ",\"sum\":" << histogram.second.sum << ",\"max\":" << histogram.second.maximum
+                        << ",\"p50\":" << histogram.second.p50 << ",\"p90\":" << histogram.second.p90
+                        << ",\"p99\":" << histogram.second.p99 << ",\"p999\":" << histogram.second.p999 << "}";
+            separator = ",";
+        }
+        metricsJSON << "}}";
+        return (metricsJSON.str());
+    }
+} // namespace Antik::File
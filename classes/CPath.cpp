@@ -91,11 +91,11 @@ namespace Antik::File
         m_path.replace_extension(extension);
     }
     //
-    // Normalize path.
+    // Normalize path (it or its trailing components need not exist yet).
     //
     void CPath::normalize(void)
     {
-        m_path = std::filesystem::canonical(m_path);
+        m_path = std::filesystem::weakly_canonical(m_path);
     }
     //
     // Return absolute path value.
@@ -3,9 +3,14 @@
 //
 // Description: Class for connecting to / listening for connections from remote peers
 // and the reading/writing of data using sockets. It supports both plain and TLS/SSL
-// connections and  is implemented using BOOST:ASIO synchronous API calls. At present it
-// only has basic TLS/SSL support and is geared more towards client support but this may
-// change in future.
+// connections and  is implemented using BOOST:ASIO synchronous API calls (apart from
+// accepting a connection when listening, which is run on the io service with a timeout).
+// There is also an asynchronous API (completion handlers) for sockets that share an
+// io service so that many connections can be driven by a few threads running it.
+// At present it only has basic TLS/SSL support and is geared more towards client support
+// but this may change in future. All sockets using a TLS version share one SSL context
+// and a socket may be given the TLS session of another connection to the same server to
+// resume (eg. FTPS data connections resuming that of the control connection).
 //
 // Dependencies:   C20++        - Language standard features used.
 //                 BOOST ASIO   - Used to talk to FTP server.
@@ -22,6 +27,13 @@
 //
 #include <iostream>
 #include <fstream>
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+//
+// Linux
+//
+#include <poll.h>
 // =======
 // IMPORTS
 // =======
@@ -46,63 +58,83 @@ namespace Antik::Network
     // PRIVATE METHODS
     // ===============
     //
-    // Socket listener thread method for incoming connections. At present it listens
-    // on a random port but sets m_hostPort to its value. The connected socket is created
-    // local and moved to m_socket on success.
+    // Accept a connection on the listening socket; waiting no longer than the listen
+    // timeout. The accept and a timer are run together on the io service and whichever
+    // completes first cancels the other. If the io service is shared (and so may be run
+    // by others) it cannot be run here so the listening socket is polled instead. The
+    // listening socket is then closed and the connected socket (created local) moved to
+    // m_socket on success.
     //
-    void CSocket::connectionListener()
+    void CSocket::acceptConnection()
     {
-        try
+        std::unique_ptr<boost::asio::ip::tcp::acceptor> acceptor{std::move(m_acceptor)};
+        std::unique_ptr<SSLSocket> socket = std::make_unique<SSLSocket>(m_ioService, *m_sslContext);
+        if (!socket)
         {
-            boost::asio::ip::tcp::acceptor acceptor(m_ioService, boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), 0));
-            m_hostPort = std::to_string(acceptor.local_endpoint().port());
-            m_isListenThreadRunning = true;
-            std::unique_ptr<SSLSocket> socket = std::make_unique<SSLSocket>(m_ioService, *m_sslContext);
-            if (!socket)
+            throw std::runtime_error("Could not create socket.");
+        }
+        bool timedOut{false};
+        if (m_ownIoService)
+        {
+            boost::asio::steady_timer acceptTimer{m_ioService, m_listenTimeout};
+            m_socketError = boost::asio::error::would_block;
+            acceptor->async_accept(socket->next_layer(), [&](const boost::system::error_code &acceptError) {
+                m_socketError = acceptError;
+                acceptTimer.cancel();
+            });
+            acceptTimer.async_wait([&](const boost::system::error_code &timerError) {
+                if (timerError != boost::asio::error::operation_aborted)
+                {
+                    timedOut = true;
+                    acceptor->cancel();
+                }
+            });
+            m_ioService.restart();
+            m_ioService.run();
+        }
+        else
+        {
+            // Poll interrupted by a signal is retried for what is left of the timeout
+            auto acceptDeadline{std::chrono::steady_clock::now() + m_listenTimeout};
+            pollfd listener{acceptor->native_handle(), POLLIN, 0};
+            int ready;
+            do
             {
-                throw std::runtime_error("Could not create socket.");
+                auto remaining{std::chrono::duration_cast<std::chrono::milliseconds>(acceptDeadline - std::chrono::steady_clock::now())};
+                ready = ::poll(&listener, 1, static_cast<int>(std::max(remaining.count(), std::chrono::milliseconds::rep(0))));
+            } while ((ready < 0) && (errno == EINTR));
+            if (ready < 0)
+            {
+                throw std::runtime_error(std::string("Poll for connection failed: ") + std::strerror(errno));
             }
-            acceptor.accept(socket->next_layer(), m_socketError);
-            if (m_socketError)
+            timedOut = (ready == 0);
+            if (!timedOut)
             {
-                throw std::runtime_error(m_socketError.message());
+                acceptor->accept(socket->next_layer(), m_socketError);
             }
-            m_socket = std::move(socket);
         }
-        catch (const std::exception &e)
+        acceptor->close();
+        if (timedOut)
         {
-            m_thrownException = std::current_exception();
+            throw std::runtime_error("Timed out waiting for connection.");
         }
-        m_isListenThreadRunning = false;
+        if (m_socketError)
+        {
+            throw std::runtime_error(m_socketError.message());
+        }
+        m_socket = std::move(socket);
     }
     // ==============
     // PUBLIC METHODS
     // ==============
     //
-    // Cleanup after socket connection. This includes stopping any unused listener
-    // thread and closing the socket if still open. Note: if the thread is still waiting
-    // for a connect it is woken up with a fake connect.
+    // Cleanup after socket connection. This includes closing any listening socket
+    // whose connection was never accepted and closing the socket if still open.
     //
     void CSocket::cleanup()
     {
         try
         {
-            if (m_isListenThreadRunning && m_socketListenThread)
-            {
-                m_isListenThreadRunning = false;
-                try
-                {
-                    boost::asio::ip::tcp::socket socket{m_ioService};
-                    boost::asio::ip::tcp::resolver::query query(m_hostAddress, m_hostPort);
-                    boost::asio::connect(socket, m_ioQueryResolver.resolve(query));
-                    socket.close();
-                }
-                catch (std::exception &e)
-                {
-                    throw std::runtime_error("Could not wake listener thread with fake connect.");
-                }
-                m_socketListenThread->join();
-            }
             close();
         }
         catch (const std::exception &e)
@@ -111,22 +143,16 @@ namespace Antik::Network
         }
     }
     //
-    // Listen for connections
+    // Listen for connections. At present it listens on a random port but sets m_hostPort
+    // to its value. The socket is listening on return; any connection made is queued until
+    // accepted by waitUntilConnected().
     //
     void CSocket::listenForConnection()
     {
         try
         {
-            // Start connection listener thread and wait until its listening
-            m_socketListenThread = std::make_unique<std::thread>(&CSocket::connectionListener, this);
-            while (!m_isListenThreadRunning)
-            {
-                continue;
-            }
-            if (m_thrownException)
-            {
-                std::rethrow_exception(m_thrownException);
-            }
+            m_acceptor = std::make_unique<boost::asio::ip::tcp::acceptor>(m_ioService, boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), 0));
+            m_hostPort = std::to_string(m_acceptor->local_endpoint().port());
         }
         catch (const std::exception &e)
         {
@@ -140,10 +166,10 @@ namespace Antik::Network
     {
         try
         {
-            // Listener thread is running (wait for it to finish)
-            if (m_socketListenThread)
+            // Listening so accept connection
+            if (m_acceptor)
             {
-                m_socketListenThread->join();
+                acceptConnection();
             }
             // TLS handshake if SSL enabled
             tlsHandshake();
@@ -264,12 +290,19 @@ namespace Antik::Network
             {
                 throw std::logic_error("No socket present.");
             }
+            // Offer any session to resume (a full handshake follows if it is refused)
+            m_tlsSessionReused = false;
+            if (m_tlsSession)
+            {
+                SSL_set_session(m_socket->native_handle(), m_tlsSession.get());
+            }
             m_socket->handshake(SSLSocket::client, m_socketError);
             if (m_socketError)
             {
                 throw std::runtime_error(m_socketError.message());
             }
             m_sslActive = true;
+            m_tlsSessionReused = SSL_session_reused(m_socket->native_handle());
         }
         catch (const std::exception &e)
         {
@@ -301,10 +334,11 @@ namespace Antik::Network
                     throw std::runtime_error(m_socketError.message());
                 }
             }
-            // Remove any listen thread
-            if (m_socketListenThread)
+            // Close any listening socket
+            if (m_acceptor)
             {
-                m_socketListenThread.reset();
+                m_acceptor->close(m_socketError);
+                m_acceptor.reset();
             }
         }
         catch (const std::exception &e)
@@ -313,23 +347,302 @@ namespace Antik::Network
         }
     }
     //
+    // Close socket without shutting down any running SSL first (so without waiting on
+    // the remote peer); used to abandon a transfer part way through.
+    //
+    void CSocket::abort()
+    {
+        try
+        {
+            std::unique_ptr<SSLSocket> socket{std::move(m_socket)};
+            m_sslActive = false;
+            // Socket exists and is open
+            if (socket && socket->next_layer().is_open())
+            {
+                socket->next_layer().close(m_socketError);
+                if (m_socketError)
+                {
+                    throw std::runtime_error(m_socketError.message());
+                }
+            }
+            // Close any listening socket
+            if (m_acceptor)
+            {
+                m_acceptor->close(m_socketError);
+                m_acceptor.reset();
+            }
+        }
+        catch (const std::exception &e)
+        {
+            throw Exception(e.what());
+        }
+    }
+    //
+    // Connect asynchronously to a given host and port (name resolution included).
+    //
+    void CSocket::asyncConnect(AsyncHandler handler)
+    {
+        m_sslActive = false;
+        m_socket = std::make_unique<SSLSocket>(m_ioService, *m_sslContext);
+        boost::asio::ip::tcp::resolver::query query{m_hostAddress, m_hostPort};
+        m_ioQueryResolver.async_resolve(query, [this, handler](const boost::system::error_code &resolveError, boost::asio::ip::tcp::resolver::results_type endpoints) {
+            if (resolveError)
+            {
+                m_socketError = resolveError;
+                m_socket.reset();
+                handler(resolveError);
+                return;
+            }
+            boost::asio::async_connect(m_socket->next_layer(), endpoints, [this, handler](const boost::system::error_code &connectError, const boost::asio::ip::tcp::endpoint &) {
+                m_socketError = connectError;
+                if (connectError)
+                {
+                    m_socket.reset();
+                }
+                handler(connectError);
+            });
+        });
+    }
+    //
+    // Read some data asynchronously from socket into buffer. The handler is passed eof
+    // (and closedByRemotePeer() is true) once the remote peer has closed the socket.
+    //
+    void CSocket::asyncRead(char *readBuffer, size_t bufferLength, AsyncIOHandler handler)
+    {
+        if (!m_socket)
+        {
+            boost::asio::post(m_ioService, [handler]() { handler(boost::asio::error::not_connected, 0); });
+            return;
+        }
+        auto readHandler = [this, handler](const boost::system::error_code &readError, std::size_t bytesRead) {
+            m_socketError = readError;
+            handler(readError, bytesRead);
+        };
+        if (m_sslActive)
+        {
+            m_socket->async_read_some(boost::asio::buffer(readBuffer, bufferLength), readHandler);
+        }
+        else
+        {
+            m_socket->next_layer().async_read_some(boost::asio::buffer(readBuffer, bufferLength), readHandler);
+        }
+    }
+    //
+    // Write whole of buffer asynchronously to socket.
+    //
+    void CSocket::asyncWrite(const char *writeBuffer, size_t writeLength, AsyncIOHandler handler)
+    {
+        if (!m_socket)
+        {
+            boost::asio::post(m_ioService, [handler]() { handler(boost::asio::error::not_connected, 0); });
+            return;
+        }
+        auto writeHandler = [this, handler](const boost::system::error_code &writeError, std::size_t bytesWritten) {
+            m_socketError = writeError;
+            handler(writeError, bytesWritten);
+        };
+        if (m_sslActive)
+        {
+            boost::asio::async_write(*m_socket, boost::asio::buffer(writeBuffer, writeLength), writeHandler);
+        }
+        else
+        {
+            boost::asio::async_write(m_socket->next_layer(), boost::asio::buffer(writeBuffer, writeLength), writeHandler);
+        }
+    }
+    //
+    // Perform TLS handshake asynchronously if SSL enabled (offering any session to resume).
+    //
+    void CSocket::asyncTlsHandshake(AsyncHandler handler)
+    {
+        if (!m_sslEnabled || !m_socket)
+        {
+            boost::system::error_code handshakeError;
+            if (m_sslEnabled)
+            {
+                handshakeError = boost::asio::error::not_connected;
+            }
+            boost::asio::post(m_ioService, [handler, handshakeError]() { handler(handshakeError); });
+            return;
+        }
+        m_tlsSessionReused = false;
+        if (m_tlsSession)
+        {
+            SSL_set_session(m_socket->native_handle(), m_tlsSession.get());
+        }
+        m_socket->async_handshake(SSLSocket::client, [this, handler](const boost::system::error_code &handshakeError) {
+            m_socketError = handshakeError;
+            if (!handshakeError)
+            {
+                m_sslActive = true;
+                m_tlsSessionReused = SSL_session_reused(m_socket->native_handle());
+            }
+            handler(handshakeError);
+        });
+    }
+    //
+    // Wait asynchronously for a connection to a listening socket (no longer than the
+    // listen timeout; timed_out passed on expiry) then TLS handshake if SSL enabled.
+    // The accept and its timer handlers are serialised on a strand as either may cancel
+    // the other.
+    //
+    void CSocket::asyncWaitUntilConnected(AsyncHandler handler)
+    {
+        if (!m_acceptor)
+        {
+            asyncTlsHandshake(handler);
+            return;
+        }
+        m_sslActive = false;
+        m_socket = std::make_unique<SSLSocket>(m_ioService, *m_sslContext);
+        auto acceptTimer{std::make_shared<boost::asio::steady_timer>(m_ioService, m_listenTimeout)};
+        m_acceptor->async_accept(m_socket->next_layer(), boost::asio::bind_executor(m_ioStrand, [this, handler, acceptTimer](const boost::system::error_code &acceptError) {
+            boost::system::error_code connectionError{acceptError};
+            if ((acceptError == boost::asio::error::operation_aborted) && (acceptTimer->expiry() <= boost::asio::steady_timer::clock_type::now()))
+            {
+                connectionError = boost::asio::error::timed_out;
+            }
+            acceptTimer->cancel();
+            if (m_acceptor)
+            {
+                boost::system::error_code closeError;
+                m_acceptor->close(closeError);
+                m_acceptor.reset();
+            }
+            m_socketError = connectionError;
+            if (connectionError)
+            {
+                m_socket.reset();
+                handler(connectionError);
+                return;
+            }
+            asyncTlsHandshake(handler);
+        }));
+        acceptTimer->async_wait(boost::asio::bind_executor(m_ioStrand, [this](const boost::system::error_code &timerError) {
+            if ((timerError != boost::asio::error::operation_aborted) && m_acceptor)
+            {
+                boost::system::error_code cancelError;
+                m_acceptor->cancel(cancelError);
+            }
+        }));
+    }
+    //
+    // Closedown any running SSL asynchronously then close socket.
+    //
+    void CSocket::asyncClose(AsyncHandler handler)
+    {
+        if (m_socket && m_socket->next_layer().is_open() && m_sslActive)
+        {
+            m_sslActive = false;
+            m_socket->async_shutdown([this, handler](const boost::system::error_code &) {
+                boost::system::error_code closeError;
+                try
+                {
+                    close();
+                }
+                catch (const std::exception &e)
+                {
+                    closeError = m_socketError;
+                }
+                handler(closeError);
+            });
+            return;
+        }
+        boost::system::error_code closeError;
+        try
+        {
+            close();
+        }
+        catch (const std::exception &e)
+        {
+            closeError = m_socketError;
+        }
+        boost::asio::post(m_ioService, [handler, closeError]() { handler(closeError); });
+    }
+    //
+    // Return io service used by socket.
+    //
+    boost::asio::io_service &CSocket::getIoService()
+    {
+        return (m_ioService);
+    }
+    //
     // Set SSL context for the TLS version se
     //
     void CSocket::setTLSVersion(TLSVerion version)
     {
         m_tlsVersion = version;
-        switch (m_tlsVersion)
+        m_sslContext = sharedSslContext(m_tlsVersion);
+    }
+    //
+    // Return the SSL context for a TLS version shared by all sockets (created on first
+    // use). Sharing one context saves the cost of setting one up per socket and keeps
+    // client sessions (and session tickets offered by servers) usable across sockets.
+    //
+    std::shared_ptr<boost::asio::ssl::context> CSocket::sharedSslContext(TLSVerion version)
+    {
+        static std::mutex sslContextMutex;
+        static std::shared_ptr<boost::asio::ssl::context> sslContexts[TLSVerion::v1_2 + 1];
+        std::unique_lock<std::mutex> locker(sslContextMutex);
+        if (!sslContexts[version])
+        {
+            switch (version)
+            {
+            case TLSVerion::v1_0:
+                sslContexts[version] = std::make_shared<boost::asio::ssl::context>(boost::asio::ssl::context::tlsv1);
+                break;
+            case TLSVerion::v1_1:
+                sslContexts[version] = std::make_shared<boost::asio::ssl::context>(boost::asio::ssl::context::tlsv11);
+                break;
+            case TLSVerion::v1_2:
+                sslContexts[version] = std::make_shared<boost::asio::ssl::context>(boost::asio::ssl::context::tlsv12);
+                break;
+            }
+            SSL_CTX_set_session_cache_mode(sslContexts[version]->native_handle(), SSL_SESS_CACHE_CLIENT);
+            SSL_CTX_clear_options(sslContexts[version]->native_handle(), SSL_OP_NO_TICKET);
+        }
+        return (sslContexts[version]);
+    }
+    //
+    // Set SSL context to use for socket (eg. one with its own verification settings).
+    //
+    void CSocket::setSslContext(std::shared_ptr<boost::asio::ssl::context> sslContext)
+    {
+        if (!sslContext)
         {
-        case TLSVerion::v1_0:
-            m_sslContext = std::make_unique<boost::asio::ssl::context>(boost::asio::ssl::context::tlsv1);
-            break;
-        case TLSVerion::v1_1:
-            m_sslContext = std::make_unique<boost::asio::ssl::context>(boost::asio::ssl::context::tlsv11);
-            break;
-        case TLSVerion::v1_2:
-            m_sslContext = std::make_unique<boost::asio::ssl::context>(boost::asio::ssl::context::tlsv12);
-            break;
+            throw Exception("No SSL context passed.");
         }
+        m_sslContext = sslContext;
+    }
+    //
+    // Return TLS session of the current connection (nullptr if TLS not active). It may
+    // be passed to another socket connecting to the same server to resume.
+    //
+    std::shared_ptr<SSL_SESSION> CSocket::getTlsSession() const
+    {
+        if (m_socket && m_sslActive)
+        {
+            SSL_SESSION *tlsSession = SSL_get1_session(m_socket->native_handle());
+            if (tlsSession)
+            {
+                return (std::shared_ptr<SSL_SESSION>(tlsSession, SSL_SESSION_free));
+            }
+        }
+        return (nullptr);
+    }
+    //
+    // Set TLS session to offer for resumption on the next handshake (nullptr for none).
+    //
+    void CSocket::setTlsSession(std::shared_ptr<SSL_SESSION> tlsSession)
+    {
+        m_tlsSession = tlsSession;
+    }
+    //
+    // Return true if the last TLS handshake resumed a session (abbreviated handshake).
+    //
+    bool CSocket::isTlsSessionReused() const
+    {
+        return (m_tlsSessionReused);
     }
     //
     // Work out ip address for local machine. This is quite difficult to achieve but
@@ -386,4 +699,12 @@ namespace Antik::Network
     {
         return m_hostPort;
     }
+    void CSocket::setListenTimeout(std::chrono::milliseconds listenTimeout)
+    {
+        m_listenTimeout = listenTimeout;
+    }
+    std::chrono::milliseconds CSocket::getListenTimeout() const
+    {
+        return m_listenTimeout;
+    }
 } // namespace Antik::Network
@@ -3,23 +3,61 @@
 //
 // Description: This class uses the CFileApprise class to generate file add events
 // on a watch folder and to process each file added with a task action function
-// provided as a parameter in its constructor.
+// provided as a parameter in its constructor. If a journal folder is passed in its
+// options then each file is journaled as received when its add event is accepted (so
+// before it waits to stabilize, in a dispatch queue or in a batch) and as completed
+// once processed so that on restart any file received but not completed is processed
+// again, as is any file added to the
+// watch folder hierarchy while the task was not running (found by reading only the
+// directories changed since the journal was last written). If a stability period
+// is set in its options then added files are only processed once they have been
+// quiet (no further events and unchanged in size/modification time) for that long.
+// If action workers are requested then files are passed to them through a dispatch
+// queue whose order is set by a dispatch policy (first in first out by default);
+// the task action must then be safe to call from more than one thread. If the task
+// action is an IBatchAction and a batch size is set then files are passed to it in
+// batches that are processed once full or when the first file has waited the batch
+// delay (each worker builds its own batches); a batch still being filled when the
+// task stops is not processed (with a journal it is on restart). Action calls can
+// be limited to a rate (token bucket) and the number of workers processing files at
+// once adapted to the action's latency and failures; if the dispatch queue and the
+// watcher's event queue are bounded then a slow action holds up the monitor loop and
+// in turn event generation rather than letting queued files grow without limit.
+// If retries or a dead-letter folder are set in its options then a file whose action
+// call fails (returns false or throws) is retried after an exponential backoff with
+// jitter, without holding up other files, until it has failed the maximum number of
+// attempts when it is moved to the dead-letter folder (and the task carries on).
 //
 // Dependencies: C20++               - Language standard features used.
 //               Class CLogger       - Logging functionality.
 //               Class CFileApprise  - File event handling abstraction.
+//               Class CFile         - File handling (dead-letter folder).
 //
 // =================
 // CLASS DEFINITIONS
 // =================
 #include "CTask.hpp"
 #include "CFileEventNotifier.hpp"
+#include "CShardedFileEventNotifier.hpp"
+#include "CTaskJournal.hpp"
+#include "CDirectoryScanner.hpp"
+#include "CFileStabilizer.hpp"
+#include "CDispatchQueue.hpp"
+#include "CTokenBucket.hpp"
+#include "CConcurrencyLimiter.hpp"
+#include "CRetryQueue.hpp"
+#include "CFile.hpp"
 // ====================
 // CLASS IMPLEMENTATION
 // ====================
 //
 // C++ STL
 //
+#include <algorithm>
+//
+// Linux
+//
+#include <sys/stat.h>
 // =========
 // NAMESPACE
 // =========
@@ -28,6 +66,8 @@ namespace Antik::File
     // ===========================
     // PRIVATE TYPES AND CONSTANTS
     // ===========================
+    // Threads used to read directories when reconciling journal
+    const int CTask::kReconcileThreads{4};
     // ==========================
     // PUBLIC TYPES AND CONSTANTS
     // ==========================
@@ -40,6 +80,484 @@ namespace Antik::File
     // ===============
     // PRIVATE METHODS
     // ===============
+    //
+    // Return a file's status change time (nanoseconds since epoch; 0 if it cannot be read).
+    //
+    std::int64_t CTask::statusChanged(const std::string &filePath)
+    {
+        struct stat fileStat;
+        if (stat(filePath.c_str(), &fileStat) == 0)
+        {
+            return (static_cast<std::int64_t>(fileStat.st_ctim.tv_sec) * 1000000000 + fileStat.st_ctim.tv_nsec);
+        }
+        return (0);
+    }
+    //
+    // Journal a file as received if a journal is enabled.
+    //
+    void CTask::journalReceived(const std::string &filePath)
+    {
+        if (m_journal)
+        {
+            m_journal->received(filePath, statusChanged(filePath));
+        }
+    }
+    //
+    // Process a file with the task action (journaling it as completed if a journal is
+    // enabled). If failures are handled then an action that throws counts as failed and
+    // a failed file is completed only once it has no retries left. Returns true when the
+    // kill count is reached.
+    //
+    bool CTask::processFile(const std::string &filePath)
+    {
+        if (m_rateLimiter && !m_rateLimiter->acquire())
+        {
+            return (false); // Task stopped waiting on rate limit
+        }
+        std::chrono::steady_clock::time_point processStart{std::chrono::steady_clock::now()};
+        bool processed{false};
+        try
+        {
+            processed = m_taskAction->process(filePath);
+        }
+        catch (...)
+        {
+            if (!m_retryQueue)
+            {
+                throw;
+            }
+        }
+        actionCompleted(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - processStart), processed);
+        return (completeFile(filePath, processed) && countCompleted(1));
+    }
+    //
+    // Process a batch of files with the task batch action (journaling them as completed
+    // if a journal is enabled). Failures are handled as for a single
+    // file with each file of a failed batch retried on its own. Returns true when the
+    // kill count is reached.
+    //
+    bool CTask::processBatch(const std::vector<std::string> &filePaths, const ReceivedTimes &received)
+    {
+        if (m_rateLimiter && !m_rateLimiter->acquire(filePaths.size()))
+        {
+            return (false); // Task stopped waiting on rate limit
+        }
+        std::chrono::steady_clock::time_point processStart{std::chrono::steady_clock::now()};
+        for (auto &fileReceived : received)
+        {
+            m_processLatency->record(std::chrono::duration_cast<std::chrono::microseconds>(processStart - fileReceived).count());
+        }
+        bool processed{false};
+        try
+        {
+            processed = m_batchAction->processBatch(filePaths);
+        }
+        catch (...)
+        {
+            if (!m_retryQueue)
+            {
+                throw;
+            }
+        }
+        actionCompleted(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - processStart), processed);
+        m_batchSize->record(filePaths.size());
+        int fileCount{0};
+        for (auto &filePath : filePaths)
+        {
+            if (completeFile(filePath, processed))
+            {
+                fileCount++;
+            }
+        }
+        return (countCompleted(fileCount));
+    }
+    //
+    // Add file to the monitor loop batch and process the batch if it is full. Returns
+    // true if the kill count is reached.
+    //
+    bool CTask::batchFile(const std::string &filePath, std::chrono::steady_clock::time_point received)
+    {
+        if (m_batchFiles.empty())
+        {
+            m_batchStarted = std::chrono::steady_clock::now();
+        }
+        m_batchFiles.push_back(filePath);
+        m_batchReceived.push_back(received);
+        if (m_batchFiles.size() >= batchLimit())
+        {
+            return (flushBatch());
+        }
+        return (false);
+    }
+    //
+    // Process the files in the monitor loop batch. Returns true if the kill count is reached.
+    //
+    bool CTask::flushBatch(void)
+    {
+        std::vector<std::string> batchFiles;
+        ReceivedTimes batchReceived;
+        batchFiles.swap(m_batchFiles);
+        batchReceived.swap(m_batchReceived);
+        return (processBatch(batchFiles, batchReceived));
+    }
+    //
+    // Return number of files in a full batch; the batch size or what is left of the
+    // kill count if less.
+    //
+    std::size_t CTask::batchLimit(void)
+    {
+        if ((m_killCount > 0) && (static_cast<std::size_t>(m_killCount) < m_options.batchSize))
+        {
+            return (static_cast<std::size_t>(m_killCount));
+        }
+        return (m_options.batchSize);
+    }
+    //
+    // Record duration and result of an action call; adjusting any adaptive concurrency
+    // limit to them.
+    //
+    void CTask::actionCompleted(std::chrono::microseconds duration, bool processed)
+    {
+        m_actionDuration->record(duration.count());
+        if (!processed)
+        {
+            m_actionFailures->add();
+        }
+        if (m_concurrencyLimiter)
+        {
+            m_concurrencyLimiter->sample(duration, !processed);
+            m_concurrencyLimit->set(static_cast<std::int64_t>(m_concurrencyLimiter->limit()));
+        }
+    }
+    //
+    // Complete a file after an action call (journaling it as completed with its current
+    // status change time so that a file changed while it waited is not taken as missed
+    // on restart). If failures are handled then a failed file with attempts left is
+    // scheduled for retry instead and one without is moved to any dead-letter folder.
+    // Returns true if the file is completed.
+    //
+    bool CTask::completeFile(const std::string &filePath, bool processed)
+    {
+        if (m_retryQueue)
+        {
+            if (processed)
+            {
+                m_retryQueue->completed(filePath);
+            }
+            else if (m_retryQueue->retry(filePath))
+            {
+                m_actionRetries->add();
+                return (false);
+            }
+            else
+            {
+                m_filesFailed->add();
+                deadLetterFile(filePath);
+            }
+        }
+        m_filesProcessed->add();
+        if (m_journal)
+        {
+            m_journal->completed(filePath, statusChanged(filePath));
+        }
+        return (true);
+    }
+    //
+    // Count files completed against the kill count. Returns true if it is reached.
+    //
+    bool CTask::countCompleted(int files)
+    {
+        return ((files != 0) && (m_killCount != 0) && ((m_killCount.fetch_sub(files) - files) <= 0));
+    }
+    //
+    // Move a file that has failed every attempt to the dead-letter folder (keeping its
+    // path relative to the watch folder). A file that cannot be moved (e.g. it has been
+    // deleted) is left where it is.
+    //
+    void CTask::deadLetterFile(const std::string &filePath)
+    {
+        if (m_options.deadLetterFolder.empty())
+        {
+            return;
+        }
+        try
+        {
+            CPath deadLetterPath{m_options.deadLetterFolder};
+            if (filePath.compare(0, m_watchFolder.size() + 1, m_watchFolder + "/") == 0)
+            {
+                deadLetterPath.join(filePath.substr(m_watchFolder.size() + 1));
+            }
+            else
+            {
+                deadLetterPath.join(CPath(filePath).fileName());
+            }
+            CFile::createDirectory(deadLetterPath.parentPath());
+            try
+            {
+                CFile::rename(filePath, deadLetterPath);
+            }
+            catch (const CFile::Exception &)
+            {
+                // Dead-letter folder on another file system
+                CFile::copy(filePath, deadLetterPath);
+                CFile::remove(filePath);
+            }
+            m_filesDeadLettered->add();
+        }
+        catch (const CFile::Exception &)
+        {
+        }
+    }
+    //
+    // Dispatch any files whose retry is due. Returns true if the kill count is reached.
+    //
+    bool CTask::processRetries(void)
+    {
+        std::string filePath;
+        while (m_retryQueue->pop(filePath))
+        {
+            if (dispatchFile(filePath, std::chrono::steady_clock::now()))
+            {
+                return (true);
+            }
+        }
+        return (false);
+    }
+    //
+    // Pass on a file resumed from the journal as if its add event had just been received;
+    // to the stabilizer if enabled otherwise dispatched. Returns true if the kill count is
+    // reached or the task has been stopped.
+    //
+    bool CTask::resumeFile(const std::string &filePath)
+    {
+        if (!m_watcher->stillWatching())
+        {
+            return (true);
+        }
+        m_resumed.insert(filePath);
+        m_filesResumed->add();
+        if (m_stabilizer)
+        {
+            m_stabilizer->add(IApprise::Event(IApprise::Event_add, filePath));
+            m_filesStabilizing->set(static_cast<std::int64_t>(m_stabilizer->size()));
+            return (false);
+        }
+        return (dispatchFile(filePath, std::chrono::steady_clock::now()));
+    }
+    //
+    // Resume files received but not completed before the task was restarted and then
+    // any file added to the watch folder hierarchy since the journal was last written;
+    // only the files of directories modified since then are examined. Missed files are
+    // journaled as received and passed on in status change time order. Returns true if
+    // the kill count is reached (or the task stopped) before all are passed on.
+    //
+    bool CTask::resumeJournal(std::int64_t watchTime)
+    {
+        for (auto &filePath : m_journal->outstanding())
+        {
+            struct stat fileStat;
+            if ((stat(filePath.c_str(), &fileStat) == 0) && S_ISREG(fileStat.st_mode))
+            {
+                if (resumeFile(filePath))
+                {
+                    return (true);
+                }
+            }
+            else
+            {
+                m_journal->completed(filePath, 0);
+            }
+        }
+        std::int64_t reconcileTime{m_journal->reconcileTime()};
+        if (reconcileTime != 0)
+        {
+            std::vector<std::pair<std::int64_t, std::string>> missedFiles;
+            std::vector<std::string> directories{m_watchFolder};
+            for (int depth = 0; !directories.empty(); depth++)
+            {
+                std::vector<CDirectoryScanner::ScanResult> scanResults;
+                std::vector<std::string> subDirectories;
+                CDirectoryScanner::readDirectories(directories, scanResults, kReconcileThreads);
+                for (std::size_t directoryNo = 0; directoryNo < directories.size(); directoryNo++)
+                {
+                    struct stat directoryStat;
+                    if ((stat(directories[directoryNo].c_str(), &directoryStat) == 0) &&
+                        ((static_cast<std::int64_t>(directoryStat.st_mtim.tv_sec) * 1000000000 + directoryStat.st_mtim.tv_nsec) >= reconcileTime))
+                    {
+                        for (auto &filePath : scanResults[directoryNo].files)
+                        {
+                            std::int64_t changed{statusChanged(filePath)};
+                            if ((changed >= reconcileTime) && (m_resumed.count(filePath) == 0) && !m_journal->wasCompleted(filePath, changed))
+                            {
+                                missedFiles.emplace_back(changed, filePath);
+                            }
+                        }
+                    }
+                    if ((m_watchDepth == -1) || (depth < m_watchDepth))
+                    {
+                        subDirectories.insert(subDirectories.end(), scanResults[directoryNo].directories.begin(), scanResults[directoryNo].directories.end());
+                    }
+                }
+                directories.swap(subDirectories);
+            }
+            std::sort(missedFiles.begin(), missedFiles.end());
+            for (auto &missedFile : missedFiles)
+            {
+                m_journal->received(missedFile.second, missedFile.first);
+                if (resumeFile(missedFile.second))
+                {
+                    return (true);
+                }
+            }
+        }
+        m_resumeFinished = std::chrono::steady_clock::now();
+        m_journal->started(watchTime);
+        return (false);
+    }
+    //
+    // Process any files whose quiet period has ended with them unchanged. Returns true
+    // if the kill count is reached.
+    //
+    bool CTask::processStableFiles(void)
+    {
+        std::vector<IApprise::Event> stableFiles;
+        m_stabilityRestarts->add(m_stabilizer->expire(stableFiles));
+        m_filesStabilizing->set(static_cast<std::int64_t>(m_stabilizer->size()));
+        for (auto &stableFile : stableFiles)
+        {
+            if (dispatchFile(stableFile.message, stableFile.time))
+            {
+                return (true);
+            }
+        }
+        return (false);
+    }
+    //
+    // Process file in monitor loop or queue it for the action workers. Returns true if
+    // the kill count is reached.
+    //
+    bool CTask::dispatchFile(const std::string &filePath, std::chrono::steady_clock::time_point received)
+    {
+        if (m_dispatchQueue)
+        {
+            m_dispatchQueue->push(filePath, received);
+            m_dispatchQueueDepth->set(static_cast<std::int64_t>(m_dispatchQueue->size()));
+            return (false);
+        }
+        if (m_batchAction)
+        {
+            return (batchFile(filePath, received));
+        }
+        m_processLatency->record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - received).count());
+        return (processFile(filePath));
+    }
+    //
+    // Create dispatch queue (closing after any remaining kill count files are dispatched
+    // unless files can be retried and so dispatched more than once) and start action
+    // workers.
+    //
+    void CTask::startWorkers(void)
+    {
+        std::size_t dispatchLimit{m_retryQueue ? 0 : static_cast<std::size_t>(m_killCount.load())};
+        m_dispatchQueue = std::make_unique<CDispatchQueue>(m_options.dispatchPolicy, dispatchLimit, m_options.maxQueuedFiles);
+        m_workerExceptions.resize(std::max(m_options.actionWorkers, 1));
+        for (std::size_t workerNo = 0; workerNo < m_workerExceptions.size(); workerNo++)
+        {
+            m_workers.emplace_back(&CTask::actionWorker, this, workerNo);
+        }
+    }
+    //
+    // Close dispatch queue (files still queued are not processed) and limits, wait for
+    // action workers to finish and pass on the first exception thrown by any of them.
+    //
+    void CTask::stopWorkers(void)
+    {
+        if (m_dispatchQueue)
+        {
+            m_dispatchQueue->close();
+        }
+        if (m_rateLimiter)
+        {
+            m_rateLimiter->close();
+        }
+        if (m_concurrencyLimiter)
+        {
+            m_concurrencyLimiter->close();
+        }
+        for (auto &worker : m_workers)
+        {
+            worker.join();
+        }
+        m_workers.clear();
+        for (auto &workerException : m_workerExceptions)
+        {
+            if (workerException && !m_thrownException)
+            {
+                m_thrownException = workerException;
+            }
+        }
+    }
+    //
+    // Action worker; process files from dispatch queue until it is closed. When batching
+    // a batch is filled from the queue until full or the batch delay has passed since its
+    // first file was popped. With an adaptive concurrency limit a worker takes a slot
+    // under it before popping a file. The task is stopped when the kill count is reached
+    // or on any exception, and the dispatch queue closed as a worker finishes so that a
+    // monitor loop waiting on a full queue is released.
+    //
+    void CTask::actionWorker(std::size_t workerNo)
+    {
+        try
+        {
+            CDispatchQueue::QueuedFile queuedFile;
+            while (!m_concurrencyLimiter || m_concurrencyLimiter->acquire())
+            {
+                if (!m_dispatchQueue->pop(queuedFile))
+                {
+                    if (m_concurrencyLimiter)
+                    {
+                        m_concurrencyLimiter->release();
+                    }
+                    break;
+                }
+                bool killed{false};
+                if (m_batchAction)
+                {
+                    std::vector<std::string> batchFiles{queuedFile.filePath};
+                    ReceivedTimes batchReceived{queuedFile.received};
+                    auto batchDeadline{std::chrono::steady_clock::now() + m_options.batchDelay};
+                    while ((batchFiles.size() < m_options.batchSize) && m_dispatchQueue->pop(queuedFile, batchDeadline))
+                    {
+                        batchFiles.push_back(queuedFile.filePath);
+                        batchReceived.push_back(queuedFile.received);
+                    }
+                    m_dispatchQueueDepth->set(static_cast<std::int64_t>(m_dispatchQueue->size()));
+                    killed = processBatch(batchFiles, batchReceived);
+                }
+                else
+                {
+                    m_dispatchQueueDepth->set(static_cast<std::int64_t>(m_dispatchQueue->size()));
+                    m_processLatency->record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - queuedFile.received).count());
+                    killed = processFile(queuedFile.filePath);
+                }
+                if (m_concurrencyLimiter)
+                {
+                    m_concurrencyLimiter->release();
+                }
+                if (killed)
+                {
+                    stop();
+                }
+            }
+            m_dispatchQueue->close();
+        }
+        catch (...)
+        {
+            m_workerExceptions[workerNo] = std::current_exception();
+            m_dispatchQueue->close();
+            stop();
+        }
+    }
     // ==============
     // PUBLIC METHODS
     // ==============
@@ -50,17 +568,85 @@ namespace Antik::File
         const std::string &watchFolder,         // Watch folder path
         std::shared_ptr<CTask::IAction> action, // Action object
         int watchDepth,                         // Watch depth -1= all, 0=just watch folder
-        int killCount                           // Kill count
+        int killCount,                          // Kill count
+        std::shared_ptr<CTask::Options> options // Task options
         )
-        : m_taskAction{action}, m_killCount{killCount}
+        : m_watchFolder{watchFolder}, m_taskAction{action}, m_watchDepth{watchDepth}, m_killCount{killCount}
     {
         // ASSERT if passed parameters invalid
         assert(watchFolder.length() != 0); // Length == 0
         assert(watchDepth >= -1);          // < -1
         assert(action != nullptr);         // nullptr
         assert(killCount >= 0);            // < 0
-        // Create CFileApprise watcher object.
-        m_watcher = std::make_unique<CApprise>(watchFolder, watchDepth);
+        if ((m_watchFolder.size() > 1) && (m_watchFolder.back() == '/'))
+        {
+            m_watchFolder.pop_back();
+        }
+        if (options != nullptr)
+        {
+            m_options = *options;
+        }
+        // Create journal if enabled
+        if (!m_options.journalFolder.empty())
+        {
+            m_journal = std::make_unique<CTaskJournal>(m_options.journalFolder, m_options.journalSegmentSize,
+                                                       m_options.journalCommitInterval, m_options.journalCommitBatch);
+        }
+        // Create stabilizer if enabled
+        if (m_options.stabilityPeriod.count() != 0)
+        {
+            m_stabilizer = std::make_unique<CFileStabilizer>(m_options.stabilityPeriod, m_options.stabilityCheckStatus);
+        }
+        // Batch files if action supports it
+        if (m_options.batchSize != 0)
+        {
+            m_batchAction = std::dynamic_pointer_cast<IBatchAction>(m_taskAction);
+        }
+        // Create rate and adaptive concurrency limits if enabled
+        if (m_options.actionRate > 0.0)
+        {
+            m_rateLimiter = std::make_unique<CTokenBucket>(m_options.actionRate, m_options.actionBurst);
+        }
+        if (m_options.adaptiveConcurrency && (m_options.actionWorkers > 1))
+        {
+            m_concurrencyLimiter = std::make_unique<CConcurrencyLimiter>(1, m_options.actionWorkers);
+        }
+        // Create retry queue if failed files are to be retried or dead-lettered
+        if ((m_options.maxAttempts > 1) || !m_options.deadLetterFolder.empty())
+        {
+            m_retryQueue = std::make_unique<CRetryQueue>(m_options.maxAttempts, m_options.retryDelay, m_options.maxRetryDelay);
+        }
+        // Create CFileApprise watcher object (its event queue bounded and watch folder
+        // sharded if requested).
+        IFileEventNotifier::Options notifierOptions;
+        notifierOptions.maxQueuedEvents = m_options.maxQueuedEvents;
+        std::shared_ptr<IFileEventNotifier> fileEventNotifier;
+        if (m_options.watchShards > 1)
+        {
+            fileEventNotifier = std::make_shared<CShardedFileEventNotifier>(m_options.watchShards, notifierOptions);
+        }
+        else
+        {
+            fileEventNotifier = std::make_shared<CFileEventNotifier>(notifierOptions);
+        }
+        m_watcher = std::make_unique<CApprise>(watchFolder, watchDepth, fileEventNotifier);
+        // Create metrics (including those of watcher)
+        m_metrics = std::make_shared<CMetrics>();
+        m_filesProcessed = &m_metrics->counter("files_processed");
+        m_filesResumed = &m_metrics->counter("files_resumed");
+        m_processLatency = &m_metrics->histogram("process_latency_us");
+        m_actionDuration = &m_metrics->histogram("action_duration_us");
+        m_filesStabilizing = &m_metrics->gauge("files_stabilizing");
+        m_stabilityRestarts = &m_metrics->counter("stability_restarts");
+        m_dispatchQueueDepth = &m_metrics->gauge("dispatch_queue_depth");
+        m_batchSize = &m_metrics->histogram("batch_size");
+        m_actionFailures = &m_metrics->counter("action_failures");
+        m_concurrencyLimit = &m_metrics->gauge("concurrency_limit");
+        m_concurrencyLimit->set(std::max(m_options.actionWorkers, 1));
+        m_actionRetries = &m_metrics->counter("action_retries");
+        m_filesFailed = &m_metrics->counter("files_failed");
+        m_filesDeadLettered = &m_metrics->counter("files_dead_lettered");
+        m_metrics->addSource("watcher", m_watcher->getMetrics());
     }
     //
     // Destructor
@@ -76,33 +662,116 @@ namespace Antik::File
         return (m_thrownException);
     }
     //
-    // Flag watcher and task loops to stop.
+    // Return task metrics.
+    //
+    std::shared_ptr<CMetrics> CTask::getMetrics(void)
+    {
+        return (m_metrics);
+    }
+    //
+    // Flag watcher and task loops to stop (releasing anything waiting on a limit).
     //
     void CTask::stop(void)
     {
         m_watcher->stopWatching();
+        if (m_rateLimiter)
+        {
+            m_rateLimiter->close();
+        }
+        if (m_concurrencyLimiter)
+        {
+            m_concurrencyLimiter->close();
+        }
     }
     //
-    // Loop calling the action process() for each add file event.
+    // Loop calling the action process() for each add file event (after resuming
+    // from any journal).
     //
     void CTask::monitor(void)
     {
         try
         {
+            bool killed{false};
             m_taskAction->init();
+            std::int64_t watchTime{std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count()};
+            if (m_journal)
+            {
+                m_journal->open();
+            }
             m_watcher->startWatching(false);
+            if ((m_options.actionWorkers != 0) || m_options.dispatchPolicy)
+            {
+                startWorkers();
+            }
+            if (m_journal)
+            {
+                killed = resumeJournal(watchTime);
+            }
             // Loop until watcher stopped
-            while (m_watcher->stillWatching())
+            while (!killed && m_watcher->stillWatching())
             {
                 IApprise::Event evt;
-                m_watcher->getNextEvent(evt);
+                std::chrono::milliseconds eventTimeout{std::chrono::milliseconds::max()};
+                if (m_stabilizer && !m_stabilizer->empty())
+                {
+                    eventTimeout = m_stabilizer->tick();
+                }
+                if (m_retryQueue && (m_dispatchQueue || !m_retryQueue->empty()))
+                {
+                    eventTimeout = std::min(eventTimeout, m_retryQueue->tick());
+                }
+                if (!m_batchFiles.empty())
+                {
+                    auto batchWait{std::chrono::ceil<std::chrono::milliseconds>(m_batchStarted + m_options.batchDelay - std::chrono::steady_clock::now())};
+                    eventTimeout = std::clamp(batchWait, std::chrono::milliseconds(0), eventTimeout);
+                }
+                if (eventTimeout != std::chrono::milliseconds::max())
+                {
+                    m_watcher->getNextEvent(evt, eventTimeout);
+                }
+                else
+                {
+                    m_watcher->getNextEvent(evt);
+                }
+                // Skip add events generated while resuming for files resumed; forgetting
+                // them once events generated after resume finished arrive.
+                if (!m_resumed.empty())
+                {
+                    if (evt.time > m_resumeFinished)
+                    {
+                        m_resumed.clear();
+                    }
+                    else if ((evt.id == IApprise::Event_add) && (m_resumed.erase(evt.message) != 0))
+                    {
+                        continue; // Already passed on at resume
+                    }
+                }
                 if ((evt.id == IApprise::Event_add) && !evt.message.empty())
                 {
-                    m_taskAction->process(evt.message);
-                    if ((m_killCount != 0) && (--(m_killCount) == 0))
+                    journalReceived(evt.message);
+                    if (!m_stabilizer)
+                    {
+                        killed = dispatchFile(evt.message, evt.time);
+                    }
+                }
+                // Wait for files to be quiet before processing
+                if (m_stabilizer)
+                {
+                    if (m_stabilizer->add(evt))
                     {
-                        break;
+                        m_stabilityRestarts->add();
                     }
+                    killed = processStableFiles();
+                }
+                // Process batch whose first file has waited long enough
+                if (!killed && !m_batchFiles.empty() && (std::chrono::steady_clock::now() >= m_batchStarted + m_options.batchDelay))
+                {
+                    killed = flushBatch();
+                }
+                // Dispatch failed files whose retry is due
+                if (!killed && m_retryQueue)
+                {
+                    killed = processRetries();
                 }
             }
             // Pass any CFileApprise exceptions up chain
@@ -116,8 +785,24 @@ namespace Antik::File
             // Pass any CTask thrown exceptions up chain
             m_thrownException = std::current_exception();
         }
-        // Stop file watcher
+        // Stop file watcher and action workers
         m_watcher->stopWatching();
+        stopWorkers();
+        // Commit and close journal
+        if (m_journal)
+        {
+            try
+            {
+                m_journal->close();
+            }
+            catch (...)
+            {
+                if (!m_thrownException)
+                {
+                    m_thrownException = std::current_exception();
+                }
+            }
+        }
         m_taskAction->term();
     }
 } // namespace Antik::File
\ No newline at end of file
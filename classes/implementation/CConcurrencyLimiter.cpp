@@ -0,0 +1,137 @@
+//
+// Class: CConcurrencyLimiter
+//
+// Description: Adaptive limit on the number of CTask action workers processing files
+// at once (additive increase/multiplicative decrease). Each action call's latency is
+// compared against a baseline (the minimum latency seen over the last window of
+// samples); a call that fails or takes more than a tolerance over the baseline cuts
+// the limit by a backoff ratio while any other raises it by one over the limit (so by
+// about one per limit's worth of calls). The limit starts at its maximum so that it
+// only falls once the action slows down.
+//
+// Dependencies: C20++               - Language standard features used.
+//
+// =================
+// CLASS DEFINITIONS
+// =================
+#include "CConcurrencyLimiter.hpp"
+// ====================
+// CLASS IMPLEMENTATION
+// ====================
+//
+// C++ STL
+//
+#include <algorithm>
+// =========
+// NAMESPACE
+// =========
+namespace Antik::File
+{
+    // ===========================
+    // PRIVATE TYPES AND CONSTANTS
+    // ===========================
+    // Latency over baseline treated as overload
+    const double CConcurrencyLimiter::kLatencyTolerance{2.0};
+    // Latency over baseline never treated as overload
+    const std::chrono::microseconds CConcurrencyLimiter::kLatencySlack{1000};
+    // Limit multiplier on overload
+    const double CConcurrencyLimiter::kBackoffRatio{0.9};
+    // Samples per baseline window
+    const std::size_t CConcurrencyLimiter::kSampleWindow{100};
+    // ==========================
+    // PUBLIC TYPES AND CONSTANTS
+    // ==========================
+    // ========================
+    // PRIVATE STATIC VARIABLES
+    // ========================
+    // =======================
+    // PUBLIC STATIC VARIABLES
+    // =======================
+    // ===============
+    // PRIVATE METHODS
+    // ===============
+    // ==============
+    // PUBLIC METHODS
+    // ==============
+    //
+    // Main CConcurrencyLimiter object constructor.
+    //
+    CConcurrencyLimiter::CConcurrencyLimiter(std::size_t minLimit, std::size_t maxLimit)
+        : m_baselineLatency{std::chrono::microseconds::max()}, m_windowLatency{std::chrono::microseconds::max()}
+    {
+        m_minLimit = static_cast<double>(std::max(minLimit, std::size_t(1)));
+        m_maxLimit = std::max(m_minLimit, static_cast<double>(maxLimit));
+        m_limit = m_maxLimit;
+    }
+    //
+    // CConcurrencyLimiter Destructor
+    //
+    CConcurrencyLimiter::~CConcurrencyLimiter()
+    {
+    }
+    //
+    // Wait for slots in use to fall under the limit and take one. Returns false if the
+    // limiter is closed.
+    //
+    bool CConcurrencyLimiter::acquire(void)
+    {
+        std::unique_lock<std::mutex> locker(m_limiterMutex);
+        m_slotWaiting.wait(locker, [this] { return (m_closed || (static_cast<double>(m_inFlight + 1) <= m_limit)); });
+        if (m_closed)
+        {
+            return (false);
+        }
+        m_inFlight++;
+        return (true);
+    }
+    //
+    // Release slot.
+    //
+    void CConcurrencyLimiter::release(void)
+    {
+        std::unique_lock<std::mutex> locker(m_limiterMutex);
+        m_inFlight--;
+        m_slotWaiting.notify_one();
+    }
+    //
+    // Adjust limit for the latency and result of an action call.
+    //
+    void CConcurrencyLimiter::sample(std::chrono::microseconds latency, bool failed)
+    {
+        std::unique_lock<std::mutex> locker(m_limiterMutex);
+        m_windowLatency = std::min(m_windowLatency, latency);
+        std::chrono::microseconds baseline{std::min(m_baselineLatency, m_windowLatency)};
+        if (++m_windowSamples == kSampleWindow)
+        {
+            m_baselineLatency = m_windowLatency;
+            m_windowLatency = std::chrono::microseconds::max();
+            m_windowSamples = 0;
+        }
+        if (failed || ((latency > baseline + kLatencySlack) && (latency.count() > baseline.count() * kLatencyTolerance)))
+        {
+            m_limit = std::max(m_minLimit, m_limit * kBackoffRatio);
+        }
+        else
+        {
+            m_limit = std::min(m_maxLimit, m_limit + 1.0 / m_limit);
+            m_slotWaiting.notify_all();
+        }
+    }
+    //
+    // Close limiter; waking any waiting acquire.
+    //
+    void CConcurrencyLimiter::close(void)
+    {
+        std::unique_lock<std::mutex> locker(m_limiterMutex);
+        m_closed = true;
+        m_slotWaiting.notify_all();
+    }
+    //
+    // Return current limit (whole slots).
+    //
+    std::size_t CConcurrencyLimiter::limit(void) const
+    {
+        std::unique_lock<std::mutex> locker(m_limiterMutex);
+        return (static_cast<std::size_t>(m_limit));
+    }
+} // namespace Antik::File
@@ -0,0 +1,78 @@
+#ifndef CCONCURRENCYLIMITER_HPP
+#define CCONCURRENCYLIMITER_HPP
+//
+// C++ STL
+//
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+// =========
+// NAMESPACE
+// =========
+namespace Antik::File
+{
+    // ================
+    // CLASS DEFINITION
+    // ================
+    class CConcurrencyLimiter
+    {
+    public:
+        // ==========================
+        // PUBLIC TYPES AND CONSTANTS
+        // ==========================
+        // ============
+        // CONSTRUCTORS
+        // ============
+        //
+        // Main constructor
+        //
+        explicit CConcurrencyLimiter(std::size_t minLimit, std::size_t maxLimit);
+        // ==========
+        // DESTRUCTOR
+        // ==========
+        virtual ~CConcurrencyLimiter();
+        // ==============
+        // PUBLIC METHODS
+        // ==============
+        bool acquire(void);                                          // Wait for a slot under the limit (false when closed)
+        void release(void);                                          // Release slot
+        void sample(std::chrono::microseconds latency, bool failed); // Adjust limit for an action call's latency/result
+        void close(void);                                            // Close limiter; waiting acquires return false
+        std::size_t limit(void) const;                               // Current limit
+        // ================
+        // PUBLIC VARIABLES
+        // ================
+    private:
+        // ===========================
+        // PRIVATE TYPES AND CONSTANTS
+        // ===========================
+        //
+        // Latency over baseline treated as overload, slack below which it never is,
+        // limit multiplier on overload and samples per baseline window
+        //
+        static const double kLatencyTolerance;
+        static const std::chrono::microseconds kLatencySlack;
+        static const double kBackoffRatio;
+        static const std::size_t kSampleWindow;
+        // ===========================================
+        // DISABLED CONSTRUCTORS/DESTRUCTORS/OPERATORS
+        // ===========================================
+        CConcurrencyLimiter(const CConcurrencyLimiter &orig) = delete;
+        CConcurrencyLimiter(const CConcurrencyLimiter &&orig) = delete;
+        CConcurrencyLimiter &operator=(CConcurrencyLimiter other) = delete;
+        // =================
+        // PRIVATE VARIABLES
+        // =================
+        double m_minLimit{1.0};                      // Lowest limit
+        double m_maxLimit{1.0};                      // Highest limit
+        double m_limit{1.0};                         // Current limit
+        std::size_t m_inFlight{0};                   // Slots in use
+        std::chrono::microseconds m_baselineLatency; // Minimum latency of last complete window
+        std::chrono::microseconds m_windowLatency;   // Minimum latency of current window
+        std::size_t m_windowSamples{0};              // Samples in current window
+        bool m_closed{false};                        // Limiter closed
+        mutable std::mutex m_limiterMutex;           // Limiter mutex
+        std::condition_variable m_slotWaiting;       // Slot wait condition
+    };
+} // namespace Antik::File
+#endif /* CCONCURRENCYLIMITER_HPP */
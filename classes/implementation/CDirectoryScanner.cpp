@@ -0,0 +1,155 @@
+//
+// Class: CDirectoryScanner
+//
+// Description: Read the contents of directories using the getdents64 system call
+// (in large batches) splitting them into regular files and sub-directories. A list
+// of directories (for example a level of a directory hierarchy) may be read in
+// parallel across a number of threads. Used by the file event notifiers to scan
+// directories that they watch.
+//
+// Dependencies: C20++               - Language standard features used.
+//               getdents64/Linux    - Linux directory reading
+//
+// =================
+// CLASS DEFINITIONS
+// =================
+#include "CDirectoryScanner.hpp"
+// ====================
+// CLASS IMPLEMENTATION
+// ====================
+//
+// C++ STL
+//
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+//
+// Linux
+//
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+// =========
+// NAMESPACE
+// =========
+namespace Antik::File
+{
+    // ===========================
+    // PRIVATE TYPES AND CONSTANTS
+    // ===========================
+    // getdents64 directory read buffer size
+    const std::uint32_t CDirectoryScanner::kScanBufferLen{32 * 1024};
+    // ==========================
+    // PUBLIC TYPES AND CONSTANTS
+    // ==========================
+    // ========================
+    // PRIVATE STATIC VARIABLES
+    // ========================
+    // =======================
+    // PUBLIC STATIC VARIABLES
+    // =======================
+    // ===============
+    // PRIVATE METHODS
+    // ===============
+    // ==============
+    // PUBLIC METHODS
+    // ==============
+    //
+    // Read a directories entries with getdents64 and split them into files and
+    // sub-directories (getting the status of each file if requested). Note: This is
+    // run on scan worker threads so any error is returned in the scan result rather
+    // than thrown.
+    //
+    void CDirectoryScanner::readDirectory(const std::string &directoryPath, ScanResult &scanResult, bool fileStatus)
+    {
+        int directoryFd{0};
+        if ((directoryFd = open(directoryPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC)) == -1)
+        {
+            scanResult.error = errno;
+            return;
+        }
+        std::unique_ptr<std::uint8_t[]> buffer{std::make_unique<std::uint8_t[]>(kScanBufferLen)};
+        while (true)
+        {
+            long readLen{0};
+            if ((readLen = syscall(SYS_getdents64, directoryFd, buffer.get(), kScanBufferLen)) <= 0)
+            {
+                if (readLen == -1)
+                {
+                    scanResult.error = errno;
+                }
+                break;
+            }
+            // Loop until all entries in batch processed
+            for (long currentPos = 0; currentPos < readLen;)
+            {
+                struct dirent64 *entry = reinterpret_cast<struct dirent64 *>(&buffer[currentPos]);
+                currentPos += entry->d_reclen;
+                std::string entryName{entry->d_name};
+                if ((entryName == ".") || (entryName == ".."))
+                {
+                    continue;
+                }
+                unsigned char entryType{entry->d_type};
+                struct stat entryStat;
+                bool haveStat{false};
+                if ((entryType == DT_UNKNOWN) || (fileStatus && (entryType == DT_REG)))
+                {
+                    if ((haveStat = (fstatat(directoryFd, entry->d_name, &entryStat, AT_SYMLINK_NOFOLLOW) == 0)))
+                    {
+                        entryType = S_ISDIR(entryStat.st_mode) ? DT_DIR : S_ISREG(entryStat.st_mode) ? DT_REG : DT_UNKNOWN;
+                    }
+                    else if (entryType == DT_REG)
+                    {
+                        continue; // Removed since read
+                    }
+                }
+                if (entryType == DT_DIR)
+                {
+                    scanResult.directories.push_back(directoryPath + "/" + entryName);
+                }
+                else if (entryType == DT_REG)
+                {
+                    scanResult.files.push_back(directoryPath + "/" + entryName);
+                    if (fileStatus && haveStat)
+                    {
+                        scanResult.fileStatus.push_back({static_cast<std::uint64_t>(entryStat.st_size),
+                                                         static_cast<std::int64_t>(entryStat.st_mtim.tv_sec) * 1000000000 + entryStat.st_mtim.tv_nsec,
+                                                         static_cast<std::uint64_t>(entryStat.st_ino),
+                                                         static_cast<std::int64_t>(entryStat.st_ctim.tv_sec) * 1000000000 + entryStat.st_ctim.tv_nsec});
+                    }
+                }
+            }
+        }
+        close(directoryFd);
+    }
+    //
+    // Read a list of directories in parallel over a number of threads (the calling
+    // thread included) with the results returned in the same order as the list.
+    //
+    void CDirectoryScanner::readDirectories(const std::vector<std::string> &directories, std::vector<ScanResult> &scanResults, int threads, bool fileStatus)
+    {
+        scanResults.clear();
+        scanResults.resize(directories.size());
+        std::atomic<std::size_t> nextDirectory{0};
+        auto scanWorker = [&]() {
+            for (std::size_t index{0}; (index = nextDirectory++) < directories.size();)
+            {
+                readDirectory(directories[index], scanResults[index], fileStatus);
+            }
+        };
+        std::vector<std::thread> scanThreads;
+        for (std::size_t thread = 1; thread < std::min(static_cast<std::size_t>(std::max(threads, 1)), directories.size()); thread++)
+        {
+            scanThreads.emplace_back(scanWorker);
+        }
+        scanWorker();
+        for (auto &scanThread : scanThreads)
+        {
+            scanThread.join();
+        }
+    }
+} // namespace Antik::File
@@ -0,0 +1,78 @@
+#ifndef CDIRECTORYSCANNER_HPP
+#define CDIRECTORYSCANNER_HPP
+//
+// C++ STL
+//
+#include <string>
+#include <vector>
+#include <cstdint>
+// =========
+// NAMESPACE
+// =========
+namespace Antik::File
+{
+    // ================
+    // CLASS DEFINITION
+    // ================
+    class CDirectoryScanner
+    {
+    public:
+        // ==========================
+        // PUBLIC TYPES AND CONSTANTS
+        // ==========================
+        //
+        // Status of a scanned file
+        //
+        struct FileStatus
+        {
+            std::uint64_t size{0};    // File size
+            std::int64_t modified{0}; // Last modification time (nanoseconds)
+            std::uint64_t inode{0};   // Inode number
+            std::int64_t changed{0};  // Last status change time (nanoseconds)
+        };
+        //
+        // Contents of a single scanned directory
+        //
+        struct ScanResult
+        {
+            std::vector<std::string> files;       // Regular files found
+            std::vector<FileStatus> fileStatus;   // Status of each file found (if requested)
+            std::vector<std::string> directories; // Sub-directories found
+            int error{0};                         // errno of any failure
+        };
+        // ============
+        // CONSTRUCTORS
+        // ============
+        // ==========
+        // DESTRUCTOR
+        // ==========
+        // ==============
+        // PUBLIC METHODS
+        // ==============
+        static void readDirectory(const std::string &directoryPath, ScanResult &scanResult, bool fileStatus = false);
+        static void readDirectories(const std::vector<std::string> &directories, std::vector<ScanResult> &scanResults, int threads, bool fileStatus = false);
+        // ================
+        // PUBLIC VARIABLES
+        // ================
+    private:
+        // ===========================
+        // PRIVATE TYPES AND CONSTANTS
+        // ===========================
+        static const std::uint32_t kScanBufferLen; // getdents64 read buffer length
+        // ===========================================
+        // DISABLED CONSTRUCTORS/DESTRUCTORS/OPERATORS
+        // ===========================================
+        CDirectoryScanner() = delete;
+        virtual ~CDirectoryScanner() = delete;
+        CDirectoryScanner(const CDirectoryScanner &orig) = delete;
+        CDirectoryScanner(const CDirectoryScanner &&orig) = delete;
+        CDirectoryScanner &operator=(CDirectoryScanner other) = delete;
+        // ===============
+        // PRIVATE METHODS
+        // ===============
+        // =================
+        // PRIVATE VARIABLES
+        // =================
+    };
+} // namespace Antik::File
+#endif /* CDIRECTORYSCANNER_HPP */
@@ -0,0 +1,144 @@
+//
+// Class: CDispatchQueue
+//
+// Description: Concurrent priority queue of files between the CTask monitor loop and
+// its action workers. Files are ranked by a dispatch policy when queued and popped
+// lowest rank first (in the order queued for equal ranks so that without a policy the
+// queue is first in first out). If a dispatch limit is given (the task kill count) the
+// queue closes once that many files have been popped so that no worker starts on a
+// file past it. If a maximum is given then push waits while the queue is full, which
+// holds up the monitor loop and so passes backpressure on to the watcher.
+//
+// Dependencies: C20++               - Language standard features used.
+//
+// =================
+// CLASS DEFINITIONS
+// =================
+#include "CDispatchQueue.hpp"
+// ====================
+// CLASS IMPLEMENTATION
+// ====================
+// =========
+// NAMESPACE
+// =========
+namespace Antik::File
+{
+    // ===========================
+    // PRIVATE TYPES AND CONSTANTS
+    // ===========================
+    // ==========================
+    // PUBLIC TYPES AND CONSTANTS
+    // ==========================
+    // ========================
+    // PRIVATE STATIC VARIABLES
+    // ========================
+    // =======================
+    // PUBLIC STATIC VARIABLES
+    // =======================
+    // ===============
+    // PRIVATE METHODS
+    // ===============
+    //
+    // Pop lowest ranked file and close the queue if its dispatch limit is reached;
+    // called with the queue locked and at least one file queued.
+    //
+    void CDispatchQueue::dispatch(QueuedFile &queuedFile)
+    {
+        queuedFile = m_queuedFiles.top();
+        m_queuedFiles.pop();
+        m_spaceWaiting.notify_one();
+        if (m_policy)
+        {
+            m_policy->dispatched(queuedFile.filePath, queuedFile.rank);
+        }
+        if ((m_dispatchLimit != 0) && (++m_dispatched == m_dispatchLimit))
+        {
+            m_closed = true;
+            m_queueWaiting.notify_all();
+            m_spaceWaiting.notify_all();
+        }
+    }
+    // ==============
+    // PUBLIC METHODS
+    // ==============
+    //
+    // Main CDispatchQueue object constructor.
+    //
+    CDispatchQueue::CDispatchQueue(std::shared_ptr<IDispatchPolicy> policy, std::size_t dispatchLimit, std::size_t maxQueued)
+        : m_policy{policy}, m_dispatchLimit{dispatchLimit}, m_maxQueued{maxQueued}
+    {
+    }
+    //
+    // CDispatchQueue Destructor
+    //
+    CDispatchQueue::~CDispatchQueue()
+    {
+    }
+    //
+    // Rank and queue file; waiting while a bounded queue is full (the file is dropped if
+    // the queue is closed).
+    //
+    void CDispatchQueue::push(const std::string &filePath, Clock::time_point received)
+    {
+        std::unique_lock<std::mutex> locker(m_queueMutex);
+        m_spaceWaiting.wait(locker, [this] { return (m_closed || (m_maxQueued == 0) || (m_queuedFiles.size() < m_maxQueued)); });
+        if (m_closed)
+        {
+            return;
+        }
+        IDispatchPolicy::Rank rank;
+        if (m_policy)
+        {
+            rank = m_policy->rank(filePath, received);
+        }
+        m_queuedFiles.push({rank, ++m_sequence, filePath, received});
+        m_queueWaiting.notify_one();
+    }
+    //
+    // Wait for and pop the lowest ranked file. Returns false once the queue is closed
+    // or its dispatch limit reached.
+    //
+    bool CDispatchQueue::pop(QueuedFile &queuedFile)
+    {
+        std::unique_lock<std::mutex> locker(m_queueMutex);
+        m_queueWaiting.wait(locker, [this] { return (m_closed || !m_queuedFiles.empty()); });
+        if (m_closed)
+        {
+            return (false);
+        }
+        dispatch(queuedFile);
+        return (true);
+    }
+    //
+    // Wait until deadline for and pop the lowest ranked file. Returns false if the
+    // deadline passes with nothing queued or once the queue is closed.
+    //
+    bool CDispatchQueue::pop(QueuedFile &queuedFile, Clock::time_point deadline)
+    {
+        std::unique_lock<std::mutex> locker(m_queueMutex);
+        if (!m_queueWaiting.wait_until(locker, deadline, [this] { return (m_closed || !m_queuedFiles.empty()); }) || m_closed)
+        {
+            return (false);
+        }
+        dispatch(queuedFile);
+        return (true);
+    }
+    //
+    // Close queue; any files still queued are not dispatched.
+    //
+    void CDispatchQueue::close(void)
+    {
+        std::unique_lock<std::mutex> locker(m_queueMutex);
+        m_closed = true;
+        m_queueWaiting.notify_all();
+        m_spaceWaiting.notify_all();
+    }
+    //
+    // Return number of files queued.
+    //
+    std::size_t CDispatchQueue::size(void) const
+    {
+        std::unique_lock<std::mutex> locker(m_queueMutex);
+        return (m_queuedFiles.size());
+    }
+} // namespace Antik::File
@@ -0,0 +1,111 @@
+#ifndef CDISPATCHQUEUE_HPP
+#define CDISPATCHQUEUE_HPP
+//
+// C++ STL
+//
+#include <string>
+#include <vector>
+#include <queue>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+//
+// Antik classes
+//
+#include "IDispatchPolicy.hpp"
+// =========
+// NAMESPACE
+// =========
+namespace Antik::File
+{
+    // ================
+    // CLASS DEFINITION
+    // ================
+    class CDispatchQueue
+    {
+    public:
+        // ==========================
+        // PUBLIC TYPES AND CONSTANTS
+        // ==========================
+        using Clock = std::chrono::steady_clock;
+        //
+        // Queued file
+        //
+        struct QueuedFile
+        {
+            IDispatchPolicy::Rank rank; // Dispatch rank
+            std::uint64_t sequence;     // Queue sequence number
+            std::string filePath;       // File path
+            Clock::time_point received; // Time file event generated
+        };
+        // ============
+        // CONSTRUCTORS
+        // ============
+        //
+        // Main constructor
+        //
+        explicit CDispatchQueue(std::shared_ptr<IDispatchPolicy> policy = nullptr, std::size_t dispatchLimit = 0, std::size_t maxQueued = 0);
+        // ==========
+        // DESTRUCTOR
+        // ==========
+        virtual ~CDispatchQueue();
+        // ==============
+        // PUBLIC METHODS
+        // ==============
+        void push(const std::string &filePath, Clock::time_point received); // Queue file (waiting for space if bounded)
+        bool pop(QueuedFile &queuedFile);                                   // Wait for next file (false when closed)
+        bool pop(QueuedFile &queuedFile, Clock::time_point deadline);       // Wait until deadline for next file (false when closed/timed out)
+        void close(void);                                                   // Close queue; waiting pops return false
+        std::size_t size(void) const;                                       // Files queued
+        // ================
+        // PUBLIC VARIABLES
+        // ================
+    private:
+        // ===========================
+        // PRIVATE TYPES AND CONSTANTS
+        // ===========================
+        //
+        // Queue order (lowest rank then sequence first)
+        //
+        struct QueueOrder
+        {
+            bool operator()(const QueuedFile &lhs, const QueuedFile &rhs) const
+            {
+                if (lhs.rank < rhs.rank)
+                {
+                    return (false);
+                }
+                if (rhs.rank < lhs.rank)
+                {
+                    return (true);
+                }
+                return (lhs.sequence > rhs.sequence);
+            }
+        };
+        // ===========================================
+        // DISABLED CONSTRUCTORS/DESTRUCTORS/OPERATORS
+        // ===========================================
+        CDispatchQueue(const CDispatchQueue &orig) = delete;
+        CDispatchQueue(const CDispatchQueue &&orig) = delete;
+        CDispatchQueue &operator=(CDispatchQueue other) = delete;
+        // ===============
+        // PRIVATE METHODS
+        // ===============
+        void dispatch(QueuedFile &queuedFile); // Pop lowest ranked file (queue locked)
+        // =================
+        // PRIVATE VARIABLES
+        // =================
+        std::shared_ptr<IDispatchPolicy> m_policy;                                          // Dispatch policy (nullptr = FIFO)
+        std::size_t m_dispatchLimit{0};                                                     // Files dispatched before queue closes (0 = no limit)
+        std::size_t m_maxQueued{0};                                                         // Files queued before push waits (0 = unbounded)
+        std::size_t m_dispatched{0};                                                        // Files dispatched
+        std::uint64_t m_sequence{0};                                                        // Queue sequence number
+        bool m_closed{false};                                                               // Queue closed
+        mutable std::mutex m_queueMutex;                                                    // Queue mutex
+        std::condition_variable m_queueWaiting;                                             // Queue wait condition
+        std::condition_variable m_spaceWaiting;                                             // Queue space wait condition
+        std::priority_queue<QueuedFile, std::vector<QueuedFile>, QueueOrder> m_queuedFiles; // Queued files
+    };
+} // namespace Antik::File
+#endif /* CDISPATCHQUEUE_HPP */
@@ -0,0 +1,850 @@
+//
+// Class: CFanotifyFileEventNotifier
+//
+// Description: File event notifier pass to CApprise class constructor. This is a
+// Linux fanotify implementation that marks the whole filesystem holding each watch
+// folder once (FAN_MARK_FILESYSTEM) rather than adding a watch per directory; so
+// there are no per-directory watches to add/remove as the hierarchy changes and no
+// window in which files created in a new directory are missed. Events report the
+// directory (as a file handle) and name of the entry (FAN_REPORT_DFID_NAME) with
+// directory handles resolved to paths through open_by_handle_at() and cached; any
+// event not within a watch folder (or deeper than the watch depth) is discarded.
+//
+// It produces the same IApprise::Event stream as the inotify notifier and shares
+// the initial scan and event coalescing options. Note: fanotify can only say that a
+// directory was moved from/to so a directory moved to immediately after one was moved
+// from within a watch folder is taken to be a rename; anything else is treated as new.
+// Watch folders are held (and events reported) as canonical paths.
+//
+// Requires Linux 5.9+ and CAP_SYS_ADMIN (constructor throws if fanotify is unavailable).
+//
+// Dependencies: C20++               - Language standard features used.
+//               fanotify/Linux      - Linux file system events
+//
+// =================
+// CLASS DEFINITIONS
+// =================
+#include "CFanotifyFileEventNotifier.hpp"
+// ====================
+// CLASS IMPLEMENTATION
+// ====================
+//
+// C++ STL
+//
+#include <mutex>
+#include <system_error>
+#include <algorithm>
+#include <cstring>
+//
+// Linux
+//
+#include <sys/ioctl.h>
+#include <sys/eventfd.h>
+#include <sys/vfs.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <climits>
+#include <cstdlib>
+// =========
+// NAMESPACE
+// =========
+namespace Antik::File
+{
+    // ===========================
+    // PRIVATE TYPES AND CONSTANTS
+    // ===========================
+    // fanotify events to recieve
+    const std::uint64_t CFanotifyFileEventNotifier::kFanotifyEvents{
+        FAN_CREATE | FAN_MOVED_TO | FAN_MOVED_FROM | FAN_DELETE |
+        FAN_CLOSE_WRITE | FAN_MODIFY | FAN_ONDIR};
+    // fanotify event read buffer size
+    const std::uint32_t CFanotifyFileEventNotifier::kFanotifyEventBuffLen{64 * 1024};
+    // Maximum number of resolved directory handles cached
+    const std::size_t CFanotifyFileEventNotifier::kMaxDirectoryHandleCache{16 * 1024};
+    // CFanotifyFileEventNotifier logging prefix
+    const std::string CFanotifyFileEventNotifier::kLogPrefix{"[CFanotifyFileEventNotifier] "};
+    // ==========================
+    // PUBLIC TYPES AND CONSTANTS
+    // ==========================
+    // ========================
+    // PRIVATE STATIC VARIABLES
+    // ========================
+    // =======================
+    // PUBLIC STATIC VARIABLES
+    // =======================
+    // ===============
+    // PRIVATE METHODS
+    // ===============
+    //
+    // Filesystem id as a single value.
+    //
+    static std::uint64_t filesystemId(const void *fsid)
+    {
+        std::uint64_t id{0};
+        std::memcpy(&id, fsid, sizeof(id));
+        return (id);
+    }
+    //
+    // Remove all filesystem marks and wake the watch loop so that it stops.
+    //
+    void CFanotifyFileEventNotifier::destroyWatchTable(void)
+    {
+        if (fanotify_mark(m_fanotifyFd, FAN_MARK_FLUSH | FAN_MARK_FILESYSTEM, 0, AT_FDCWD, nullptr) == -1)
+        {
+            throw std::system_error(std::error_code(errno, std::system_category()), "fanotify_mark() error");
+        }
+        std::uint64_t stop{1};
+        if (write(m_stopFd, &stop, sizeof(stop)) == -1)
+        {
+            throw std::system_error(std::error_code(errno, std::system_category()), "eventfd write() error");
+        }
+    }
+    //
+    // Initialize fanotify (reporting directory handle and name) and the eventfd used to stop.
+    //
+    void CFanotifyFileEventNotifier::initialiseWatchTable(void)
+    {
+        if ((m_fanotifyFd = fanotify_init(FAN_CLASS_NOTIF | FAN_REPORT_DFID_NAME | FAN_CLOEXEC | FAN_NONBLOCK, O_RDONLY | O_LARGEFILE)) == -1)
+        {
+            throw std::system_error(std::error_code(errno, std::system_category()), "fanotify_init() error");
+        }
+        if ((m_stopFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) == -1)
+        {
+            throw std::system_error(std::error_code(errno, std::system_category()), "eventfd() error");
+        }
+    }
+    //
+    // Return true if path is not deeper than the maximum watch depth.
+    //
+    bool CFanotifyFileEventNotifier::withinWatchDepth(const std::string &filePath) const
+    {
+        return ((m_watchDepth == -1) || (std::count(filePath.begin(), filePath.end(), '/') <= m_watchDepth));
+    }
+    //
+    // Return true if path is a watch folder or lies below one (and not below a
+    // directory whose watch has been removed).
+    //
+    bool CFanotifyFileEventNotifier::withinWatchFolder(const std::string &filePath) const
+    {
+        auto within = [&filePath](const std::string &directoryPath) {
+            return ((filePath.size() >= directoryPath.size()) && (filePath.compare(0, directoryPath.size(), directoryPath) == 0) &&
+                    ((filePath.size() == directoryPath.size()) || (filePath[directoryPath.size()] == '/')));
+        };
+        if (std::none_of(m_watchFolders.begin(), m_watchFolders.end(), [&within](auto &watchFolder) { return within(watchFolder.first); }))
+        {
+            return (false);
+        }
+        return (std::none_of(m_removedDirectories.begin(), m_removedDirectories.end(), within));
+    }
+    //
+    // Remove a watch folder unmarking its filesystem if it holds no others.
+    //
+    void CFanotifyFileEventNotifier::releaseWatchFolder(const std::string &watchFolder)
+    {
+        auto watched = m_watchFolders.find(watchFolder);
+        if (watched == m_watchFolders.end())
+        {
+            return;
+        }
+        auto markedFilesystem = m_markedFilesystems.find(watched->second);
+        m_watchFolders.erase(watched);
+        m_directoryHandles.clear();
+        if ((markedFilesystem != m_markedFilesystems.end()) && (--markedFilesystem->second.watchFolders == 0))
+        {
+            if ((fanotify_mark(m_fanotifyFd, FAN_MARK_REMOVE | FAN_MARK_FILESYSTEM, kFanotifyEvents, markedFilesystem->second.mountFd, nullptr) == -1) && (errno != ENOENT))
+            {
+                throw std::system_error(std::error_code(errno, std::system_category()), "fanotify_mark() error");
+            }
+            close(markedFilesystem->second.mountFd);
+            m_markedFilesystems.erase(markedFilesystem);
+        }
+    }
+    //
+    // Resolve the directory file handle of an event into its path (using the
+    // handle cache where possible). Returns false if the directory no longer
+    // exists or is not on a marked filesystem.
+    //
+    bool CFanotifyFileEventNotifier::directoryPath(const struct fanotify_event_info_fid *fid, std::string &filePath)
+    {
+        const struct file_handle *handle{reinterpret_cast<const struct file_handle *>(fid->handle)};
+        m_handleKey.assign(reinterpret_cast<const char *>(&fid->fsid), sizeof(fid->fsid));
+        m_handleKey.append(reinterpret_cast<const char *>(&handle->handle_type), sizeof(handle->handle_type));
+        m_handleKey.append(reinterpret_cast<const char *>(handle->f_handle), handle->handle_bytes);
+        auto cached = m_directoryHandles.find(m_handleKey);
+        if (cached != m_directoryHandles.end())
+        {
+            filePath = cached->second;
+            return (true);
+        }
+        auto markedFilesystem = m_markedFilesystems.find(filesystemId(&fid->fsid));
+        if (markedFilesystem == m_markedFilesystems.end())
+        {
+            return (false);
+        }
+        int directoryFd{open_by_handle_at(markedFilesystem->second.mountFd, const_cast<struct file_handle *>(handle), O_PATH | O_CLOEXEC)};
+        if (directoryFd == -1)
+        {
+            if ((errno == ESTALE) || (errno == ENOENT))
+            {
+                return (false);
+            }
+            throw std::system_error(std::error_code(errno, std::system_category()), "open_by_handle_at() error");
+        }
+        char linkPath[PATH_MAX];
+        std::string procPath{"/proc/self/fd/" + std::to_string(directoryFd)};
+        ssize_t linkLen{readlink(procPath.c_str(), linkPath, sizeof(linkPath))};
+        close(directoryFd);
+        if ((linkLen <= 0) || (linkLen == sizeof(linkPath)))
+        {
+            return (false);
+        }
+        filePath.assign(linkPath, linkLen);
+        // Directory unlinked since event was queued
+        static const std::string kDeleted{" (deleted)"};
+        if ((filePath.size() > kDeleted.size()) && (filePath.compare(filePath.size() - kDeleted.size(), kDeleted.size(), kDeleted) == 0))
+        {
+            return (false);
+        }
+        if (m_directoryHandles.size() >= kMaxDirectoryHandleCache)
+        {
+            m_directoryHandles.clear();
+        }
+        m_directoryHandles[m_handleKey] = filePath;
+        return (true);
+    }
+    //
+    // Scan passed directories and any sub-directories within the watch depth a level
+    // at a time; reading each level in parallel. Event_addir is sent for sub-directories
+    // found if requested while Event_add is sent for every file found that is not
+    // already in the process of being created (and so will be reported by fanotify).
+    //
+    void CFanotifyFileEventNotifier::scanDirectories(const std::vector<std::string> &directories, bool reportDirectories)
+    {
+        std::vector<std::string> level{directories};
+        while (!level.empty())
+        {
+            std::vector<CDirectoryScanner::ScanResult> scanResults;
+            CDirectoryScanner::readDirectories(level, scanResults, m_options.scanThreads);
+            std::vector<std::string> nextLevel;
+            for (auto &scanResult : scanResults)
+            {
+                // Directory removed since being found so ignore.
+                if ((scanResult.error == ENOENT) || (scanResult.error == ENOTDIR))
+                {
+                    continue;
+                }
+                if (scanResult.error)
+                {
+                    throw std::system_error(std::error_code(scanResult.error, std::system_category()), "getdents64() error");
+                }
+                for (auto &filePath : scanResult.files)
+                {
+                    if (m_inProcessOfCreation.find(filePath) == m_inProcessOfCreation.end() && !wasScanReported(filePath))
+                    {
+                        markScanReported(filePath);
+                        sendEvent(IApprise::Event_add, filePath);
+                    }
+                }
+                for (auto &directoryPath : scanResult.directories)
+                {
+                    if (withinWatchDepth(directoryPath) && withinWatchFolder(directoryPath) && !wasScanReported(directoryPath))
+                    {
+                        if (reportDirectories)
+                        {
+                            markScanReported(directoryPath);
+                            sendEvent(IApprise::Event_addir, directoryPath);
+                        }
+                        nextLevel.push_back(directoryPath);
+                    }
+                }
+            }
+            level = std::move(nextLevel);
+        }
+    }
+    //
+    // Record a path as reported by a scan. Any fanotify event for the path that was
+    // queued before the scan finished (ie. before the number of bytes currently read
+    // plus those waiting to be read have been processed) is then ignored.
+    //
+    void CFanotifyFileEventNotifier::markScanReported(const std::string &filePath)
+    {
+        unsigned int bytesAvailable{0};
+        ioctl(m_fanotifyFd, FIONREAD, &bytesAvailable);
+        m_scanReported[filePath] = m_fanotifyBytesRead + bytesAvailable;
+        m_scanReportedExpiry.emplace_back(m_fanotifyBytesRead + bytesAvailable, filePath);
+    }
+    //
+    // Return true if path has been reported by a scan whose events have not yet
+    // all been processed; removing it so that only one event is ignored.
+    //
+    bool CFanotifyFileEventNotifier::wasScanReported(const std::string &filePath)
+    {
+        auto scanReported = m_scanReported.find(filePath);
+        if (scanReported != m_scanReported.end())
+        {
+            bool stillValid{scanReported->second > m_fanotifyBytesProcessed};
+            m_scanReported.erase(scanReported);
+            return (stillValid);
+        }
+        return (false);
+    }
+    //
+    // Remove any scan reported paths whose events have now all been processed.
+    //
+    void CFanotifyFileEventNotifier::expireScanReported(void)
+    {
+        while (!m_scanReportedExpiry.empty() && (m_scanReportedExpiry.front().first <= m_fanotifyBytesProcessed))
+        {
+            auto scanReported = m_scanReported.find(m_scanReportedExpiry.front().second);
+            if ((scanReported != m_scanReported.end()) && (scanReported->second <= m_fanotifyBytesProcessed))
+            {
+                m_scanReported.erase(scanReported);
+            }
+            m_scanReportedExpiry.pop_front();
+        }
+    }
+    //
+    // Process a fanotify event. An event may have several merged actions which are
+    // handled in the order they would have happened.
+    //
+    void CFanotifyFileEventNotifier::processEvent(std::uint64_t mask, const std::string &filePath, const std::string &directoryPath)
+    {
+        bool directoryRenamed{m_directoryMovedFrom};
+        m_directoryMovedFrom = false;
+        // Watch folder itself deleted or moved away so remove it
+        if ((mask & FAN_ONDIR) && (mask & (FAN_DELETE | FAN_MOVED_FROM)) && (m_watchFolders.count(filePath) != 0))
+        {
+            releaseWatchFolder(filePath);
+            return;
+        }
+        // Not for a directory being watched so ignore
+        if (!withinWatchFolder(directoryPath) || !withinWatchDepth(directoryPath))
+        {
+            return;
+        }
+        if (mask & FAN_ONDIR)
+        {
+            // Directory moved so hold until next event to see if it is a rename
+            if (mask & FAN_MOVED_FROM)
+            {
+                m_directoryHandles.clear();
+                m_directoryMovedFrom = true;
+            }
+            // Directory renamed within hierarchy just send Event_addir; otherwise new
+            // so send Event_addir and if scanning report anything already created in it.
+            if (mask & (FAN_CREATE | FAN_MOVED_TO))
+            {
+                if (mask & FAN_MOVED_TO)
+                {
+                    m_directoryHandles.clear();
+                }
+                m_removedDirectories.erase(filePath);
+                if (!wasScanReported(filePath))
+                {
+                    sendEvent(IApprise::Event_addir, filePath);
+                    if (m_options.initialScan && !((mask & FAN_MOVED_TO) && directoryRenamed) && withinWatchDepth(filePath))
+                    {
+                        scanDirectories({filePath}, true);
+                    }
+                }
+            }
+            // Directory deleted send Event_unlinkdir
+            if (mask & FAN_DELETE)
+            {
+                m_removedDirectories.erase(filePath);
+                sendEvent(IApprise::Event_unlinkdir, filePath);
+            }
+            return;
+        }
+        // Flag file as being created (unless already reported by a scan)
+        if ((mask & FAN_CREATE) && !wasScanReported(filePath))
+        {
+            m_inProcessOfCreation.insert(filePath);
+        }
+        // If file not being created send Event_change
+        if ((mask & FAN_MODIFY) && !(mask & FAN_CLOSE_WRITE) && (m_inProcessOfCreation.find(filePath) == m_inProcessOfCreation.end()))
+        {
+            sendEvent(IApprise::Event_change, filePath);
+        }
+        // File closed. If being created send Event_add otherwise Event_change.
+        if (mask & FAN_CLOSE_WRITE)
+        {
+            if (m_inProcessOfCreation.erase(filePath) == 0)
+            {
+                sendEvent(IApprise::Event_change, filePath);
+            }
+            else
+            {
+                sendEvent(IApprise::Event_add, filePath);
+            }
+        }
+        // File moved into directory send Event_add (unless already reported by a scan).
+        if ((mask & FAN_MOVED_TO) && !wasScanReported(filePath))
+        {
+            sendEvent(IApprise::Event_add, filePath);
+        }
+        // File deleted send Event_unlink
+        if (mask & FAN_DELETE)
+        {
+            m_inProcessOfCreation.erase(filePath);
+            sendEvent(IApprise::Event_unlink, filePath);
+        }
+    }
+    //
+    // Generate CFanotifyFileEventNotifier event; held until queued by queueGeneratedEvents().
+    //
+    void CFanotifyFileEventNotifier::sendEvent(IApprise::EventId id, const std::string &fileName)
+    {
+        m_generatedEvents.emplace_back(id, fileName);
+    }
+    //
+    // Pass events generated (while the watch table was locked) to the coalescing stage
+    // or queue.
+    //
+    void CFanotifyFileEventNotifier::queueGeneratedEvents(void)
+    {
+        for (auto &evt : m_generatedEvents)
+        {
+            if (m_coalescer && CFileEventCoalescer::coalesces(evt.id))
+            {
+                m_coalescer->add(evt);
+            }
+            else
+            {
+                queueEvent(evt);
+            }
+        }
+        m_generatedEvents.clear();
+    }
+    //
+    // Place event on queue and wake any waiting reader.
+    //
+    void CFanotifyFileEventNotifier::queueEvent(const IApprise::Event &evt)
+    {
+        std::unique_lock<std::mutex> locker(m_queuedEventsMutex);
+        // Wait for space in a bounded queue; only on the event generation thread so that
+        // a consumer whose addWatch() scan queues events cannot block itself.
+        if ((m_options.maxQueuedEvents != 0) && (m_queuedEvents.size() >= m_options.maxQueuedEvents) &&
+            (std::this_thread::get_id() == m_generationThread))
+        {
+            m_backpressureWaits->add();
+            m_queueSpaceWaiting.wait(locker, [&]() {
+                return ((m_queuedEvents.size() < m_options.maxQueuedEvents) || !m_doWork.load());
+            });
+        }
+        m_queuedEvents.push(evt);
+        m_eventsQueued->add();
+        m_queueDepth->set(static_cast<std::int64_t>(m_queuedEvents.size()));
+        m_queuedEventsWaiting.notify_one();
+    }
+    //
+    // Queue any coalesced events whose window has closed (or all if flushing).
+    //
+    void CFanotifyFileEventNotifier::expireCoalescedEvents(bool flush)
+    {
+        std::vector<IApprise::Event> expired;
+        if (flush)
+        {
+            m_coalescer->flush(expired);
+        }
+        else
+        {
+            m_coalescer->expire(expired);
+        }
+        for (auto &evt : expired)
+        {
+            queueEvent(evt);
+        }
+    }
+    // ==============
+    // PUBLIC METHODS
+    // ==============
+    //
+    // Main CFanotifyFileEventNotifier object constructor.
+    //
+    CFanotifyFileEventNotifier::CFanotifyFileEventNotifier(const IFileEventNotifier::Options &options) : m_options{options}, m_doWork{true}
+    {
+        // Create metrics
+        m_metrics = std::make_shared<CMetrics>();
+        m_eventsQueued = &m_metrics->counter("events_queued");
+        m_queueDepth = &m_metrics->gauge("queue_depth");
+        m_backpressureWaits = &m_metrics->counter("backpressure_waits");
+        m_overflows = &m_metrics->counter("overflows");
+        m_readBatchBytes = &m_metrics->histogram("read_batch_bytes");
+        m_readBatchEvents = &m_metrics->histogram("read_batch_events");
+        // Allocate fanotify read buffer
+        m_fanotifyBuffer = std::make_unique<std::uint8_t[]>(kFanotifyEventBuffLen);
+        // Create coalescing stage if needed
+        if (m_options.coalesceWindow.count() > 0)
+        {
+            m_coalescer = std::make_unique<CFileEventCoalescer>(m_options.coalesceWindow);
+        }
+        // Initialise fanotify
+        initialiseWatchTable();
+    }
+    //
+    // CFanotifyFileEventNotifier Destructor
+    //
+    CFanotifyFileEventNotifier::~CFanotifyFileEventNotifier()
+    {
+        for (auto &markedFilesystem : m_markedFilesystems)
+        {
+            close(markedFilesystem.second.mountFd);
+        }
+        if (m_stopFd != -1)
+        {
+            close(m_stopFd);
+        }
+        if (m_fanotifyFd != -1)
+        {
+            close(m_fanotifyFd);
+        }
+    }
+    //
+    // Add watch folder marking its filesystem if not already marked. A directory
+    // within an existing watch folder is already covered by its filesystem mark.
+    //
+    void CFanotifyFileEventNotifier::addWatch(const std::string &filePath)
+    {
+        char realPath[PATH_MAX];
+        if (realpath(filePath.c_str(), realPath) == nullptr)
+        {
+            throw std::system_error(std::error_code(errno, std::system_category()), "realpath() error");
+        }
+        std::string fileName{realPath};
+        std::unique_lock<std::mutex> tableLocker(m_watchTableMutex);
+        // Deeper than max watch depth so ignore.
+        if (!withinWatchDepth(fileName))
+        {
+            return;
+        }
+        // Already covered (re-adding any removed directory)
+        if (withinWatchFolder(fileName) || (m_removedDirectories.erase(fileName) != 0))
+        {
+            return;
+        }
+        struct statfs filesystem;
+        if (statfs(fileName.c_str(), &filesystem) == -1)
+        {
+            throw std::system_error(std::error_code(errno, std::system_category()), "statfs() error");
+        }
+        std::uint64_t fsid{filesystemId(&filesystem.f_fsid)};
+        auto markedFilesystem = m_markedFilesystems.find(fsid);
+        if (markedFilesystem == m_markedFilesystems.end())
+        {
+            if (fanotify_mark(m_fanotifyFd, FAN_MARK_ADD | FAN_MARK_FILESYSTEM, kFanotifyEvents, AT_FDCWD, fileName.c_str()) == -1)
+            {
+                throw std::system_error(std::error_code(errno, std::system_category()), "fanotify_mark() error");
+            }
+            int mountFd{open(fileName.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC)};
+            if (mountFd == -1)
+            {
+                throw std::system_error(std::error_code(errno, std::system_category()), "open() error");
+            }
+            markedFilesystem = m_markedFilesystems.emplace(fsid, MarkedFilesystem{mountFd, 0}).first;
+        }
+        markedFilesystem->second.watchFolders++;
+        m_watchFolders[fileName] = fsid;
+    }
+    //
+    //  Remove watch for watch folder or directory within one.
+    //
+    void CFanotifyFileEventNotifier::removeWatch(const std::string &filePath)
+    {
+        char realPath[PATH_MAX];
+        std::string fileName{(realpath(filePath.c_str(), realPath) != nullptr) ? realPath : filePath};
+        // Remove path trailing '/'
+        if ((fileName.size() > 1) && (fileName.back() == '/'))
+        {
+            fileName.pop_back();
+        }
+        bool noWatches{false};
+        {
+            std::unique_lock<std::mutex> tableLocker(m_watchTableMutex);
+            if (m_watchFolders.count(fileName) != 0)
+            {
+                releaseWatchFolder(fileName);
+            }
+            else if (withinWatchFolder(fileName))
+            {
+                m_removedDirectories.insert(fileName);
+            }
+            else
+            {
+                throw std::logic_error("watch not present");
+            }
+            noWatches = m_watchFolders.empty();
+        }
+        // No more watches so closedown
+        if (noWatches)
+        {
+            stopEventGeneration();
+        }
+    }
+    //
+    // Get next IApprise event in queue.
+    //
+    void CFanotifyFileEventNotifier::getNextEvent(IApprise::Event &evt)
+    {
+        std::unique_lock<std::mutex> locker(m_queuedEventsMutex);
+        // Wait for something to happen. Either an event or stop running
+        m_queuedEventsWaiting.wait(locker, [&]() {
+            return (!m_queuedEvents.empty() || !m_doWork.load());
+        });
+        // return next event from queue
+        if (!m_queuedEvents.empty())
+        {
+            evt = m_queuedEvents.front();
+            m_queuedEvents.pop();
+            m_queueDepth->set(static_cast<std::int64_t>(m_queuedEvents.size()));
+            m_queueSpaceWaiting.notify_one();
+        }
+        else
+        {
+            evt.id = IApprise::Event_none;
+            evt.message = "";
+        }
+    }
+    //
+    // Get next IApprise event in queue; waiting at most timeout for one (Event_none on timeout).
+    //
+    void CFanotifyFileEventNotifier::getNextEvent(IApprise::Event &evt, std::chrono::milliseconds timeout)
+    {
+        std::unique_lock<std::mutex> locker(m_queuedEventsMutex);
+        // Wait for something to happen. Either an event, stop running or timeout
+        m_queuedEventsWaiting.wait_for(locker, timeout, [&]() {
+            return (!m_queuedEvents.empty() || !m_doWork.load());
+        });
+        // return next event from queue
+        if (!m_queuedEvents.empty())
+        {
+            evt = m_queuedEvents.front();
+            m_queuedEvents.pop();
+            m_queueDepth->set(static_cast<std::int64_t>(m_queuedEvents.size()));
+            m_queueSpaceWaiting.notify_one();
+        }
+        else
+        {
+            evt.id = IApprise::Event_none;
+            evt.message = "";
+        }
+    }
+    //
+    // Return true if event generation loop still running.
+    //
+    bool CFanotifyFileEventNotifier::stillWatching() const
+    {
+        return m_doWork.load();
+    }
+    //
+    // Return pointer to any excpetion thrown.
+    //
+    std::exception_ptr CFanotifyFileEventNotifier::getThrownException() const
+    {
+        return m_thrownException;
+    }
+    //
+    // Return notifier metrics.
+    //
+    std::shared_ptr<CMetrics> CFanotifyFileEventNotifier::getMetrics() const
+    {
+        return (m_metrics);
+    }
+    //
+    // Set maximum watch depth.
+    //
+    void CFanotifyFileEventNotifier::setWatchDepth(int watchDepth)
+    {
+        m_watchDepth = watchDepth;
+    }
+    //
+    // Flag watch loop to stop.
+    //
+    void CFanotifyFileEventNotifier::stopEventGeneration(void)
+    {
+        // If still active then need to close down (only once; it may be called by the
+        // generation thread and a consumer removing the last watch at the same time)
+        if (m_doWork.exchange(false))
+        {
+            std::unique_lock<std::mutex> locker(m_queuedEventsMutex);
+            m_queuedEventsWaiting.notify_one();
+            m_queueSpaceWaiting.notify_all();
+            destroyWatchTable();
+        }
+    }
+    //
+    // Clear event queue.
+    //
+    void CFanotifyFileEventNotifier::clearEventQueue()
+    {
+        while (read(m_fanotifyFd, m_fanotifyBuffer.get(), kFanotifyEventBuffLen) > 0)
+        {
+        }
+        if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+        {
+            throw std::system_error(std::error_code(errno, std::system_category()), "fanotify read() error");
+        }
+    }
+    //
+    // Loop generating IApprise events from fanotify; until stopped.
+    //
+    void CFanotifyFileEventNotifier::generateEvents(void)
+    {
+        std::uint8_t *buffer{m_fanotifyBuffer.get()};
+        std::string filePath;
+        std::string eventDirectory;
+        try
+        {
+            // Record thread so that it alone waits for space in a bounded queue
+            {
+                std::unique_lock<std::mutex> locker(m_queuedEventsMutex);
+                m_generationThread = std::this_thread::get_id();
+            }
+            // Report contents of watch folder(s) present at start
+            if (m_options.initialScan)
+            {
+                std::unique_lock<std::mutex> tableLocker(m_watchTableMutex);
+                std::vector<std::string> watchFolders;
+                for (auto &watchFolder : m_watchFolders)
+                {
+                    watchFolders.push_back(watchFolder.first);
+                }
+                scanDirectories(watchFolders, false);
+            }
+            queueGeneratedEvents();
+            // Loop until told to stop
+            while (m_doWork.load())
+            {
+                // Wait for events or stop (at most a coalescer tick while any are pending)
+                struct pollfd fanotifyPoll[2]{{m_fanotifyFd, POLLIN, 0}, {m_stopFd, POLLIN, 0}};
+                int pollTimeout{(m_coalescer && !m_coalescer->empty()) ? static_cast<int>(m_coalescer->tick().count()) : -1};
+                int pollStatus{poll(fanotifyPoll, 2, pollTimeout)};
+                if ((pollStatus == -1) && (errno != EINTR))
+                {
+                    throw std::system_error(std::error_code(errno, std::system_category()), "fanotify poll() error");
+                }
+                if (pollStatus <= 0)
+                {
+                    if (m_coalescer)
+                    {
+                        expireCoalescedEvents();
+                    }
+                    continue;
+                }
+                if (fanotifyPoll[1].revents & POLLIN)
+                {
+                    break;
+                }
+                // Read in events
+                ssize_t readLen{read(m_fanotifyFd, buffer, kFanotifyEventBuffLen)};
+                if (readLen == -1)
+                {
+                    if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR))
+                    {
+                        continue;
+                    }
+                    throw std::system_error(std::error_code(errno, std::system_category()), "fanotify read() error");
+                }
+                m_readBatchBytes->record(readLen);
+                std::uint64_t eventsRead{0};
+                std::unique_lock<std::mutex> tableLocker(m_watchTableMutex);
+                m_fanotifyBytesRead += readLen;
+                // Loop until all read processed
+                for (auto event = reinterpret_cast<struct fanotify_event_metadata *>(buffer); FAN_EVENT_OK(event, readLen); event = FAN_EVENT_NEXT(event, readLen))
+                {
+                    m_fanotifyBytesProcessed += event->event_len;
+                    eventsRead++;
+                    if (!m_scanReportedExpiry.empty())
+                    {
+                        expireScanReported();
+                    }
+                    if (event->vers != FANOTIFY_METADATA_VERSION)
+                    {
+                        throw std::runtime_error("fanotify metadata version mismatch");
+                    }
+                    if (event->fd >= 0)
+                    {
+                        close(event->fd);
+                    }
+                    // Events lost so report
+                    if (event->mask & FAN_Q_OVERFLOW)
+                    {
+                        m_overflows->add();
+                        sendEvent(IApprise::Event_overflow, kLogPrefix + "fanotify event queue overflow");
+                        continue;
+                    }
+                    // Find directory handle and name record
+                    const struct fanotify_event_info_fid *fid{nullptr};
+                    for (std::uint32_t infoPos = event->metadata_len; infoPos + sizeof(struct fanotify_event_info_header) <= event->event_len;)
+                    {
+                        auto info = reinterpret_cast<const struct fanotify_event_info_header *>(reinterpret_cast<const std::uint8_t *>(event) + infoPos);
+                        if (info->info_type == FAN_EVENT_INFO_TYPE_DFID_NAME)
+                        {
+                            fid = reinterpret_cast<const struct fanotify_event_info_fid *>(info);
+                            break;
+                        }
+                        if (info->len == 0)
+                        {
+                            break;
+                        }
+                        infoPos += info->len;
+                    }
+                    // No directory/name or directory since deleted so ignore
+                    if ((fid == nullptr) || !directoryPath(fid, eventDirectory))
+                    {
+                        m_directoryMovedFrom = false;
+                        continue;
+                    }
+                    const struct file_handle *handle{reinterpret_cast<const struct file_handle *>(fid->handle)};
+                    const char *name{reinterpret_cast<const char *>(handle->f_handle + handle->handle_bytes)};
+                    if ((*name == '\0') || (std::strcmp(name, ".") == 0))
+                    {
+                        continue;
+                    }
+                    filePath = eventDirectory;
+                    if (filePath.back() != '/')
+                    {
+                        filePath += '/';
+                    }
+                    filePath += name;
+                    processEvent(event->mask, filePath, eventDirectory);
+                }
+                m_readBatchEvents->record(eventsRead);
+                bool noWatches{m_watchFolders.empty()};
+                tableLocker.unlock();
+                queueGeneratedEvents();
+                // No more watch folders so closedown
+                if (noWatches)
+                {
+                    stopEventGeneration();
+                }
+                // Queue any coalesced events now due
+                if (m_coalescer)
+                {
+                    expireCoalescedEvents();
+                }
+            }
+            //
+            // Generate event for any exceptions and also store to be passed up the chain
+            //
+        }
+        catch (std::system_error &e)
+        {
+            sendEvent(IApprise::Event_error, kLogPrefix + "Caught a system_error exception: [" + e.what() + "]");
+            m_thrownException = std::current_exception();
+        }
+        catch (std::exception &e)
+        {
+            sendEvent(IApprise::Event_error, kLogPrefix + "General exception occured: [" + e.what() + "]");
+            m_thrownException = std::current_exception();
+        }
+        // Queue any events generated before stopping and anything still waiting to be coalesced
+        queueGeneratedEvents();
+        if (m_coalescer)
+        {
+            expireCoalescedEvents(true);
+        }
+        stopEventGeneration(); // If not asked to stop then call anyway (cleanup)
+    }
+} // namespace Antik::File
@@ -0,0 +1,196 @@
+#ifndef CFANOTIFYFILEEVENTNOTIFIER_HPP
+#define CFANOTIFYFILEEVENTNOTIFIER_HPP
+//
+// C++ STL
+//
+#include <unordered_map>
+#include <queue>
+#include <deque>
+#include <vector>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <set>
+//
+// Antik classes
+//
+#include "CommonAntik.hpp"
+#include "IApprise.hpp"
+#include "IFileEventNotifier.hpp"
+#include "CFileEventCoalescer.hpp"
+#include "CDirectoryScanner.hpp"
+//
+// fanotify
+//
+#include <sys/fanotify.h>
+// =========
+// NAMESPACE
+// =========
+namespace Antik::File
+{
+    // ================
+    // CLASS DEFINITION
+    // ================
+    class CFanotifyFileEventNotifier : public IFileEventNotifier
+    {
+    public:
+        // ==========================
+        // PUBLIC TYPES AND CONSTANTS
+        // ==========================
+        // ============
+        // CONSTRUCTORS
+        // ============
+        //
+        // Main constructor
+        //
+        explicit CFanotifyFileEventNotifier(const IFileEventNotifier::Options &options = IFileEventNotifier::Options());
+        // ==========
+        // DESTRUCTOR
+        // ==========
+        virtual ~CFanotifyFileEventNotifier();
+        // ==============
+        // PUBLIC METHODS
+        // ==============
+        //
+        // Event queue
+        //
+        void generateEvents(void) override;                   // Watch folder(s) for file events
+        void stopEventGeneration(void) override;              // Stop watch loop/thread
+        void getNextEvent(IApprise::Event &message) override; // Get next queued event
+        void getNextEvent(IApprise::Event &message, std::chrono::milliseconds timeout) override; // Get next queued event (waiting at most timeout)
+        bool stillWatching() const override;                  // Events still being generated
+        void clearEventQueue() override;                      // Clear event queue
+        //
+        // Watch processing
+        //
+        void setWatchDepth(int watchDepth) override;            // Set maximum watch depth
+        void addWatch(const std::string &filePath) override;    // Add path to be watched
+        void removeWatch(const std::string &filePath) override; // Remove path being watched
+        // Exception handling
+        std::exception_ptr getThrownException() const override; // Get last thrown exception
+        // Metrics
+        std::shared_ptr<CMetrics> getMetrics() const override; // Get notifier metrics
+        // ================
+        // PUBLIC VARIABLES
+        // ================
+    private:
+        // ===========================
+        // PRIVATE TYPES AND CONSTANTS
+        // ===========================
+        //
+        // Logging prefix
+        //
+        static const std::string kLogPrefix; // Logging output prefix
+        //
+        // fanotify
+        //
+        static const std::uint64_t kFanotifyEvents;        // fanotify events to monitor
+        static const std::uint32_t kFanotifyEventBuffLen;  // fanotify read buffer length
+        static const std::size_t kMaxDirectoryHandleCache; // Maximum cached directory handles
+        //
+        // Marked filesystem; marked once however many watch folders it holds.
+        //
+        struct MarkedFilesystem
+        {
+            int mountFd{-1};     // File descriptor on filesystem (for open_by_handle_at)
+            int watchFolders{0}; // Watch folders on filesystem
+        };
+        // ===========================================
+        // DISABLED CONSTRUCTORS/DESTRUCTORS/OPERATORS
+        // ===========================================
+        CFanotifyFileEventNotifier(const CFanotifyFileEventNotifier &orig) = delete;
+        CFanotifyFileEventNotifier(const CFanotifyFileEventNotifier &&orig) = delete;
+        CFanotifyFileEventNotifier &operator=(CFanotifyFileEventNotifier other) = delete;
+        // ===============
+        // PRIVATE METHODS
+        // ===============
+        //
+        // Watch processing
+        //
+        void initialiseWatchTable(void);                           // Initialise fanotify
+        void destroyWatchTable(void);                              // Remove filesystem marks
+        bool withinWatchDepth(const std::string &filePath) const;  // Path within maximum watch depth
+        bool withinWatchFolder(const std::string &filePath) const; // Path within a watch folder
+        void releaseWatchFolder(const std::string &watchFolder);   // Remove watch folder (and unmark its filesystem)
+        //
+        // Directory handle to path
+        //
+        bool directoryPath(const struct fanotify_event_info_fid *fid, std::string &filePath); // Resolve event directory
+        //
+        // Directory scan
+        //
+        void scanDirectories(const std::vector<std::string> &directories, bool reportDirectories); // Scan directory hierarchy
+        void markScanReported(const std::string &filePath);                                        // Path reported by scan
+        bool wasScanReported(const std::string &filePath);                                         // Path already reported by scan
+        void expireScanReported(void);                                                             // Expire old scan reported paths
+        //
+        // Process a single (possibly merged) fanotify event
+        //
+        void processEvent(std::uint64_t mask, const std::string &filePath, const std::string &directoryPath);
+        //
+        // Queue IApprise event
+        //
+        void sendEvent(
+            IApprise::EventId id,      // Event id
+            const std::string &message // Filename/message
+        );
+        void queueGeneratedEvents(void);                // Queue events generated while table locked
+        void queueEvent(const IApprise::Event &evt);    // Place event on queue
+        void expireCoalescedEvents(bool flush = false); // Queue coalesced events whose window has closed
+        // =================
+        // PRIVATE VARIABLES
+        // =================
+        //
+        // fanotify
+        //
+        int m_fanotifyFd{-1};                                                    // fanotify file descriptor for read
+        int m_stopFd{-1};                                                        // eventfd used to wake watch loop to stop
+        std::unique_ptr<std::uint8_t[]> m_fanotifyBuffer;                        // read buffer
+        std::unordered_map<std::uint64_t, MarkedFilesystem> m_markedFilesystems; // Marked filesystems indexed by fsid
+        std::unordered_map<std::string, std::uint64_t> m_watchFolders;           // Watch folders (and their fsid)
+        std::set<std::string> m_removedDirectories;                              // Directories within watch folders no longer watched
+        std::mutex m_watchTableMutex;                                            // Watch folder table mutex
+        std::unordered_map<std::string, std::string> m_directoryHandles;         // Resolved directory path indexed by handle
+        std::string m_handleKey;                                                 // Directory handle cache key
+        std::set<std::string> m_inProcessOfCreation;                             // Set to hold files being created.
+        bool m_directoryMovedFrom{false};                                        // Last event a directory moved from within watch
+        std::uint64_t m_fanotifyBytesRead{0};                                    // Total bytes read from fanotify
+        std::uint64_t m_fanotifyBytesProcessed{0};                               // Total bytes of fanotify events processed
+        //
+        // Directory scan
+        //
+        IFileEventNotifier::Options m_options;                                  // Notifier options
+        std::unordered_map<std::string, std::uint64_t> m_scanReported;          // Paths reported by scan (and expiry)
+        std::deque<std::pair<std::uint64_t, std::string>> m_scanReportedExpiry; // Scan reported paths in expiry order
+        //
+        // Event coalescing
+        //
+        std::unique_ptr<CFileEventCoalescer> m_coalescer; // Coalescing stage (nullptr if not enabled)
+        //
+        // Metrics
+        //
+        std::shared_ptr<CMetrics> m_metrics;             // Notifier metrics
+        CMetrics::Counter *m_eventsQueued{nullptr};      // Events queued
+        CMetrics::Gauge *m_queueDepth{nullptr};          // Event queue depth
+        CMetrics::Counter *m_backpressureWaits{nullptr}; // Waits for space in a full event queue
+        CMetrics::Counter *m_overflows{nullptr};         // Event queue overflows
+        CMetrics::Histogram *m_readBatchBytes{nullptr};  // Bytes returned by each fanotify read
+        CMetrics::Histogram *m_readBatchEvents{nullptr}; // Events returned by each fanotify read
+        //
+        // Publicly accessed via accessors
+        //
+        std::exception_ptr m_thrownException{nullptr}; // Pointer to any exception thrown
+        std::atomic<bool> m_doWork{false};             // doWork=true (run watcher loop) false=(stop watcher loop)
+        int m_watchDepth{-1};                          // Watch depth -1=all,0=just watch folder,1=next level down etc.
+        //
+        // Event queue
+        //
+        std::condition_variable m_queuedEventsWaiting;  // Queued events conditional
+        std::condition_variable m_queueSpaceWaiting;    // Queue space conditional (bounded queue)
+        std::thread::id m_generationThread;             // Event generation thread (only it waits for space)
+        std::mutex m_queuedEventsMutex;                 // Queued events mutex
+        std::queue<IApprise::Event> m_queuedEvents;     // Queue of CFanotifyFileEventNotifier events
+        std::vector<IApprise::Event> m_generatedEvents; // Events generated waiting to be queued
+    };
+} // namespace Antik::File
+#endif /* CFANOTIFYFILEEVENTNOTIFIER_HPP */
@@ -0,0 +1,206 @@
+//
+// Class: CFileEventCoalescer
+//
+// Description: Coalescing stage used by file event notifiers between the raw
+// file system events and the event queue. File events (add/change/unlink) are held
+// per path for a window (anchored at the first event for the path) and any further
+// events for the path within it merged so that for example a storm of modifies
+// followed by a close becomes a single change and a create followed by a delete
+// nothing at all. Pending paths are kept on a single level time wheel whose span is
+// always larger than the window so expiring them is O(1) per wheel tick.
+//
+// Dependencies: C20++               - Language standard features used.
+//
+// =================
+// CLASS DEFINITIONS
+// =================
+#include "CFileEventCoalescer.hpp"
+// ====================
+// CLASS IMPLEMENTATION
+// ====================
+//
+// C++ STL
+//
+#include <algorithm>
+#include <limits>
+// =========
+// NAMESPACE
+// =========
+namespace Antik::File
+{
+    // ===========================
+    // PRIVATE TYPES AND CONSTANTS
+    // ===========================
+    // Time wheel slots (window is at most half the wheel)
+    const std::uint64_t CFileEventCoalescer::kWheelSlots{64};
+    // ==========================
+    // PUBLIC TYPES AND CONSTANTS
+    // ==========================
+    // ========================
+    // PRIVATE STATIC VARIABLES
+    // ========================
+    // =======================
+    // PUBLIC STATIC VARIABLES
+    // =======================
+    // ===============
+    // PRIVATE METHODS
+    // ===============
+    //
+    // Convert time to wheel tick.
+    //
+    std::uint64_t CFileEventCoalescer::toTick(Clock::time_point now) const
+    {
+        if (now < m_start)
+        {
+            return (0);
+        }
+        return (std::chrono::duration_cast<std::chrono::milliseconds>(now - m_start) / m_tick);
+    }
+    //
+    // Merge a new event with the one pending for a path. Returning Event_none
+    // means that the two cancel each other out.
+    //
+    IApprise::EventId CFileEventCoalescer::merge(const PendingEvent &pending, IApprise::EventId next)
+    {
+        switch (next)
+        {
+        // File added within window then unlinked so nothing to report; otherwise
+        // (eg. unlink, add, unlink) a file that existed before the window has gone
+        case IApprise::Event_unlink:
+            return ((pending.first == IApprise::Event_add) ? IApprise::Event_none : IApprise::Event_unlink);
+        // Any add reports the file as added
+        case IApprise::Event_add:
+            return (IApprise::Event_add);
+        // Change to a pending add is still an add
+        case IApprise::Event_change:
+            return ((pending.id == IApprise::Event_add) ? IApprise::Event_add : IApprise::Event_change);
+        default:
+            return (next);
+        }
+    }
+    //
+    // Expire any events in a wheel slot whose window has closed by the passed tick.
+    // Entries for paths since cancelled or re-added are discarded.
+    //
+    void CFileEventCoalescer::expireSlot(std::uint64_t slot, std::uint64_t tick, std::vector<IApprise::Event> &expired)
+    {
+        std::vector<WheelEntry> &wheelSlot{m_wheel[slot]};
+        std::size_t kept{0};
+        for (auto &wheelEntry : wheelSlot)
+        {
+            auto pendingEvent = m_pending.find(wheelEntry.filePath);
+            if ((pendingEvent == m_pending.end()) || (pendingEvent->second.sequence != wheelEntry.sequence))
+            {
+                continue;
+            }
+            if (wheelEntry.deadline <= tick)
+            {
+                expired.emplace_back(pendingEvent->second.id, wheelEntry.filePath);
+                expired.back().time = pendingEvent->second.time;
+                m_pending.erase(pendingEvent);
+            }
+            else
+            {
+                wheelSlot[kept++] = std::move(wheelEntry);
+            }
+        }
+        wheelSlot.resize(kept);
+    }
+    // ==============
+    // PUBLIC METHODS
+    // ==============
+    //
+    // Main CFileEventCoalescer object constructor.
+    //
+    CFileEventCoalescer::CFileEventCoalescer(std::chrono::milliseconds window, Clock::time_point now) : m_window{window}, m_start{now}
+    {
+        m_tick = std::max(std::chrono::milliseconds(1), m_window / static_cast<long>(kWheelSlots / 2));
+        m_windowTicks = std::max(static_cast<std::uint64_t>((m_window + m_tick - std::chrono::milliseconds(1)) / m_tick), static_cast<std::uint64_t>(1));
+        m_wheel.resize(kWheelSlots);
+    }
+    //
+    // CFileEventCoalescer Destructor
+    //
+    CFileEventCoalescer::~CFileEventCoalescer()
+    {
+    }
+    //
+    // Return true if event is one that is coalesced (file events only).
+    //
+    bool CFileEventCoalescer::coalesces(IApprise::EventId id)
+    {
+        return ((id == IApprise::Event_add) || (id == IApprise::Event_change) || (id == IApprise::Event_unlink));
+    }
+    //
+    // Add event; merging it with any event already pending for the path.
+    //
+    void CFileEventCoalescer::add(const IApprise::Event &evt, Clock::time_point now)
+    {
+        auto pendingEvent = m_pending.find(evt.message);
+        if (pendingEvent != m_pending.end())
+        {
+            IApprise::EventId merged{merge(pendingEvent->second, evt.id)};
+            if (merged == IApprise::Event_none)
+            {
+                m_pending.erase(pendingEvent);
+            }
+            else
+            {
+                pendingEvent->second.id = merged;
+            }
+            return;
+        }
+        std::uint64_t deadline{std::max(toTick(now), m_currentTick) + m_windowTicks};
+        m_wheel[deadline % kWheelSlots].push_back({evt.message, ++m_sequence, deadline});
+        m_pending[evt.message] = {evt.id, evt.id, m_sequence, evt.time};
+    }
+    //
+    // Advance the wheel to the current time passing back any events whose window has closed.
+    //
+    void CFileEventCoalescer::expire(std::vector<IApprise::Event> &expired, Clock::time_point now)
+    {
+        std::uint64_t nowTick{toTick(now)};
+        if (nowTick <= m_currentTick)
+        {
+            return;
+        }
+        std::uint64_t ticks{std::min(nowTick - m_currentTick, kWheelSlots)};
+        for (std::uint64_t tick = 1; tick <= ticks; tick++)
+        {
+            expireSlot((m_currentTick + tick) % kWheelSlots, nowTick, expired);
+        }
+        m_currentTick = nowTick;
+    }
+    //
+    // Pass back all pending events (in window close order) and empty the wheel.
+    //
+    void CFileEventCoalescer::flush(std::vector<IApprise::Event> &expired)
+    {
+        for (std::uint64_t tick = 1; tick <= kWheelSlots; tick++)
+        {
+            expireSlot((m_currentTick + tick) % kWheelSlots, std::numeric_limits<std::uint64_t>::max(), expired);
+        }
+        m_pending.clear();
+    }
+    //
+    // Return true if no events pending.
+    //
+    bool CFileEventCoalescer::empty(void) const
+    {
+        return (m_pending.empty());
+    }
+    //
+    // Return number of events pending.
+    //
+    std::size_t CFileEventCoalescer::size(void) const
+    {
+        return (m_pending.size());
+    }
+    //
+    // Return wheel tick length (maximum time between calls to expire()).
+    //
+    std::chrono::milliseconds CFileEventCoalescer::tick(void) const
+    {
+        return (m_tick);
+    }
+} // namespace Antik::File
@@ -0,0 +1,111 @@
+#ifndef CFILEEVENTCOALESCER_HPP
+#define CFILEEVENTCOALESCER_HPP
+//
+// C++ STL
+//
+#include <string>
+#include <vector>
+#include <chrono>
+#include <unordered_map>
+//
+// Antik classes
+//
+#include "IApprise.hpp"
+// =========
+// NAMESPACE
+// =========
+namespace Antik::File
+{
+    // ================
+    // CLASS DEFINITION
+    // ================
+    class CFileEventCoalescer
+    {
+    public:
+        // ==========================
+        // PUBLIC TYPES AND CONSTANTS
+        // ==========================
+        using Clock = std::chrono::steady_clock;
+        // ============
+        // CONSTRUCTORS
+        // ============
+        //
+        // Main constructor
+        //
+        explicit CFileEventCoalescer(std::chrono::milliseconds window, Clock::time_point now = Clock::now());
+        // ==========
+        // DESTRUCTOR
+        // ==========
+        virtual ~CFileEventCoalescer();
+        // ==============
+        // PUBLIC METHODS
+        // ==============
+        //
+        // Coalesce events
+        //
+        static bool coalesces(IApprise::EventId id);                                              // Event is coalesced
+        void add(const IApprise::Event &evt, Clock::time_point now = Clock::now());               // Merge event with any pending
+        void expire(std::vector<IApprise::Event> &expired, Clock::time_point now = Clock::now()); // Remove events whose window closed
+        void flush(std::vector<IApprise::Event> &expired);                                        // Remove all pending events
+        //
+        // Pending events
+        //
+        bool empty(void) const;                     // No events pending
+        std::size_t size(void) const;               // Number of events pending
+        std::chrono::milliseconds tick(void) const; // Wheel tick length
+        // ================
+        // PUBLIC VARIABLES
+        // ================
+    private:
+        // ===========================
+        // PRIVATE TYPES AND CONSTANTS
+        // ===========================
+        //
+        // Time wheel slots
+        //
+        static const std::uint64_t kWheelSlots;
+        //
+        // Pending event for a path
+        //
+        struct PendingEvent
+        {
+            IApprise::EventId id;    // Merged event id
+            IApprise::EventId first; // Id of first event in window
+            std::uint64_t sequence;  // Sequence number of wheel entry
+            Clock::time_point time;  // Time first event generated
+        };
+        //
+        // Wheel slot entry
+        //
+        struct WheelEntry
+        {
+            std::string filePath;   // Event path
+            std::uint64_t sequence; // Sequence number when added
+            std::uint64_t deadline; // Wheel tick when window closes
+        };
+        // ===========================================
+        // DISABLED CONSTRUCTORS/DESTRUCTORS/OPERATORS
+        // ===========================================
+        CFileEventCoalescer(const CFileEventCoalescer &orig) = delete;
+        CFileEventCoalescer(const CFileEventCoalescer &&orig) = delete;
+        CFileEventCoalescer &operator=(CFileEventCoalescer other) = delete;
+        // ===============
+        // PRIVATE METHODS
+        // ===============
+        std::uint64_t toTick(Clock::time_point now) const;                                              // Time to wheel tick
+        static IApprise::EventId merge(const PendingEvent &pending, IApprise::EventId next);            // Merge event id with pending
+        void expireSlot(std::uint64_t slot, std::uint64_t tick, std::vector<IApprise::Event> &expired); // Expire single wheel slot
+        // =================
+        // PRIVATE VARIABLES
+        // =================
+        std::chrono::milliseconds m_window;                      // Coalescing window
+        std::chrono::milliseconds m_tick;                        // Wheel tick length
+        Clock::time_point m_start;                               // Wheel start time
+        std::uint64_t m_currentTick{0};                          // Last wheel tick expired
+        std::uint64_t m_windowTicks{0};                          // Window length in ticks
+        std::uint64_t m_sequence{0};                             // Wheel entry sequence number
+        std::vector<std::vector<WheelEntry>> m_wheel;            // Time wheel of pending paths
+        std::unordered_map<std::string, PendingEvent> m_pending; // Pending event for each path
+    };
+} // namespace Antik::File
+#endif /* CFILEEVENTCOALESCER_HPP */
@@ -4,6 +4,40 @@
 // Description: File event notifier pass to CApprise class constructor. This is
 // the default Linux inotify implementation.
 //
+// If the initial scan option is set then the contents of the watch folder(s) are
+// reported as added when event generation starts and any newly created directory
+// is scanned once watched so that files written into it before the watch was in
+// place are not missed. Scanned directories are read by CDirectoryScanner in parallel
+// (one level of the hierarchy at a time) and any files reported by a scan are not
+// reported again by the real inotify events that were queued before it finished.
+//
+// Watched directories are held in an interned table indexed both by watch descriptor
+// and (a component at a time) by path with each entry holding just its name within its
+// parent; so adding, removing and renaming (IN_MOVED_FROM/IN_MOVED_TO paired by cookie)
+// a directory and all the watches below it does not require searching every watch.
+// The table is guarded by a mutex as watches may be added and removed by the consumer
+// thread; events generated while it is held are only queued once it has been released
+// so that waiting for space in a bounded queue cannot block a consumer adding a watch.
+// A directory moved from with no move to following it is given one short poll for its
+// move to before it is taken to have left the watched hierarchy.
+//
+// If a coalesce window is set then file events pass through a CFileEventCoalescer
+// before being queued; the inotify file descriptor being polled with a timeout of
+// one coalescer tick while any events are pending.
+//
+// An inotify queue overflow (IN_Q_OVERFLOW) is reported as Event_overflow and the
+// read buffer enlarged until the burst has been drained. If the reconcile overflow
+// option is set then the files known in each watched directory (from scans and the
+// events reported) are kept and on overflow every watched directory is rescanned in
+// parallel against them to report anything whose events were lost; also watching
+// any new directories missed.
+//
+// A notifier created as one of a number of shards watches only the top-level directories
+// (those directly in a watch folder) whose name hashes to it, along with the watch
+// folders themselves so that it sees its own directories being created and renamed;
+// events for files directly in a watch folder are reported by shard zero only. Each
+// shard passes its events to the queue it is given rather than its own.
+//
 // Dependencies: C20++               - Language standard features used.
 //               inotify/Linux       - Linux file system events
 //
@@ -20,10 +54,13 @@
 #include <mutex>
 #include <system_error>
 #include <algorithm>
+#include <limits>
+#include <string_view>
 //
 // Linux
 //
 #include <sys/ioctl.h>
+#include <poll.h>
 #include <unistd.h>
 // =========
 // NAMESPACE
@@ -41,6 +78,14 @@ namespace Antik::File
     const std::uint32_t CFileEventNotifier::kInotifyEventSize{(sizeof(struct inotify_event))};
     // inotify event read buffer size
     const std::uint32_t CFileEventNotifier::kInotifyEventBuffLen{(1024 * (CFileEventNotifier::kInotifyEventSize + 16))};
+    // inotify event read buffer size after a queue overflow
+    const std::uint32_t CFileEventNotifier::kInotifyOverflowEventBuffLen{(16 * CFileEventNotifier::kInotifyEventBuffLen)};
+    // Reads that do not fill half the buffer before the overflow buffer size reverts
+    const std::uint32_t CFileEventNotifier::kOverflowReads{32};
+    // No watched directory id
+    const std::uint32_t CFileEventNotifier::kNoDirectory{std::numeric_limits<std::uint32_t>::max()};
+    // Time to wait for the move to of a directory moved from
+    const std::chrono::milliseconds CFileEventNotifier::kPendingMoveWait{10};
     // CFileEventNotifier logging prefix
     const std::string CFileEventNotifier::kLogPrefix{"[CFileEventNotifier] "};
     // ==========================
@@ -63,7 +108,8 @@ namespace Antik::File
     //
     void CFileEventNotifier::destroyWatchTable(void)
     {
-        for (auto it = m_watchMap.begin(); it != m_watchMap.end(); ++it)
+        std::unique_lock<std::mutex> tableLocker(m_watchTableMutex);
+        for (auto it = m_watchIndex.begin(); it != m_watchIndex.end(); ++it)
         {
             if (inotify_rm_watch(m_inotifyFd, it->first) == -1)
             {
@@ -87,24 +133,630 @@ namespace Antik::File
         }
     }
     //
-    // Queue CFileEventNotifier event
+    // Find watched directory id for a path (kNoDirectory if not watched) by locating
+    // its root and then walking down the table a path component at a time.
+    //
+    std::uint32_t CFileEventNotifier::findDirectory(const std::string &directoryPath)
+    {
+        auto root = m_rootIndex.find(directoryPath);
+        if (root != m_rootIndex.end())
+        {
+            return (root->second);
+        }
+        for (auto &rootEntry : m_rootIndex)
+        {
+            const std::string &rootPath{rootEntry.first};
+            if ((directoryPath.size() > rootPath.size()) && (directoryPath[rootPath.size()] == '/') &&
+                (directoryPath.compare(0, rootPath.size(), rootPath) == 0))
+            {
+                std::uint32_t directoryId{rootEntry.second};
+                std::size_t componentStart{rootPath.size() + 1};
+                while ((directoryId != kNoDirectory) && (componentStart <= directoryPath.size()))
+                {
+                    std::size_t componentEnd{directoryPath.find('/', componentStart)};
+                    if (componentEnd == std::string::npos)
+                    {
+                        componentEnd = directoryPath.size();
+                    }
+                    m_pathComponent.assign(directoryPath, componentStart, componentEnd - componentStart);
+                    auto &children{m_watchedDirectories[directoryId].children};
+                    auto child = children.find(m_pathComponent);
+                    directoryId = (child != children.end()) ? child->second : kNoDirectory;
+                    componentStart = componentEnd + 1;
+                }
+                if (directoryId != kNoDirectory)
+                {
+                    return (directoryId);
+                }
+            }
+        }
+        return (kNoDirectory);
+    }
+    //
+    // Build the path for a watched directory (with any name appended) into the
+    // passed (reused) path buffer.
+    //
+    void CFileEventNotifier::directoryPath(std::uint32_t directoryId, const char *name, std::string &filePath)
+    {
+        m_pathDirectoryIds.clear();
+        for (; directoryId != kNoDirectory; directoryId = m_watchedDirectories[directoryId].parent)
+        {
+            m_pathDirectoryIds.push_back(directoryId);
+        }
+        filePath.clear();
+        for (auto pathDirectoryId = m_pathDirectoryIds.rbegin(); pathDirectoryId != m_pathDirectoryIds.rend(); ++pathDirectoryId)
+        {
+            if (!filePath.empty())
+            {
+                filePath += '/';
+            }
+            filePath += m_watchedDirectories[*pathDirectoryId].name;
+        }
+        if ((name != nullptr) && (*name != '\0'))
+        {
+            filePath += '/';
+            filePath += name;
+        }
+    }
+    //
+    // Add a watched directory to the table (as a child of its parent directory if that
+    // is watched otherwise as a root) and return its id. If the watch is already in
+    // the table then its existing id is returned.
+    //
+    std::uint32_t CFileEventNotifier::internDirectory(std::int32_t watch, const std::string &directoryPath)
+    {
+        auto watched = m_watchIndex.find(watch);
+        if (watched != m_watchIndex.end())
+        {
+            return (watched->second);
+        }
+        std::uint32_t directoryId{0};
+        if (!m_freeDirectoryIds.empty())
+        {
+            directoryId = m_freeDirectoryIds.back();
+            m_freeDirectoryIds.pop_back();
+        }
+        else
+        {
+            directoryId = static_cast<std::uint32_t>(m_watchedDirectories.size());
+            m_watchedDirectories.emplace_back();
+        }
+        WatchedDirectory &watchedDirectory{m_watchedDirectories[directoryId]};
+        watchedDirectory.watch = watch;
+        std::size_t lastSeparator{directoryPath.rfind('/')};
+        std::uint32_t parentId{(lastSeparator != std::string::npos) && (lastSeparator != 0) ? findDirectory(directoryPath.substr(0, lastSeparator)) : kNoDirectory};
+        if (parentId != kNoDirectory)
+        {
+            watchedDirectory.parent = parentId;
+            watchedDirectory.name = directoryPath.substr(lastSeparator + 1);
+            m_watchedDirectories[parentId].children[watchedDirectory.name] = directoryId;
+        }
+        else
+        {
+            watchedDirectory.parent = kNoDirectory;
+            watchedDirectory.name = directoryPath;
+            m_rootIndex[directoryPath] = directoryId;
+        }
+        m_watchIndex[watch] = directoryId;
+        return (directoryId);
+    }
+    //
+    // Remove a watched directory and all those below it from the table removing their
+    // inotify watches. Note: The kernel will already have removed the watch of any deleted
+    // directory so error EINVAL is ignored.
+    //
+    void CFileEventNotifier::releaseDirectory(std::uint32_t directoryId)
+    {
+        WatchedDirectory &watchedDirectory{m_watchedDirectories[directoryId]};
+        while (!watchedDirectory.children.empty())
+        {
+            releaseDirectory(watchedDirectory.children.begin()->second);
+        }
+        if (watchedDirectory.parent != kNoDirectory)
+        {
+            m_watchedDirectories[watchedDirectory.parent].children.erase(watchedDirectory.name);
+        }
+        else
+        {
+            m_rootIndex.erase(watchedDirectory.name);
+        }
+        m_watchIndex.erase(watchedDirectory.watch);
+        std::int32_t watch{watchedDirectory.watch};
+        watchedDirectory.watch = -1;
+        watchedDirectory.parent = kNoDirectory;
+        watchedDirectory.name.clear();
+        watchedDirectory.files.clear();
+        m_freeDirectoryIds.push_back(directoryId);
+        if ((inotify_rm_watch(m_inotifyFd, watch) == -1) && (errno != EINVAL))
+        {
+            throw std::system_error(std::error_code(errno, std::system_category()), "inotify_rm_watch() error");
+        }
+    }
+    //
+    // Remove the watches of any directories below a watched directory (at a given
+    // depth) that are deeper than the maximum watch depth.
+    //
+    void CFileEventNotifier::releaseBelowWatchDepth(std::uint32_t directoryId, int depth)
+    {
+        auto &children{m_watchedDirectories[directoryId].children};
+        if (depth >= m_watchDepth)
+        {
+            while (!children.empty())
+            {
+                releaseDirectory(children.begin()->second);
+            }
+        }
+        else
+        {
+            for (auto &child : children)
+            {
+                releaseBelowWatchDepth(child.second, depth + 1);
+            }
+        }
+    }
+    //
+    // Rename any files being created below a directory that has been renamed.
+    //
+    void CFileEventNotifier::renameInProcessOfCreation(const std::string &fromPath, const std::string &toPath)
+    {
+        std::string fromPrefix{fromPath + "/"};
+        std::vector<std::string> renamed;
+        for (auto file = m_inProcessOfCreation.lower_bound(fromPrefix);
+             (file != m_inProcessOfCreation.end()) && (file->compare(0, fromPrefix.size(), fromPrefix) == 0);)
+        {
+            renamed.push_back(toPath + file->substr(fromPath.size()));
+            file = m_inProcessOfCreation.erase(file);
+        }
+        m_inProcessOfCreation.insert(renamed.begin(), renamed.end());
+    }
+    //
+    // Rename a watched directory (possibly into a new parent). All directories below
+    // it keep their watches (unless now deeper than the maximum watch depth) and pick
+    // up the new path through their parent.
+    //
+    void CFileEventNotifier::moveDirectory(std::uint32_t directoryId, std::uint32_t parentId, const std::string &name)
+    {
+        std::string fromPath;
+        std::string toPath;
+        directoryPath(directoryId, nullptr, fromPath);
+        WatchedDirectory &watchedDirectory{m_watchedDirectories[directoryId]};
+        if (watchedDirectory.parent != kNoDirectory)
+        {
+            m_watchedDirectories[watchedDirectory.parent].children.erase(watchedDirectory.name);
+        }
+        else
+        {
+            m_rootIndex.erase(watchedDirectory.name);
+        }
+        watchedDirectory.parent = parentId;
+        watchedDirectory.name = name;
+        m_watchedDirectories[parentId].children[name] = directoryId;
+        directoryPath(directoryId, nullptr, toPath);
+        renameInProcessOfCreation(fromPath, toPath);
+        if (m_watchDepth != -1)
+        {
+            releaseBelowWatchDepth(directoryId, static_cast<int>(std::count(toPath.begin(), toPath.end(), '/')));
+        }
+    }
+    //
+    // Any directories moved from with no matching move to have left the watched
+    // hierarchy so remove them (and everything below them).
+    //
+    void CFileEventNotifier::resolvePendingMoves(void)
+    {
+        for (auto &pendingMove : m_pendingMoves)
+        {
+            auto moved = m_watchIndex.find(pendingMove.second);
+            if (moved != m_watchIndex.end())
+            {
+                releaseDirectory(moved->second);
+            }
+        }
+        m_pendingMoves.clear();
+    }
+    //
+    // Return true if path is not deeper than the maximum watch depth.
+    //
+    bool CFileEventNotifier::withinWatchDepth(const std::string &filePath) const
+    {
+        return ((m_watchDepth == -1) || (std::count(filePath.begin(), filePath.end(), '/') <= m_watchDepth));
+    }
+    //
+    // Return true if a path belongs to this shard; anything in or below a top-level
+    // directory to the shard its name hashes to, files directly in a watch folder to
+    // shard zero and anything else (a watch folder itself) to every shard.
+    //
+    bool CFileEventNotifier::ownsPath(const std::string &filePath, bool directory) const
+    {
+        if (m_shard.shards <= 1)
+        {
+            return (true);
+        }
+        for (auto &rootEntry : m_rootIndex)
+        {
+            const std::string &root{rootEntry.first};
+            if ((filePath.size() > root.size() + 1) && (filePath[root.size()] == '/') && (filePath.compare(0, root.size(), root) == 0))
+            {
+                std::size_t topLevelEnd{filePath.find('/', root.size() + 1)};
+                if ((topLevelEnd == std::string::npos) && !directory)
+                {
+                    return (m_shard.shardNo == 0);
+                }
+                std::string_view topLevel{std::string_view(filePath).substr(root.size() + 1, topLevelEnd - (root.size() + 1))};
+                return ((std::hash<std::string_view>{}(topLevel) % m_shard.shards) == m_shard.shardNo);
+            }
+        }
+        return (true);
+    }
+    //
+    // Scan passed (already watched) directories and any sub-directories within the
+    // watch depth a level at a time; reading each level in parallel. Sub-directories
+    // found are watched before being scanned and Event_addir sent for them if requested
+    // while Event_add is sent (if requested) for every file found that is not already
+    // in the process of being created (and so will be reported by inotify). Files found
+    // are added to the snapshot if reconciling overflows.
+    //
+    void CFileEventNotifier::scanDirectories(const std::vector<std::string> &directories, bool reportDirectories, bool reportFiles)
+    {
+        std::vector<std::string> level{directories};
+        while (!level.empty())
+        {
+            std::vector<CDirectoryScanner::ScanResult> scanResults;
+            CDirectoryScanner::readDirectories(level, scanResults, m_options.scanThreads, m_options.reconcileOverflow);
+            // Report files and watch sub-directories ready for next level
+            std::vector<std::string> nextLevel;
+            for (std::size_t directoryNo = 0; directoryNo < level.size(); directoryNo++)
+            {
+                auto &scanResult{scanResults[directoryNo]};
+                // Directory removed since being watched so ignore.
+                if ((scanResult.error == ENOENT) || (scanResult.error == ENOTDIR))
+                {
+                    continue;
+                }
+                if (scanResult.error)
+                {
+                    throw std::system_error(std::error_code(scanResult.error, std::system_category()), "getdents64() error");
+                }
+                if (m_options.reconcileOverflow)
+                {
+                    std::uint32_t directoryId{findDirectory(level[directoryNo])};
+                    for (std::size_t fileNo = 0; (directoryId != kNoDirectory) && (fileNo < scanResult.files.size()); fileNo++)
+                    {
+                        m_watchedDirectories[directoryId].files[scanResult.files[fileNo].substr(level[directoryNo].size() + 1)] = scanResult.fileStatus[fileNo];
+                    }
+                }
+                for (auto &filePath : scanResult.files)
+                {
+                    if (reportFiles && (m_inProcessOfCreation.find(filePath) == m_inProcessOfCreation.end()) && !wasScanReported(filePath))
+                    {
+                        markScanReported(filePath);
+                        sendEvent(IApprise::Event_add, filePath);
+                    }
+                }
+                for (auto &directoryPath : scanResult.directories)
+                {
+                    if (withinWatchDepth(directoryPath) && ownsPath(directoryPath, true) && !wasScanReported(directoryPath))
+                    {
+                        watchDirectory(directoryPath);
+                        if (reportDirectories)
+                        {
+                            markScanReported(directoryPath);
+                            sendEvent(IApprise::Event_addir, directoryPath);
+                        }
+                        nextLevel.push_back(directoryPath);
+                    }
+                }
+            }
+            level = std::move(nextLevel);
+        }
+    }
+    //
+    // Record a path as reported by a scan. Any inotify event for the path that was
+    // queued before the scan finished (ie. before the number of bytes currently read
+    // plus those waiting to be read have been processed) is then ignored.
+    //
+    void CFileEventNotifier::markScanReported(const std::string &filePath)
+    {
+        unsigned int bytesAvailable{0};
+        ioctl(m_inotifyFd, FIONREAD, &bytesAvailable);
+        m_scanReported[filePath] = m_inotifyBytesRead + bytesAvailable;
+        m_scanReportedExpiry.emplace_back(m_inotifyBytesRead + bytesAvailable, filePath);
+    }
+    //
+    // Return true if path has been reported by a scan whose events have not yet
+    // all been processed; removing it so that only one event is ignored.
+    //
+    bool CFileEventNotifier::wasScanReported(const std::string &filePath)
+    {
+        auto scanReported = m_scanReported.find(filePath);
+        if (scanReported != m_scanReported.end())
+        {
+            bool stillValid{scanReported->second > m_inotifyBytesProcessed};
+            m_scanReported.erase(scanReported);
+            return (stillValid);
+        }
+        return (false);
+    }
+    //
+    // Remove any scan reported paths whose events have now all been processed.
+    //
+    void CFileEventNotifier::expireScanReported(void)
+    {
+        while (!m_scanReportedExpiry.empty() && (m_scanReportedExpiry.front().first <= m_inotifyBytesProcessed))
+        {
+            auto scanReported = m_scanReported.find(m_scanReportedExpiry.front().second);
+            if ((scanReported != m_scanReported.end()) && (scanReported->second <= m_inotifyBytesProcessed))
+            {
+                m_scanReported.erase(scanReported);
+            }
+            m_scanReportedExpiry.pop_front();
+        }
+    }
+    //
+    // Record a file in a watched directory as known (status unknown until next
+    // scanned) or gone; if reconciling overflows.
+    //
+    void CFileEventNotifier::snapshotFile(std::uint32_t directoryId, const char *name, bool present)
+    {
+        if (m_options.reconcileOverflow && (name != nullptr))
+        {
+            if (present)
+            {
+                m_watchedDirectories[directoryId].files.try_emplace(name);
+            }
+            else
+            {
+                m_watchedDirectories[directoryId].files.erase(name);
+            }
+        }
+    }
+    //
+    // Send Event_unlink for every known file in a watched directory sub-tree that
+    // has gone and Event_unlinkdir for each directory in it.
+    //
+    void CFileEventNotifier::unlinkSnapshot(std::uint32_t directoryId)
+    {
+        std::string filePath;
+        for (auto &file : m_watchedDirectories[directoryId].files)
+        {
+            directoryPath(directoryId, file.first.c_str(), filePath);
+            sendEvent(IApprise::Event_unlink, filePath);
+        }
+        m_watchedDirectories[directoryId].files.clear();
+        for (auto &child : m_watchedDirectories[directoryId].children)
+        {
+            unlinkSnapshot(child.second);
+        }
+        directoryPath(directoryId, nullptr, filePath);
+        sendEvent(IApprise::Event_unlinkdir, filePath);
+    }
+    //
+    // Rescan every watched directory in parallel comparing against the files known
+    // in it; sending Event_add/change/unlink for any differences. Any directories
+    // since removed are dropped and any new ones are watched and scanned. Note: A
+    // file found whose creation was seen is reported as added now as its close
+    // may have been lost.
+    //
+    void CFileEventNotifier::reconcileDirectories(void)
+    {
+        std::vector<std::string> directories;
+        std::vector<std::uint32_t> directoryIds;
+        for (auto &watched : m_watchIndex)
+        {
+            directoryIds.push_back(watched.second);
+            directories.emplace_back();
+            directoryPath(watched.second, nullptr, directories.back());
+        }
+        std::vector<CDirectoryScanner::ScanResult> scanResults;
+        CDirectoryScanner::readDirectories(directories, scanResults, m_options.scanThreads, true);
+        std::vector<std::string> newDirectories;
+        for (std::size_t directoryNo = 0; directoryNo < directories.size(); directoryNo++)
+        {
+            auto &scanResult{scanResults[directoryNo]};
+            WatchedDirectory &watchedDirectory{m_watchedDirectories[directoryIds[directoryNo]]};
+            // Released along with a directory above it that has gone
+            if (watchedDirectory.watch == -1)
+            {
+                continue;
+            }
+            // Directory has gone
+            if ((scanResult.error == ENOENT) || (scanResult.error == ENOTDIR))
+            {
+                unlinkSnapshot(directoryIds[directoryNo]);
+                releaseDirectory(directoryIds[directoryNo]);
+                continue;
+            }
+            if (scanResult.error)
+            {
+                throw std::system_error(std::error_code(scanResult.error, std::system_category()), "getdents64() error");
+            }
+            // Files added or changed
+            std::set<std::string> foundFiles;
+            for (std::size_t fileNo = 0; fileNo < scanResult.files.size(); fileNo++)
+            {
+                const std::string &filePath{scanResult.files[fileNo]};
+                const CDirectoryScanner::FileStatus &status{scanResult.fileStatus[fileNo]};
+                auto known = watchedDirectory.files.find(filePath.substr(directories[directoryNo].size() + 1));
+                if (known == watchedDirectory.files.end())
+                {
+                    m_inProcessOfCreation.erase(filePath);
+                    markScanReported(filePath);
+                    sendEvent(IApprise::Event_add, filePath);
+                    known = watchedDirectory.files.emplace(filePath.substr(directories[directoryNo].size() + 1), status).first;
+                }
+                else if (known->second.inode != 0)
+                {
+                    if (known->second.inode != status.inode)
+                    {
+                        sendEvent(IApprise::Event_add, filePath);
+                    }
+                    else if ((known->second.size != status.size) || (known->second.modified != status.modified))
+                    {
+                        sendEvent(IApprise::Event_change, filePath);
+                    }
+                }
+                known->second = status;
+                foundFiles.insert(known->first);
+            }
+            // Files removed
+            for (auto file = watchedDirectory.files.begin(); file != watchedDirectory.files.end();)
+            {
+                if (foundFiles.find(file->first) == foundFiles.end())
+                {
+                    sendEvent(IApprise::Event_unlink, directories[directoryNo] + "/" + file->first);
+                    file = watchedDirectory.files.erase(file);
+                }
+                else
+                {
+                    ++file;
+                }
+            }
+            // Directories not watched
+            for (auto &subDirectory : scanResult.directories)
+            {
+                if (withinWatchDepth(subDirectory) && ownsPath(subDirectory, true) && (findDirectory(subDirectory) == kNoDirectory))
+                {
+                    newDirectories.push_back(subDirectory);
+                }
+            }
+        }
+        for (auto &newDirectory : newDirectories)
+        {
+            sendEvent(IApprise::Event_addir, newDirectory);
+            watchDirectory(newDirectory);
+        }
+        scanDirectories(newDirectories, true);
+    }
+    //
+    // Report inotify queue overflow, enlarge the read buffer to drain any burst and
+    // rescan for anything missed if reconciling.
+    //
+    void CFileEventNotifier::handleOverflow(void)
+    {
+        m_overflows->add();
+        sendEvent(IApprise::Event_overflow, kLogPrefix + "inotify event queue overflow");
+        m_overflowReads = kOverflowReads;
+        if (m_options.reconcileOverflow)
+        {
+            reconcileDirectories();
+        }
+    }
+    //
+    // Reallocate the inotify read buffer with a new length.
+    //
+    void CFileEventNotifier::resizeReadBuffer(std::uint32_t bufferLen)
+    {
+        m_inotifyBuffer = std::make_unique<std::uint8_t[]>(bufferLen);
+        m_inotifyBufferLen = bufferLen;
+    }
+    //
+    // Generate CFileEventNotifier event; held until queued by queueGeneratedEvents().
     //
     void CFileEventNotifier::sendEvent(IApprise::EventId id, const std::string &fileName)
     {
+        // Path belongs to another shard
+        if ((m_shard.shards > 1) && (id != IApprise::Event_error) && (id != IApprise::Event_overflow) &&
+            !ownsPath(fileName, (id == IApprise::Event_addir) || (id == IApprise::Event_unlinkdir)))
+        {
+            return;
+        }
+        m_generatedEvents.emplace_back(id, fileName);
+    }
+    //
+    // Pass events generated (while the watch table was locked) to the coalescing stage
+    // or queue.
+    //
+    void CFileEventNotifier::queueGeneratedEvents(void)
+    {
+        for (auto &evt : m_generatedEvents)
+        {
+            if (m_coalescer && CFileEventCoalescer::coalesces(evt.id))
+            {
+                m_coalescer->add(evt);
+            }
+            else
+            {
+                queueEvent(evt);
+            }
+        }
+        m_generatedEvents.clear();
+    }
+    //
+    // Place event on queue and wake any waiting reader.
+    //
+    void CFileEventNotifier::queueEvent(const IApprise::Event &evt)
+    {
+        if (m_shard.queueEvent)
+        {
+            m_eventsQueued->add();
+            m_shard.queueEvent(evt);
+            return;
+        }
         std::unique_lock<std::mutex> locker(m_queuedEventsMutex);
-        m_queuedEvents.push(IApprise::Event(id, fileName));
+        // Wait for space in a bounded queue; only on the event generation thread so that
+        // a consumer whose addWatch() scan queues events cannot block itself.
+        if ((m_options.maxQueuedEvents != 0) && (m_queuedEvents.size() >= m_options.maxQueuedEvents) &&
+            (std::this_thread::get_id() == m_generationThread))
+        {
+            m_backpressureWaits->add();
+            m_queueSpaceWaiting.wait(locker, [&]() {
+                return ((m_queuedEvents.size() < m_options.maxQueuedEvents) || !m_doWork.load());
+            });
+        }
+        m_queuedEvents.push(evt);
+        m_eventsQueued->add();
+        m_queueDepth->set(static_cast<std::int64_t>(m_queuedEvents.size()));
         m_queuedEventsWaiting.notify_one();
     }
+    //
+    // Queue any coalesced events whose window has closed (or all if flushing).
+    //
+    void CFileEventNotifier::expireCoalescedEvents(bool flush)
+    {
+        std::vector<IApprise::Event> expired;
+        if (flush)
+        {
+            m_coalescer->flush(expired);
+        }
+        else
+        {
+            m_coalescer->expire(expired);
+        }
+        for (auto &evt : expired)
+        {
+            queueEvent(evt);
+        }
+    }
     // ==============
     // PUBLIC METHODS
     // ==============
     //
     // Main CFileEventNotifier object constructor.
     //
-    CFileEventNotifier::CFileEventNotifier() : m_doWork{true}
+    CFileEventNotifier::CFileEventNotifier(const IFileEventNotifier::Options &options) : CFileEventNotifier(options, Shard{0, 1, nullptr})
+    {
+    }
+    //
+    // CFileEventNotifier object constructor for one shard of a partitioned watch hierarchy.
+    //
+    CFileEventNotifier::CFileEventNotifier(const IFileEventNotifier::Options &options, const Shard &shard)
+        : m_options{options}, m_shard{shard}, m_doWork{true}
     {
+        // Create metrics
+        m_metrics = std::make_shared<CMetrics>();
+        m_eventsQueued = &m_metrics->counter("events_queued");
+        m_queueDepth = &m_metrics->gauge("queue_depth");
+        m_backpressureWaits = &m_metrics->counter("backpressure_waits");
+        m_overflows = &m_metrics->counter("overflows");
+        m_readBatchBytes = &m_metrics->histogram("read_batch_bytes");
+        m_readBatchEvents = &m_metrics->histogram("read_batch_events");
         // Allocate inotify read buffer
         m_inotifyBuffer = std::make_unique<std::uint8_t[]>(kInotifyEventBuffLen);
+        // Create coalescing stage if needed
+        if (m_options.coalesceWindow.count() > 0)
+        {
+            m_coalescer = std::make_unique<CFileEventCoalescer>(m_options.coalesceWindow);
+        }
         // Create watch table
         initialiseWatchTable();
     }
@@ -115,9 +767,9 @@ namespace Antik::File
     {
     }
     //
-    // Add watch for file/directory
+    // Add watch for a directory to inotify and the watch table.
     //
-    void CFileEventNotifier::addWatch(const std::string &filePath)
+    void CFileEventNotifier::watchDirectory(const std::string &filePath)
     {
         std::string fileName{filePath};
         int watch{0};
@@ -126,8 +778,8 @@ namespace Antik::File
         {
             fileName.pop_back();
         }
-        // Deeper than max watch depth so ignore.
-        if ((m_watchDepth != -1) && (std::count(fileName.begin(), fileName.end(), '/') > m_watchDepth))
+        // Deeper than max watch depth or in another shard so ignore.
+        if (!withinWatchDepth(fileName) || !ownsPath(fileName, true))
         {
             return;
         }
@@ -136,55 +788,42 @@ namespace Antik::File
         {
             throw std::system_error(std::error_code(errno, std::system_category()), "inotify_add_watch() error");
         }
-        // Add watch to map
-        m_watchMap.insert({watch, fileName});
+        // Add watch to table
+        internDirectory(watch, fileName);
+    }
+    //
+    // Add watch for file/directory
+    //
+    void CFileEventNotifier::addWatch(const std::string &filePath)
+    {
+        std::unique_lock<std::mutex> tableLocker(m_watchTableMutex);
+        watchDirectory(filePath);
     }
     //
     //  Remove watch for file/directory
     //
     void CFileEventNotifier::removeWatch(const std::string &filePath)
     {
-        try
+        std::string fileName{filePath};
+        bool noWatches{false};
+        // Remove path trailing '/'
+        if (fileName.back() == '/')
         {
-            std::string fileName{filePath};
-            int32_t watch{0};
-            // Remove path trailing '/'
-            if (fileName.back() == '/')
-            {
-                fileName.pop_back();
-            }
-            // Find Watch value
-            for (auto watchMapEntry : m_watchMap)
-            {
-                if (watchMapEntry.second.compare(filePath) == 0)
-                {
-                    watch = watchMapEntry.first;
-                    break;
-                }
-            }
-            if (watch)
-            {
-                m_watchMap.erase(watch);
-                if (inotify_rm_watch(m_inotifyFd, watch) == -1)
-                {
-                    throw std::system_error(std::error_code(errno, std::system_category()), "inotify_rm_watch() error");
-                }
-            }
-            else
-            {
-                throw std::logic_error("watch not present");
-            }
+            fileName.pop_back();
         }
-        catch (std::system_error &e)
+        // Find watched directory and remove it (along with any below it)
         {
-            // Ignore error 22 and carry on. From the documentation on this error the kernel has removed the watch for us.
-            if (e.code() != std::error_code(EINVAL, std::system_category()))
+            std::unique_lock<std::mutex> tableLocker(m_watchTableMutex);
+            std::uint32_t directoryId{findDirectory(fileName)};
+            if (directoryId == kNoDirectory)
             {
-                throw; // Throw exception back up the chain.
+                throw std::logic_error("watch not present");
             }
+            releaseDirectory(directoryId);
+            noWatches = m_watchIndex.empty();
         }
         // No more watches so closedown
-        if (m_watchMap.size() == 0)
+        if (noWatches)
         {
             stopEventGeneration();
         }
@@ -204,6 +843,32 @@ namespace Antik::File
         {
             evt = m_queuedEvents.front();
             m_queuedEvents.pop();
+            m_queueDepth->set(static_cast<std::int64_t>(m_queuedEvents.size()));
+            m_queueSpaceWaiting.notify_one();
+        }
+        else
+        {
+            evt.id = IApprise::Event_none;
+            evt.message = "";
+        }
+    }
+    //
+    // Get next IApprise event in queue; waiting at most timeout for one (Event_none on timeout).
+    //
+    void CFileEventNotifier::getNextEvent(IApprise::Event &evt, std::chrono::milliseconds timeout)
+    {
+        std::unique_lock<std::mutex> locker(m_queuedEventsMutex);
+        // Wait for something to happen. Either an event, stop running or timeout
+        m_queuedEventsWaiting.wait_for(locker, timeout, [&]() {
+            return (!m_queuedEvents.empty() || !m_doWork.load());
+        });
+        // return next event from queue
+        if (!m_queuedEvents.empty())
+        {
+            evt = m_queuedEvents.front();
+            m_queuedEvents.pop();
+            m_queueDepth->set(static_cast<std::int64_t>(m_queuedEvents.size()));
+            m_queueSpaceWaiting.notify_one();
         }
         else
         {
@@ -226,6 +891,13 @@ namespace Antik::File
         return m_thrownException;
     }
     //
+    // Return notifier metrics.
+    //
+    std::shared_ptr<CMetrics> CFileEventNotifier::getMetrics() const
+    {
+        return (m_metrics);
+    }
+    //
     // Set maximum watch depth.
     //
     void CFileEventNotifier::setWatchDepth(int watchDepth)
@@ -237,12 +909,13 @@ namespace Antik::File
     //
     void CFileEventNotifier::stopEventGeneration(void)
     {
-        // If still active then need to close down
-        if (m_doWork.load())
+        // If still active then need to close down (only once; shards are stopped by
+        // their generation thread and the sharded notifier's at the same time)
+        if (m_doWork.exchange(false))
         {
             std::unique_lock<std::mutex> locker(m_queuedEventsMutex);
-            m_doWork = false;
             m_queuedEventsWaiting.notify_one();
+            m_queueSpaceWaiting.notify_all();
             destroyWatchTable();
         }
     }
@@ -259,7 +932,7 @@ namespace Antik::File
             while (true)
             {
                 int readLen{0};
-                if ((readLen = read(m_inotifyFd, buffer, kInotifyEventBuffLen)) == -1)
+                if ((readLen = read(m_inotifyFd, buffer, m_inotifyBufferLen)) == -1)
                 {
                     throw std::system_error(std::error_code(errno, std::system_category()), "inotify read() error");
                 }
@@ -275,46 +948,139 @@ namespace Antik::File
     //
     void CFileEventNotifier::generateEvents(void)
     {
-        std::uint8_t *buffer{m_inotifyBuffer.get()};
+        std::uint8_t *buffer{nullptr};
         struct inotify_event *event{
             nullptr};
         std::string filePath;
         try
         {
+            // Record thread so that it alone waits for space in a bounded queue
+            {
+                std::unique_lock<std::mutex> locker(m_queuedEventsMutex);
+                m_generationThread = std::this_thread::get_id();
+            }
+            // Report contents of watch folder(s) present at start (or just snapshot them)
+            if (m_options.initialScan || m_options.reconcileOverflow)
+            {
+                std::unique_lock<std::mutex> tableLocker(m_watchTableMutex);
+                std::vector<std::string> watchedDirectories;
+                for (auto &rootEntry : m_rootIndex)
+                {
+                    watchedDirectories.push_back(rootEntry.first);
+                }
+                scanDirectories(watchedDirectories, false, m_options.initialScan);
+            }
+            queueGeneratedEvents();
             // Loop until told to stop
             while (m_doWork.load())
             {
                 int readLen{0};
                 int currentPos{0};
+                bool noWatches{false};
+                // Wait at most a coalescer tick for events while any are pending and only until
+                // the move to of any directory moved from is due.
+                int pollTimeout{-1};
+                if (m_coalescer && !m_coalescer->empty())
+                {
+                    pollTimeout = static_cast<int>(m_coalescer->tick().count());
+                }
+                if (!m_pendingMoves.empty())
+                {
+                    auto moveWait{std::chrono::duration_cast<std::chrono::milliseconds>(m_pendingMovesDue - std::chrono::steady_clock::now())};
+                    if ((pollTimeout == -1) || (moveWait.count() < pollTimeout))
+                    {
+                        pollTimeout = std::max(static_cast<int>(moveWait.count()), 0);
+                    }
+                }
+                if (pollTimeout != -1)
+                {
+                    struct pollfd inotifyPoll
+                    {
+                        m_inotifyFd, POLLIN, 0
+                    };
+                    int pollStatus{poll(&inotifyPoll, 1, pollTimeout)};
+                    if ((pollStatus == -1) && (errno != EINTR))
+                    {
+                        throw std::system_error(std::error_code(errno, std::system_category()), "inotify poll() error");
+                    }
+                    if (pollStatus <= 0)
+                    {
+                        // Directory moved from whose move to has not arrived has left the hierarchy
+                        if (!m_pendingMoves.empty() && (std::chrono::steady_clock::now() >= m_pendingMovesDue))
+                        {
+                            std::unique_lock<std::mutex> tableLocker(m_watchTableMutex);
+                            resolvePendingMoves();
+                            noWatches = m_watchIndex.empty();
+                        }
+                        if (noWatches)
+                        {
+                            stopEventGeneration();
+                        }
+                        if (m_coalescer)
+                        {
+                            expireCoalescedEvents();
+                        }
+                        continue;
+                    }
+                }
                 // Read in events
-                if ((readLen = read(m_inotifyFd, buffer, kInotifyEventBuffLen)) == -1)
+                buffer = m_inotifyBuffer.get();
+                if ((readLen = read(m_inotifyFd, buffer, m_inotifyBufferLen)) == -1)
                 {
                     throw std::system_error(std::error_code(errno, std::system_category()), "inotify read() error");
                 }
+                m_readBatchBytes->record(readLen);
+                std::uint64_t eventsRead{0};
+                std::unique_lock<std::mutex> tableLocker(m_watchTableMutex);
+                m_inotifyBytesRead += readLen;
                 // Loop until all read processed
                 while (currentPos < readLen)
                 {
                     // Point to next event & display if necessary
                     event = (struct inotify_event *)&buffer[currentPos];
                     currentPos += kInotifyEventSize + event->len;
+                    eventsRead++;
+                    m_inotifyBytesProcessed += kInotifyEventSize + event->len;
+                    if (!m_scanReportedExpiry.empty())
+                    {
+                        expireScanReported();
+                    }
+                    // Events lost so report and recover
+                    if (event->mask & IN_Q_OVERFLOW)
+                    {
+                        handleOverflow();
+                        continue;
+                    }
                     // IGNORE so move onto next event
                     if (event->mask == IN_IGNORED)
                     {
                         continue;
                     }
-                    // Create full file name path
-                    filePath = m_watchMap[event->wd];
-                    if (event->len > 0)
+                    // A directory move from is immediately followed by its move to if the directory
+                    // stays within the hierarchy; so anything else means it has been moved out.
+                    if (!m_pendingMoves.empty() && ((event->mask != (IN_ISDIR | IN_MOVED_TO)) || (m_pendingMoves.count(event->cookie) == 0)))
                     {
-                        filePath += ("/" + static_cast<std::string>(event->name));
+                        resolvePendingMoves();
                     }
+                    // Watch since removed so ignore
+                    auto watched = m_watchIndex.find(event->wd);
+                    if (watched == m_watchIndex.end())
+                    {
+                        continue;
+                    }
+                    // Create full file name path
+                    std::uint32_t directoryId{watched->second};
+                    directoryPath(directoryId, (event->len > 0) ? event->name : nullptr, filePath);
                     // Process event
                     switch (event->mask)
                     {
-                    // Flag file as being created
+                    // Flag file as being created (unless already reported by a scan)
                     case IN_CREATE:
                     {
-                        m_inProcessOfCreation.insert(filePath);
+                        if (!wasScanReported(filePath))
+                        {
+                            m_inProcessOfCreation.insert(filePath);
+                        }
                         break;
                     }
                     // If file not being created send Event_change
@@ -323,16 +1089,53 @@ namespace Antik::File
                         auto beingCreated = m_inProcessOfCreation.find(filePath);
                         if (beingCreated == m_inProcessOfCreation.end())
                         {
+                            snapshotFile(directoryId, event->name, true);
                             sendEvent(IApprise::Event_change, filePath);
                         }
                         break;
                     }
-                    // Add watch for new directory and send Event_addir
-                    case (IN_ISDIR | IN_CREATE):
+                    // Directory renamed within hierarchy so move it (and everything below it)
+                    // in the watch table and send Event_addir; otherwise it has been moved
+                    // in from outside so treat as new.
                     case (IN_ISDIR | IN_MOVED_TO):
                     {
+                        auto pendingMove = m_pendingMoves.find(event->cookie);
+                        if (pendingMove != m_pendingMoves.end())
+                        {
+                            auto moved = m_watchIndex.find(pendingMove->second);
+                            m_pendingMoves.erase(pendingMove);
+                            if (moved != m_watchIndex.end())
+                            {
+                                sendEvent(IApprise::Event_addir, filePath);
+                                if (withinWatchDepth(filePath) && ownsPath(filePath, true))
+                                {
+                                    moveDirectory(moved->second, directoryId, event->name);
+                                }
+                                else
+                                {
+                                    releaseDirectory(moved->second);
+                                }
+                                break;
+                            }
+                        }
+                        [[fallthrough]];
+                    }
+                    // Add watch for new directory and send Event_addir. If scanning
+                    // then report anything created in it before the watch was added.
+                    // A directory moved in (from outside or another shard) arrives with
+                    // its contents so is always scanned; watching everything below it.
+                    case (IN_ISDIR | IN_CREATE):
+                    {
+                        if (wasScanReported(filePath))
+                        {
+                            break;
+                        }
                         sendEvent(IApprise::Event_addir, filePath);
-                        addWatch(filePath);
+                        watchDirectory(filePath);
+                        if ((m_options.initialScan || (event->mask == (IN_ISDIR | IN_MOVED_TO))) && withinWatchDepth(filePath) && ownsPath(filePath, true))
+                        {
+                            scanDirectories({filePath}, true);
+                        }
                         break;
                     }
                     // Directory deleted send Event_unlinkdir
@@ -341,28 +1144,54 @@ namespace Antik::File
                         sendEvent(IApprise::Event_unlinkdir, filePath);
                         break;
                     }
-                    // Remove watch for deleted/moved directory
+                    // Directory moved so hold until paired with its move to (by cookie)
                     case (IN_ISDIR | IN_MOVED_FROM):
+                    {
+                        auto &children{m_watchedDirectories[directoryId].children};
+                        auto child = children.find(event->name);
+                        if (child != children.end())
+                        {
+                            if (m_pendingMoves.empty())
+                            {
+                                m_pendingMovesDue = std::chrono::steady_clock::now() + kPendingMoveWait;
+                            }
+                            m_pendingMoves[event->cookie] = m_watchedDirectories[child->second].watch;
+                        }
+                        break;
+                    }
+                    // Remove watch for deleted directory
                     case IN_DELETE_SELF:
                     {
-                        removeWatch(filePath);
+                        releaseDirectory(directoryId);
                         break;
                     }
                     // File deleted send Event_unlink
                     case IN_DELETE:
                     {
+                        snapshotFile(directoryId, event->name, false);
                         sendEvent(IApprise::Event_unlink, filePath);
                         break;
                     }
-                    // File moved into directory send Event_add.
+                    // File moved out of directory
+                    case IN_MOVED_FROM:
+                    {
+                        snapshotFile(directoryId, event->name, false);
+                        break;
+                    }
+                    // File moved into directory send Event_add (unless already reported by a scan).
                     case IN_MOVED_TO:
                     {
-                        sendEvent(IApprise::Event_add, filePath);
+                        snapshotFile(directoryId, event->name, true);
+                        if (!wasScanReported(filePath))
+                        {
+                            sendEvent(IApprise::Event_add, filePath);
+                        }
                         break;
                     }
                     // File closed. If being created send Event_add otherwise Event_change.
                     case IN_CLOSE_WRITE:
                     {
+                        snapshotFile(directoryId, event->name, true);
                         auto beingCreated = m_inProcessOfCreation.find(filePath);
                         if (beingCreated == m_inProcessOfCreation.end())
                         {
@@ -379,6 +1208,36 @@ namespace Antik::File
                         break;
                     }
                 }
+                m_readBatchEvents->record(eventsRead);
+                // Read buffer enlarged after an overflow until reads no longer fill half of it
+                if (m_overflowReads > 0)
+                {
+                    if (static_cast<std::uint32_t>(readLen) > (m_inotifyBufferLen / 2))
+                    {
+                        m_overflowReads = kOverflowReads;
+                    }
+                    else if (--m_overflowReads == 0)
+                    {
+                        resizeReadBuffer(kInotifyEventBuffLen);
+                    }
+                    if ((m_overflowReads > 0) && (m_inotifyBufferLen != kInotifyOverflowEventBuffLen))
+                    {
+                        resizeReadBuffer(kInotifyOverflowEventBuffLen);
+                    }
+                }
+                noWatches = m_watchIndex.empty();
+                tableLocker.unlock();
+                queueGeneratedEvents();
+                // No more watches so closedown
+                if (noWatches)
+                {
+                    stopEventGeneration();
+                }
+                // Queue any coalesced events now due
+                if (m_coalescer)
+                {
+                    expireCoalescedEvents();
+                }
             }
             //
             // Generate event for any exceptions and also store to be passed up the chain
@@ -394,6 +1253,12 @@ namespace Antik::File
             sendEvent(IApprise::Event_error, kLogPrefix + "General exception occured: [" + e.what() + "]");
             m_thrownException = std::current_exception();
         }
+        // Queue any events generated before stopping and anything still waiting to be coalesced
+        queueGeneratedEvents();
+        if (m_coalescer)
+        {
+            expireCoalescedEvents(true);
+        }
         stopEventGeneration(); // If not asked to stop then call anyway (cleanup)
     }
 } // namespace Antik::File
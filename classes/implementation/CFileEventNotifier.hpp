@@ -5,15 +5,23 @@
 //
 #include <unordered_map>
 #include <queue>
+#include <deque>
+#include <vector>
 #include <condition_variable>
+#include <mutex>
+#include <chrono>
+#include <thread>
 #include <atomic>
 #include <set>
+#include <functional>
 //
 // Antik classes
 //
 #include "CommonAntik.hpp"
 #include "IApprise.hpp"
 #include "IFileEventNotifier.hpp"
+#include "CFileEventCoalescer.hpp"
+#include "CDirectoryScanner.hpp"
 //
 // inotify
 //
@@ -32,13 +40,27 @@ namespace Antik::File
         // ==========================
         // PUBLIC TYPES AND CONSTANTS
         // ==========================
+        //
+        // Shard of a watch hierarchy partitioned between notifiers by top-level directory
+        // (see CShardedFileEventNotifier); events are passed to queueEvent if it is set.
+        //
+        struct Shard
+        {
+            std::size_t shardNo;                                     // Shard number
+            std::size_t shards;                                      // Number of shards
+            std::function<void(const IApprise::Event &)> queueEvent; // Shared event queue (nullptr = own queue)
+        };
         // ============
         // CONSTRUCTORS
         // ============
         //
         // Main constructor
         //
-        CFileEventNotifier();
+        explicit CFileEventNotifier(const IFileEventNotifier::Options &options = IFileEventNotifier::Options());
+        //
+        // Shard constructor
+        //
+        CFileEventNotifier(const IFileEventNotifier::Options &options, const Shard &shard);
         // ==========
         // DESTRUCTOR
         // ==========
@@ -52,6 +74,7 @@ namespace Antik::File
         void generateEvents(void) override;                   // Watch folder(s) for file events
         void stopEventGeneration(void) override;              // Stop watch loop/thread
         void getNextEvent(IApprise::Event &message) override; // Get next queued event
+        void getNextEvent(IApprise::Event &message, std::chrono::milliseconds timeout) override; // Get next queued event (waiting at most timeout)
         bool stillWatching() const override;                  // Events still being generated
         void clearEventQueue() override;                      // Clear event queue
         //
@@ -62,6 +85,8 @@ namespace Antik::File
         void removeWatch(const std::string &filePath) override; // Remove path being watched
         // Exception handling
         std::exception_ptr getThrownException() const override; // Get last thrown exception
+        // Metrics
+        std::shared_ptr<CMetrics> getMetrics() const override; // Get notifier metrics
         // ================
         // PUBLIC VARIABLES
         // ================
@@ -76,9 +101,29 @@ namespace Antik::File
         //
         // inotify
         //
-        static const std::uint32_t kInofityEvents;       // inotify events to monitor
-        static const std::uint32_t kInotifyEventSize;    // inotify read event size
-        static const std::uint32_t kInotifyEventBuffLen; // inotify read buffer length
+        static const std::uint32_t kInofityEvents;               // inotify events to monitor
+        static const std::uint32_t kInotifyEventSize;            // inotify read event size
+        static const std::uint32_t kInotifyEventBuffLen;         // inotify read buffer length
+        static const std::uint32_t kInotifyOverflowEventBuffLen; // inotify read buffer length after an overflow
+        static const std::uint32_t kOverflowReads;               // Reads not filling buffer before overflow length reverts
+        //
+        // Watched directory table
+        //
+        static const std::uint32_t kNoDirectory;                 // No directory id
+        static const std::chrono::milliseconds kPendingMoveWait; // Wait for move to of a directory moved from
+        //
+        // Watched directory; an entry in the interned path table. Only the name within
+        // its parent is held (full path for a root) so the path of a whole sub-tree
+        // changes when a directory is renamed by updating a single entry.
+        //
+        struct WatchedDirectory
+        {
+            std::int32_t watch{-1};                                               // inotify watch descriptor (-1 == free entry)
+            std::uint32_t parent{kNoDirectory};                                   // Parent directory id (kNoDirectory == root)
+            std::string name;                                                     // Name within parent directory (root path)
+            std::unordered_map<std::string, std::uint32_t> children;              // Watched sub-directory ids indexed by name
+            std::unordered_map<std::string, CDirectoryScanner::FileStatus> files; // Known files (if reconciling overflow)
+        };
         // ===========================================
         // DISABLED CONSTRUCTORS/DESTRUCTORS/OPERATORS
         // ===========================================
@@ -91,8 +136,37 @@ namespace Antik::File
         //
         // Watch processing
         //
-        void initialiseWatchTable(void); // Initialise table for watched folders
-        void destroyWatchTable(void);    // Tare down watch table
+        void initialiseWatchTable(void);                                  // Initialise table for watched folders
+        void destroyWatchTable(void);                                     // Tare down watch table
+        bool withinWatchDepth(const std::string &filePath) const;         // Path within maximum watch depth
+        bool ownsPath(const std::string &filePath, bool directory) const; // Path belongs to this shard
+        //
+        // Watched directory table
+        //
+        std::uint32_t findDirectory(const std::string &directoryPath);                                  // Path to directory id
+        void directoryPath(std::uint32_t directoryId, const char *name, std::string &filePath);         // Directory id (+ name) to path
+        std::uint32_t internDirectory(std::int32_t watch, const std::string &directoryPath);            // Add directory to table
+        void watchDirectory(const std::string &filePath);                                               // Add directory watch (table locked)
+        void releaseDirectory(std::uint32_t directoryId);                                               // Remove directory sub-tree
+        void releaseBelowWatchDepth(std::uint32_t directoryId, int depth);                              // Remove sub-tree below max watch depth
+        void moveDirectory(std::uint32_t directoryId, std::uint32_t parentId, const std::string &name); // Rename directory
+        void renameInProcessOfCreation(const std::string &fromPath, const std::string &toPath);         // Rename files being created
+        void resolvePendingMoves(void);                                                                 // Directories moved out of hierarchy
+        //
+        // Directory scan
+        //
+        void scanDirectories(const std::vector<std::string> &directories, bool reportDirectories, bool reportFiles = true); // Scan directory hierarchy
+        void markScanReported(const std::string &filePath);                                                                 // Path reported by scan
+        bool wasScanReported(const std::string &filePath);                                                                  // Path already reported by scan
+        void expireScanReported(void);                                                                                      // Expire old scan reported paths
+        //
+        // Queue overflow
+        //
+        void snapshotFile(std::uint32_t directoryId, const char *name, bool present); // Record file known/gone
+        void unlinkSnapshot(std::uint32_t directoryId);                               // Report known sub-tree contents gone
+        void reconcileDirectories(void);                                              // Rescan watched directories against snapshot
+        void handleOverflow(void);                                                    // Process inotify queue overflow
+        void resizeReadBuffer(std::uint32_t bufferLen);                               // Change inotify read buffer length
         //
         // Queue IApprise event
         //
@@ -100,6 +174,9 @@ namespace Antik::File
             IApprise::EventId id,      // Event id
             const std::string &message // Filename/message
         );
+        void queueGeneratedEvents(void);                // Queue events generated while table locked
+        void queueEvent(const IApprise::Event &evt);    // Place event on queue
+        void expireCoalescedEvents(bool flush = false); // Queue coalesced events whose window has closed
         // =================
         // PRIVATE VARIABLES
         // =================
@@ -109,8 +186,41 @@ namespace Antik::File
         int m_inotifyFd{0};                                                   // file descriptor for read
         std::uint32_t m_inotifyWatchMask{CFileEventNotifier::kInofityEvents}; // watch event mask
         std::unique_ptr<std::uint8_t[]> m_inotifyBuffer;                      // read buffer
-        std::unordered_map<int32_t, std::string> m_watchMap;                  // Watch table indexed by watch variable
+        std::uint32_t m_inotifyBufferLen{kInotifyEventBuffLen};               // read buffer length
+        std::uint32_t m_overflowReads{0};                                     // Reads left before enlarged buffer reverts
+        std::vector<WatchedDirectory> m_watchedDirectories;                   // Interned watched directory table
+        std::vector<std::uint32_t> m_freeDirectoryIds;                        // Free entries in watched directory table
+        std::unordered_map<std::int32_t, std::uint32_t> m_watchIndex;         // Watched directory id indexed by watch
+        std::unordered_map<std::string, std::uint32_t> m_rootIndex;           // Root watched directory id indexed by path
+        std::unordered_map<std::uint32_t, std::int32_t> m_pendingMoves;       // Directory moved from watch indexed by cookie
+        std::chrono::steady_clock::time_point m_pendingMovesDue;              // Time by which pending moves must be paired
+        std::mutex m_watchTableMutex;                                         // Watched directory table mutex
+        std::vector<std::uint32_t> m_pathDirectoryIds;                        // Directory ids when building path
+        std::string m_pathComponent;                                          // Path component when finding directory
         std::set<std::string> m_inProcessOfCreation;                          // Set to hold files being created.
+        std::uint64_t m_inotifyBytesRead{0};                                  // Total bytes read from inotify
+        std::uint64_t m_inotifyBytesProcessed{0};                             // Total bytes of inotify events processed
+        //
+        // Directory scan
+        //
+        IFileEventNotifier::Options m_options;                                  // Notifier options
+        Shard m_shard{0, 1, nullptr};                                           // Shard of watch hierarchy (whole of it by default)
+        std::unordered_map<std::string, std::uint64_t> m_scanReported;          // Paths reported by scan (and expiry)
+        std::deque<std::pair<std::uint64_t, std::string>> m_scanReportedExpiry; // Scan reported paths in expiry order
+        //
+        // Event coalescing
+        //
+        std::unique_ptr<CFileEventCoalescer> m_coalescer; // Coalescing stage (nullptr if not enabled)
+        //
+        // Metrics
+        //
+        std::shared_ptr<CMetrics> m_metrics;             // Notifier metrics
+        CMetrics::Counter *m_eventsQueued{nullptr};      // Events queued
+        CMetrics::Gauge *m_queueDepth{nullptr};          // Event queue depth
+        CMetrics::Counter *m_backpressureWaits{nullptr}; // Waits for space in a full event queue
+        CMetrics::Counter *m_overflows{nullptr};         // Event queue overflows
+        CMetrics::Histogram *m_readBatchBytes{nullptr};  // Bytes returned by each inotify read
+        CMetrics::Histogram *m_readBatchEvents{nullptr}; // Events returned by each inotify read
         //
         // Publicly accessed via accessors
         //
@@ -120,9 +230,12 @@ namespace Antik::File
         //
         // Event queue
         //
-        std::condition_variable m_queuedEventsWaiting; // Queued events conditional
-        std::mutex m_queuedEventsMutex;                // Queued events mutex
-        std::queue<IApprise::Event> m_queuedEvents;    // Queue of CFileEventNotifier events
+        std::condition_variable m_queuedEventsWaiting;  // Queued events conditional
+        std::condition_variable m_queueSpaceWaiting;    // Queue space conditional (bounded queue)
+        std::thread::id m_generationThread;             // Event generation thread (only it waits for space)
+        std::mutex m_queuedEventsMutex;                 // Queued events mutex
+        std::queue<IApprise::Event> m_queuedEvents;     // Queue of CFileEventNotifier events
+        std::vector<IApprise::Event> m_generatedEvents; // Events generated waiting to be queued
     };
 } // namespace Antik::File
 #endif /* CFILEEVENTNOTIFIER_HPP */
@@ -0,0 +1,287 @@
+//
+// Class: CFileStabilizer
+//
+// Description: Stabilization stage used by CTask between file add events and the
+// task action. A file is only passed on once no further event has been seen for it
+// for a quiet period and (if requested) its size and modification time are the same
+// at the end of the period as at the start; otherwise the period is restarted. This
+// stops files written by producers that open/close them repeatedly (or through more
+// than one handle) from being processed before they are complete. Pending files are
+// kept on a hierarchical time wheel (each level covering 64 times the span of
+// the one below) with entries cascading down a level as their deadline approaches so
+// that the cost per tick is O(1) however many files are pending and however long the
+// quiet period.
+//
+// Dependencies: C20++               - Language standard features used.
+//               Linux               - stat.
+//
+// =================
+// CLASS DEFINITIONS
+// =================
+#include "CFileStabilizer.hpp"
+// ====================
+// CLASS IMPLEMENTATION
+// ====================
+//
+// C++ STL
+//
+#include <algorithm>
+//
+// Linux
+//
+#include <sys/stat.h>
+// =========
+// NAMESPACE
+// =========
+namespace Antik::File
+{
+    // ===========================
+    // PRIVATE TYPES AND CONSTANTS
+    // ===========================
+    // Time wheel levels and slots per level (64 slots of 64^level ticks)
+    const int CFileStabilizer::kWheelLevels{4};
+    const int CFileStabilizer::kWheelSlotBits{6};
+    // Ticks per quiet period (with tick no longer than maximum)
+    static const std::uint64_t kQuietPeriodTicks{16};
+    static const std::chrono::milliseconds kMaximumTick{100};
+    // ==========================
+    // PUBLIC TYPES AND CONSTANTS
+    // ==========================
+    // ========================
+    // PRIVATE STATIC VARIABLES
+    // ========================
+    // =======================
+    // PUBLIC STATIC VARIABLES
+    // =======================
+    // ===============
+    // PRIVATE METHODS
+    // ===============
+    //
+    // Convert time to wheel tick.
+    //
+    std::uint64_t CFileStabilizer::toTick(Clock::time_point now) const
+    {
+        if (now < m_start)
+        {
+            return (0);
+        }
+        return (std::chrono::duration_cast<std::chrono::milliseconds>(now - m_start) / m_tick);
+    }
+    //
+    // Place entry in the slot of the lowest wheel level whose span covers the time
+    // to its deadline (entries beyond the span of the top level are cascaded and
+    // placed again when their slot comes round).
+    //
+    void CFileStabilizer::schedule(WheelEntry &&wheelEntry)
+    {
+        std::uint64_t delta{(wheelEntry.deadline > m_currentTick) ? wheelEntry.deadline - m_currentTick : 0};
+        int level{0};
+        while ((level < kWheelLevels - 1) && ((delta >> (kWheelSlotBits * (level + 1))) != 0))
+        {
+            level++;
+        }
+        std::uint64_t slot{(std::max(wheelEntry.deadline, m_currentTick) >> (kWheelSlotBits * level)) & ((1 << kWheelSlotBits) - 1)};
+        m_wheel[level][slot].push_back(std::move(wheelEntry));
+    }
+    //
+    // Get file size and modification time. Returns false if the file no longer exists.
+    //
+    bool CFileStabilizer::fileStatus(const std::string &filePath, PendingFile &pendingFile) const
+    {
+        if (!m_checkStatus)
+        {
+            return (true);
+        }
+        struct stat fileStat;
+        if (stat(filePath.c_str(), &fileStat) == -1)
+        {
+            return (false);
+        }
+        pendingFile.size = static_cast<std::int64_t>(fileStat.st_size);
+        pendingFile.modified = static_cast<std::int64_t>(fileStat.st_mtim.tv_sec) * 1000000000 + fileStat.st_mtim.tv_nsec;
+        return (true);
+    }
+    //
+    // Expire level 0 wheel slot for the current tick. Files whose status has not changed
+    // over the quiet period are passed back; those that have changed start another and
+    // those that have gone are forgotten. Entries for files since restarted/cancelled are
+    // discarded. Returns the number of quiet periods restarted.
+    //
+    std::size_t CFileStabilizer::expireSlot(std::vector<WheelEntry> &wheelSlot, std::vector<IApprise::Event> &stable)
+    {
+        std::vector<WheelEntry> wheelEntries;
+        std::size_t restarted{0};
+        wheelEntries.swap(wheelSlot);
+        for (auto &wheelEntry : wheelEntries)
+        {
+            auto pendingFile = m_pending.find(wheelEntry.filePath);
+            if ((pendingFile == m_pending.end()) || (pendingFile->second.sequence != wheelEntry.sequence))
+            {
+                continue;
+            }
+            if (wheelEntry.deadline > m_currentTick)
+            {
+                schedule(std::move(wheelEntry));
+                continue;
+            }
+            PendingFile current{pendingFile->second};
+            if (!fileStatus(wheelEntry.filePath, current))
+            {
+                m_pending.erase(pendingFile);
+            }
+            else if ((current.size != pendingFile->second.size) || (current.modified != pendingFile->second.modified))
+            {
+                pendingFile->second.size = current.size;
+                pendingFile->second.modified = current.modified;
+                wheelEntry.deadline = m_currentTick + m_quietTicks + 1;
+                schedule(std::move(wheelEntry));
+                restarted++;
+            }
+            else
+            {
+                stable.emplace_back(IApprise::Event_add, wheelEntry.filePath);
+                stable.back().time = pendingFile->second.time;
+                m_pending.erase(pendingFile);
+            }
+        }
+        return (restarted);
+    }
+    // ==============
+    // PUBLIC METHODS
+    // ==============
+    //
+    // Main CFileStabilizer object constructor.
+    //
+    CFileStabilizer::CFileStabilizer(std::chrono::milliseconds quietPeriod, bool checkStatus, Clock::time_point now)
+        : m_quietPeriod{quietPeriod}, m_checkStatus{checkStatus}, m_start{now}
+    {
+        m_tick = std::clamp(m_quietPeriod / static_cast<long>(kQuietPeriodTicks), std::chrono::milliseconds(1), kMaximumTick);
+        // Quiet period rounded up to whole ticks (deadlines are a tick further on so that
+        // the period is never cut short by the tick the file was added part way through)
+        m_quietTicks = std::max(static_cast<std::uint64_t>((m_quietPeriod + m_tick - std::chrono::milliseconds(1)) / m_tick), static_cast<std::uint64_t>(1));
+        m_wheel.resize(kWheelLevels, std::vector<std::vector<WheelEntry>>(1 << kWheelSlotBits));
+    }
+    //
+    // CFileStabilizer Destructor
+    //
+    CFileStabilizer::~CFileStabilizer()
+    {
+    }
+    //
+    // Return true if event affects stabilization (file add/change/unlink).
+    //
+    bool CFileStabilizer::stabilizes(IApprise::EventId id)
+    {
+        return ((id == IApprise::Event_add) || (id == IApprise::Event_change) || (id == IApprise::Event_unlink));
+    }
+    //
+    // Pass event to stabilizer. An add starts (or restarts) the quiet period for a file, a
+    // change restarts it if the file is pending and an unlink cancels it. Returns true if
+    // the quiet period of a pending file was restarted.
+    //
+    bool CFileStabilizer::add(const IApprise::Event &evt, Clock::time_point now)
+    {
+        if (!stabilizes(evt.id) || evt.message.empty())
+        {
+            return (false);
+        }
+        auto pendingFile = m_pending.find(evt.message);
+        if (evt.id == IApprise::Event_unlink)
+        {
+            if (pendingFile != m_pending.end())
+            {
+                m_pending.erase(pendingFile);
+            }
+            return (false);
+        }
+        if ((pendingFile == m_pending.end()) && (evt.id == IApprise::Event_change))
+        {
+            return (false);
+        }
+        PendingFile current{++m_sequence, 0, 0, evt.time};
+        if (!fileStatus(evt.message, current))
+        {
+            if (pendingFile != m_pending.end())
+            {
+                m_pending.erase(pendingFile);
+            }
+            return (false);
+        }
+        if (m_pending.empty())
+        {
+            m_currentTick = std::max(toTick(now), m_currentTick);
+        }
+        schedule({evt.message, m_sequence, std::max(toTick(now), m_currentTick) + m_quietTicks + 1});
+        if (pendingFile != m_pending.end())
+        {
+            current.time = pendingFile->second.time;
+            pendingFile->second = current;
+            return (true);
+        }
+        m_pending.emplace(evt.message, current);
+        return (false);
+    }
+    //
+    // Advance the wheel to the current time (cascading entries down from higher levels
+    // as each level wraps) passing back any files stable at the end of their quiet
+    // period. Returns the number of quiet periods restarted because a file changed.
+    //
+    std::size_t CFileStabilizer::expire(std::vector<IApprise::Event> &stable, Clock::time_point now)
+    {
+        std::uint64_t nowTick{toTick(now)};
+        std::size_t restarted{0};
+        if (m_pending.empty())
+        {
+            m_currentTick = std::max(nowTick, m_currentTick);
+            return (0);
+        }
+        while (m_currentTick < nowTick)
+        {
+            m_currentTick++;
+            for (int level = 1; level < kWheelLevels; level++)
+            {
+                if ((m_currentTick & ((static_cast<std::uint64_t>(1) << (kWheelSlotBits * level)) - 1)) != 0)
+                {
+                    break;
+                }
+                std::vector<WheelEntry> wheelEntries;
+                wheelEntries.swap(m_wheel[level][(m_currentTick >> (kWheelSlotBits * level)) & ((1 << kWheelSlotBits) - 1)]);
+                for (auto &wheelEntry : wheelEntries)
+                {
+                    auto pendingFile = m_pending.find(wheelEntry.filePath);
+                    if ((pendingFile != m_pending.end()) && (pendingFile->second.sequence == wheelEntry.sequence))
+                    {
+                        schedule(std::move(wheelEntry));
+                    }
+                }
+            }
+            restarted += expireSlot(m_wheel[0][m_currentTick & ((1 << kWheelSlotBits) - 1)], stable);
+            if (m_pending.empty())
+            {
+                m_currentTick = nowTick;
+            }
+        }
+        return (restarted);
+    }
+    //
+    // Return true if no files pending.
+    //
+    bool CFileStabilizer::empty(void) const
+    {
+        return (m_pending.empty());
+    }
+    //
+    // Return number of files pending.
+    //
+    std::size_t CFileStabilizer::size(void) const
+    {
+        return (m_pending.size());
+    }
+    //
+    // Return wheel tick length (maximum time between calls to expire()).
+    //
+    std::chrono::milliseconds CFileStabilizer::tick(void) const
+    {
+        return (m_tick);
+    }
+} // namespace Antik::File
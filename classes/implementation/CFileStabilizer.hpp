@@ -0,0 +1,113 @@
+#ifndef CFILESTABILIZER_HPP
+#define CFILESTABILIZER_HPP
+//
+// C++ STL
+//
+#include <string>
+#include <vector>
+#include <chrono>
+#include <unordered_map>
+//
+// Antik classes
+//
+#include "IApprise.hpp"
+// =========
+// NAMESPACE
+// =========
+namespace Antik::File
+{
+    // ================
+    // CLASS DEFINITION
+    // ================
+    class CFileStabilizer
+    {
+    public:
+        // ==========================
+        // PUBLIC TYPES AND CONSTANTS
+        // ==========================
+        using Clock = std::chrono::steady_clock;
+        // ============
+        // CONSTRUCTORS
+        // ============
+        //
+        // Main constructor
+        //
+        explicit CFileStabilizer(std::chrono::milliseconds quietPeriod, bool checkStatus = true, Clock::time_point now = Clock::now());
+        // ==========
+        // DESTRUCTOR
+        // ==========
+        virtual ~CFileStabilizer();
+        // ==============
+        // PUBLIC METHODS
+        // ==============
+        //
+        // Stabilize files
+        //
+        static bool stabilizes(IApprise::EventId id);                                                   // Event affects pending files
+        bool add(const IApprise::Event &evt, Clock::time_point now = Clock::now());                     // Start/restart/cancel quiet period for file
+        std::size_t expire(std::vector<IApprise::Event> &stable, Clock::time_point now = Clock::now()); // Remove files stable at end of quiet period
+        //
+        // Pending files
+        //
+        bool empty(void) const;                     // No files pending
+        std::size_t size(void) const;               // Number of files pending
+        std::chrono::milliseconds tick(void) const; // Wheel tick length
+        // ================
+        // PUBLIC VARIABLES
+        // ================
+    private:
+        // ===========================
+        // PRIVATE TYPES AND CONSTANTS
+        // ===========================
+        //
+        // Time wheel levels and slots per level (as bits)
+        //
+        static const int kWheelLevels;
+        static const int kWheelSlotBits;
+        //
+        // Pending file
+        //
+        struct PendingFile
+        {
+            std::uint64_t sequence; // Sequence number of wheel entry
+            std::int64_t size;      // File size at start of quiet period
+            std::int64_t modified;  // File modification time (ns) at start of quiet period
+            Clock::time_point time; // Time first add event generated
+        };
+        //
+        // Wheel slot entry
+        //
+        struct WheelEntry
+        {
+            std::string filePath;   // File path
+            std::uint64_t sequence; // Sequence number when added
+            std::uint64_t deadline; // Wheel tick when quiet period ends
+        };
+        // ===========================================
+        // DISABLED CONSTRUCTORS/DESTRUCTORS/OPERATORS
+        // ===========================================
+        CFileStabilizer(const CFileStabilizer &orig) = delete;
+        CFileStabilizer(const CFileStabilizer &&orig) = delete;
+        CFileStabilizer &operator=(CFileStabilizer other) = delete;
+        // ===============
+        // PRIVATE METHODS
+        // ===============
+        std::uint64_t toTick(Clock::time_point now) const;                                                // Time to wheel tick
+        void schedule(WheelEntry &&wheelEntry);                                                           // Place entry on wheel level for its deadline
+        bool fileStatus(const std::string &filePath, PendingFile &pendingFile) const;                     // Stat file (false if gone)
+        std::size_t expireSlot(std::vector<WheelEntry> &wheelSlot, std::vector<IApprise::Event> &stable); // Expire level 0 slot
+        // =================
+        // PRIVATE VARIABLES
+        // =================
+        std::chrono::milliseconds m_quietPeriod;                   // Quiet period
+        bool m_checkStatus{true};                                  // Compare size/modification time at end of quiet period
+        std::chrono::milliseconds m_tick;                          // Wheel tick length
+        Clock::time_point m_start;                                 // Wheel start time
+        std::uint64_t m_currentTick{0};                            // Last wheel tick expired
+        std::uint64_t m_quietTicks{0};                             // Quiet period in ticks
+        std::uint64_t m_sequence{0};                               // Wheel entry sequence number
+        std::vector<std::vector<std::vector<WheelEntry>>> m_wheel; // Hierarchical time wheel of pending files (level, slot)
+        std::unordered_map<std::string, PendingFile> m_pending;    // Pending files
+    };
+} // namespace Antik::File
+#endif /* CFILESTABILIZER_HPP */
@@ -0,0 +1,734 @@
+//
+// Class: CPollingFileEventNotifier
+//
+// Description: File event notifier pass to CApprise class constructor. This is a
+// polling implementation for filesystems (such as NFS/SMB mounts) where changes made
+// by other clients are not seen by inotify/fanotify. A compact snapshot of every
+// watched directory is held (per file a name hash, size, modification time and inode
+// with names in a per-directory pool) and directories are periodically rescanned in
+// parallel by CDirectoryScanner and diffed against it to generate Event_add/change/
+// unlink (and Event_addir/unlinkdir for directories).
+//
+// To scale to large hierarchies rescans are incremental; every directory that has
+// changed within the last kHotPolls polls is rescanned each poll while only the next
+// Options::pollBatchSize unchanged directories (in a round-robin sweep) are; so a
+// change in an active directory is seen within one poll interval and in any other
+// within the time taken to sweep the hierarchy (all are rescanned if the batch size
+// is 0). Note: A file still being written when a poll happens is reported as added
+// and then as changed by the next; use the coalesce window option to merge these.
+//
+// Dependencies: C20++               - Language standard features used.
+//               Linux               - stat
+//
+// =================
+// CLASS DEFINITIONS
+// =================
+#include "CPollingFileEventNotifier.hpp"
+// ====================
+// CLASS IMPLEMENTATION
+// ====================
+//
+// C++ STL
+//
+#include <mutex>
+#include <system_error>
+#include <algorithm>
+//
+// Linux
+//
+#include <sys/stat.h>
+// =========
+// NAMESPACE
+// =========
+namespace Antik::File
+{
+    // ===========================
+    // PRIVATE TYPES AND CONSTANTS
+    // ===========================
+    // Polls a changed directory is rescanned for after its last change
+    const std::uint32_t CPollingFileEventNotifier::kHotPolls{8};
+    // CPollingFileEventNotifier logging prefix
+    const std::string CPollingFileEventNotifier::kLogPrefix{"[CPollingFileEventNotifier] "};
+    // ==========================
+    // PUBLIC TYPES AND CONSTANTS
+    // ==========================
+    // ========================
+    // PRIVATE STATIC VARIABLES
+    // ========================
+    // =======================
+    // PUBLIC STATIC VARIABLES
+    // =======================
+    // ===============
+    // PRIVATE METHODS
+    // ===============
+    //
+    // Return true if path is not deeper than the maximum watch depth.
+    //
+    bool CPollingFileEventNotifier::withinWatchDepth(const std::string &filePath) const
+    {
+        return ((m_watchDepth == -1) || (std::count(filePath.begin(), filePath.end(), '/') <= m_watchDepth));
+    }
+    //
+    // Return true if directory (or one above it) has had its watch removed.
+    //
+    bool CPollingFileEventNotifier::isRemovedDirectory(const std::string &directoryPath) const
+    {
+        return (std::any_of(m_removedDirectories.begin(), m_removedDirectories.end(), [&directoryPath](const std::string &removedPath) {
+            return ((directoryPath.size() >= removedPath.size()) && (directoryPath.compare(0, removedPath.size(), removedPath) == 0) &&
+                    ((directoryPath.size() == removedPath.size()) || (directoryPath[removedPath.size()] == '/')));
+        }));
+    }
+    //
+    // Convert the result of scanning a directory into its snapshot; files sorted by
+    // name hash (then name) and sub-directories (those being watched) by path.
+    //
+    void CPollingFileEventNotifier::buildSnapshot(const std::string &directoryPath, CDirectoryScanner::ScanResult &scanResult, DirectorySnapshot &snapshot)
+    {
+        snapshot.files.clear();
+        snapshot.names.clear();
+        snapshot.files.reserve(scanResult.files.size());
+        for (std::size_t fileNo = 0; fileNo < scanResult.files.size(); fileNo++)
+        {
+            std::string_view name{std::string_view(scanResult.files[fileNo]).substr(directoryPath.size() + 1)};
+            snapshot.files.push_back({m_nameHash(name), static_cast<std::uint32_t>(snapshot.names.size()), static_cast<std::uint32_t>(name.size()), scanResult.fileStatus[fileNo]});
+            snapshot.names.append(name);
+        }
+        std::string_view names{snapshot.names};
+        std::sort(snapshot.files.begin(), snapshot.files.end(), [&names](const SnapshotEntry &lhs, const SnapshotEntry &rhs) {
+            return ((lhs.nameHash != rhs.nameHash) ? (lhs.nameHash < rhs.nameHash) : (names.substr(lhs.nameOffset, lhs.nameLength) < names.substr(rhs.nameOffset, rhs.nameLength)));
+        });
+        snapshot.directories.clear();
+        for (auto &subDirectory : scanResult.directories)
+        {
+            if (withinWatchDepth(subDirectory) && !isRemovedDirectory(subDirectory))
+            {
+                snapshot.directories.push_back(std::move(subDirectory));
+            }
+        }
+        std::sort(snapshot.directories.begin(), snapshot.directories.end());
+    }
+    //
+    // Snapshot passed directories and any sub-directories within the watch depth a
+    // level at a time; reading each level in parallel. If requested Event_addir is
+    // sent for each sub-directory and Event_add for every file found.
+    //
+    void CPollingFileEventNotifier::walkDirectories(const std::vector<std::string> &directories, bool report)
+    {
+        std::vector<std::string> level{directories};
+        while (!level.empty())
+        {
+            std::vector<CDirectoryScanner::ScanResult> scanResults;
+            CDirectoryScanner::readDirectories(level, scanResults, m_options.scanThreads, true);
+            std::vector<std::string> nextLevel;
+            for (std::size_t directoryNo = 0; directoryNo < level.size(); directoryNo++)
+            {
+                auto &scanResult{scanResults[directoryNo]};
+                // Directory removed since being found so ignore.
+                if ((scanResult.error == ENOENT) || (scanResult.error == ENOTDIR))
+                {
+                    continue;
+                }
+                if (scanResult.error)
+                {
+                    throw std::system_error(std::error_code(scanResult.error, std::system_category()), "getdents64() error");
+                }
+                if (report)
+                {
+                    for (auto &filePath : scanResult.files)
+                    {
+                        sendEvent(IApprise::Event_add, filePath);
+                    }
+                }
+                DirectorySnapshot &snapshot{m_directories[level[directoryNo]]};
+                buildSnapshot(level[directoryNo], scanResult, snapshot);
+                snapshot.lastPoll = m_pollCount;
+                m_sweepOrder.push_back(level[directoryNo]);
+                for (auto &subDirectory : snapshot.directories)
+                {
+                    if (report)
+                    {
+                        sendEvent(IApprise::Event_addir, subDirectory);
+                    }
+                    nextLevel.push_back(subDirectory);
+                }
+            }
+            level = std::move(nextLevel);
+        }
+    }
+    //
+    // Compare the rescan of a directory against its snapshot sending events for
+    // any differences and then replace the snapshot. Returns true if anything changed.
+    //
+    bool CPollingFileEventNotifier::diffDirectory(const std::string &directoryPath, DirectorySnapshot &snapshot, CDirectoryScanner::ScanResult &scanResult)
+    {
+        DirectorySnapshot rescan;
+        buildSnapshot(directoryPath, scanResult, rescan);
+        bool changed{false};
+        std::string_view oldNames{snapshot.names};
+        std::string_view newNames{rescan.names};
+        auto filePath = [&directoryPath](std::string_view names, const SnapshotEntry &entry) {
+            return (directoryPath + "/" + std::string(names.substr(entry.nameOffset, entry.nameLength)));
+        };
+        // Merge the two sorted file lists
+        auto oldFile = snapshot.files.begin();
+        auto newFile = rescan.files.begin();
+        while ((oldFile != snapshot.files.end()) || (newFile != rescan.files.end()))
+        {
+            int compare{0};
+            if (oldFile == snapshot.files.end())
+            {
+                compare = 1;
+            }
+            else if (newFile == rescan.files.end())
+            {
+                compare = -1;
+            }
+            else if (oldFile->nameHash != newFile->nameHash)
+            {
+                compare = (oldFile->nameHash < newFile->nameHash) ? -1 : 1;
+            }
+            else
+            {
+                compare = oldNames.substr(oldFile->nameOffset, oldFile->nameLength).compare(newNames.substr(newFile->nameOffset, newFile->nameLength));
+            }
+            if (compare < 0)
+            {
+                sendEvent(IApprise::Event_unlink, filePath(oldNames, *oldFile++));
+                changed = true;
+            }
+            else if (compare > 0)
+            {
+                sendEvent(IApprise::Event_add, filePath(newNames, *newFile++));
+                changed = true;
+            }
+            else
+            {
+                // Replaced by another file (eg. renamed over) so new
+                if (oldFile->status.inode != newFile->status.inode)
+                {
+                    sendEvent(IApprise::Event_add, filePath(newNames, *newFile));
+                    changed = true;
+                }
+                else if ((oldFile->status.size != newFile->status.size) || (oldFile->status.modified != newFile->status.modified))
+                {
+                    sendEvent(IApprise::Event_change, filePath(newNames, *newFile));
+                    changed = true;
+                }
+                oldFile++;
+                newFile++;
+            }
+        }
+        // Sub-directories removed and added
+        std::vector<std::string> removedDirectories;
+        std::vector<std::string> addedDirectories;
+        std::set_difference(snapshot.directories.begin(), snapshot.directories.end(), rescan.directories.begin(), rescan.directories.end(), std::back_inserter(removedDirectories));
+        std::set_difference(rescan.directories.begin(), rescan.directories.end(), snapshot.directories.begin(), snapshot.directories.end(), std::back_inserter(addedDirectories));
+        snapshot.files = std::move(rescan.files);
+        snapshot.names = std::move(rescan.names);
+        snapshot.directories = std::move(rescan.directories);
+        for (auto &removedDirectory : removedDirectories)
+        {
+            releaseDirectory(removedDirectory, true);
+        }
+        for (auto &addedDirectory : addedDirectories)
+        {
+            sendEvent(IApprise::Event_addir, addedDirectory);
+        }
+        if (!addedDirectories.empty())
+        {
+            walkDirectories(addedDirectories, true);
+        }
+        return (changed || !removedDirectories.empty() || !addedDirectories.empty());
+    }
+    //
+    // Remove a directory and all those below it from the snapshot; sending Event_unlink
+    // for its files and Event_unlinkdir for it (and sub-directories) if requested.
+    //
+    void CPollingFileEventNotifier::releaseDirectory(const std::string &directoryPath, bool report)
+    {
+        auto directory = m_directories.find(directoryPath);
+        if (directory == m_directories.end())
+        {
+            return;
+        }
+        DirectorySnapshot snapshot{std::move(directory->second)};
+        m_directories.erase(directory);
+        m_hotDirectories.erase(directoryPath);
+        if (report)
+        {
+            for (auto &file : snapshot.files)
+            {
+                sendEvent(IApprise::Event_unlink, directoryPath + "/" + snapshot.names.substr(file.nameOffset, file.nameLength));
+            }
+        }
+        for (auto &subDirectory : snapshot.directories)
+        {
+            releaseDirectory(subDirectory, report);
+        }
+        if (report)
+        {
+            sendEvent(IApprise::Event_unlinkdir, directoryPath);
+        }
+    }
+    //
+    // Remove from the snapshot directories whose watch has been removed since the last
+    // poll. A directory within a watch folder is also forgotten by its parent so that
+    // it is seen as new should its watch be added back.
+    //
+    void CPollingFileEventNotifier::releaseRemovedWatches(void)
+    {
+        for (auto &releasedWatch : m_releasedWatches)
+        {
+            releaseDirectory(releasedWatch, false);
+            auto parent = m_directories.find(releasedWatch.substr(0, releasedWatch.rfind('/')));
+            if (parent != m_directories.end())
+            {
+                auto &subDirectories{parent->second.directories};
+                subDirectories.erase(std::remove(subDirectories.begin(), subDirectories.end(), releasedWatch), subDirectories.end());
+            }
+        }
+        m_releasedWatches.clear();
+    }
+    //
+    // Rescan (in parallel) all recently changed directories plus the next batch of
+    // the sweep through the rest; releasing any removed watches and snapshotting any
+    // newly added watch folders first.
+    //
+    void CPollingFileEventNotifier::pollDirectories(void)
+    {
+        m_pollCount++;
+        releaseRemovedWatches();
+        for (auto &watchFolder : m_watchFolders)
+        {
+            if (m_directories.find(watchFolder) == m_directories.end())
+            {
+                walkDirectories({watchFolder}, m_options.initialScan);
+            }
+        }
+        // Select directories due a rescan (each once)
+        std::vector<std::string> dueDirectories;
+        auto selectDirectory = [this, &dueDirectories](const std::string &directoryPath) {
+            auto directory = m_directories.find(directoryPath);
+            if ((directory != m_directories.end()) && (directory->second.lastPoll != m_pollCount))
+            {
+                directory->second.lastPoll = m_pollCount;
+                dueDirectories.push_back(directoryPath);
+            }
+        };
+        for (auto &hotDirectory : m_hotDirectories)
+        {
+            selectDirectory(hotDirectory);
+        }
+        if (m_options.pollBatchSize == 0)
+        {
+            for (auto &directory : m_directories)
+            {
+                selectDirectory(directory.first);
+            }
+        }
+        else
+        {
+            bool sweepRestarted{false};
+            for (std::size_t selected = 0; selected < m_options.pollBatchSize;)
+            {
+                if (m_sweepPosition >= m_sweepOrder.size())
+                {
+                    if (sweepRestarted)
+                    {
+                        break;
+                    }
+                    m_sweepOrder.clear();
+                    for (auto &directory : m_directories)
+                    {
+                        m_sweepOrder.push_back(directory.first);
+                    }
+                    m_sweepPosition = 0;
+                    sweepRestarted = true;
+                    continue;
+                }
+                if (m_directories.count(m_sweepOrder[m_sweepPosition]) != 0)
+                {
+                    selectDirectory(m_sweepOrder[m_sweepPosition]);
+                    selected++;
+                }
+                m_sweepPosition++;
+            }
+        }
+        // Rescan and compare against snapshot
+        std::vector<CDirectoryScanner::ScanResult> scanResults;
+        CDirectoryScanner::readDirectories(dueDirectories, scanResults, m_options.scanThreads, true);
+        m_pollDirectories->record(dueDirectories.size());
+        for (std::size_t directoryNo = 0; directoryNo < dueDirectories.size(); directoryNo++)
+        {
+            const std::string &directoryPath{dueDirectories[directoryNo]};
+            auto directory = m_directories.find(directoryPath);
+            // Removed as part of an earlier directory in this poll
+            if (directory == m_directories.end())
+            {
+                continue;
+            }
+            auto &scanResult{scanResults[directoryNo]};
+            // Directory has gone; a watch folder is just no longer watched.
+            if ((scanResult.error == ENOENT) || (scanResult.error == ENOTDIR))
+            {
+                releaseDirectory(directoryPath, m_watchFolders.count(directoryPath) == 0);
+                m_watchFolders.erase(directoryPath);
+                continue;
+            }
+            if (scanResult.error)
+            {
+                throw std::system_error(std::error_code(scanResult.error, std::system_category()), "getdents64() error");
+            }
+            if (diffDirectory(directoryPath, directory->second, scanResult))
+            {
+                directory = m_directories.find(directoryPath);
+                directory->second.hot = kHotPolls;
+                m_hotDirectories.insert(directoryPath);
+            }
+            else if ((directory->second.hot > 0) && (--directory->second.hot == 0))
+            {
+                m_hotDirectories.erase(directoryPath);
+            }
+        }
+    }
+    //
+    // Generate CPollingFileEventNotifier event; held until queued by queueGeneratedEvents().
+    //
+    void CPollingFileEventNotifier::sendEvent(IApprise::EventId id, const std::string &fileName)
+    {
+        m_generatedEvents.emplace_back(id, fileName);
+    }
+    //
+    // Pass events generated (while the watch table was locked) to the coalescing stage
+    // or queue.
+    //
+    void CPollingFileEventNotifier::queueGeneratedEvents(void)
+    {
+        for (auto &evt : m_generatedEvents)
+        {
+            if (m_coalescer && CFileEventCoalescer::coalesces(evt.id))
+            {
+                m_coalescer->add(evt);
+            }
+            else
+            {
+                queueEvent(evt);
+            }
+        }
+        m_generatedEvents.clear();
+    }
+    //
+    // Place event on queue and wake any waiting reader.
+    //
+    void CPollingFileEventNotifier::queueEvent(const IApprise::Event &evt)
+    {
+        std::unique_lock<std::mutex> locker(m_queuedEventsMutex);
+        // Wait for space in a bounded queue; only on the event generation thread so that
+        // a consumer whose addWatch() scan queues events cannot block itself.
+        if ((m_options.maxQueuedEvents != 0) && (m_queuedEvents.size() >= m_options.maxQueuedEvents) &&
+            (std::this_thread::get_id() == m_generationThread))
+        {
+            m_backpressureWaits->add();
+            m_queueSpaceWaiting.wait(locker, [&]() {
+                return ((m_queuedEvents.size() < m_options.maxQueuedEvents) || !m_doWork.load());
+            });
+        }
+        m_queuedEvents.push(evt);
+        m_eventsQueued->add();
+        m_queueDepth->set(static_cast<std::int64_t>(m_queuedEvents.size()));
+        m_queuedEventsWaiting.notify_one();
+    }
+    //
+    // Queue any coalesced events whose window has closed (or all if flushing).
+    //
+    void CPollingFileEventNotifier::expireCoalescedEvents(bool flush)
+    {
+        std::vector<IApprise::Event> expired;
+        if (flush)
+        {
+            m_coalescer->flush(expired);
+        }
+        else
+        {
+            m_coalescer->expire(expired);
+        }
+        for (auto &evt : expired)
+        {
+            queueEvent(evt);
+        }
+    }
+    // ==============
+    // PUBLIC METHODS
+    // ==============
+    //
+    // Main CPollingFileEventNotifier object constructor.
+    //
+    CPollingFileEventNotifier::CPollingFileEventNotifier(const IFileEventNotifier::Options &options) : m_options{options}, m_doWork{true}
+    {
+        // Create metrics
+        m_metrics = std::make_shared<CMetrics>();
+        m_eventsQueued = &m_metrics->counter("events_queued");
+        m_queueDepth = &m_metrics->gauge("queue_depth");
+        m_backpressureWaits = &m_metrics->counter("backpressure_waits");
+        m_pollDuration = &m_metrics->histogram("poll_duration_us");
+        m_pollDirectories = &m_metrics->histogram("poll_directories");
+        // Create coalescing stage if needed
+        if (m_options.coalesceWindow.count() > 0)
+        {
+            m_coalescer = std::make_unique<CFileEventCoalescer>(m_options.coalesceWindow);
+        }
+    }
+    //
+    // CPollingFileEventNotifier Destructor
+    //
+    CPollingFileEventNotifier::~CPollingFileEventNotifier()
+    {
+    }
+    //
+    // Add watch folder (or re-add a directory within one whose watch was removed).
+    // It is snapshotted at the start of the next poll (unless its removal has not
+    // yet been acted on).
+    //
+    void CPollingFileEventNotifier::addWatch(const std::string &filePath)
+    {
+        std::string fileName{filePath};
+        // Remove path trailing '/'
+        if (fileName.back() == '/')
+        {
+            fileName.pop_back();
+        }
+        // Deeper than max watch depth so ignore.
+        if (!withinWatchDepth(fileName))
+        {
+            return;
+        }
+        std::unique_lock<std::mutex> tableLocker(m_watchTableMutex);
+        m_releasedWatches.erase(std::remove(m_releasedWatches.begin(), m_releasedWatches.end(), fileName), m_releasedWatches.end());
+        if (m_removedDirectories.erase(fileName) != 0)
+        {
+            return;
+        }
+        struct stat fileStat;
+        if (stat(fileName.c_str(), &fileStat) == -1)
+        {
+            throw std::system_error(std::error_code(errno, std::system_category()), "stat() error");
+        }
+        if (!S_ISDIR(fileStat.st_mode))
+        {
+            throw std::system_error(std::error_code(ENOTDIR, std::system_category()), "stat() error");
+        }
+        m_watchFolders.insert(fileName);
+    }
+    //
+    //  Remove watch for watch folder or directory within one; it is released from the
+    //  snapshot by the poll thread at the start of the next poll.
+    //
+    void CPollingFileEventNotifier::removeWatch(const std::string &filePath)
+    {
+        std::string fileName{filePath};
+        bool noWatches{false};
+        // Remove path trailing '/'
+        if (fileName.back() == '/')
+        {
+            fileName.pop_back();
+        }
+        {
+            std::unique_lock<std::mutex> tableLocker(m_watchTableMutex);
+            if (m_watchFolders.erase(fileName) != 0)
+            {
+                m_releasedWatches.push_back(fileName);
+            }
+            else if ((m_directories.count(fileName) != 0) && !isRemovedDirectory(fileName))
+            {
+                m_releasedWatches.push_back(fileName);
+                m_removedDirectories.insert(fileName);
+            }
+            else
+            {
+                throw std::logic_error("watch not present");
+            }
+            noWatches = m_watchFolders.empty();
+        }
+        // No more watches so closedown
+        if (noWatches)
+        {
+            stopEventGeneration();
+        }
+    }
+    //
+    // Get next IApprise event in queue.
+    //
+    void CPollingFileEventNotifier::getNextEvent(IApprise::Event &evt)
+    {
+        std::unique_lock<std::mutex> locker(m_queuedEventsMutex);
+        // Wait for something to happen. Either an event or stop running
+        m_queuedEventsWaiting.wait(locker, [&]() {
+            return (!m_queuedEvents.empty() || !m_doWork.load());
+        });
+        // return next event from queue
+        if (!m_queuedEvents.empty())
+        {
+            evt = m_queuedEvents.front();
+            m_queuedEvents.pop();
+            m_queueDepth->set(static_cast<std::int64_t>(m_queuedEvents.size()));
+            m_queueSpaceWaiting.notify_one();
+        }
+        else
+        {
+            evt.id = IApprise::Event_none;
+            evt.message = "";
+        }
+    }
+    //
+    // Get next IApprise event in queue; waiting at most timeout for one (Event_none on timeout).
+    //
+    void CPollingFileEventNotifier::getNextEvent(IApprise::Event &evt, std::chrono::milliseconds timeout)
+    {
+        std::unique_lock<std::mutex> locker(m_queuedEventsMutex);
+        // Wait for something to happen. Either an event, stop running or timeout
+        m_queuedEventsWaiting.wait_for(locker, timeout, [&]() {
+            return (!m_queuedEvents.empty() || !m_doWork.load());
+        });
+        // return next event from queue
+        if (!m_queuedEvents.empty())
+        {
+            evt = m_queuedEvents.front();
+            m_queuedEvents.pop();
+            m_queueDepth->set(static_cast<std::int64_t>(m_queuedEvents.size()));
+            m_queueSpaceWaiting.notify_one();
+        }
+        else
+        {
+            evt.id = IApprise::Event_none;
+            evt.message = "";
+        }
+    }
+    //
+    // Return true if event generation loop still running.
+    //
+    bool CPollingFileEventNotifier::stillWatching() const
+    {
+        return m_doWork.load();
+    }
+    //
+    // Return pointer to any excpetion thrown.
+    //
+    std::exception_ptr CPollingFileEventNotifier::getThrownException() const
+    {
+        return m_thrownException;
+    }
+    //
+    // Return notifier metrics.
+    //
+    std::shared_ptr<CMetrics> CPollingFileEventNotifier::getMetrics() const
+    {
+        return (m_metrics);
+    }
+    //
+    // Set maximum watch depth.
+    //
+    void CPollingFileEventNotifier::setWatchDepth(int watchDepth)
+    {
+        m_watchDepth = watchDepth;
+    }
+    //
+    // Flag watch loop to stop.
+    //
+    void CPollingFileEventNotifier::stopEventGeneration(void)
+    {
+        // If still active then need to close down (only once; it may be called by the
+        // poll thread and a consumer removing the last watch at the same time)
+        if (m_doWork.exchange(false))
+        {
+            {
+                std::unique_lock<std::mutex> locker(m_queuedEventsMutex);
+                m_queuedEventsWaiting.notify_one();
+                m_queueSpaceWaiting.notify_all();
+            }
+            std::unique_lock<std::mutex> locker(m_pollMutex);
+            m_pollWaiting.notify_one();
+        }
+    }
+    //
+    // Clear event queue. Nothing is queued outside of the notifier for polling so just
+    // discard any events queued but not yet read.
+    //
+    void CPollingFileEventNotifier::clearEventQueue()
+    {
+        std::unique_lock<std::mutex> locker(m_queuedEventsMutex);
+        std::queue<IApprise::Event>().swap(m_queuedEvents);
+        m_queueDepth->set(0);
+        m_queueSpaceWaiting.notify_all();
+    }
+    //
+    // Loop rescanning watched directories every poll interval and generating
+    // IApprise events for any changes; until stopped.
+    //
+    void CPollingFileEventNotifier::generateEvents(void)
+    {
+        try
+        {
+            // Record thread so that it alone waits for space in a bounded queue
+            {
+                std::unique_lock<std::mutex> locker(m_queuedEventsMutex);
+                m_generationThread = std::this_thread::get_id();
+            }
+            auto nextPoll{std::chrono::steady_clock::now()};
+            // Loop until told to stop
+            while (m_doWork.load())
+            {
+                if (std::chrono::steady_clock::now() >= nextPoll)
+                {
+                    std::chrono::steady_clock::time_point pollStart{std::chrono::steady_clock::now()};
+                    bool noWatches{false};
+                    {
+                        std::unique_lock<std::mutex> tableLocker(m_watchTableMutex);
+                        pollDirectories();
+                        noWatches = m_watchFolders.empty();
+                    }
+                    nextPoll = std::chrono::steady_clock::now() + m_options.pollInterval;
+                    m_pollDuration->record(std::chrono::duration_cast<std::chrono::microseconds>(nextPoll - m_options.pollInterval - pollStart).count());
+                    queueGeneratedEvents();
+                    // No more watch folders so closedown
+                    if (noWatches)
+                    {
+                        stopEventGeneration();
+                    }
+                }
+                // Queue any coalesced events now due
+                if (m_coalescer)
+                {
+                    expireCoalescedEvents();
+                }
+                // Wait until next poll (at most a coalescer tick while any events are pending) or stopped
+                auto waitUntil{nextPoll};
+                if (m_coalescer && !m_coalescer->empty())
+                {
+                    waitUntil = std::min(waitUntil, std::chrono::steady_clock::now() + m_coalescer->tick());
+                }
+                std::unique_lock<std::mutex> locker(m_pollMutex);
+                m_pollWaiting.wait_until(locker, waitUntil, [this]() { return (!m_doWork.load()); });
+            }
+            //
+            // Generate event for any exceptions and also store to be passed up the chain
+            //
+        }
+        catch (std::system_error &e)
+        {
+            sendEvent(IApprise::Event_error, kLogPrefix + "Caught a system_error exception: [" + e.what() + "]");
+            m_thrownException = std::current_exception();
+        }
+        catch (std::exception &e)
+        {
+            sendEvent(IApprise::Event_error, kLogPrefix + "General exception occured: [" + e.what() + "]");
+            m_thrownException = std::current_exception();
+        }
+        // Queue any events generated before stopping and anything still waiting to be coalesced
+        queueGeneratedEvents();
+        if (m_coalescer)
+        {
+            expireCoalescedEvents(true);
+        }
+        stopEventGeneration(); // If not asked to stop then call anyway (cleanup)
+    }
+} // namespace Antik::File
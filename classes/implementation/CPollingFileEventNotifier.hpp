@@ -0,0 +1,191 @@
+#ifndef CPOLLINGFILEEVENTNOTIFIER_HPP
+#define CPOLLINGFILEEVENTNOTIFIER_HPP
+//
+// C++ STL
+//
+#include <unordered_map>
+#include <unordered_set>
+#include <queue>
+#include <vector>
+#include <set>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <string_view>
+//
+// Antik classes
+//
+#include "CommonAntik.hpp"
+#include "IApprise.hpp"
+#include "IFileEventNotifier.hpp"
+#include "CFileEventCoalescer.hpp"
+#include "CDirectoryScanner.hpp"
+// =========
+// NAMESPACE
+// =========
+namespace Antik::File
+{
+    // ================
+    // CLASS DEFINITION
+    // ================
+    class CPollingFileEventNotifier : public IFileEventNotifier
+    {
+    public:
+        // ==========================
+        // PUBLIC TYPES AND CONSTANTS
+        // ==========================
+        // ============
+        // CONSTRUCTORS
+        // ============
+        //
+        // Main constructor
+        //
+        explicit CPollingFileEventNotifier(const IFileEventNotifier::Options &options = IFileEventNotifier::Options());
+        // ==========
+        // DESTRUCTOR
+        // ==========
+        virtual ~CPollingFileEventNotifier();
+        // ==============
+        // PUBLIC METHODS
+        // ==============
+        //
+        // Event queue
+        //
+        void generateEvents(void) override;                   // Watch folder(s) for file events
+        void stopEventGeneration(void) override;              // Stop watch loop/thread
+        void getNextEvent(IApprise::Event &message) override; // Get next queued event
+        void getNextEvent(IApprise::Event &message, std::chrono::milliseconds timeout) override; // Get next queued event (waiting at most timeout)
+        bool stillWatching() const override;                  // Events still being generated
+        void clearEventQueue() override;                      // Clear event queue
+        //
+        // Watch processing
+        //
+        void setWatchDepth(int watchDepth) override;            // Set maximum watch depth
+        void addWatch(const std::string &filePath) override;    // Add path to be watched
+        void removeWatch(const std::string &filePath) override; // Remove path being watched
+        // Exception handling
+        std::exception_ptr getThrownException() const override; // Get last thrown exception
+        // Metrics
+        std::shared_ptr<CMetrics> getMetrics() const override; // Get notifier metrics
+        // ================
+        // PUBLIC VARIABLES
+        // ================
+    private:
+        // ===========================
+        // PRIVATE TYPES AND CONSTANTS
+        // ===========================
+        //
+        // Logging prefix
+        //
+        static const std::string kLogPrefix; // Logging output prefix
+        //
+        // Polls a changed directory is rescanned for after its last change
+        //
+        static const std::uint32_t kHotPolls;
+        //
+        // Snapshot of a file; its name is held in the directory name pool.
+        //
+        struct SnapshotEntry
+        {
+            std::uint64_t nameHash{0};            // Hash of name
+            std::uint32_t nameOffset{0};          // Offset of name in name pool
+            std::uint32_t nameLength{0};          // Length of name
+            CDirectoryScanner::FileStatus status; // File size, modification time and inode
+        };
+        //
+        // Snapshot of a directory; files sorted by name hash (then name).
+        //
+        struct DirectorySnapshot
+        {
+            std::vector<SnapshotEntry> files;     // File snapshots
+            std::string names;                    // File name pool
+            std::vector<std::string> directories; // Watched sub-directories (sorted)
+            std::uint32_t hot{0};                 // Polls left to rescan every poll
+            std::uint64_t lastPoll{0};            // Last poll directory was selected for
+        };
+        // ===========================================
+        // DISABLED CONSTRUCTORS/DESTRUCTORS/OPERATORS
+        // ===========================================
+        CPollingFileEventNotifier(const CPollingFileEventNotifier &orig) = delete;
+        CPollingFileEventNotifier(const CPollingFileEventNotifier &&orig) = delete;
+        CPollingFileEventNotifier &operator=(CPollingFileEventNotifier other) = delete;
+        // ===============
+        // PRIVATE METHODS
+        // ===============
+        //
+        // Watch processing
+        //
+        bool withinWatchDepth(const std::string &filePath) const;        // Path within maximum watch depth
+        bool isRemovedDirectory(const std::string &directoryPath) const; // Directory watch removed
+        //
+        // Snapshot
+        //
+        void buildSnapshot(const std::string &directoryPath, CDirectoryScanner::ScanResult &scanResult, DirectorySnapshot &snapshot); // Scan result to snapshot
+        void walkDirectories(const std::vector<std::string> &directories, bool report);                                               // Snapshot directory hierarchy
+        bool diffDirectory(const std::string &directoryPath, DirectorySnapshot &snapshot, CDirectoryScanner::ScanResult &scanResult); // Rescan against snapshot
+        void releaseDirectory(const std::string &directoryPath, bool report);                                                         // Remove directory sub-tree
+        void releaseRemovedWatches(void);                                                                                             // Remove directories whose watch was removed
+        void pollDirectories(void);                                                                                                   // Rescan due directories
+        //
+        // Queue IApprise event
+        //
+        void sendEvent(
+            IApprise::EventId id,      // Event id
+            const std::string &message // Filename/message
+        );
+        void queueGeneratedEvents(void);                // Queue events generated while table locked
+        void queueEvent(const IApprise::Event &evt);    // Place event on queue
+        void expireCoalescedEvents(bool flush = false); // Queue coalesced events whose window has closed
+        // =================
+        // PRIVATE VARIABLES
+        // =================
+        //
+        // Snapshot
+        //
+        IFileEventNotifier::Options m_options;                            // Notifier options
+        std::set<std::string> m_watchFolders;                             // Watch folders
+        std::set<std::string> m_removedDirectories;                       // Directories within watch folders no longer watched
+        std::vector<std::string> m_releasedWatches;                       // Watches removed still to be released from snapshot
+        std::mutex m_watchTableMutex;                                     // Watch folder and snapshot table mutex
+        std::unordered_map<std::string, DirectorySnapshot> m_directories; // Directory snapshots indexed by path
+        std::unordered_set<std::string> m_hotDirectories;                 // Recently changed directories
+        std::vector<std::string> m_sweepOrder;                            // Order unchanged directories are rescanned
+        std::size_t m_sweepPosition{0};                                   // Next directory in sweep order
+        std::uint64_t m_pollCount{0};                                     // Number of polls
+        std::hash<std::string_view> m_nameHash;                           // File name hash
+        //
+        // Event coalescing
+        //
+        std::unique_ptr<CFileEventCoalescer> m_coalescer; // Coalescing stage (nullptr if not enabled)
+        //
+        // Metrics
+        //
+        std::shared_ptr<CMetrics> m_metrics;             // Notifier metrics
+        CMetrics::Counter *m_eventsQueued{nullptr};      // Events queued
+        CMetrics::Gauge *m_queueDepth{nullptr};          // Event queue depth
+        CMetrics::Counter *m_backpressureWaits{nullptr}; // Waits for space in a full event queue
+        CMetrics::Histogram *m_pollDuration{nullptr};    // Time taken to rescan due directories (us)
+        CMetrics::Histogram *m_pollDirectories{nullptr}; // Directories rescanned each poll
+        //
+        // Publicly accessed via accessors
+        //
+        std::exception_ptr m_thrownException{nullptr}; // Pointer to any exception thrown
+        std::atomic<bool> m_doWork{false};             // doWork=true (run watcher loop) false=(stop watcher loop)
+        int m_watchDepth{-1};                          // Watch depth -1=all,0=just watch folder,1=next level down etc.
+        //
+        // Poll interval wait
+        //
+        std::condition_variable m_pollWaiting; // Poll wait conditional (signalled on stop)
+        std::mutex m_pollMutex;                // Poll wait mutex
+        //
+        // Event queue
+        //
+        std::condition_variable m_queuedEventsWaiting;  // Queued events conditional
+        std::condition_variable m_queueSpaceWaiting;    // Queue space conditional (bounded queue)
+        std::thread::id m_generationThread;             // Event generation thread (only it waits for space)
+        std::mutex m_queuedEventsMutex;                 // Queued events mutex
+        std::queue<IApprise::Event> m_queuedEvents;     // Queue of CPollingFileEventNotifier events
+        std::vector<IApprise::Event> m_generatedEvents; // Events generated waiting to be queued
+    };
+} // namespace Antik::File
+#endif /* CPOLLINGFILEEVENTNOTIFIER_HPP */
@@ -0,0 +1,156 @@
+//
+// Class: CRetryQueue
+//
+// Description: Delay queue of files that a CTask action failed to process. Each
+// failure of a file schedules its retry after an exponential backoff (the retry delay
+// doubled for each failed attempt up to a maximum) with jitter, so that files failing
+// together do not all come back at once; the delay is taken at random from between
+// half and all of the backoff. Once a file has failed the maximum number of attempts
+// it is not retried again. The queue is safe to use from more than one thread (action
+// workers schedule retries that the monitor loop pops when due).
+//
+// Dependencies: C20++               - Language standard features used.
+//
+// =================
+// CLASS DEFINITIONS
+// =================
+#include "CRetryQueue.hpp"
+// ====================
+// CLASS IMPLEMENTATION
+// ====================
+//
+// C++ STL
+//
+#include <algorithm>
+// =========
+// NAMESPACE
+// =========
+namespace Antik::File
+{
+    // ===========================
+    // PRIVATE TYPES AND CONSTANTS
+    // ===========================
+    // Longest wait between checks for retries scheduled
+    const std::chrono::milliseconds CRetryQueue::kPollInterval{100};
+    // ==========================
+    // PUBLIC TYPES AND CONSTANTS
+    // ==========================
+    // ========================
+    // PRIVATE STATIC VARIABLES
+    // ========================
+    // =======================
+    // PUBLIC STATIC VARIABLES
+    // =======================
+    // ===============
+    // PRIVATE METHODS
+    // ===============
+    //
+    // Return delay before retrying a file that has failed a number of attempts; the
+    // retry delay doubled for each attempt after the first (up to the maximum delay)
+    // with between none and half of it taken off at random. Called with the queue locked.
+    //
+    std::chrono::milliseconds CRetryQueue::jitteredBackoff(int attempt)
+    {
+        std::chrono::milliseconds delay{m_retryDelay};
+        for (int doubling = 1; (doubling < attempt) && (delay < m_maxRetryDelay); doubling++)
+        {
+            delay *= 2;
+        }
+        delay = std::min(delay, m_maxRetryDelay);
+        std::uniform_int_distribution<std::chrono::milliseconds::rep> jitter(0, delay.count() / 2);
+        return (delay - std::chrono::milliseconds(jitter(m_jitter)));
+    }
+    // ==============
+    // PUBLIC METHODS
+    // ==============
+    //
+    // Main CRetryQueue object constructor.
+    //
+    CRetryQueue::CRetryQueue(int maxAttempts, std::chrono::milliseconds retryDelay, std::chrono::milliseconds maxRetryDelay)
+        : m_maxAttempts{std::max(maxAttempts, 1)}, m_retryDelay{retryDelay}, m_maxRetryDelay{std::max(maxRetryDelay, retryDelay)}, m_jitter{std::random_device{}()}
+    {
+    }
+    //
+    // CRetryQueue Destructor
+    //
+    CRetryQueue::~CRetryQueue()
+    {
+    }
+    //
+    // Record a failed attempt at processing a file and schedule its retry after the
+    // backoff for the attempts so far. Returns false (forgetting the file) if it has
+    // no attempts left.
+    //
+    bool CRetryQueue::retry(const std::string &filePath, Clock::time_point now)
+    {
+        std::unique_lock<std::mutex> locker(m_retryMutex);
+        int attempts{++m_attempts[filePath]};
+        if (attempts >= m_maxAttempts)
+        {
+            m_attempts.erase(filePath);
+            return (false);
+        }
+        m_retries.push({now + jitteredBackoff(attempts), filePath});
+        return (true);
+    }
+    //
+    // Forget failed attempts of a file that has been processed.
+    //
+    void CRetryQueue::completed(const std::string &filePath)
+    {
+        std::unique_lock<std::mutex> locker(m_retryMutex);
+        m_attempts.erase(filePath);
+    }
+    //
+    // Pop a file whose retry is due. Returns false if none are.
+    //
+    bool CRetryQueue::pop(std::string &filePath, Clock::time_point now)
+    {
+        std::unique_lock<std::mutex> locker(m_retryMutex);
+        if (m_retries.empty() || (m_retries.top().due > now))
+        {
+            return (false);
+        }
+        filePath = m_retries.top().filePath;
+        m_retries.pop();
+        return (true);
+    }
+    //
+    // Return delay (with jitter) before retrying a file that has failed a number of attempts.
+    //
+    std::chrono::milliseconds CRetryQueue::backoff(int attempt)
+    {
+        std::unique_lock<std::mutex> locker(m_retryMutex);
+        return (jitteredBackoff(attempt));
+    }
+    //
+    // Return time until the next retry is due; no longer than the poll interval so that
+    // retries scheduled meanwhile (by action workers) are not left waiting.
+    //
+    std::chrono::milliseconds CRetryQueue::tick(Clock::time_point now) const
+    {
+        std::unique_lock<std::mutex> locker(m_retryMutex);
+        if (m_retries.empty())
+        {
+            return (kPollInterval);
+        }
+        auto due{std::chrono::ceil<std::chrono::milliseconds>(m_retries.top().due - now)};
+        return (std::clamp(due, std::chrono::milliseconds(0), kPollInterval));
+    }
+    //
+    // Return true if no retries are scheduled.
+    //
+    bool CRetryQueue::empty(void) const
+    {
+        std::unique_lock<std::mutex> locker(m_retryMutex);
+        return (m_retries.empty());
+    }
+    //
+    // Return number of retries scheduled.
+    //
+    std::size_t CRetryQueue::size(void) const
+    {
+        std::unique_lock<std::mutex> locker(m_retryMutex);
+        return (m_retries.size());
+    }
+} // namespace Antik::File
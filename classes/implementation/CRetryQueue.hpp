@@ -0,0 +1,97 @@
+#ifndef CRETRYQUEUE_HPP
+#define CRETRYQUEUE_HPP
+//
+// C++ STL
+//
+#include <string>
+#include <vector>
+#include <queue>
+#include <unordered_map>
+#include <random>
+#include <chrono>
+#include <mutex>
+// =========
+// NAMESPACE
+// =========
+namespace Antik::File
+{
+    // ================
+    // CLASS DEFINITION
+    // ================
+    class CRetryQueue
+    {
+    public:
+        // ==========================
+        // PUBLIC TYPES AND CONSTANTS
+        // ==========================
+        using Clock = std::chrono::steady_clock;
+        // ============
+        // CONSTRUCTORS
+        // ============
+        //
+        // Main constructor
+        //
+        explicit CRetryQueue(int maxAttempts, std::chrono::milliseconds retryDelay, std::chrono::milliseconds maxRetryDelay);
+        // ==========
+        // DESTRUCTOR
+        // ==========
+        virtual ~CRetryQueue();
+        // ==============
+        // PUBLIC METHODS
+        // ==============
+        bool retry(const std::string &filePath, Clock::time_point now = Clock::now()); // Record failed attempt; scheduling retry (false when attempts used up)
+        void completed(const std::string &filePath);                                   // Forget attempts of file processed
+        bool pop(std::string &filePath, Clock::time_point now = Clock::now());         // Pop file whose retry is due (false if none)
+        std::chrono::milliseconds backoff(int attempt);                                // Delay before retry after a number of attempts
+        std::chrono::milliseconds tick(Clock::time_point now = Clock::now()) const;    // Time until next retry due (at most poll interval)
+        bool empty(void) const;                                                        // No retries scheduled
+        std::size_t size(void) const;                                                  // Number of retries scheduled
+        // ================
+        // PUBLIC VARIABLES
+        // ================
+    private:
+        // ===========================
+        // PRIVATE TYPES AND CONSTANTS
+        // ===========================
+        //
+        // Longest wait between checks for retries scheduled
+        //
+        static const std::chrono::milliseconds kPollInterval;
+        //
+        // Scheduled retry (earliest due first)
+        //
+        struct RetryFile
+        {
+            Clock::time_point due; // Time retry due
+            std::string filePath;  // File path
+        };
+        struct RetryOrder
+        {
+            bool operator()(const RetryFile &lhs, const RetryFile &rhs) const
+            {
+                return (lhs.due > rhs.due);
+            }
+        };
+        // ===========================================
+        // DISABLED CONSTRUCTORS/DESTRUCTORS/OPERATORS
+        // ===========================================
+        CRetryQueue(const CRetryQueue &orig) = delete;
+        CRetryQueue(const CRetryQueue &&orig) = delete;
+        CRetryQueue &operator=(CRetryQueue other) = delete;
+        // ===============
+        // PRIVATE METHODS
+        // ===============
+        std::chrono::milliseconds jitteredBackoff(int attempt); // Retry delay after a number of attempts (queue locked)
+        // =================
+        // PRIVATE VARIABLES
+        // =================
+        int m_maxAttempts{1};                                                         // Attempts before file fails for good
+        std::chrono::milliseconds m_retryDelay;                                       // Delay before first retry
+        std::chrono::milliseconds m_maxRetryDelay;                                    // Longest delay before a retry
+        std::unordered_map<std::string, int> m_attempts;                              // Failed attempts of each file
+        std::priority_queue<RetryFile, std::vector<RetryFile>, RetryOrder> m_retries; // Scheduled retries
+        std::mt19937 m_jitter;                                                        // Backoff jitter generator
+        mutable std::mutex m_retryMutex;                                              // Retry queue mutex
+    };
+} // namespace Antik::File
+#endif /* CRETRYQUEUE_HPP */
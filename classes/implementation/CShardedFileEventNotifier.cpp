@@ -0,0 +1,301 @@
+//
+// Class: CShardedFileEventNotifier
+//
+// Description: File event notifier pass to CApprise class constructor. This is an
+// inotify implementation for very large hierarchies that partitions the watch folder(s)
+// between a number of CFileEventNotifier shards by a hash of each top-level directory
+// name (files directly in a watch folder belong to shard zero). Each shard has its own
+// inotify instance and runs on its own thread, so reading, parsing and dispatching
+// events scales across cores. Shards place their events on the one queue read by the
+// consumer; events from any one shard (and so for any one file) stay in order while
+// those of different shards interleave. If any shard stops (e.g. on an exception) then
+// all are stopped.
+//
+// Dependencies: C20++               - Language standard features used.
+//               Class CFileEventNotifier - inotify notifier for each shard.
+//
+// =================
+// CLASS DEFINITIONS
+// =================
+#include "CShardedFileEventNotifier.hpp"
+// ====================
+// CLASS IMPLEMENTATION
+// ====================
+//
+// C++ STL
+//
+#include <algorithm>
+#include <stdexcept>
+// =========
+// NAMESPACE
+// =========
+namespace Antik::File
+{
+    // ===========================
+    // PRIVATE TYPES AND CONSTANTS
+    // ===========================
+    // CShardedFileEventNotifier logging prefix
+    const std::string CShardedFileEventNotifier::kLogPrefix{"[CShardedFileEventNotifier] "};
+    // ==========================
+    // PUBLIC TYPES AND CONSTANTS
+    // ==========================
+    // ========================
+    // PRIVATE STATIC VARIABLES
+    // ========================
+    // =======================
+    // PUBLIC STATIC VARIABLES
+    // =======================
+    // ===============
+    // PRIVATE METHODS
+    // ===============
+    //
+    // Generate events for a shard until it stops and then wake the main generation loop.
+    //
+    void CShardedFileEventNotifier::runShard(std::size_t shardNo)
+    {
+        {
+            std::unique_lock<std::mutex> locker(m_queuedEventsMutex);
+            m_generationThreads.push_back(std::this_thread::get_id());
+        }
+        m_shards[shardNo]->generateEvents();
+        std::unique_lock<std::mutex> locker(m_queuedEventsMutex);
+        m_shardsRunning--;
+        m_shardStopped.notify_all();
+    }
+    //
+    // Place event on queue and wake any waiting reader.
+    //
+    void CShardedFileEventNotifier::queueEvent(const IApprise::Event &evt)
+    {
+        std::unique_lock<std::mutex> locker(m_queuedEventsMutex);
+        // Wait for space in a bounded queue; only on a shard event generation thread so
+        // that a consumer whose addWatch() queues events cannot block itself.
+        if ((m_options.maxQueuedEvents != 0) && (m_queuedEvents.size() >= m_options.maxQueuedEvents) &&
+            (std::find(m_generationThreads.begin(), m_generationThreads.end(), std::this_thread::get_id()) != m_generationThreads.end()))
+        {
+            m_backpressureWaits->add();
+            m_queueSpaceWaiting.wait(locker, [&]() {
+                return ((m_queuedEvents.size() < m_options.maxQueuedEvents) || !m_doWork.load());
+            });
+        }
+        m_queuedEvents.push(evt);
+        m_eventsQueued->add();
+        m_queueDepth->set(static_cast<std::int64_t>(m_queuedEvents.size()));
+        m_queuedEventsWaiting.notify_one();
+    }
+    // ==============
+    // PUBLIC METHODS
+    // ==============
+    //
+    // Main CShardedFileEventNotifier object constructor.
+    //
+    CShardedFileEventNotifier::CShardedFileEventNotifier(std::size_t shards, const IFileEventNotifier::Options &options) : m_options{options}, m_doWork{true}
+    {
+        // Create metrics (including those of each shard)
+        m_metrics = std::make_shared<CMetrics>();
+        m_eventsQueued = &m_metrics->counter("events_queued");
+        m_queueDepth = &m_metrics->gauge("queue_depth");
+        m_backpressureWaits = &m_metrics->counter("backpressure_waits");
+        // Create shards
+        shards = std::max(shards, std::size_t(1));
+        for (std::size_t shardNo = 0; shardNo < shards; shardNo++)
+        {
+            m_shards.push_back(std::make_shared<CFileEventNotifier>(m_options, CFileEventNotifier::Shard{shardNo, shards, [this](const IApprise::Event &evt) { queueEvent(evt); }}));
+            m_metrics->addSource("shard" + std::to_string(shardNo), m_shards.back()->getMetrics());
+        }
+    }
+    //
+    // CShardedFileEventNotifier Destructor
+    //
+    CShardedFileEventNotifier::~CShardedFileEventNotifier()
+    {
+    }
+    //
+    // Add watch for file/directory to every shard (each only watches what it owns).
+    //
+    void CShardedFileEventNotifier::addWatch(const std::string &filePath)
+    {
+        for (auto &shard : m_shards)
+        {
+            shard->addWatch(filePath);
+        }
+    }
+    //
+    // Remove watch for file/directory from the shards watching it.
+    //
+    void CShardedFileEventNotifier::removeWatch(const std::string &filePath)
+    {
+        std::size_t removed{0};
+        for (auto &shard : m_shards)
+        {
+            try
+            {
+                shard->removeWatch(filePath);
+                removed++;
+            }
+            catch (const std::logic_error &)
+            {
+            }
+        }
+        if (removed == 0)
+        {
+            throw std::logic_error("watch not present");
+        }
+    }
+    //
+    // Get next IApprise event in queue.
+    //
+    void CShardedFileEventNotifier::getNextEvent(IApprise::Event &evt)
+    {
+        std::unique_lock<std::mutex> locker(m_queuedEventsMutex);
+        // Wait for something to happen. Either an event or stop running
+        m_queuedEventsWaiting.wait(locker, [&]() {
+            return (!m_queuedEvents.empty() || !m_doWork.load());
+        });
+        // return next event from queue
+        if (!m_queuedEvents.empty())
+        {
+            evt = m_queuedEvents.front();
+            m_queuedEvents.pop();
+            m_queueDepth->set(static_cast<std::int64_t>(m_queuedEvents.size()));
+            m_queueSpaceWaiting.notify_one();
+        }
+        else
+        {
+            evt.id = IApprise::Event_none;
+            evt.message = "";
+        }
+    }
+    //
+    // Get next IApprise event in queue; waiting at most timeout for one (Event_none on timeout).
+    //
+    void CShardedFileEventNotifier::getNextEvent(IApprise::Event &evt, std::chrono::milliseconds timeout)
+    {
+        std::unique_lock<std::mutex> locker(m_queuedEventsMutex);
+        // Wait for something to happen. Either an event, stop running or timeout
+        m_queuedEventsWaiting.wait_for(locker, timeout, [&]() {
+            return (!m_queuedEvents.empty() || !m_doWork.load());
+        });
+        // return next event from queue
+        if (!m_queuedEvents.empty())
+        {
+            evt = m_queuedEvents.front();
+            m_queuedEvents.pop();
+            m_queueDepth->set(static_cast<std::int64_t>(m_queuedEvents.size()));
+            m_queueSpaceWaiting.notify_one();
+        }
+        else
+        {
+            evt.id = IApprise::Event_none;
+            evt.message = "";
+        }
+    }
+    //
+    // Return true if event generation loop still running.
+    //
+    bool CShardedFileEventNotifier::stillWatching() const
+    {
+        return m_doWork.load();
+    }
+    //
+    // Return pointer to any exception thrown (by notifier or any of its shards).
+    //
+    std::exception_ptr CShardedFileEventNotifier::getThrownException() const
+    {
+        if (m_thrownException)
+        {
+            return m_thrownException;
+        }
+        for (auto &shard : m_shards)
+        {
+            if (shard->getThrownException())
+            {
+                return shard->getThrownException();
+            }
+        }
+        return nullptr;
+    }
+    //
+    // Return notifier metrics.
+    //
+    std::shared_ptr<CMetrics> CShardedFileEventNotifier::getMetrics() const
+    {
+        return (m_metrics);
+    }
+    //
+    // Set maximum watch depth.
+    //
+    void CShardedFileEventNotifier::setWatchDepth(int watchDepth)
+    {
+        for (auto &shard : m_shards)
+        {
+            shard->setWatchDepth(watchDepth);
+        }
+    }
+    //
+    // Flag watch loop and shards to stop.
+    //
+    void CShardedFileEventNotifier::stopEventGeneration(void)
+    {
+        // If still active then need to close down
+        if (m_doWork.load())
+        {
+            {
+                std::unique_lock<std::mutex> locker(m_queuedEventsMutex);
+                m_doWork = false;
+                m_queuedEventsWaiting.notify_all();
+                m_queueSpaceWaiting.notify_all();
+                m_shardStopped.notify_all();
+            }
+            for (auto &shard : m_shards)
+            {
+                shard->stopEventGeneration();
+            }
+        }
+    }
+    //
+    // Clear event queue of every shard.
+    //
+    void CShardedFileEventNotifier::clearEventQueue()
+    {
+        for (auto &shard : m_shards)
+        {
+            shard->clearEventQueue();
+        }
+    }
+    //
+    // Run a thread generating events for each shard until stopped or any shard stops.
+    //
+    void CShardedFileEventNotifier::generateEvents(void)
+    {
+        std::vector<std::thread> shardThreads;
+        try
+        {
+            {
+                std::unique_lock<std::mutex> locker(m_queuedEventsMutex);
+                m_shardsRunning = m_shards.size();
+            }
+            for (std::size_t shardNo = 0; shardNo < m_shards.size(); shardNo++)
+            {
+                shardThreads.emplace_back(&CShardedFileEventNotifier::runShard, this, shardNo);
+            }
+            std::unique_lock<std::mutex> locker(m_queuedEventsMutex);
+            m_shardStopped.wait(locker, [this]() { return (!m_doWork.load() || (m_shardsRunning < m_shards.size())); });
+        }
+        catch (std::system_error &e)
+        {
+            queueEvent(IApprise::Event(IApprise::Event_error, kLogPrefix + "Caught a system_error exception: [" + e.what() + "]"));
+            m_thrownException = std::current_exception();
+        }
+        catch (std::exception &e)
+        {
+            queueEvent(IApprise::Event(IApprise::Event_error, kLogPrefix + "General exception occured: [" + e.what() + "]"));
+            m_thrownException = std::current_exception();
+        }
+        stopEventGeneration(); // If not asked to stop then call anyway (cleanup)
+        for (auto &shardThread : shardThreads)
+        {
+            shardThread.join();
+        }
+    }
+} // namespace Antik::File
@@ -0,0 +1,118 @@
+#ifndef CSHARDEDFILEEVENTNOTIFIER_HPP
+#define CSHARDEDFILEEVENTNOTIFIER_HPP
+//
+// C++ STL
+//
+#include <queue>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+//
+// Antik classes
+//
+#include "CommonAntik.hpp"
+#include "IApprise.hpp"
+#include "IFileEventNotifier.hpp"
+#include "CFileEventNotifier.hpp"
+// =========
+// NAMESPACE
+// =========
+namespace Antik::File
+{
+    // ================
+    // CLASS DEFINITION
+    // ================
+    class CShardedFileEventNotifier : public IFileEventNotifier
+    {
+    public:
+        // ==========================
+        // PUBLIC TYPES AND CONSTANTS
+        // ==========================
+        // ============
+        // CONSTRUCTORS
+        // ============
+        //
+        // Main constructor
+        //
+        explicit CShardedFileEventNotifier(std::size_t shards, const IFileEventNotifier::Options &options = IFileEventNotifier::Options());
+        // ==========
+        // DESTRUCTOR
+        // ==========
+        virtual ~CShardedFileEventNotifier();
+        // ==============
+        // PUBLIC METHODS
+        // ==============
+        //
+        // Event queue
+        //
+        void generateEvents(void) override;                   // Watch folder(s) for file events
+        void stopEventGeneration(void) override;              // Stop watch loop/thread
+        void getNextEvent(IApprise::Event &message) override; // Get next queued event
+        void getNextEvent(IApprise::Event &message, std::chrono::milliseconds timeout) override; // Get next queued event (waiting at most timeout)
+        bool stillWatching() const override;                  // Events still being generated
+        void clearEventQueue() override;                      // Clear event queue
+        //
+        // Watch processing
+        //
+        void setWatchDepth(int watchDepth) override;            // Set maximum watch depth
+        void addWatch(const std::string &filePath) override;    // Add path to be watched
+        void removeWatch(const std::string &filePath) override; // Remove path being watched
+        // Exception handling
+        std::exception_ptr getThrownException() const override; // Get last thrown exception
+        // Metrics
+        std::shared_ptr<CMetrics> getMetrics() const override; // Get notifier metrics
+        // ================
+        // PUBLIC VARIABLES
+        // ================
+    private:
+        // ===========================
+        // PRIVATE TYPES AND CONSTANTS
+        // ===========================
+        //
+        // Logging prefix
+        //
+        static const std::string kLogPrefix; // Logging output prefix
+        // ===========================================
+        // DISABLED CONSTRUCTORS/DESTRUCTORS/OPERATORS
+        // ===========================================
+        CShardedFileEventNotifier(const CShardedFileEventNotifier &orig) = delete;
+        CShardedFileEventNotifier(const CShardedFileEventNotifier &&orig) = delete;
+        CShardedFileEventNotifier &operator=(CShardedFileEventNotifier other) = delete;
+        // ===============
+        // PRIVATE METHODS
+        // ===============
+        void runShard(std::size_t shardNo);          // Generate events for a shard until it stops
+        void queueEvent(const IApprise::Event &evt); // Place shard event on queue
+        // =================
+        // PRIVATE VARIABLES
+        // =================
+        IFileEventNotifier::Options m_options;                     // Notifier options
+        std::vector<std::shared_ptr<CFileEventNotifier>> m_shards; // Shard notifiers
+        std::size_t m_shardsRunning{0};                            // Shards still generating events
+        //
+        // Metrics
+        //
+        std::shared_ptr<CMetrics> m_metrics;             // Notifier metrics
+        CMetrics::Counter *m_eventsQueued{nullptr};      // Events queued
+        CMetrics::Gauge *m_queueDepth{nullptr};          // Event queue depth
+        CMetrics::Counter *m_backpressureWaits{nullptr}; // Waits for space in a full event queue
+        //
+        // Publicly accessed via accessors
+        //
+        std::exception_ptr m_thrownException{nullptr}; // Pointer to any exception thrown
+        std::atomic<bool> m_doWork{false};             // doWork=true (run watcher loop) false=(stop watcher loop)
+        //
+        // Event queue
+        //
+        std::condition_variable m_queuedEventsWaiting;    // Queued events conditional
+        std::condition_variable m_queueSpaceWaiting;      // Queue space conditional (bounded queue)
+        std::condition_variable m_shardStopped;           // Shard stopped conditional
+        std::vector<std::thread::id> m_generationThreads; // Shard event generation threads (only they wait for space)
+        std::mutex m_queuedEventsMutex;                   // Queued events mutex
+        std::queue<IApprise::Event> m_queuedEvents;       // Queue of shard events
+    };
+} // namespace Antik::File
+#endif /* CSHARDEDFILEEVENTNOTIFIER_HPP */
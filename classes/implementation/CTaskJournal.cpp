@@ -0,0 +1,502 @@
+//
+// Class: CTaskJournal
+//
+// Description: Durable append-only journal of the files received and completed by
+// a task so that after a restart it can re-process files that were received but not
+// completed and pick up files added while it was not running (at-least-once processing).
+// Records are appended to preallocated, memory mapped segment files and committed
+// (msync) in groups; either after a number of records have been appended or a commit
+// interval has passed. When a segment fills, or the journal is opened, a new segment
+// is started holding a checkpoint of the current journal state and the old segments
+// removed. Replay of a segment stops at the first zero length or corrupt record.
+//
+// Dependencies: C20++               - Language standard features used.
+//               mmap/Linux          - Memory mapped segment files
+//
+// =================
+// CLASS DEFINITIONS
+// =================
+#include "CTaskJournal.hpp"
+// ====================
+// CLASS IMPLEMENTATION
+// ====================
+//
+// C++ STL
+//
+#include <system_error>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <cstdio>
+//
+// Linux
+//
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+// =========
+// NAMESPACE
+// =========
+namespace Antik::File
+{
+    // ===========================
+    // PRIVATE TYPES AND CONSTANTS
+    // ===========================
+    // Segment file name prefix (followed by segment number)
+    const std::string CTaskJournal::kSegmentPrefix{"journal."};
+    // Segment file magic number ("AntikTJ1")
+    const std::uint64_t CTaskJournal::kSegmentMagic{0x314a546b69746e41};
+    // Allowance for status change time granularity and event ordering
+    const std::chrono::nanoseconds CTaskJournal::kReconcileWindow{std::chrono::seconds(2)};
+    // ==========================
+    // PUBLIC TYPES AND CONSTANTS
+    // ==========================
+    // ========================
+    // PRIVATE STATIC VARIABLES
+    // ========================
+    // =======================
+    // PUBLIC STATIC VARIABLES
+    // =======================
+    // ===============
+    // PRIVATE METHODS
+    // ===============
+    //
+    // Length of record for a file path (header, path and null padded to 8 bytes).
+    //
+    std::size_t CTaskJournal::recordLength(const std::string &filePath)
+    {
+        return ((sizeof(RecordHeader) + filePath.size() + 1 + 7) & ~static_cast<std::size_t>(7));
+    }
+    //
+    // Record checksum (FNV-1a) over its time, type and file path.
+    //
+    std::uint32_t CTaskJournal::recordChecksum(std::int64_t time, std::uint8_t type, const char *filePath, std::size_t length)
+    {
+        std::uint32_t checksum{2166136261};
+        auto addByte = [&checksum](std::uint8_t byte) {
+            checksum = (checksum ^ byte) * 16777619;
+        };
+        for (int shift = 0; shift < 64; shift += 8)
+        {
+            addByte(static_cast<std::uint8_t>(static_cast<std::uint64_t>(time) >> shift));
+        }
+        addByte(type);
+        for (std::size_t index = 0; index < length; index++)
+        {
+            addByte(static_cast<std::uint8_t>(filePath[index]));
+        }
+        return (checksum);
+    }
+    //
+    // Update journal state from a record.
+    //
+    void CTaskJournal::applyRecord(std::uint8_t type, std::int64_t time, const std::string &filePath)
+    {
+        switch (type)
+        {
+        case kReceived:
+            m_outstanding[filePath] = time;
+            m_completed.erase(filePath);
+            m_watchTime = std::max(m_watchTime, time);
+            break;
+        case kCompleted:
+            if (auto received = m_outstanding.find(filePath); received != m_outstanding.end())
+            {
+                m_completed[filePath] = (time != 0) ? time : received->second;
+                m_outstanding.erase(received);
+            }
+            break;
+        case kStarted:
+            m_watchTime = std::max(m_watchTime, time);
+            break;
+        }
+    }
+    //
+    // Write a record to the current segment (which must have room for it).
+    //
+    void CTaskJournal::appendRecord(std::uint8_t type, std::int64_t time, const std::string &filePath)
+    {
+        RecordHeader header;
+        header.length = static_cast<std::uint32_t>(recordLength(filePath));
+        header.checksum = recordChecksum(time, type, filePath.c_str(), filePath.size());
+        header.time = time;
+        header.type = type;
+        std::memcpy(&m_segment[m_appendOffset + sizeof(RecordHeader)], filePath.c_str(), filePath.size() + 1);
+        std::memcpy(&m_segment[m_appendOffset], &header, sizeof(RecordHeader));
+        m_appendOffset += header.length;
+    }
+    //
+    // Journal a record; starting a new segment if the current one is full and waking
+    // the commit thread if a commit batch is ready. Any commit thread exception is
+    // passed on to the caller.
+    //
+    void CTaskJournal::append(std::uint8_t type, std::int64_t time, const std::string &filePath)
+    {
+        std::unique_lock<std::mutex> locker(m_journalMutex);
+        if (m_thrownException)
+        {
+            std::rethrow_exception(m_thrownException);
+        }
+        if (!m_open)
+        {
+            throw std::logic_error("journal not open");
+        }
+        applyRecord(type, time, filePath);
+        if (m_appendOffset + recordLength(filePath) > m_segmentLength)
+        {
+            createSegment(); // Checkpoint holds record just applied
+            return;
+        }
+        appendRecord(type, time, filePath);
+        if (++m_pendingRecords >= m_commitBatch)
+        {
+            m_commitWaiting.notify_one();
+        }
+    }
+    //
+    // Return existing segment files (and their numbers) in segment number order.
+    //
+    std::vector<std::pair<std::uint64_t, std::string>> CTaskJournal::segmentFiles(void) const
+    {
+        std::vector<std::pair<std::uint64_t, std::string>> segments;
+        for (auto &entry : std::filesystem::directory_iterator(m_journalFolder))
+        {
+            std::string fileName{entry.path().filename().string()};
+            if ((fileName.compare(0, kSegmentPrefix.size(), kSegmentPrefix) == 0) && (fileName.size() > kSegmentPrefix.size()) &&
+                (fileName.find_first_not_of("0123456789", kSegmentPrefix.size()) == std::string::npos))
+            {
+                segments.emplace_back(std::stoull(fileName.substr(kSegmentPrefix.size())), entry.path().string());
+            }
+        }
+        std::sort(segments.begin(), segments.end());
+        return (segments);
+    }
+    //
+    // Replay the records of a segment file.
+    //
+    void CTaskJournal::replaySegment(const std::string &segmentFile)
+    {
+        int segmentFd{-1};
+        if ((segmentFd = ::open(segmentFile.c_str(), O_RDONLY | O_CLOEXEC)) == -1)
+        {
+            throw std::system_error(std::error_code(errno, std::system_category()), "open() error");
+        }
+        struct stat segmentStat;
+        if (fstat(segmentFd, &segmentStat) == -1)
+        {
+            ::close(segmentFd);
+            throw std::system_error(std::error_code(errno, std::system_category()), "fstat() error");
+        }
+        std::size_t segmentLength{static_cast<std::size_t>(segmentStat.st_size)};
+        if (segmentLength < sizeof(kSegmentMagic))
+        {
+            ::close(segmentFd);
+            return; // Created but never initialised
+        }
+        void *segment{mmap(nullptr, segmentLength, PROT_READ, MAP_PRIVATE, segmentFd, 0)};
+        ::close(segmentFd);
+        if (segment == MAP_FAILED)
+        {
+            throw std::system_error(std::error_code(errno, std::system_category()), "mmap() error");
+        }
+        const std::uint8_t *records{static_cast<const std::uint8_t *>(segment)};
+        std::uint64_t magic{0};
+        std::memcpy(&magic, records, sizeof(magic));
+        for (std::size_t offset = sizeof(kSegmentMagic); (magic == kSegmentMagic) && (offset + sizeof(RecordHeader) <= segmentLength);)
+        {
+            RecordHeader header;
+            std::memcpy(&header, &records[offset], sizeof(RecordHeader));
+            if ((header.length <= sizeof(RecordHeader)) || (header.length > segmentLength - offset))
+            {
+                break;
+            }
+            const char *filePath{reinterpret_cast<const char *>(&records[offset + sizeof(RecordHeader)])};
+            std::size_t filePathLength{strnlen(filePath, header.length - sizeof(RecordHeader))};
+            if ((header.length != recordLength(std::string(filePath, filePathLength))) ||
+                (header.checksum != recordChecksum(header.time, header.type, filePath, filePathLength)))
+            {
+                break;
+            }
+            applyRecord(header.type, header.time, std::string(filePath, filePathLength));
+            offset += header.length;
+        }
+        munmap(segment, segmentLength);
+    }
+    //
+    // Create a new segment holding a checkpoint of the current journal state (files
+    // outstanding, files recently completed and the watch time), commit it and remove
+    // the segments it replaces.
+    //
+    void CTaskJournal::createSegment(void)
+    {
+        std::vector<std::pair<std::uint64_t, std::string>> oldSegments{segmentFiles()};
+        closeSegment();
+        for (auto completed = m_completed.begin(); completed != m_completed.end();)
+        {
+            if (completed->second < (m_watchTime - kReconcileWindow.count()))
+            {
+                completed = m_completed.erase(completed);
+            }
+            else
+            {
+                completed++;
+            }
+        }
+        std::size_t checkpointLength{sizeof(kSegmentMagic) + recordLength("")};
+        for (auto &outstanding : m_outstanding)
+        {
+            checkpointLength += recordLength(outstanding.first);
+        }
+        for (auto &completed : m_completed)
+        {
+            checkpointLength += recordLength(completed.first) * 2;
+        }
+        std::size_t pageSize{static_cast<std::size_t>(sysconf(_SC_PAGESIZE))};
+        m_segmentLength = ((std::max(m_segmentSize, checkpointLength * 2) + pageSize - 1) / pageSize) * pageSize;
+        char segmentName[32];
+        std::snprintf(segmentName, sizeof(segmentName), "%08llu", static_cast<unsigned long long>(++m_segmentNumber));
+        m_segmentFile = m_journalFolder + "/" + kSegmentPrefix + segmentName;
+        if ((m_segmentFd = ::open(m_segmentFile.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)) == -1)
+        {
+            throw std::system_error(std::error_code(errno, std::system_category()), "open() error");
+        }
+        if (int error = posix_fallocate(m_segmentFd, 0, static_cast<off_t>(m_segmentLength)); error != 0)
+        {
+            throw std::system_error(std::error_code(error, std::system_category()), "posix_fallocate() error");
+        }
+        void *segment{mmap(nullptr, m_segmentLength, PROT_READ | PROT_WRITE, MAP_SHARED, m_segmentFd, 0)};
+        if (segment == MAP_FAILED)
+        {
+            throw std::system_error(std::error_code(errno, std::system_category()), "mmap() error");
+        }
+        m_segment = static_cast<std::uint8_t *>(segment);
+        std::memcpy(m_segment, &kSegmentMagic, sizeof(kSegmentMagic));
+        m_appendOffset = sizeof(kSegmentMagic);
+        m_syncedOffset = 0;
+        if (m_watchTime != 0)
+        {
+            appendRecord(kStarted, m_watchTime, "");
+        }
+        for (auto &completed : m_completed)
+        {
+            appendRecord(kReceived, completed.second, completed.first);
+            appendRecord(kCompleted, completed.second, completed.first);
+        }
+        for (auto &outstanding : m_outstanding)
+        {
+            appendRecord(kReceived, outstanding.second, outstanding.first);
+        }
+        syncSegment();
+        syncFolder();
+        for (auto &oldSegment : oldSegments)
+        {
+            if (oldSegment.second != m_segmentFile)
+            {
+                std::filesystem::remove(oldSegment.second);
+            }
+        }
+    }
+    //
+    // Unmap and close current segment.
+    //
+    void CTaskJournal::closeSegment(void)
+    {
+        if (m_segment != nullptr)
+        {
+            munmap(m_segment, m_segmentLength);
+            m_segment = nullptr;
+        }
+        if (m_segmentFd != -1)
+        {
+            ::close(m_segmentFd);
+            m_segmentFd = -1;
+        }
+    }
+    //
+    // Flush the pages of the current segment holding records appended since the last
+    // commit to disk.
+    //
+    void CTaskJournal::syncSegment(void)
+    {
+        if ((m_segment != nullptr) && (m_syncedOffset < m_appendOffset))
+        {
+            std::size_t pageSize{static_cast<std::size_t>(sysconf(_SC_PAGESIZE))};
+            std::size_t syncStart{(m_syncedOffset / pageSize) * pageSize};
+            if (msync(&m_segment[syncStart], m_appendOffset - syncStart, MS_SYNC) == -1)
+            {
+                throw std::system_error(std::error_code(errno, std::system_category()), "msync() error");
+            }
+            m_syncedOffset = m_appendOffset;
+        }
+        m_pendingRecords = 0;
+    }
+    //
+    // Flush journal folder (segment creation/removal) to disk.
+    //
+    void CTaskJournal::syncFolder(void)
+    {
+        int folderFd{-1};
+        if ((folderFd = ::open(m_journalFolder.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC)) == -1)
+        {
+            throw std::system_error(std::error_code(errno, std::system_category()), "open() error");
+        }
+        int result{fsync(folderFd)};
+        ::close(folderFd);
+        if (result == -1)
+        {
+            throw std::system_error(std::error_code(errno, std::system_category()), "fsync() error");
+        }
+    }
+    //
+    // Group commit thread; commit appended records when a batch is ready or the commit
+    // interval has passed.
+    //
+    void CTaskJournal::committer(void)
+    {
+        std::unique_lock<std::mutex> locker(m_journalMutex);
+        while (m_open)
+        {
+            m_commitWaiting.wait_for(locker, m_commitInterval, [this] { return (!m_open || (m_pendingRecords >= m_commitBatch)); });
+            try
+            {
+                syncSegment();
+            }
+            catch (...)
+            {
+                m_thrownException = std::current_exception();
+                break;
+            }
+        }
+    }
+    // ==============
+    // PUBLIC METHODS
+    // ==============
+    //
+    // Constructor
+    //
+    CTaskJournal::CTaskJournal(const std::string &journalFolder, std::size_t segmentSize, std::chrono::milliseconds commitInterval, std::size_t commitBatch)
+        : m_journalFolder{journalFolder}, m_segmentSize{segmentSize}, m_commitInterval{commitInterval}, m_commitBatch{std::max(commitBatch, static_cast<std::size_t>(1))}
+    {
+        if ((m_journalFolder.size() > 1) && (m_journalFolder.back() == '/'))
+        {
+            m_journalFolder.pop_back();
+        }
+    }
+    //
+    // Destructor
+    //
+    CTaskJournal::~CTaskJournal()
+    {
+        try
+        {
+            close();
+        }
+        catch (...)
+        {
+        }
+    }
+    //
+    // Replay any existing journal, start a new segment holding its state and start
+    // the group commit thread.
+    //
+    void CTaskJournal::open(void)
+    {
+        std::unique_lock<std::mutex> locker(m_journalMutex);
+        if (m_open)
+        {
+            throw std::logic_error("journal already open");
+        }
+        std::filesystem::create_directories(m_journalFolder);
+        std::vector<std::pair<std::uint64_t, std::string>> segments{segmentFiles()};
+        for (auto &segment : segments)
+        {
+            replaySegment(segment.second);
+            m_segmentNumber = segment.first;
+        }
+        m_replayedOutstanding.clear();
+        for (auto &outstanding : m_outstanding)
+        {
+            m_replayedOutstanding.push_back(outstanding.first);
+        }
+        std::sort(m_replayedOutstanding.begin(), m_replayedOutstanding.end());
+        m_reconcileTime = (m_watchTime != 0) ? std::max(m_watchTime - kReconcileWindow.count(), static_cast<std::int64_t>(1)) : 0;
+        createSegment();
+        m_replayedCompleted = m_completed;
+        m_thrownException = nullptr;
+        m_open = true;
+        m_committer = std::make_unique<std::thread>(&CTaskJournal::committer, this);
+    }
+    //
+    // Stop the group commit thread, commit any remaining records and close segment.
+    //
+    void CTaskJournal::close(void)
+    {
+        std::unique_lock<std::mutex> locker(m_journalMutex);
+        if (!m_open)
+        {
+            return;
+        }
+        m_open = false;
+        m_commitWaiting.notify_one();
+        locker.unlock();
+        m_committer->join();
+        m_committer.reset();
+        locker.lock();
+        syncSegment();
+        closeSegment();
+    }
+    //
+    // Commit all appended records now.
+    //
+    void CTaskJournal::commit(void)
+    {
+        std::unique_lock<std::mutex> locker(m_journalMutex);
+        syncSegment();
+    }
+    //
+    // Journal file received for processing.
+    //
+    void CTaskJournal::received(const std::string &filePath, std::int64_t changed)
+    {
+        append(kReceived, changed, filePath);
+    }
+    //
+    // Journal file processing completed (with its status change time if it has changed
+    // since received).
+    //
+    void CTaskJournal::completed(const std::string &filePath, std::int64_t changed)
+    {
+        append(kCompleted, changed, filePath);
+    }
+    //
+    // Journal that all files changed before the passed time have been received.
+    //
+    void CTaskJournal::started(std::int64_t watchTime)
+    {
+        append(kStarted, watchTime, "");
+    }
+    //
+    // Files received but not completed when journal replayed.
+    //
+    std::vector<std::string> CTaskJournal::outstanding(void) const
+    {
+        return (m_replayedOutstanding);
+    }
+    //
+    // Status change time from which files may have been missed when the journal was
+    // replayed (0 if there was no journal).
+    //
+    std::int64_t CTaskJournal::reconcileTime(void) const
+    {
+        return (m_reconcileTime);
+    }
+    //
+    // File (with passed status change time) was completed close to reconcile time.
+    //
+    bool CTaskJournal::wasCompleted(const std::string &filePath, std::int64_t changed) const
+    {
+        auto completed = m_replayedCompleted.find(filePath);
+        return ((completed != m_replayedCompleted.end()) && (completed->second == changed));
+    }
+} // namespace Antik::File
@@ -0,0 +1,171 @@
+#ifndef CTASKJOURNAL_HPP
+#define CTASKJOURNAL_HPP
+//
+// C++ STL
+//
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <memory>
+// =========
+// NAMESPACE
+// =========
+namespace Antik::File
+{
+    // ================
+    // CLASS DEFINITION
+    // ================
+    class CTaskJournal
+    {
+    public:
+        // ==========================
+        // PUBLIC TYPES AND CONSTANTS
+        // ==========================
+        // ============
+        // CONSTRUCTORS
+        // ============
+        //
+        // Main constructor
+        //
+        CTaskJournal(
+            const std::string &journalFolder,         // Folder holding journal segment files
+            std::size_t segmentSize,                  // Size of a segment file
+            std::chrono::milliseconds commitInterval, // Maximum time before appended records are committed
+            std::size_t commitBatch                   // Appended records that trigger a commit
+        );
+        // ==========
+        // DESTRUCTOR
+        // ==========
+        virtual ~CTaskJournal();
+        // ==============
+        // PUBLIC METHODS
+        // ==============
+        //
+        // Control
+        //
+        void open(void);   // Replay existing journal and start a new segment
+        void close(void);  // Commit and close journal
+        void commit(void); // Commit all appended records
+        //
+        // Journal records
+        //
+        void received(const std::string &filePath, std::int64_t changed);  // File (with status change time) received for processing
+        void completed(const std::string &filePath, std::int64_t changed); // File processing completed (status change time then; 0 = as received)
+        void started(std::int64_t watchTime);                              // All files changed before time received
+        //
+        // Replayed journal
+        //
+        std::vector<std::string> outstanding(void) const;                          // Files received but not completed
+        std::int64_t reconcileTime(void) const;                                    // Files changed since may have been missed (0 = none)
+        bool wasCompleted(const std::string &filePath, std::int64_t changed) const; // File already processed
+        // ================
+        // PUBLIC VARIABLES
+        // ================
+    private:
+        // ===========================
+        // PRIVATE TYPES AND CONSTANTS
+        // ===========================
+        //
+        // Journal record types
+        //
+        enum RecordType : std::uint8_t
+        {
+            kReceived = 'R',  // File received (time = file status change time)
+            kCompleted = 'C', // File completed (time = file status change time or 0 if unchanged)
+            kStarted = 'S'    // All files changed before time received
+        };
+        //
+        // Journal record header; followed by the file path (null terminated and padded
+        // to 8 bytes). A zero length marks the end of the records in a segment.
+        //
+        struct RecordHeader
+        {
+            std::uint32_t length{0};   // Record length (including header)
+            std::uint32_t checksum{0}; // Checksum of record time, type and file path
+            std::int64_t time{0};      // Record time (nanoseconds since epoch)
+            std::uint8_t type{0};      // Record type
+            std::uint8_t pad[7]{};     // Padding
+        };
+        static const std::string kSegmentPrefix;                // Segment file name prefix
+        static const std::uint64_t kSegmentMagic;               // Segment file magic number
+        static const std::chrono::nanoseconds kReconcileWindow; // Allowance for status change time granularity/ordering
+        // ===========================================
+        // DISABLED CONSTRUCTORS/DESTRUCTORS/OPERATORS
+        // ===========================================
+        CTaskJournal() = delete;
+        CTaskJournal(const CTaskJournal &orig) = delete;
+        CTaskJournal(const CTaskJournal &&orig) = delete;
+        CTaskJournal &operator=(CTaskJournal other) = delete;
+        // ===============
+        // PRIVATE METHODS
+        // ===============
+        //
+        // Records
+        //
+        static std::size_t recordLength(const std::string &filePath);                                              // Aligned record length
+        static std::uint32_t recordChecksum(std::int64_t time, std::uint8_t type, const char *filePath, std::size_t length); // Record checksum
+        void applyRecord(std::uint8_t type, std::int64_t time, const std::string &filePath);                       // Update state from record
+        void appendRecord(std::uint8_t type, std::int64_t time, const std::string &filePath);                      // Write record to segment
+        void append(std::uint8_t type, std::int64_t time, const std::string &filePath);                            // Journal record
+        //
+        // Segments
+        //
+        std::vector<std::pair<std::uint64_t, std::string>> segmentFiles(void) const; // Existing segment files in order
+        void replaySegment(const std::string &segmentFile);                           // Replay a segments records
+        void createSegment(void);                                                     // Create new segment holding current state
+        void closeSegment(void);                                                      // Unmap and close current segment
+        void syncSegment(void);                                                       // Flush appended records to disk
+        void syncFolder(void);                                                        // Flush journal folder to disk
+        //
+        // Group commit thread
+        //
+        void committer(void);
+        // =================
+        // PRIVATE VARIABLES
+        // =================
+        //
+        // Constructor passed in and intialized
+        //
+        std::string m_journalFolder;                // Journal folder
+        std::size_t m_segmentSize{0};               // Segment size
+        std::chrono::milliseconds m_commitInterval; // Commit interval
+        std::size_t m_commitBatch{0};               // Commit batch size
+        //
+        // Journal state (replayed and then maintained as records appended)
+        //
+        std::unordered_map<std::string, std::int64_t> m_outstanding; // Files received but not completed (and change time)
+        std::unordered_map<std::string, std::int64_t> m_completed;   // Recently completed files (and change time)
+        std::int64_t m_watchTime{0};                                 // Files changed before time received
+        //
+        // Replayed journal
+        //
+        std::vector<std::string> m_replayedOutstanding;                    // Files outstanding when replayed
+        std::unordered_map<std::string, std::int64_t> m_replayedCompleted; // Files recently completed when replayed
+        std::int64_t m_reconcileTime{0};                                   // Replayed reconcile time (0 = none)
+        //
+        // Current segment
+        //
+        std::uint64_t m_segmentNumber{0}; // Current segment number
+        std::string m_segmentFile;        // Current segment file name
+        int m_segmentFd{-1};              // Current segment file descriptor
+        std::uint8_t *m_segment{nullptr}; // Mapped segment
+        std::size_t m_segmentLength{0};   // Mapped segment length
+        std::size_t m_appendOffset{0};    // Offset of next record
+        std::size_t m_syncedOffset{0};    // Offset records committed up to
+        std::size_t m_pendingRecords{0};  // Records appended since last commit
+        //
+        // Group commit
+        //
+        std::mutex m_journalMutex;                     // Journal mutex
+        std::condition_variable m_commitWaiting;       // Commit thread conditional
+        std::unique_ptr<std::thread> m_committer;      // Commit thread
+        bool m_open{false};                            // Journal open
+        std::exception_ptr m_thrownException{nullptr}; // Pointer to any exception thrown by commit thread
+    };
+} // namespace Antik::File
+#endif /* CTASKJOURNAL_HPP */
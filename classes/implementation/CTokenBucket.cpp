@@ -0,0 +1,101 @@
+//
+// Class: CTokenBucket
+//
+// Description: Token bucket rate limiter for CTask actions. Tokens are added at a
+// fixed rate up to a burst size; taking more tokens than are held leaves the bucket
+// in debt so that the caller waits for its own tokens and later callers queue up
+// behind it (a batch larger than the burst size is still let through at the rate).
+//
+// Dependencies: C20++               - Language standard features used.
+//
+// =================
+// CLASS DEFINITIONS
+// =================
+#include "CTokenBucket.hpp"
+// ====================
+// CLASS IMPLEMENTATION
+// ====================
+//
+// C++ STL
+//
+#include <algorithm>
+// =========
+// NAMESPACE
+// =========
+namespace Antik::File
+{
+    // ===========================
+    // PRIVATE TYPES AND CONSTANTS
+    // ===========================
+    // ==========================
+    // PUBLIC TYPES AND CONSTANTS
+    // ==========================
+    // ========================
+    // PRIVATE STATIC VARIABLES
+    // ========================
+    // =======================
+    // PUBLIC STATIC VARIABLES
+    // =======================
+    // ===============
+    // PRIVATE METHODS
+    // ===============
+    // ==============
+    // PUBLIC METHODS
+    // ==============
+    //
+    // Main CTokenBucket object constructor (starts full).
+    //
+    CTokenBucket::CTokenBucket(double rate, std::size_t burst, Clock::time_point now)
+        : m_rate{rate}, m_burst{static_cast<double>(std::max(burst, std::size_t(1)))}, m_refilled{now}
+    {
+        m_tokens = m_burst;
+    }
+    //
+    // CTokenBucket Destructor
+    //
+    CTokenBucket::~CTokenBucket()
+    {
+    }
+    //
+    // Add tokens for time passed and take those requested. Returns how long until the
+    // tokens taken are available (zero if they already are).
+    //
+    CTokenBucket::Clock::duration CTokenBucket::reserve(std::size_t tokens, Clock::time_point now)
+    {
+        std::unique_lock<std::mutex> locker(m_bucketMutex);
+        if (now > m_refilled)
+        {
+            m_tokens = std::min(m_burst, m_tokens + std::chrono::duration<double>(now - m_refilled).count() * m_rate);
+            m_refilled = now;
+        }
+        m_tokens -= static_cast<double>(tokens);
+        if (m_tokens >= 0.0)
+        {
+            return (Clock::duration::zero());
+        }
+        return (std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(-m_tokens / m_rate)));
+    }
+    //
+    // Take tokens and wait until they are available. Returns false if the bucket is
+    // closed before then.
+    //
+    bool CTokenBucket::acquire(std::size_t tokens)
+    {
+        Clock::duration wait{reserve(tokens)};
+        std::unique_lock<std::mutex> locker(m_bucketMutex);
+        if (wait != Clock::duration::zero())
+        {
+            m_closeWaiting.wait_for(locker, wait, [this] { return (m_closed); });
+        }
+        return (!m_closed);
+    }
+    //
+    // Close bucket; waking any waiting acquire.
+    //
+    void CTokenBucket::close(void)
+    {
+        std::unique_lock<std::mutex> locker(m_bucketMutex);
+        m_closed = true;
+        m_closeWaiting.notify_all();
+    }
+} // namespace Antik::File
@@ -0,0 +1,66 @@
+#ifndef CTOKENBUCKET_HPP
+#define CTOKENBUCKET_HPP
+//
+// C++ STL
+//
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+// =========
+// NAMESPACE
+// =========
+namespace Antik::File
+{
+    // ================
+    // CLASS DEFINITION
+    // ================
+    class CTokenBucket
+    {
+    public:
+        // ==========================
+        // PUBLIC TYPES AND CONSTANTS
+        // ==========================
+        using Clock = std::chrono::steady_clock;
+        // ============
+        // CONSTRUCTORS
+        // ============
+        //
+        // Main constructor
+        //
+        explicit CTokenBucket(double rate, std::size_t burst = 1, Clock::time_point now = Clock::now());
+        // ==========
+        // DESTRUCTOR
+        // ==========
+        virtual ~CTokenBucket();
+        // ==============
+        // PUBLIC METHODS
+        // ==============
+        Clock::duration reserve(std::size_t tokens, Clock::time_point now = Clock::now()); // Take tokens; returning wait before they are available
+        bool acquire(std::size_t tokens = 1);                                              // Take tokens and wait for them (false when closed)
+        void close(void);                                                                  // Close bucket; waiting acquires return false
+        // ================
+        // PUBLIC VARIABLES
+        // ================
+    private:
+        // ===========================
+        // PRIVATE TYPES AND CONSTANTS
+        // ===========================
+        // ===========================================
+        // DISABLED CONSTRUCTORS/DESTRUCTORS/OPERATORS
+        // ===========================================
+        CTokenBucket(const CTokenBucket &orig) = delete;
+        CTokenBucket(const CTokenBucket &&orig) = delete;
+        CTokenBucket &operator=(CTokenBucket other) = delete;
+        // =================
+        // PRIVATE VARIABLES
+        // =================
+        double m_rate{0.0};                     // Tokens added per second
+        double m_burst{0.0};                    // Most tokens held
+        double m_tokens{0.0};                   // Tokens held (negative when reserved ahead)
+        Clock::time_point m_refilled;           // Time tokens last added
+        bool m_closed{false};                   // Bucket closed
+        std::mutex m_bucketMutex;               // Bucket mutex
+        std::condition_variable m_closeWaiting; // Close wait condition
+    };
+} // namespace Antik::File
+#endif /* CTOKENBUCKET_HPP */
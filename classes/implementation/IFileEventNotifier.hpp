@@ -5,10 +5,12 @@
 //
 #include <string>
 #include <stdexcept>
+#include <chrono>
 //
 // Antik classes
 //
 #include "IApprise.hpp"
+#include "CMetrics.hpp"
 // =========
 // NAMESPACE
 // =========
@@ -23,6 +25,19 @@ namespace Antik::File
         // ==========================
         // PUBLIC TYPES AND CONSTANTS
         // ==========================
+        //
+        // Notifier options (passed to implementation constructor)
+        //
+        struct Options
+        {
+            bool initialScan{false};                      // Report files present at start and in newly created directories
+            int scanThreads{4};                           // Number of threads used to enumerate directories when scanning
+            std::chrono::milliseconds coalesceWindow{0};  // Window to coalesce file events per path over (0 = off)
+            std::chrono::milliseconds pollInterval{1000}; // Interval between directory rescans (polling notifier)
+            std::size_t pollBatchSize{0};                 // Unchanged directories rescanned per poll (0 = all)
+            bool reconcileOverflow{false};                // Keep snapshot of files to rescan against on queue overflow
+            std::size_t maxQueuedEvents{0};               // Events queued before event generation waits for space (0 = unbounded)
+        };
         // ============
         // CONSTRUCTORS
         // ============
@@ -35,6 +50,7 @@ namespace Antik::File
         virtual void generateEvents(void) = 0;                   // Watch folder(s) for file events
         virtual void stopEventGeneration(void) = 0;              // Stop watch loop/thread
         virtual void getNextEvent(IApprise::Event &message) = 0; // Get next queued event
+        virtual void getNextEvent(IApprise::Event &message, std::chrono::milliseconds timeout) = 0; // Get next queued event (waiting at most timeout)
         virtual bool stillWatching() const = 0;                  // Events still being generated
         virtual void clearEventQueue() = 0;                      // Clear event queue
         //
@@ -47,6 +63,10 @@ namespace Antik::File
         // Get any thrown exceptions
         //
         virtual std::exception_ptr getThrownException() const = 0;
+        //
+        // Get notifier metrics
+        //
+        virtual std::shared_ptr<CMetrics> getMetrics() const = 0;
         // ================
         // PUBLIC VARIABLES
         // ================
@@ -5,6 +5,8 @@
 //
 #include <stdexcept>
 #include <thread>
+#include <memory>
+#include <mutex>
 //
 // Antik classes
 //
@@ -50,6 +52,7 @@ namespace Antik::File
         void stopWatching(void) override;
         bool stillWatching(void) override;
         void getNextEvent(CApprise::Event &message) override;
+        void getNextEvent(CApprise::Event &message, std::chrono::milliseconds timeout) override;
         //
         // Watch handling
         //
@@ -59,6 +62,10 @@ namespace Antik::File
         // Get any thrown exceptions
         //
         std::exception_ptr getThrownException(void) override; // Get any exception thrown by watcher to pass down chain
+        //
+        // Get watcher metrics (including those of its file event notifier)
+        //
+        std::shared_ptr<CMetrics> getMetrics(void) override;
         // ================
         // PUBLIC VARIABLES
         // ================
@@ -87,7 +94,14 @@ namespace Antik::File
         //
         // Watcher thread
         //
-        std::unique_ptr<std::thread> m_watcherThread;
+        std::unique_ptr<std::thread> m_watcherThread; // Notifier event generation thread
+        std::mutex m_watcherThreadMutex;              // Serialise joining of watcher thread
+        //
+        // Metrics
+        //
+        std::shared_ptr<CMetrics> m_metrics;                  // Watcher metrics
+        CMetrics::Counter *m_eventsDelivered{nullptr};        // Events returned by getNextEvent()
+        CMetrics::Histogram *m_eventDeliveryLatency{nullptr}; // Time from event generated to returned (us)
     };
 } // namespace Antik::File
 #endif /* CAPPRISE_HPP */
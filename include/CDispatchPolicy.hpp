@@ -0,0 +1,119 @@
+#ifndef CDISPATCHPOLICY_HPP
+#define CDISPATCHPOLICY_HPP
+//
+// C++ STL
+//
+#include <string>
+#include <chrono>
+#include <unordered_map>
+//
+// Antik classes
+//
+#include "IDispatchPolicy.hpp"
+// =========
+// NAMESPACE
+// =========
+namespace Antik::File
+{
+    // ================
+    // CLASS DEFINITION
+    // ================
+    //
+    // Round-robin between the directories files are queued from (start time fair queuing)
+    //
+    class CFairDispatchPolicy : public IDispatchPolicy
+    {
+    public:
+        // ============
+        // CONSTRUCTORS
+        // ============
+        CFairDispatchPolicy();
+        // ==========
+        // DESTRUCTOR
+        // ==========
+        virtual ~CFairDispatchPolicy();
+        // ==============
+        // PUBLIC METHODS
+        // ==============
+        Rank rank(const std::string &filePath, std::chrono::steady_clock::time_point received) override;
+        void dispatched(const std::string &filePath, const Rank &rank) override;
+
+    private:
+        // ===========================
+        // PRIVATE TYPES AND CONSTANTS
+        // ===========================
+        //
+        // Directories tracked before those with nothing queued are forgotten
+        //
+        static const std::size_t kPruneDirectories;
+        // =================
+        // PRIVATE VARIABLES
+        // =================
+        std::int64_t m_round{0};                                   // Round of last file dispatched
+        std::size_t m_pruneDirectories{0};                         // Directories tracked that trigger a prune
+        std::unordered_map<std::string, std::int64_t> m_nextRound; // Next round for each directory
+    };
+    //
+    // Priority by file extension (lower dispatched first) and optionally smallest file first
+    //
+    class CPriorityDispatchPolicy : public IDispatchPolicy
+    {
+    public:
+        // ============
+        // CONSTRUCTORS
+        // ============
+        explicit CPriorityDispatchPolicy(
+            const std::unordered_map<std::string, int> &extensionPriorities, // Priority for extension (e.g. ".txt")
+            int defaultPriority = 0,                                        // Priority of other extensions
+            bool smallestFirst = false                                      // Smallest file first within a priority
+        );
+        // ==========
+        // DESTRUCTOR
+        // ==========
+        virtual ~CPriorityDispatchPolicy();
+        // ==============
+        // PUBLIC METHODS
+        // ==============
+        Rank rank(const std::string &filePath, std::chrono::steady_clock::time_point received) override;
+        void dispatched(const std::string &filePath, const Rank &rank) override;
+
+    private:
+        // =================
+        // PRIVATE VARIABLES
+        // =================
+        std::unordered_map<std::string, int> m_extensionPriorities; // Priority for extension
+        int m_defaultPriority{0};                                   // Priority of other extensions
+        bool m_smallestFirst{false};                                // Smallest file first within a priority
+    };
+    //
+    // Earliest deadline first; deadline is time queued plus one for file extension
+    //
+    class CDeadlineDispatchPolicy : public IDispatchPolicy
+    {
+    public:
+        // ============
+        // CONSTRUCTORS
+        // ============
+        explicit CDeadlineDispatchPolicy(
+            std::chrono::milliseconds defaultDeadline,                                                // Deadline of other extensions
+            const std::unordered_map<std::string, std::chrono::milliseconds> &extensionDeadlines = {} // Deadline for extension (e.g. ".txt")
+        );
+        // ==========
+        // DESTRUCTOR
+        // ==========
+        virtual ~CDeadlineDispatchPolicy();
+        // ==============
+        // PUBLIC METHODS
+        // ==============
+        Rank rank(const std::string &filePath, std::chrono::steady_clock::time_point received) override;
+        void dispatched(const std::string &filePath, const Rank &rank) override;
+
+    private:
+        // =================
+        // PRIVATE VARIABLES
+        // =================
+        std::chrono::milliseconds m_defaultDeadline;                                     // Deadline of other extensions
+        std::unordered_map<std::string, std::chrono::milliseconds> m_extensionDeadlines; // Deadline for extension
+    };
+} // namespace Antik::File
+#endif /* CDISPATCHPOLICY_HPP */
@@ -10,11 +10,18 @@
 #include <memory>
 #include <mutex>
 #include <iomanip>
+#include <fstream>
+#include <functional>
+#include <exception>
 //
 // Antik classes
 //
 #include "CommonAntik.hpp"
 #include "CSocket.hpp"
+//
+// OpenSSL message digests
+//
+#include <openssl/evp.h>
 // =========
 // NAMESPACE
 // =========
@@ -100,6 +107,35 @@ namespace Antik::FTP
                 return streamDateTime.str();
             }
         };
+        //
+        // File information from the facts of an MLST/MLSD entry
+        //
+        struct FileInfo
+        {
+            std::string name;      // File name (path for MLST)
+            std::string type;      // Type fact ("file", "dir", "cdir", "pdir" ...)
+            std::uint64_t size{0}; // Size fact (bytes)
+            DateTime modify;       // Modify fact (UTC)
+            std::string perm;      // Perm fact
+            bool isDirectory() const
+            {
+                return ((type == "dir") || (type == "cdir") || (type == "pdir"));
+            }
+        };
+        using FileInfoList = std::vector<FileInfo>;
+        //
+        // Reply to a pipelined command
+        //
+        struct CommandReply
+        {
+            std::uint16_t statusCode{0}; // Returned status code
+            std::string response;        // Raw response
+        };
+        //
+        // Asynchronous command completion handler (passed any exception thrown and the
+        // returned status code)
+        //
+        using AsyncHandler = std::function<void(std::exception_ptr, std::uint16_t)>;
         // ============
         // CONSTRUCTORS
         // ============
@@ -107,6 +143,11 @@ namespace Antik::FTP
         // Main constructor
         //
         CFTP();
+        //
+        // Session using an io service shared with others (run by the caller's threads
+        // for asynchronous commands)
+        //
+        explicit CFTP(boost::asio::io_service &ioService);
         // ==========
         // DESTRUCTOR
         // ==========
@@ -122,6 +163,8 @@ namespace Antik::FTP
         void setUserAndPassword(const std::string &userName, const std::string &userPassword);
         std::string getServer(void) const;
         std::string getUser(void) const;
+        // Copy server, account and transfer settings from another (possibly connected) CFTP
+        void copySettings(const CFTP &ftpServer);
         //
         // FTP connect, disconnect and connection status
         //
@@ -134,11 +177,20 @@ namespace Antik::FTP
         // FTP get and put file
         std::uint16_t getFile(const std::string &remoteFilePath, const std::string &localFilePath);
         std::uint16_t putFile(const std::string &remoteFilePath, const std::string &localFilePath);
+        // FTP resume get and put of a partially transferred file, verify file transferred
+        std::uint16_t resumeGetFile(const std::string &remoteFilePath, const std::string &localFilePath, bool verify = false);
+        std::uint16_t resumePutFile(const std::string &remoteFilePath, const std::string &localFilePath, bool verify = false);
+        bool verifyFile(const std::string &remoteFilePath, const std::string &localFilePath);
+        bool isVerifySupported();
+        std::uint16_t getFileSegment(const std::string &remoteFilePath, int localFile, std::uint64_t offset, std::uint64_t length, std::uint64_t &bytesTransferred);
         // FTP list file/directory
         std::uint16_t list(const std::string &directoryPath, std::string &listOutput);
         std::uint16_t listFiles(const std::string &directoryPath, FileList &fileList);
         std::uint16_t listDirectory(const std::string &directoryPath, std::string &listOutput);
         std::uint16_t listFile(const std::string &filePath, std::string &listOutput);
+        std::uint16_t listDirectory(const std::string &directoryPath, FileInfoList &fileInfoList);
+        std::uint16_t listFile(const std::string &filePath, FileInfo &fileInfo);
+        bool isMLSTSupported();
         // FTP set/get current working directory
         std::uint16_t changeWorkingDirectory(const std::string &workingDirectoryPath);
         std::uint16_t getCurrentWoringDirectory(std::string &currentWoringDirectory);
@@ -146,17 +198,36 @@ namespace Antik::FTP
         std::uint16_t makeDirectory(const std::string &directoryName);
         std::uint16_t removeDirectory(const std::string &directoryName);
         std::uint16_t cdUp();
+        // FTP no operation (keep control connection alive)
+        std::uint16_t noOperation();
         // FTP delete/rename remote file, get size in bytes
         std::uint16_t deleteFile(const std::string &fileName);
         std::uint16_t renameFile(const std::string &srcFileName, const std::string &dstFileName);
         std::uint16_t fileSize(const std::string &fileName, size_t &fileSize);
+        std::vector<std::uint16_t> fileSize(const FileList &fileNames, std::vector<size_t> &fileSizes);
         // FTP get file last modified time
         std::uint16_t getModifiedDateTime(const std::string &filePath, DateTime &modifiedDateTime);
+        std::vector<std::uint16_t> getModifiedDateTime(const FileList &filePaths, std::vector<DateTime> &modifiedDateTimes);
         // FTP Is file a directory, does file exist
         bool isDirectory(const std::string &fileName);
         bool fileExists(const std::string &fileName);
-        // FTP server features
+        std::vector<bool> isDirectory(const FileList &fileNames);
+        std::vector<bool> fileExists(const FileList &fileNames);
+        // Send commands without waiting for each reply (replies returned in command order)
+        std::uint16_t pipelineCommands(const std::vector<std::string> &commands, std::vector<CommandReply> &replies);
+        // FTP server features, is feature listed
         std::vector<std::string> getServerFeatures();
+        bool serverFeature(const std::string &feature);
+        // Parse MLST/MLSD entry facts, XCRC/HASH CRC32 field
+        static void parseFacts(const std::string &entry, FileInfo &fileInfo);
+        static bool parseCRC(std::string crcField, std::uint32_t &crc);
+        // Asynchronous connect/disconnect, get/put file and list; one command at a time per
+        // session with the handler run by the io service once it completes
+        void asyncConnect(AsyncHandler handler);
+        void asyncDisconnect(AsyncHandler handler);
+        void asyncGetFile(const std::string &remoteFilePath, const std::string &localFilePath, AsyncHandler handler);
+        void asyncPutFile(const std::string &remoteFilePath, const std::string &localFilePath, AsyncHandler handler);
+        void asyncList(const std::string &directoryPath, std::string &listOutput, AsyncHandler handler);
         // Enable/Disable SSL
         void setSslEnabled(bool sslEnabled);
         bool isSslEnabled() const;
@@ -174,6 +245,12 @@ namespace Antik::FTP
         // ===========================
         // PRIVATE TYPES AND CONSTANTS
         // ===========================
+        // Control channel read size
+        static const std::size_t kControlReadSize;
+        // Most pipelined commands awaiting a reply
+        static const std::size_t kPipelineDepth;
+        // Next step of an asynchronous command
+        using AsyncStep = std::function<void()>;
         // Data channel transfer types
         enum DataTransferType
         {
@@ -194,19 +271,57 @@ namespace Antik::FTP
         bool sendTransferMode();
         // FTP command channel I/O to server
         void ftpCommand(const std::string &commandLine);
+        void ftpCommands(const std::vector<std::string> &commandLines, std::vector<CommandReply> &replies);
+        void ftpSend(const std::string &commandLines);
         void ftpResponse();
+        void ftpResponseStatusCode();
+        std::size_t ftpResponseLine();
+        bool bufferedResponseLine(std::size_t &lineStart);
+        std::size_t extendControlBuffer();
+        void resetConnection(void);
+        // Command response parsing
+        static bool mlstIsDirectory(const std::string &mlstResponse);
+        static bool statIsDirectory(const std::string &statResponse);
+        static bool statFileExists(const std::string &statResponse);
         // Get FTP server features list
         void ftpServerFeatures(void);
+        void parseServerFeatures(void);
+        // Local file size, checksums and partial file check (for resumed transfers)
+        static std::uint64_t localFileSize(const std::string &localFilePath);
+        std::uint32_t localFileCRC(const std::string &localFilePath, std::uint64_t length);
+        std::string localFileHash(const std::string &localFilePath, const EVP_MD *digestType);
+        bool responseCRCMatches(const std::string &localFilePath, std::uint64_t length);
+        bool partialFileMatches(const std::string &remoteFilePath, const std::string &localFilePath, std::uint64_t length);
         // Data channel I/O
-        void transferOnDataChannel(const std::string &file, DataTransferType transferType);
+        void transferOnDataChannel(const std::string &file, DataTransferType transferType, std::uint64_t offset = 0);
         void transferOnDataChannel(std::string &commandRespnse);
-        void transferOnDataChannel(const std::string &file, std::string &commandRespnse, DataTransferType transferType);
+        void transferOnDataChannel(const std::string &file, std::string &commandRespnse, DataTransferType transferType, std::uint64_t offset = 0);
         void downloadCommandResponse(std::string &commandResponse);
-        void downloadFile(const std::string &file);
-        void uploadFile(const std::string &file);
+        void downloadFile(const std::string &file, std::uint64_t offset);
+        bool downloadSegment(int localFile, std::uint64_t offset, std::uint64_t length, std::uint64_t &bytesTransferred);
+        void transferSegmentOnDataChannel(int localFile, std::uint64_t offset, std::uint64_t length, std::uint64_t &bytesTransferred);
+        void uploadFile(const std::string &file, std::uint64_t offset);
         // PORT/PASV related methods
         void extractPassiveAddressPort(std::string &pasvResponse);
         std::string createPortCommand();
+        // Asynchronous command start/step/completion
+        void asyncStart(AsyncHandler handler);
+        void asyncStep(const AsyncStep &step);
+        void asyncComplete(std::exception_ptr commandException);
+        static void asyncCheck(const boost::system::error_code &error);
+        // Asynchronous command channel I/O, login
+        void asyncFtpCommand(const std::string &commandLine, AsyncStep next);
+        void asyncFtpResponse(AsyncStep next);
+        void asyncFtpExtendedResponse(const std::string &lastLineStart, AsyncStep next);
+        void asyncFtpResponseLine(std::function<void(std::size_t)> next);
+        void asyncSecureConnection(void);
+        void asyncLogin(void);
+        // Asynchronous data channel I/O
+        void asyncSendTransferMode(std::function<void(bool)> next);
+        void asyncTransferOnDataChannel(const std::string &commandLine, std::function<void(AsyncStep)> transfer);
+        void asyncDownloadFile(std::shared_ptr<std::ofstream> localFile, AsyncStep next);
+        void asyncUploadFile(std::shared_ptr<std::ifstream> localFile, AsyncStep next);
+        void asyncDownloadCommandResponse(std::string &commandResponse, AsyncStep next);
         // =================
         // PRIVATE VARIABLES
         // =================
@@ -226,6 +341,9 @@ namespace Antik::FTP
         Antik::Network::CSocket m_dataChannelSocket;
         bool m_sslEnabled{false};
         std::vector<std::string> m_serverFeatures;
+        std::string m_controlBuffer;                 // Control channel bytes read but not yet parsed
+        std::size_t m_controlBufferPosition{0};      // Start of unparsed bytes in control buffer
+        AsyncHandler m_asyncHandler{nullptr};        // Handler of asynchronous command in progress
     };
 } // namespace Antik::FTP
 #endif /* CFTP_HPP */
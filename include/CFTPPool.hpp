@@ -0,0 +1,147 @@
+#ifndef CFTPPOOL_HPP
+#define CFTPPOOL_HPP
+//
+// C++ STL
+//
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+//
+// Antik classes
+//
+#include "CommonAntik.hpp"
+#include "CFTP.hpp"
+// =========
+// NAMESPACE
+// =========
+namespace Antik::FTP
+{
+    // ================
+    // CLASS DEFINITION
+    // ================
+    class CFTPPool
+    {
+    public:
+        // ==========================
+        // PUBLIC TYPES AND CONSTANTS
+        // ==========================
+        using Clock = std::chrono::steady_clock;
+        //
+        // Class exception
+        //
+        struct Exception : public std::runtime_error
+        {
+            Exception(std::string const &message)
+                : std::runtime_error("CFTPPool Failure: " + message)
+            {
+            }
+        };
+        //
+        // Pool options
+        //
+        struct Options
+        {
+            std::size_t maxSessions{4};                 // Most sessions open at once
+            std::chrono::milliseconds keepAlive{30000}; // Idle time before a session is sent a NOOP (0 = never)
+            std::chrono::milliseconds maxIdle{0};       // Idle time before a session is closed (0 = never)
+            bool validateOnCheckout{true};              // Check idle session alive (and back in home directory) on checkout
+            bool binaryTransfer{false};                 // Session transfer type (== true binary otherwise ASCII)
+        };
+        //
+        // Checked out session; returned to the pool when destroyed
+        //
+        class Session
+        {
+        public:
+            Session() = default;
+            Session(Session &&other) noexcept;
+            Session &operator=(Session &&other) noexcept;
+            ~Session();
+            CFTP *operator->() const;
+            CFTP &operator*() const;
+            explicit operator bool() const;
+            void discard(); // Close session instead of returning it to the pool (eg. after a failure)
+            void release(); // Return session to the pool now
+        private:
+            friend class CFTPPool;
+            Session(CFTPPool *pool, std::unique_ptr<CFTP> ftpServer);
+            Session(const Session &orig) = delete;
+            Session &operator=(const Session &other) = delete;
+            CFTPPool *m_pool{nullptr};         // Pool session checked out from
+            std::unique_ptr<CFTP> m_ftpServer; // Connected session
+            bool m_discard{false};             // == true close session on release
+        };
+        // ============
+        // CONSTRUCTORS
+        // ============
+        //
+        // Main constructor
+        //
+        explicit CFTPPool(const CFTP &ftpServer);
+        CFTPPool(const CFTP &ftpServer, const Options &options);
+        // ==========
+        // DESTRUCTOR
+        // ==========
+        virtual ~CFTPPool();
+        // ==============
+        // PUBLIC METHODS
+        // ==============
+        Session checkout(void);                      // Check out a connected, logged in session (waits if pool at maximum)
+        void closeIdleSessions(void);                // Close all idle sessions
+        std::size_t getSessionCount(void) const;     // Sessions open (idle and checked out)
+        std::size_t getIdleSessionCount(void) const; // Sessions idle in pool
+        std::size_t getReconnectCount(void) const;   // Dropped sessions reconnected
+        // ================
+        // PUBLIC VARIABLES
+        // ================
+    private:
+        // ===========================
+        // PRIVATE TYPES AND CONSTANTS
+        // ===========================
+        //
+        // Session waiting in pool
+        //
+        struct IdleSession
+        {
+            std::unique_ptr<CFTP> ftpServer; // Connected session
+            Clock::time_point lastUsed;      // Time session returned to pool
+            Clock::time_point lastActive;    // Time of last command (checkout or keepalive)
+        };
+        // ===========================================
+        // DISABLED CONSTRUCTORS/DESTRUCTORS/OPERATORS
+        // ===========================================
+        CFTPPool(const CFTPPool &orig) = delete;
+        CFTPPool(const CFTPPool &&orig) = delete;
+        CFTPPool &operator=(CFTPPool other) = delete;
+        // ===============
+        // PRIVATE METHODS
+        // ===============
+        std::unique_ptr<CFTP> openSession(void);                     // Connect and login a new session
+        std::unique_ptr<CFTP> reopenSession(void);                   // Replace a dropped session (closed if reconnect fails)
+        bool validSession(CFTP &ftpServer);                          // Session alive and reset for reuse
+        void checkin(std::unique_ptr<CFTP> ftpServer, bool discard); // Return session to pool
+        void sessionClosed(void);                                    // Forget a session closed
+        void keepAlive(void);                                        // Keepalive/idle timeout loop
+        std::chrono::milliseconds keepAliveTick(void) const;         // Time between keepalive checks
+        // =================
+        // PRIVATE VARIABLES
+        // =================
+        CFTP m_settings;                                // Server, account and transfer settings for sessions
+        Options m_options;                              // Pool options
+        std::string m_homeDirectory;                    // Working directory after login
+        std::vector<IdleSession> m_idleSessions;        // Idle sessions (most recently used last)
+        std::size_t m_sessionCount{0};                  // Sessions open (idle and checked out)
+        std::size_t m_reconnectCount{0};                // Dropped sessions reconnected
+        bool m_running{true};                           // == false stop keepalive thread
+        std::unique_ptr<std::thread> m_keepAliveThread; // Keepalive thread
+        mutable std::mutex m_poolMutex;                 // Pool mutex
+        std::condition_variable m_sessionAvailable;     // Session returned/closed conditional
+        std::condition_variable m_keepAliveWaiting;     // Keepalive thread wait conditional
+    };
+} // namespace Antik::FTP
+#endif /* CFTPPOOL_HPP */
@@ -0,0 +1,178 @@
+#ifndef CMETRICS_HPP
+#define CMETRICS_HPP
+//
+// C++ STL
+//
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <memory>
+// =========
+// NAMESPACE
+// =========
+namespace Antik::File
+{
+    // ================
+    // CLASS DEFINITION
+    // ================
+    class CMetrics
+    {
+    public:
+        // ==========================
+        // PUBLIC TYPES AND CONSTANTS
+        // ==========================
+        //
+        // Monotonic counter
+        //
+        class Counter
+        {
+        public:
+            void add(std::uint64_t count = 1) noexcept // Add to counter
+            {
+                m_value.fetch_add(count, std::memory_order_relaxed);
+            }
+            std::uint64_t value(void) const noexcept // Current value
+            {
+                return (m_value.load(std::memory_order_relaxed));
+            }
+
+        private:
+            std::atomic<std::uint64_t> m_value{0}; // Counter value
+        };
+        //
+        // Gauge (with high water mark)
+        //
+        class Gauge
+        {
+        public:
+            void set(std::int64_t value) noexcept; // Set gauge value
+            void add(std::int64_t delta) noexcept; // Add to (subtract from) gauge value
+            std::int64_t value(void) const noexcept // Current value
+            {
+                return (m_value.load(std::memory_order_relaxed));
+            }
+            std::int64_t maximum(void) const noexcept // Highest value seen
+            {
+                return (m_maximum.load(std::memory_order_relaxed));
+            }
+
+        private:
+            void updateMaximum(std::int64_t value) noexcept;
+            std::atomic<std::int64_t> m_value{0};   // Gauge value
+            std::atomic<std::int64_t> m_maximum{0}; // Highest value seen
+        };
+        //
+        // Histogram of unsigned values in log-linear buckets (HDR style); values
+        // are recorded to within 1/kSubBuckets of their true value.
+        //
+        class Histogram
+        {
+        public:
+            static constexpr int kSubBucketBits{5};                                     // Sub-bucket bits (precision)
+            static constexpr std::size_t kSubBuckets{1 << kSubBucketBits};              // Sub-buckets per power of 2
+            static constexpr std::size_t kBuckets{(65 - kSubBucketBits) * kSubBuckets}; // Total buckets
+            static std::size_t bucketIndex(std::uint64_t value) noexcept;               // Bucket for value
+            static std::uint64_t bucketHighest(std::size_t index) noexcept;             // Highest value in bucket
+            void record(std::uint64_t value) noexcept;                                  // Record a value
+            std::uint64_t bucketCount(std::size_t index) const noexcept // Values recorded in bucket
+            {
+                return (m_buckets[index].load(std::memory_order_relaxed));
+            }
+            std::uint64_t sum(void) const noexcept // Sum of recorded values
+            {
+                return (m_sum.load(std::memory_order_relaxed));
+            }
+            std::uint64_t maximum(void) const noexcept // Largest recorded value
+            {
+                return (m_maximum.load(std::memory_order_relaxed));
+            }
+
+        private:
+            std::atomic<std::uint64_t> m_buckets[kBuckets]{}; // Bucket counts
+            std::atomic<std::uint64_t> m_sum{0};              // Sum of recorded values
+            std::atomic<std::uint64_t> m_maximum{0};          // Largest recorded value
+        };
+        //
+        // Point in time copy of metrics (names prefixed by any source prefix)
+        //
+        struct HistogramSnapshot
+        {
+            std::uint64_t count{0};   // Values recorded
+            std::uint64_t sum{0};     // Sum of values
+            std::uint64_t maximum{0}; // Largest value
+            std::uint64_t p50{0};     // 50th percentile
+            std::uint64_t p90{0};     // 90th percentile
+            std::uint64_t p99{0};     // 99th percentile
+            std::uint64_t p999{0};    // 99.9th percentile
+        };
+        struct GaugeSnapshot
+        {
+            std::int64_t value{0};   // Gauge value
+            std::int64_t maximum{0}; // Highest value seen
+        };
+        struct Snapshot
+        {
+            std::map<std::string, std::uint64_t> counters;       // Counter values
+            std::map<std::string, GaugeSnapshot> gauges;         // Gauge values
+            std::map<std::string, HistogramSnapshot> histograms; // Histogram summaries
+        };
+        // ============
+        // CONSTRUCTORS
+        // ============
+        CMetrics();
+        // ==========
+        // DESTRUCTOR
+        // ==========
+        virtual ~CMetrics();
+        // ==============
+        // PUBLIC METHODS
+        // ==============
+        //
+        // Metric registration (returned references remain valid for the lifetime of the
+        // metrics object; registering an existing name returns the existing metric).
+        //
+        Counter &counter(const std::string &name);
+        Gauge &gauge(const std::string &name);
+        Histogram &histogram(const std::string &name);
+        //
+        // Include the metrics of another object (names prefixed with "prefix.")
+        //
+        void addSource(const std::string &prefix, std::shared_ptr<CMetrics> source);
+        //
+        // Snapshot / export
+        //
+        Snapshot snapshot(void) const;
+        std::string exportText(void) const;
+        std::string exportJSON(void) const;
+        // ================
+        // PUBLIC VARIABLES
+        // ================
+    private:
+        // ===========================
+        // PRIVATE TYPES AND CONSTANTS
+        // ===========================
+        // ===========================================
+        // DISABLED CONSTRUCTORS/DESTRUCTORS/OPERATORS
+        // ===========================================
+        CMetrics(const CMetrics &orig) = delete;
+        CMetrics(const CMetrics &&orig) = delete;
+        CMetrics &operator=(CMetrics other) = delete;
+        // ===============
+        // PRIVATE METHODS
+        // ===============
+        void snapshot(const std::string &prefix, Snapshot &metricsSnapshot) const;
+        static std::uint64_t percentile(const std::vector<std::uint64_t> &bucketCounts, std::uint64_t count, std::uint64_t maximum, double percent);
+        // =================
+        // PRIVATE VARIABLES
+        // =================
+        mutable std::mutex m_metricsMutex;                                        // Registration mutex
+        std::map<std::string, std::unique_ptr<Counter>> m_counters;               // Counters
+        std::map<std::string, std::unique_ptr<Gauge>> m_gauges;                   // Gauges
+        std::map<std::string, std::unique_ptr<Histogram>> m_histograms;           // Histograms
+        std::vector<std::pair<std::string, std::shared_ptr<CMetrics>>> m_sources; // Included metrics
+    };
+} // namespace Antik::File
+#endif /* CMETRICS_HPP */
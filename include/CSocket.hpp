@@ -5,9 +5,10 @@
 //
 #include <string>
 #include <stdexcept>
-#include <thread>
 #include <memory>
 #include <mutex>
+#include <chrono>
+#include <functional>
 //
 // Antik classes
 //
@@ -50,16 +51,30 @@ namespace Antik::Network
             v1_1,
             v1_2
         };
+        //
+        // Asynchronous completion handlers (passed error and bytes read/written)
+        //
+        using AsyncHandler = std::function<void(const boost::system::error_code &)>;
+        using AsyncIOHandler = std::function<void(const boost::system::error_code &, std::size_t)>;
         // ============
         // CONSTRUCTORS
         // ============
         //
         // Main constructor
         //
-        CSocket()
+        CSocket() : m_ownIoService{std::make_unique<boost::asio::io_service>()}, m_ioService{*m_ownIoService}
+        {
+            // Default SSL context use TLS v1.2
+            m_sslContext = sharedSslContext(TLSVerion::v1_2);
+        }
+        //
+        // Socket using an io service shared with others (run by the caller's threads
+        // for asynchronous I/O)
+        //
+        explicit CSocket(boost::asio::io_service &ioService) : m_ioService{ioService}
         {
             // Default SSL context use TLS v1.2
-            m_sslContext = std::make_unique<boost::asio::ssl::context>(boost::asio::ssl::context::tlsv12);
+            m_sslContext = sharedSslContext(TLSVerion::v1_2);
         }
         // ==========
         // DESTRUCTOR
@@ -74,16 +89,33 @@ namespace Antik::Network
         static std::string localIPAddress();
         // Set TLS version to use
         void setTLSVersion(TLSVerion version);
+        // SSL context shared by all sockets using a TLS version, set socket SSL context
+        static std::shared_ptr<boost::asio::ssl::context> sharedSslContext(TLSVerion version);
+        void setSslContext(std::shared_ptr<boost::asio::ssl::context> sslContext);
+        // TLS session of connection, session to resume on next handshake, was session resumed
+        std::shared_ptr<SSL_SESSION> getTlsSession() const;
+        void setTlsSession(std::shared_ptr<SSL_SESSION> tlsSession);
+        bool isTlsSessionReused() const;
         // Socket IO methods connect, read/write and close
         void connect();
         size_t read(char *readBuffer, size_t bufferLength);
         size_t write(const char *writeBuffer, size_t writeLength);
         void close();
+        void abort();
         // Socket TLS handshake
         void tlsHandshake();
+        // Asynchronous connect, read/write (whole buffer), TLS handshake, wait for connection
+        // when listening and close; handlers are run by the io service
+        void asyncConnect(AsyncHandler handler);
+        void asyncRead(char *readBuffer, size_t bufferLength, AsyncIOHandler handler);
+        void asyncWrite(const char *writeBuffer, size_t writeLength, AsyncIOHandler handler);
+        void asyncTlsHandshake(AsyncHandler handler);
+        void asyncWaitUntilConnected(AsyncHandler handler);
+        void asyncClose(AsyncHandler handler);
+        boost::asio::io_service &getIoService();
         // Socket closed by remote peer
         bool closedByRemotePeer();
-        // Listen and wait for remote connections
+        // Listen and wait (up to listen timeout) for remote connections
         void listenForConnection();
         void waitUntilConnected();
         // Socket cleanup
@@ -95,6 +127,8 @@ namespace Antik::Network
         std::string getHostAddress() const;
         void setHostPort(std::string hostPort);
         std::string getHostPort() const;
+        void setListenTimeout(std::chrono::milliseconds listenTimeout);
+        std::chrono::milliseconds getListenTimeout() const;
         // ================
         // PUBLIC VARIABLES
         // ================
@@ -112,8 +146,8 @@ namespace Antik::Network
         // ===============
         // PRIVATE METHODS
         // ===============
-        // Listen on a thread for a connection
-        void connectionListener();
+        // Accept connection on listening socket
+        void acceptConnection();
         // =================
         // PRIVATE VARIABLES
         // =================
@@ -123,13 +157,16 @@ namespace Antik::Network
         std::string m_hostAddress;                                        // Host ip address
         std::string m_hostPort;                                           // Host port address
         boost::system::error_code m_socketError;                          // Last socket error
-        boost::asio::io_service m_ioService;                              // io Service
+        std::unique_ptr<boost::asio::io_service> m_ownIoService;          // io Service (if not shared)
+        boost::asio::io_service &m_ioService;                             // io Service
+        boost::asio::io_service::strand m_ioStrand{m_ioService};          // Serialise handlers of concurrent operations
         boost::asio::ip::tcp::resolver m_ioQueryResolver{m_ioService};    // io name resolver
-        std::atomic<bool> m_isListenThreadRunning{false};                 // Listen thread running flag
-        std::unique_ptr<std::thread> m_socketListenThread{nullptr};       // Connection listen thread
-        std::unique_ptr<boost::asio::ssl::context> m_sslContext{nullptr}; // SSL context (initialised in constructor).
+        std::unique_ptr<boost::asio::ip::tcp::acceptor> m_acceptor;       // Listening socket (connection not yet accepted)
+        std::chrono::milliseconds m_listenTimeout{60000};                 // Time to wait for a connection when listening
+        std::shared_ptr<boost::asio::ssl::context> m_sslContext{nullptr}; // SSL context (initialised in constructor).
+        std::shared_ptr<SSL_SESSION> m_tlsSession{nullptr};               // TLS session to resume on handshake
+        bool m_tlsSessionReused{false};                                   // == true last handshake resumed session
         std::unique_ptr<SSLSocket> m_socket{nullptr};                     // SSL socket allocated at run time
-        std::exception_ptr m_thrownException{nullptr};                    // Pointer to any exception thrown in connectionListener
     };
     //
     // Return true if socket closed by server otherwise false.
@@ -7,16 +7,30 @@
 #include <thread>
 #include <stdexcept>
 #include <memory>
+#include <chrono>
+#include <unordered_set>
+#include <vector>
+#include <atomic>
 //
 // Antik classes
 //
 #include "CommonAntik.hpp"
 #include "CApprise.hpp"
+#include "IDispatchPolicy.hpp"
 // =========
 // NAMESPACE
 // =========
 namespace Antik::File
 {
+    // ====================
+    // FORWARD DECLARATIONS
+    // ====================
+    class CTaskJournal;
+    class CFileStabilizer;
+    class CDispatchQueue;
+    class CTokenBucket;
+    class CConcurrencyLimiter;
+    class CRetryQueue;
     // ================
     // CLASS DEFINITION
     // ================
@@ -46,6 +60,45 @@ namespace Antik::File
             virtual bool process(const std::string &file) = 0;
             virtual void term(void) = 0;
         };
+        //
+        // Batch action interface class; files are passed to processBatch() in batches
+        // (see Options batchSize/batchDelay) so that per-call costs are shared.
+        //
+        class IBatchAction : public IAction
+        {
+        public:
+            virtual bool processBatch(const std::vector<std::string> &files) = 0;
+            bool process(const std::string &file) override
+            {
+                return (processBatch({file}));
+            }
+        };
+        //
+        // Task options
+        //
+        struct Options
+        {
+            std::string journalFolder;                            // Journal folder ("" = no journal)
+            std::size_t journalSegmentSize{4 * 1024 * 1024};      // Journal segment file size
+            std::chrono::milliseconds journalCommitInterval{100}; // Maximum time before journal records committed
+            std::size_t journalCommitBatch{256};                  // Journal records that trigger a commit
+            std::chrono::milliseconds stabilityPeriod{0};         // Quiet period before added file processed (0 = process on add)
+            bool stabilityCheckStatus{true};                      // File size/modification time unchanged over quiet period
+            int actionWorkers{0};                                 // Action worker threads (0 = process files in monitor loop)
+            std::shared_ptr<IDispatchPolicy> dispatchPolicy;      // Order files dispatched to workers (nullptr = FIFO)
+            std::size_t batchSize{0};                             // Files per processBatch() for an IBatchAction (0 = no batching)
+            std::chrono::milliseconds batchDelay{1000};           // Longest a file waits for its batch to fill
+            double actionRate{0.0};                               // Files processed per second (0 = no limit)
+            std::size_t actionBurst{1};                           // Files processed ahead of action rate after being idle
+            bool adaptiveConcurrency{false};                      // Adapt workers processing at once to action latency/failures
+            std::size_t maxQueuedFiles{0};                        // Files queued for workers before monitor loop waits (0 = unbounded)
+            std::size_t maxQueuedEvents{0};                       // Watcher events queued before event generation waits (0 = unbounded)
+            std::size_t watchShards{1};                           // inotify instances watch folder split between (by top-level directory)
+            int maxAttempts{1};                                   // Attempts at processing a file before it fails for good (1 = no retries)
+            std::chrono::milliseconds retryDelay{100};            // Backoff before first retry of a failed file (doubled for each further retry)
+            std::chrono::milliseconds maxRetryDelay{30000};       // Longest backoff before a retry
+            std::string deadLetterFolder;                         // Folder files that fail for good are moved to ("" = left in place)
+        };
         // ===========
         // CONSTRUCTOR
         // ===========
@@ -53,10 +106,11 @@ namespace Antik::File
         // Main constructor
         //
         explicit CTask(
-            const std::string &watchFolder,  // Watch folder path
-            std::shared_ptr<IAction> action, // Task action function
-            int watchDepth,                  // Watch depth -1= all, 0=just watch folder
-            int killCount                    // Kill count
+            const std::string &watchFolder,            // Watch folder path
+            std::shared_ptr<IAction> action,           // Task action function
+            int watchDepth,                            // Watch depth -1= all, 0=just watch folder
+            int killCount,                             // Kill count
+            std::shared_ptr<Options> options = nullptr // Task options (nullptr = defaults)
         );
         // ==========
         // DESTRUCTOR
@@ -74,10 +128,19 @@ namespace Antik::File
         // Private data accessors
         //
         std::exception_ptr getThrownException(void); // Get any exception thrown by task to pass down chain
+        std::shared_ptr<CMetrics> getMetrics(void);  // Get task metrics (including those of its watcher)
     private:
         // ===========================
         // PRIVATE TYPES AND CONSTANTS
         // ===========================
+        //
+        // Threads used to read directories when reconciling journal
+        //
+        static const int kReconcileThreads;
+        //
+        // Times file events generated for the files of a batch
+        //
+        using ReceivedTimes = std::vector<std::chrono::steady_clock::time_point>;
         // ===========================================
         // DISABLED CONSTRUCTORS/DESTRUCTORS/OPERATORS
         // ===========================================
@@ -88,6 +151,25 @@ namespace Antik::File
         // ===============
         // PRIVATE METHODS
         // ===============
+        static std::int64_t statusChanged(const std::string &filePath);                                 // File status change time (0 if unknown)
+        void journalReceived(const std::string &filePath);                                              // Journal file as received
+        bool processFile(const std::string &filePath);                                                  // Process file (true when kill count reached)
+        bool resumeJournal(std::int64_t watchTime);                                                     // Process files outstanding/missed in journal
+        bool resumeFile(const std::string &filePath);                                                   // Pass on file resumed from journal
+        bool processStableFiles(void);                                                                  // Process files stable at end of quiet period
+        bool dispatchFile(const std::string &filePath, std::chrono::steady_clock::time_point received); // Process file or queue it for action workers
+        void startWorkers(void);                                                                        // Create dispatch queue and start action workers
+        void stopWorkers(void);                                                                         // Close dispatch queue and wait for action workers
+        void actionWorker(std::size_t workerNo);                                                        // Process files from dispatch queue
+        bool processBatch(const std::vector<std::string> &filePaths, const ReceivedTimes &received);    // Process batch of files (true when kill count reached)
+        bool batchFile(const std::string &filePath, std::chrono::steady_clock::time_point received);    // Add file to batch; processing it when full
+        bool flushBatch(void);                                                                          // Process files in batch
+        std::size_t batchLimit(void);                                                                   // Files in a full batch
+        void actionCompleted(std::chrono::microseconds duration, bool processed);                       // Record action call result (adapting concurrency limit)
+        bool completeFile(const std::string &filePath, bool processed);                                 // Complete file or schedule its retry (true if completed)
+        bool countCompleted(int files);                                                                 // Count files completed against kill count (true when reached)
+        void deadLetterFile(const std::string &filePath);                                               // Move file that failed for good to dead-letter folder
+        bool processRetries(void);                                                                      // Dispatch files whose retry is due
         // =================
         // PRIVATE VARIABLES
         // =================
@@ -96,12 +178,63 @@ namespace Antik::File
         //
         std::string m_watchFolder;             // Watch Folder
         std::shared_ptr<IAction> m_taskAction; // Task action function
-        int m_killCount{0};                    // Task Kill Count
+        int m_watchDepth{-1};                  // Watch depth
+        std::atomic<int> m_killCount{0};       // Task Kill Count
+        Options m_options;                     // Task options
+        //
+        // Task journal
+        //
+        std::unique_ptr<CTaskJournal> m_journal;                // Journal (nullptr if not enabled)
+        std::unordered_set<std::string> m_resumed;              // Files passed on at resume (skip their live add event)
+        std::chrono::steady_clock::time_point m_resumeFinished; // Time resume finished (later add events not skipped)
+        //
+        // File stabilization
+        //
+        std::unique_ptr<CFileStabilizer> m_stabilizer; // Stabilizer (nullptr if not enabled)
+        //
+        // Action workers
+        //
+        std::unique_ptr<CDispatchQueue> m_dispatchQueue;    // Dispatch queue (nullptr if no workers)
+        std::vector<std::thread> m_workers;                 // Action worker threads
+        std::vector<std::exception_ptr> m_workerExceptions; // Exception thrown in each worker
+        //
+        // Batching (monitor loop)
+        //
+        std::shared_ptr<IBatchAction> m_batchAction;          // Batch action (nullptr if not batching)
+        std::vector<std::string> m_batchFiles;                // Files in batch
+        ReceivedTimes m_batchReceived;                        // Time file events generated
+        std::chrono::steady_clock::time_point m_batchStarted; // Time first file added to batch
+        //
+        // Action rate and concurrency limits
+        //
+        std::unique_ptr<CTokenBucket> m_rateLimiter;               // Action rate limit (nullptr if not limited)
+        std::unique_ptr<CConcurrencyLimiter> m_concurrencyLimiter; // Adaptive worker limit (nullptr if not enabled)
+        //
+        // Failed file retries
+        //
+        std::unique_ptr<CRetryQueue> m_retryQueue; // Retry queue (nullptr if failures not handled)
         //
         // CFileApprise file watcher
         //
         std::shared_ptr<CApprise> m_watcher; // Folder watcher
         //
+        // Metrics
+        //
+        std::shared_ptr<CMetrics> m_metrics;             // Task metrics
+        CMetrics::Counter *m_filesProcessed{nullptr};    // Files processed
+        CMetrics::Counter *m_filesResumed{nullptr};      // Files processed from journal on restart
+        CMetrics::Histogram *m_processLatency{nullptr};  // Time from event generated to process start (us)
+        CMetrics::Histogram *m_actionDuration{nullptr};  // Action process() duration (us)
+        CMetrics::Gauge *m_filesStabilizing{nullptr};    // Files waiting for quiet period to end
+        CMetrics::Counter *m_stabilityRestarts{nullptr}; // Quiet periods restarted by file events/changes
+        CMetrics::Gauge *m_dispatchQueueDepth{nullptr};  // Files queued for action workers
+        CMetrics::Histogram *m_batchSize{nullptr};       // Files per processBatch() call
+        CMetrics::Counter *m_actionFailures{nullptr};    // Action calls returning false
+        CMetrics::Gauge *m_concurrencyLimit{nullptr};    // Workers allowed to process files at once
+        CMetrics::Counter *m_actionRetries{nullptr};     // Failed files scheduled for retry
+        CMetrics::Counter *m_filesFailed{nullptr};       // Files failed for good (all attempts)
+        CMetrics::Counter *m_filesDeadLettered{nullptr}; // Failed files moved to dead-letter folder
+        //
         // Publicly accessed via accessors
         //
         std::exception_ptr m_thrownException{nullptr}; // Pointer to any exception thrown
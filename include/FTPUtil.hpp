@@ -18,9 +18,24 @@
 #include "CFTP.hpp"
 namespace Antik::FTP
 {
+    //
+    // Part of a file being downloaded in segments.
+    //
+    struct FileSegment
+    {
+        std::uint64_t offset{0};      // Offset of segment in file
+        std::uint64_t length{0};      // Segment length
+        std::uint64_t transferred{0}; // Bytes of segment written so far
+        int attempts{0};              // Failed attempts at segment
+    };
     void makeRemotePath(CFTP &ftpServer, const std::string &remotePath, bool saveCWD = true);
     void listRemoteRecursive(CFTP &ftpServer, const std::string &remoteDirecory, FileList &fileList, FileFeedBackFn remoteFileFeedbackFn = nullptr);
-    FileList getFiles(CFTP &ftpServer, const std::string &localDirectory, const FileList &fileList, FileCompletionFn completionFn = nullptr, bool safe = false, char postFix = '~');
-    FileList putFiles(CFTP &ftpServer, const std::string &localDirectory, const FileList &fileList, FileCompletionFn completionFn = nullptr, bool safe = false, char postFix = '~');
+    FileList getFiles(CFTP &ftpServer, const std::string &localDirectory, const FileList &fileList, FileCompletionFn completionFn = nullptr, bool safe = false, char postFix = '~', bool resume = false);
+    FileList putFiles(CFTP &ftpServer, const std::string &localDirectory, const FileList &fileList, FileCompletionFn completionFn = nullptr, bool safe = false, char postFix = '~', bool resume = false);
+    FileList getFilesParallel(CFTP &ftpServer, std::size_t connections, const std::string &localDirectory, const FileList &fileList, FileCompletionFn completionFn = nullptr, bool safe = false, char postFix = '~', bool resume = false);
+    FileList putFilesParallel(CFTP &ftpServer, std::size_t connections, const std::string &localDirectory, const FileList &fileList, FileCompletionFn completionFn = nullptr, bool safe = false, char postFix = '~', bool resume = false);
+    std::uint16_t getFileSegmented(CFTP &ftpServer, std::size_t connections, const std::string &remoteFilePath, const std::string &localFilePath);
+    void saveSegments(const std::string &progressFile, std::uint64_t fileSize, const std::string &fileVersion, const std::vector<FileSegment> &segments);
+    bool loadSegments(const std::string &progressFile, std::uint64_t fileSize, const std::string &fileVersion, std::vector<FileSegment> &segments);
 } // namespace Antik::FTP
 #endif /* FTPUTIL_HPP */
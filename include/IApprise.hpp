@@ -5,6 +5,12 @@
 //
 #include <stdexcept>
 #include <string>
+#include <chrono>
+#include <memory>
+//
+// Antik classes
+//
+#include "CMetrics.hpp"
 // =========
 // NAMESPACE
 // =========
@@ -37,18 +43,20 @@ namespace Antik::File
             Event_unlink,    // File deleted from watched folder hierarchy
             Event_addir,     // Directory added to watched folder hierarchy
             Event_unlinkdir, // Directory deleted from watched folder hierarchy
-            Event_error      // Exception error
+            Event_error,     // Exception error
+            Event_overflow   // Event queue overflowed (events may have been lost)
         };
         //
         // CApprise event structure
         //
         struct Event
         {
-            explicit Event(EventId id = EventId::Event_none, std::string message = "") : id{id}, message{message}
+            explicit Event(EventId id = EventId::Event_none, std::string message = "") : id{id}, message{message}, time{std::chrono::steady_clock::now()}
             {
             }
-            EventId id;          // Event id
-            std::string message; // Event file name / error message string
+            EventId id;                                 // Event id
+            std::string message;                        // Event file name / error message string
+            std::chrono::steady_clock::time_point time; // Time event generated
         };
         //
         // Event control
@@ -57,6 +65,7 @@ namespace Antik::File
         virtual void stopWatching(void) = 0;
         virtual bool stillWatching(void) = 0;
         virtual void getNextEvent(IApprise::Event &message) = 0;
+        virtual void getNextEvent(IApprise::Event &message, std::chrono::milliseconds timeout) = 0;
         //
         // Watch handling
         //
@@ -66,6 +75,10 @@ namespace Antik::File
         // Get any thrown exceptions
         //
         virtual std::exception_ptr getThrownException(void) = 0; // Get any exception thrown by watcher to pass down chain
+        //
+        // Get watcher metrics
+        //
+        virtual std::shared_ptr<CMetrics> getMetrics(void) = 0;
     };
 } // namespace Antik::File
 #endif /* IAPPRISE_HPP */
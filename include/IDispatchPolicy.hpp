@@ -0,0 +1,46 @@
+#ifndef IDISPATCHPOLICY_HPP
+#define IDISPATCHPOLICY_HPP
+//
+// C++ STL
+//
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include <tuple>
+// =========
+// NAMESPACE
+// =========
+namespace Antik::File
+{
+    //
+    // Task dispatch policy interface; ranks files queued for the task action workers
+    // (lowest rank dispatched first, files of equal rank in the order queued). Both
+    // methods are called with the dispatch queue locked.
+    //
+    class IDispatchPolicy
+    {
+    public:
+        //
+        // Dispatch rank
+        //
+        struct Rank
+        {
+            std::int64_t primary{0};   // Primary rank
+            std::int64_t secondary{0}; // Rank within primary
+            bool operator<(const Rank &other) const
+            {
+                return (std::tie(primary, secondary) < std::tie(other.primary, other.secondary));
+            }
+        };
+        //
+        // Rank file when queued / file with rank dispatched to a worker
+        //
+        virtual Rank rank(const std::string &filePath, std::chrono::steady_clock::time_point received) = 0;
+        virtual void dispatched(const std::string &filePath, const Rank &rank) = 0;
+        //
+        // Destructor
+        //
+        virtual ~IDispatchPolicy(){};
+    };
+} // namespace Antik::File
+#endif /* IDISPATCHPOLICY_HPP */
@@ -0,0 +1,545 @@
+/*
+ * File:   BMCApprise.cpp
+ *
+ * Author: Robert Tizzard
+ *
+ * Created on October 18, 2026, 11:05 AM
+ *
+ * Copyright 2021.
+ *
+ */
+//
+// Program: BMCApprise
+//
+// Description: Benchmark the file watcher (CApprise) or the full task pipeline (CTask)
+// with a synthetic file storm. A number of writer threads create files at a target
+// rate spread over a fan-out of sub-directories of the watch folder; a percentage of
+// the files are written in a staging folder and then renamed into place. Each add
+// event received is matched to the file it is for and the time from the file being
+// closed/renamed to the event being received recorded. At the end the event rate,
+// end-to-end latency percentiles and the number of missed and duplicate events are
+// reported (and optionally the watcher/task metrics).
+//
+// Dependencies: C20++, Classes (CApprise, CTask, CMetrics, CFile).
+//               Linux, Boost C++ Libraries.
+//
+// BMCApprise
+// Program Options:
+//   --help                   Print help messages
+//   -w [ --watch ] arg       Watch folder (created and emptied)
+//   -n [ --writers ] arg     Number of writer threads
+//   -f [ --files ] arg       Files created by each writer
+//   -r [ --rate ] arg        Total files per second (0 = as fast as possible)
+//   -d [ --fanout ] arg      Sub-directories files are spread over (0 = watch folder)
+//   -s [ --size ] arg        Minimum file size in bytes
+//   -z [ --maxsize ] arg     Maximum file size in bytes
+//   -m [ --rename ] arg      Percentage of files renamed into place
+//   -p [ --pipeline ] arg    Pipeline to drive (apprise or task)
+//   -k [ --notifier ] arg    File event notifier (inotify, sharded, fanotify or polling; task inotify or sharded)
+//   -g [ --shards ] arg      inotify instances used by the sharded notifier
+//   -c [ --coalesce ] arg    Notifier event coalescing window in milliseconds
+//   -t [ --timeout ] arg     Seconds to wait for outstanding events after last write
+//   -j [ --json ]            Report as JSON
+//   -x [ --metrics ]         Include watcher/task metrics in report
+// =============
+// INCLUDE FILES
+// =============
+//
+// C++ STL
+//
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <random>
+#include <filesystem>
+//
+// Antik Classes
+//
+#include "CApprise.hpp"
+#include "CTask.hpp"
+#include "CMetrics.hpp"
+#include "CFile.hpp"
+#include "CFileEventNotifier.hpp"
+#include "CFanotifyFileEventNotifier.hpp"
+#include "CPollingFileEventNotifier.hpp"
+#include "CShardedFileEventNotifier.hpp"
+using namespace Antik::File;
+//
+// Linux
+//
+#include <fcntl.h>
+#include <unistd.h>
+//
+// Boost program options
+//
+#include <boost/program_options.hpp>
+namespace po = boost::program_options;
+// ======================
+// LOCAL TYES/DEFINITIONS
+// ======================
+// Command line parameter data
+struct ParamArgData
+{
+    std::string watchFolder{"/tmp/watch_benchmark"}; // Watch folder
+    int writers{4};                                  // Writer threads
+    int filesPerWriter{1000};                        // Files created by each writer
+    double filesPerSecond{0};                        // Total file creation rate (0 = unlimited)
+    int fanOut{0};                                   // Sub-directories files spread over
+    std::size_t minimumSize{0};                      // Minimum file size
+    std::size_t maximumSize{0};                      // Maximum file size
+    int renamePercent{0};                            // Percentage of files renamed into place
+    std::string pipeline{"apprise"};                 // Pipeline driven (apprise/task)
+    std::string notifier{"inotify"};                 // File event notifier
+    int shards{4};                                   // Sharded notifier inotify instances
+    int coalesceWindow{0};                           // Coalescing window (milliseconds)
+    int timeout{10};                                 // Seconds to wait for outstanding events
+    bool json{false};                                // Report as JSON
+    bool metrics{false};                             // Include watcher/task metrics
+};
+// Storm state shared between writers and the event consumer
+struct StormState
+{
+    explicit StormState(const ParamArgData &argData)
+        : completed(static_cast<std::size_t>(argData.writers) * argData.filesPerWriter),
+          received(static_cast<std::size_t>(argData.writers) * argData.filesPerWriter)
+    {
+    }
+    std::vector<std::atomic<std::int64_t>> completed;         // Time each file closed/renamed into place (ns)
+    std::vector<std::atomic<std::uint8_t>> received;          // Add event received for file
+    std::atomic<std::uint64_t> uniqueEvents{0};               // Files with an add event
+    std::atomic<std::uint64_t> duplicateEvents{0};            // Repeated add events for a file
+    std::atomic<std::uint64_t> unknownEvents{0};              // Add events for files not in storm
+    std::atomic<std::uint64_t> earlyEvents{0};                // Add events before file closed/renamed
+    std::atomic<std::int64_t> lastEvent{0};                   // Time of last add event (ns)
+    std::atomic<bool> writersDone{false};                     // All files written
+    CMetrics latency;                                         // End-to-end latency (us)
+    std::chrono::steady_clock::time_point start;              // Time storm started
+    std::chrono::steady_clock::time_point writesDone;         // Time last file written
+};
+// Benchmark task action; records each file processed
+class BenchmarkAction : public CTask::IAction
+{
+public:
+    explicit BenchmarkAction(StormState &storm, const std::string &watchFolder) : m_storm{storm}, m_watchFolder{watchFolder}
+    {
+    }
+    void init(void) override{};
+    void term(void) override{};
+    bool process(const std::string &file) override;
+    virtual ~BenchmarkAction(){};
+
+private:
+    StormState &m_storm;       // Storm state
+    std::string m_watchFolder; // Watch folder
+};
+// ===============
+// LOCAL FUNCTIONS
+// ===============
+//
+// Exit with error message/status
+//
+static void exitWithError(std::string errMsg)
+{
+    // Display error and exit.
+    std::cout.flush();
+    std::cerr << errMsg << std::endl;
+    exit(EXIT_FAILURE);
+}
+//
+// Read in and process command line arguments using boost.
+//
+static void procCmdLine(int argc, char **argv, ParamArgData &argData)
+{
+    // Define and parse the program options
+    po::options_description commandLine("Program Options");
+    commandLine.add_options()("help", "Print help messages")("watch,w", po::value<std::string>(&argData.watchFolder), "Watch folder (created and emptied)")("writers,n", po::value<int>(&argData.writers), "Number of writer threads")("files,f", po::value<int>(&argData.filesPerWriter), "Files created by each writer")("rate,r", po::value<double>(&argData.filesPerSecond), "Total files per second (0 = as fast as possible)")("fanout,d", po::value<int>(&argData.fanOut), "Sub-directories files are spread over (0 = watch folder)")("size,s", po::value<std::size_t>(&argData.minimumSize), "Minimum file size in bytes")("maxsize,z", po::value<std::size_t>(&argData.maximumSize), "Maximum file size in bytes")("rename,m", po::value<int>(&argData.renamePercent), "Percentage of files renamed into place")("pipeline,p", po::value<std::string>(&argData.pipeline), "Pipeline to drive (apprise or task)")("notifier,k", po::value<std::string>(&argData.notifier), "File event notifier (inotify, sharded, fanotify or polling; task inotify or sharded)")("shards,g", po::value<int>(&argData.shards), "inotify instances used by the sharded notifier")("coalesce,c", po::value<int>(&argData.coalesceWindow), "Notifier event coalescing window in milliseconds")("timeout,t", po::value<int>(&argData.timeout), "Seconds to wait for outstanding events after last write")("json,j", "Report as JSON")("metrics,x", "Include watcher/task metrics in report");
+    po::variables_map vm;
+    try
+    {
+        // Process arguments
+        po::store(po::parse_command_line(argc, argv, commandLine), vm);
+        // Display options and exit with success
+        if (vm.count("help"))
+        {
+            std::cout << "BMCApprise" << std::endl
+                      << commandLine << std::endl;
+            exit(EXIT_SUCCESS);
+        }
+        po::notify(vm);
+        argData.json = (vm.count("json") != 0);
+        argData.metrics = (vm.count("metrics") != 0);
+        argData.maximumSize = std::max(argData.maximumSize, argData.minimumSize);
+        if ((argData.writers < 1) || (argData.filesPerWriter < 1) || (argData.fanOut < 0) ||
+            (argData.renamePercent < 0) || (argData.renamePercent > 100))
+        {
+            throw po::error("Invalid storm parameters.");
+        }
+        if ((argData.pipeline != "apprise") && (argData.pipeline != "task"))
+        {
+            throw po::error("Pipeline must be apprise or task.");
+        }
+        if ((argData.notifier != "inotify") && (argData.notifier != "sharded") && (argData.notifier != "fanotify") && (argData.notifier != "polling"))
+        {
+            throw po::error("Notifier must be inotify, sharded, fanotify or polling.");
+        }
+        if ((argData.pipeline == "task") && (((argData.notifier != "inotify") && (argData.notifier != "sharded")) || (argData.coalesceWindow != 0)))
+        {
+            throw po::error("Task pipeline notifier must be inotify or sharded (without coalescing).");
+        }
+    }
+    catch (po::error &e)
+    {
+        std::cerr << "BMCApprise Error: " << e.what() << std::endl
+                  << std::endl;
+        std::cerr << commandLine << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+//
+// Current steady clock time in nanoseconds.
+//
+static inline std::int64_t timeNow(void)
+{
+    return (std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+//
+// Directory a file is created in.
+//
+static std::string fileDirectory(const ParamArgData &argData, std::size_t fileNo)
+{
+    if (argData.fanOut == 0)
+    {
+        return (argData.watchFolder);
+    }
+    return (argData.watchFolder + "/dir" + std::to_string(fileNo % argData.fanOut));
+}
+//
+// Record add event for a file (names are "file<number>.dat").
+//
+static void recordAddEvent(StormState &storm, const std::string &filePath)
+{
+    std::size_t namePos{filePath.rfind("/file")};
+    if ((namePos == std::string::npos) || (filePath.compare(filePath.size() - 4, 4, ".dat") != 0))
+    {
+        storm.unknownEvents++;
+        return;
+    }
+    std::size_t fileNo{std::stoull(filePath.substr(namePos + 5))};
+    std::int64_t now{timeNow()};
+    if (fileNo >= storm.received.size())
+    {
+        storm.unknownEvents++;
+        return;
+    }
+    if (storm.received[fileNo].exchange(1) != 0)
+    {
+        storm.duplicateEvents++;
+        return;
+    }
+    std::int64_t completed{storm.completed[fileNo].load(std::memory_order_acquire)};
+    if (completed == 0)
+    {
+        storm.earlyEvents++; // Reported before being closed/renamed (polling)
+    }
+    else
+    {
+        storm.latency.histogram("latency_us").record(static_cast<std::uint64_t>(std::max(now - completed, static_cast<std::int64_t>(0))) / 1000);
+    }
+    storm.lastEvent = now;
+    storm.uniqueEvents++;
+}
+//
+// Task action process; record add event.
+//
+bool BenchmarkAction::process(const std::string &file)
+{
+    recordAddEvent(m_storm, file);
+    return (true);
+}
+//
+// Writer thread; create every writers'th file (starting at writer) at the target rate.
+//
+static void writer(const ParamArgData &argData, StormState &storm, int writerNo)
+{
+    std::mt19937_64 random(writerNo);
+    std::uniform_int_distribution<std::size_t> fileSize(argData.minimumSize, argData.maximumSize);
+    std::vector<char> buffer(std::max(argData.maximumSize, static_cast<std::size_t>(1)), 'X');
+    std::chrono::nanoseconds interval{0};
+    if (argData.filesPerSecond > 0)
+    {
+        interval = std::chrono::nanoseconds(static_cast<std::int64_t>(1e9 * argData.writers / argData.filesPerSecond));
+    }
+    for (int writerFileNo = 0; writerFileNo < argData.filesPerWriter; writerFileNo++)
+    {
+        std::size_t fileNo{static_cast<std::size_t>(writerFileNo) * argData.writers + writerNo};
+        if (interval.count() != 0)
+        {
+            std::this_thread::sleep_until(storm.start + interval * writerFileNo);
+        }
+        std::string fileName{"/file" + std::to_string(fileNo) + ".dat"};
+        std::string filePath{fileDirectory(argData, fileNo) + fileName};
+        bool renamed{static_cast<int>(fileNo % 100) < argData.renamePercent};
+        std::string writePath{renamed ? (argData.watchFolder + "_staging" + fileName) : filePath};
+        int fd{open(writePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)};
+        if (fd == -1)
+        {
+            throw std::system_error(std::error_code(errno, std::system_category()), "open() error");
+        }
+        for (std::size_t written = 0, size = fileSize(random); written < size;)
+        {
+            ssize_t writeLen{write(fd, buffer.data(), std::min(buffer.size(), size - written))};
+            if (writeLen == -1)
+            {
+                close(fd);
+                throw std::system_error(std::error_code(errno, std::system_category()), "write() error");
+            }
+            written += writeLen;
+        }
+        if (renamed)
+        {
+            close(fd);
+            storm.completed[fileNo].store(timeNow(), std::memory_order_release);
+            if (rename(writePath.c_str(), filePath.c_str()) == -1)
+            {
+                throw std::system_error(std::error_code(errno, std::system_category()), "rename() error");
+            }
+        }
+        else
+        {
+            storm.completed[fileNo].store(timeNow(), std::memory_order_release);
+            close(fd);
+        }
+    }
+}
+//
+// Create notifier for benchmark.
+//
+static std::shared_ptr<IFileEventNotifier> createNotifier(const ParamArgData &argData)
+{
+    IFileEventNotifier::Options options;
+    options.coalesceWindow = std::chrono::milliseconds(argData.coalesceWindow);
+    if (argData.notifier == "fanotify")
+    {
+        return (std::make_shared<CFanotifyFileEventNotifier>(options));
+    }
+    if (argData.notifier == "polling")
+    {
+        options.pollInterval = std::chrono::milliseconds(100);
+        return (std::make_shared<CPollingFileEventNotifier>(options));
+    }
+    if (argData.notifier == "sharded")
+    {
+        return (std::make_shared<CShardedFileEventNotifier>(static_cast<std::size_t>(argData.shards), options));
+    }
+    return (std::make_shared<CFileEventNotifier>(options));
+}
+//
+// Create fan-out directories.
+//
+static void createDirectories(const ParamArgData &argData)
+{
+    for (int directoryNo = 0; directoryNo < argData.fanOut; directoryNo++)
+    {
+        CFile::createDirectory(fileDirectory(argData, directoryNo));
+    }
+}
+//
+// Wait for the task watcher to report (and so watch) the fan-out directories created
+// after it (and so only its watch folder) was; bounded by the event timeout.
+//
+static void waitForDirectories(const ParamArgData &argData, const CMetrics &taskMetrics)
+{
+    auto timeout{std::chrono::steady_clock::now() + std::chrono::seconds(argData.timeout)};
+    while ((taskMetrics.snapshot().counters["watcher.notifier.events_queued"] < static_cast<std::uint64_t>(argData.fanOut)) &&
+           (std::chrono::steady_clock::now() < timeout))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // Watch for last directory is added just after its event is queued
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+}
+//
+// Wait for all add events or for the timeout to pass with no events after the last write.
+//
+static void waitForEvents(const ParamArgData &argData, StormState &storm, std::function<void(void)> stop)
+{
+    while (!storm.writersDone || (storm.uniqueEvents < storm.received.size()))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        if (storm.writersDone)
+        {
+            std::int64_t lastActivity{std::max(storm.lastEvent.load(), static_cast<std::int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(storm.writesDone.time_since_epoch()).count()))};
+            if ((timeNow() - lastActivity) > (static_cast<std::int64_t>(argData.timeout) * 1000000000))
+            {
+                break;
+            }
+        }
+    }
+    stop();
+}
+//
+// Run writers to completion.
+//
+static void runWriters(const ParamArgData &argData, StormState &storm)
+{
+    std::vector<std::thread> writers;
+    std::vector<std::exception_ptr> writerExceptions(argData.writers);
+    storm.start = std::chrono::steady_clock::now();
+    for (int writerNo = 0; writerNo < argData.writers; writerNo++)
+    {
+        writers.emplace_back([&, writerNo]() {
+            try
+            {
+                writer(argData, storm, writerNo);
+            }
+            catch (...)
+            {
+                writerExceptions[writerNo] = std::current_exception();
+            }
+        });
+    }
+    for (auto &writerThread : writers)
+    {
+        writerThread.join();
+    }
+    storm.writesDone = std::chrono::steady_clock::now();
+    storm.writersDone = true;
+    for (auto &writerException : writerExceptions)
+    {
+        if (writerException)
+        {
+            std::rethrow_exception(writerException);
+        }
+    }
+}
+//
+// Report benchmark results.
+//
+static void report(const ParamArgData &argData, StormState &storm, std::shared_ptr<CMetrics> pipelineMetrics)
+{
+    CMetrics::HistogramSnapshot latency{storm.latency.snapshot().histograms["latency_us"]};
+    std::uint64_t files{storm.received.size()};
+    double writeSeconds{std::chrono::duration<double>(storm.writesDone - storm.start).count()};
+    double eventSeconds{std::max(static_cast<double>(storm.lastEvent - std::chrono::duration_cast<std::chrono::nanoseconds>(storm.start.time_since_epoch()).count()) / 1e9, 1e-9)};
+    std::ostringstream results;
+    if (argData.json)
+    {
+        results << "{\"pipeline\":\"" << argData.pipeline << "\",\"notifier\":\"" << argData.notifier << "\",\"writers\":" << argData.writers
+                << ",\"files\":" << files << ",\"fanout\":" << argData.fanOut << ",\"renamePercent\":" << argData.renamePercent
+                << ",\"writeSeconds\":" << writeSeconds << ",\"filesPerSecond\":" << (files / writeSeconds)
+                << ",\"events\":" << storm.uniqueEvents << ",\"eventsPerSecond\":" << (storm.uniqueEvents / eventSeconds)
+                << ",\"missed\":" << (files - storm.uniqueEvents) << ",\"duplicates\":" << storm.duplicateEvents << ",\"unknown\":" << storm.unknownEvents << ",\"early\":" << storm.earlyEvents
+                << ",\"latencyUs\":{\"p50\":" << latency.p50 << ",\"p90\":" << latency.p90 << ",\"p99\":" << latency.p99
+                << ",\"p999\":" << latency.p999 << ",\"max\":" << latency.maximum << "}";
+        if (argData.metrics && pipelineMetrics)
+        {
+            results << ",\"metrics\":" << pipelineMetrics->exportJSON();
+        }
+        results << "}" << std::endl;
+    }
+    else
+    {
+        results << "Pipeline          : " << argData.pipeline << " (" << argData.notifier << ")" << std::endl
+                << "Files written     : " << files << " by " << argData.writers << " writers over " << std::max(argData.fanOut, 1)
+                << " directories (" << argData.renamePercent << "% renamed)" << std::endl
+                << "Write rate        : " << (files / writeSeconds) << " files/sec" << std::endl
+                << "Events received   : " << storm.uniqueEvents << " (" << (storm.uniqueEvents / eventSeconds) << " events/sec)" << std::endl
+                << "Missed events     : " << (files - storm.uniqueEvents) << std::endl
+                << "Duplicate events  : " << storm.duplicateEvents << std::endl
+                << "Unknown events    : " << storm.unknownEvents << std::endl
+                << "Early events      : " << storm.earlyEvents << std::endl
+                << "Latency (us)      : p50 " << latency.p50 << " p90 " << latency.p90 << " p99 " << latency.p99
+                << " p99.9 " << latency.p999 << " max " << latency.maximum << std::endl;
+        if (argData.metrics && pipelineMetrics)
+        {
+            results << pipelineMetrics->exportText();
+        }
+    }
+    std::cout << results.str();
+}
+// ============================
+// ===== MAIN ENTRY POint =====
+// ============================
+int main(int argc, char **argv)
+{
+    try
+    {
+        ParamArgData argData;
+        // Read in command line parameters and process
+        procCmdLine(argc, argv, argData);
+        // Create empty watch/staging folders
+        if (argData.watchFolder.back() == '/')
+        {
+            argData.watchFolder.pop_back();
+        }
+        std::filesystem::remove_all(argData.watchFolder);
+        std::filesystem::remove_all(argData.watchFolder + "_staging");
+        CFile::createDirectory(argData.watchFolder);
+        CFile::createDirectory(argData.watchFolder + "_staging");
+        StormState storm{argData};
+        std::shared_ptr<CMetrics> pipelineMetrics;
+        if (argData.pipeline == "apprise")
+        {
+            // Consume watcher events directly
+            CApprise watcher{argData.watchFolder, -1, createNotifier(argData)};
+            pipelineMetrics = watcher.getMetrics();
+            createDirectories(argData);
+            if ((argData.notifier == "inotify") || (argData.notifier == "sharded"))
+            {
+                for (int directoryNo = 0; directoryNo < argData.fanOut; directoryNo++)
+                {
+                    watcher.addWatch(fileDirectory(argData, directoryNo));
+                }
+            }
+            watcher.startWatching();
+            std::thread consumer([&]() {
+                while (watcher.stillWatching())
+                {
+                    IApprise::Event evt;
+                    watcher.getNextEvent(evt);
+                    if (evt.id == IApprise::Event_add)
+                    {
+                        recordAddEvent(storm, evt.message);
+                    }
+                }
+            });
+            std::thread waiter(waitForEvents, std::cref(argData), std::ref(storm), [&watcher]() { watcher.stopWatching(); });
+            runWriters(argData, storm);
+            waiter.join();
+            consumer.join();
+            if (watcher.getThrownException())
+            {
+                std::rethrow_exception(watcher.getThrownException());
+            }
+        }
+        else
+        {
+            // Consume through task action (its watch folder sharded if requested)
+            auto options = std::make_shared<CTask::Options>();
+            options->watchShards = (argData.notifier == "sharded") ? static_cast<std::size_t>(argData.shards) : 1;
+            CTask task{argData.watchFolder, std::make_shared<BenchmarkAction>(storm, argData.watchFolder), -1, static_cast<int>(storm.received.size()), options};
+            pipelineMetrics = task.getMetrics();
+            createDirectories(argData);
+            std::thread monitor(&CTask::monitor, &task);
+            waitForDirectories(argData, *pipelineMetrics);
+            std::thread waiter(waitForEvents, std::cref(argData), std::ref(storm), [&task]() { task.stop(); });
+            runWriters(argData, storm);
+            waiter.join();
+            monitor.join();
+            if (task.getThrownException())
+            {
+                std::rethrow_exception(task.getThrownException());
+            }
+        }
+        report(argData, storm, pipelineMetrics);
+        std::filesystem::remove_all(argData.watchFolder);
+        std::filesystem::remove_all(argData.watchFolder + "_staging");
+    }
+    catch (std::exception &e)
+    {
+        exitWithError(e.what());
+    }
+    exit(EXIT_SUCCESS);
+}
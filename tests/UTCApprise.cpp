@@ -20,9 +20,14 @@
 #include <fstream>
 #include <thread>
 #include <sstream>
+#include <set>
 // CApprise class
 #include "CApprise.hpp"
 #include "CFileEventNotifier.hpp"
+#include "CFanotifyFileEventNotifier.hpp"
+#include "CPollingFileEventNotifier.hpp"
+#include "CShardedFileEventNotifier.hpp"
+#include "CFileEventCoalescer.hpp"
 // Used Antik classes
 #include "CFile.hpp"
 #include "CPath.hpp"
@@ -566,3 +571,470 @@ TEST_F(ITCApprise, RemoveNonExistantWatchFolder)
     CApprise watcher;
     EXPECT_THROW(watcher.removeWatch(kWatchFolder + "x"), CApprise::Exception);
 }
+//
+// Initial scan reports files present in watch folder hierarchy at start.
+//
+TEST_F(ITCApprise, InitialScanExistingFiles)
+{
+    IFileEventNotifier::Options options;
+    options.initialScan = true;
+    CFile::createDirectory(kWatchFolder + "scan");
+    for (auto cnt01 = 0; cnt01 < 10; cnt01++)
+    {
+        createFile(kWatchFolder + "temp" + std::to_string(cnt01) + ".txt");
+        createFile(kWatchFolder + "scan/temp" + std::to_string(cnt01) + ".txt");
+    }
+    CApprise watcher{kWatchFolder, watchDepth, std::make_shared<CFileEventNotifier>(options)};
+    watcher.startWatching();
+    gatherEvents(watcher, evtTotals, 20);
+    watcher.stopWatching();
+    EXPECT_EQ(20, evtTotals.add);
+    EXPECT_EQ(0, evtTotals.addir);
+    EXPECT_EQ(0, evtTotals.error);
+    for (auto cnt01 = 0; cnt01 < 10; cnt01++)
+    {
+        CFile::remove(kWatchFolder + "temp" + std::to_string(cnt01) + ".txt");
+        CFile::remove(kWatchFolder + "scan/temp" + std::to_string(cnt01) + ".txt");
+    }
+    CFile::remove(kWatchFolder + "scan");
+}
+//
+// Initial scan reports directories and files created in a new directory before it is watched.
+//
+TEST_F(ITCApprise, InitialScanNewDirectory)
+{
+    IFileEventNotifier::Options options;
+    options.initialScan = true;
+    CApprise watcher{kWatchFolder, watchDepth, std::make_shared<CFileEventNotifier>(options)};
+    watcher.startWatching();
+    CFile::createDirectory(kWatchFolder + "scan1/scan2/scan3");
+    for (auto cnt01 = 0; cnt01 < 10; cnt01++)
+    {
+        createFile(kWatchFolder + "scan1/scan2/scan3/temp" + std::to_string(cnt01) + ".txt");
+    }
+    while ((evtTotals.add < 10) || (evtTotals.addir < 3))
+    {
+        gatherEvents(watcher, evtTotals, 1);
+    }
+    watcher.stopWatching();
+    EXPECT_EQ(10, evtTotals.add);
+    EXPECT_EQ(3, evtTotals.addir);
+    EXPECT_EQ(0, evtTotals.error);
+    for (auto cnt01 = 0; cnt01 < 10; cnt01++)
+    {
+        CFile::remove(kWatchFolder + "scan1/scan2/scan3/temp" + std::to_string(cnt01) + ".txt");
+    }
+    CFile::remove(kWatchFolder + "scan1/scan2/scan3");
+    CFile::remove(kWatchFolder + "scan1/scan2");
+    CFile::remove(kWatchFolder + "scan1");
+}
+//
+// Coalescer merges a modify storm into one change and cancels a create followed by a delete.
+//
+TEST(UTCFileEventCoalescer, MergeEvents)
+{
+    CFileEventCoalescer::Clock::time_point start{CFileEventCoalescer::Clock::now()};
+    CFileEventCoalescer coalescer{std::chrono::milliseconds(100), start};
+    std::vector<IApprise::Event> expired;
+    for (auto cnt01 = 0; cnt01 < 100; cnt01++)
+    {
+        coalescer.add(IApprise::Event(IApprise::Event_change, "/tmp/watch/log.txt"), start);
+    }
+    coalescer.add(IApprise::Event(IApprise::Event_add, "/tmp/watch/new.txt"), start);
+    coalescer.add(IApprise::Event(IApprise::Event_change, "/tmp/watch/new.txt"), start);
+    coalescer.add(IApprise::Event(IApprise::Event_add, "/tmp/watch/tmp.txt"), start);
+    coalescer.add(IApprise::Event(IApprise::Event_unlink, "/tmp/watch/tmp.txt"), start);
+    EXPECT_EQ(2, coalescer.size());
+    coalescer.expire(expired, start + std::chrono::milliseconds(50));
+    EXPECT_TRUE(expired.empty());
+    coalescer.expire(expired, start + std::chrono::milliseconds(150));
+    ASSERT_EQ(2, expired.size());
+    EXPECT_EQ(IApprise::Event_change, expired[0].id);
+    EXPECT_EQ("/tmp/watch/log.txt", expired[0].message);
+    EXPECT_EQ(IApprise::Event_add, expired[1].id);
+    EXPECT_EQ("/tmp/watch/new.txt", expired[1].message);
+    EXPECT_TRUE(coalescer.empty());
+}
+//
+// Add then unlink only cancel out when the add is the first event for the path in its
+// window; a file unlinked, re-created and unlinked again is reported as unlinked.
+//
+TEST(UTCFileEventCoalescer, MergeUnlinkAddUnlink)
+{
+    CFileEventCoalescer coalescer{std::chrono::milliseconds(10000)};
+    std::vector<IApprise::Event> expired;
+    coalescer.add(IApprise::Event(IApprise::Event_unlink, "/tmp/watch/tmp.txt"));
+    coalescer.add(IApprise::Event(IApprise::Event_add, "/tmp/watch/tmp.txt"));
+    coalescer.add(IApprise::Event(IApprise::Event_unlink, "/tmp/watch/tmp.txt"));
+    coalescer.add(IApprise::Event(IApprise::Event_add, "/tmp/watch/new.txt"));
+    coalescer.add(IApprise::Event(IApprise::Event_change, "/tmp/watch/new.txt"));
+    coalescer.add(IApprise::Event(IApprise::Event_unlink, "/tmp/watch/new.txt"));
+    coalescer.flush(expired);
+    ASSERT_EQ(1, expired.size());
+    EXPECT_EQ(IApprise::Event_unlink, expired[0].id);
+    EXPECT_EQ("/tmp/watch/tmp.txt", expired[0].message);
+    EXPECT_TRUE(coalescer.empty());
+}
+//
+// Coalescer flush returns all pending events irrespective of window.
+//
+TEST(UTCFileEventCoalescer, FlushEvents)
+{
+    CFileEventCoalescer coalescer{std::chrono::milliseconds(10000)};
+    std::vector<IApprise::Event> expired;
+    coalescer.add(IApprise::Event(IApprise::Event_change, "/tmp/watch/log.txt"));
+    coalescer.add(IApprise::Event(IApprise::Event_unlink, "/tmp/watch/log.txt"));
+    coalescer.expire(expired);
+    EXPECT_TRUE(expired.empty());
+    coalescer.flush(expired);
+    ASSERT_EQ(1, expired.size());
+    EXPECT_EQ(IApprise::Event_unlink, expired[0].id);
+    EXPECT_TRUE(coalescer.empty());
+}
+//
+// Repeated updates to a file within the coalesce window produce a single change event.
+//
+TEST_F(ITCApprise, CoalesceUpdates)
+{
+    IFileEventNotifier::Options options;
+    options.coalesceWindow = std::chrono::milliseconds(1000);
+    createFile(kWatchFolder + "tmp.txt");
+    CApprise watcher{kWatchFolder, watchDepth, std::make_shared<CFileEventNotifier>(options)};
+    watcher.startWatching();
+    for (auto cnt01 = 0; cnt01 < 100; cnt01++)
+    {
+        std::ofstream fileToUpdate;
+        fileToUpdate.open(kWatchFolder + "tmp.txt", std::ios::out | std::ios::app);
+        fileToUpdate << "Writing this to a file.\n";
+        fileToUpdate.close();
+    }
+    createFile(kWatchFolder + "tmp1.txt");
+    CFile::remove(kWatchFolder + "tmp1.txt");
+    createFile(kWatchFolder + "tmp2.txt");
+    gatherEvents(watcher, evtTotals, 2);
+    watcher.stopWatching();
+    EXPECT_EQ(1, evtTotals.add);
+    EXPECT_EQ(1, evtTotals.change);
+    EXPECT_EQ(0, evtTotals.unlink);
+    EXPECT_EQ(0, evtTotals.error);
+    CFile::remove(kWatchFolder + "tmp.txt");
+    CFile::remove(kWatchFolder + "tmp2.txt");
+}
+//
+// Renamed directory keeps its watches (and those below it) with events reporting the new path.
+//
+TEST_F(ITCApprise, RenameDirectory)
+{
+    CApprise watcher{kWatchFolder, watchDepth};
+    watcher.startWatching();
+    IApprise::Event evt;
+    CFile::createDirectory(kWatchFolder + "rename1");
+    watcher.getNextEvent(evt);
+    EXPECT_EQ(IApprise::Event_addir, evt.id);
+    CFile::createDirectory(kWatchFolder + "rename1/rename2");
+    watcher.getNextEvent(evt);
+    EXPECT_EQ(IApprise::Event_addir, evt.id);
+    CFile::rename(kWatchFolder + "rename1", kWatchFolder + "rename3");
+    watcher.getNextEvent(evt);
+    EXPECT_EQ(IApprise::Event_addir, evt.id);
+    EXPECT_EQ(kWatchFolder + "rename3", evt.message);
+    createFile(kWatchFolder + "rename3/rename2/tmp.txt");
+    watcher.getNextEvent(evt);
+    EXPECT_EQ(IApprise::Event_add, evt.id);
+    EXPECT_EQ(kWatchFolder + "rename3/rename2/tmp.txt", evt.message);
+    watcher.stopWatching();
+    CFile::remove(kWatchFolder + "rename3/rename2/tmp.txt");
+    CFile::remove(kWatchFolder + "rename3/rename2");
+    CFile::remove(kWatchFolder + "rename3");
+}
+//
+// File still being written when its directory is renamed is reported as added under the new path.
+//
+TEST_F(ITCApprise, RenameDirectoryFileBeingCreated)
+{
+    CApprise watcher{kWatchFolder, watchDepth};
+    watcher.startWatching();
+    IApprise::Event evt;
+    CFile::createDirectory(kWatchFolder + "rename1");
+    watcher.getNextEvent(evt);
+    EXPECT_EQ(IApprise::Event_addir, evt.id);
+    std::ofstream outfile(kWatchFolder + "rename1/tmp.txt");
+    outfile << "TEST TEXT" << std::endl;
+    CFile::rename(kWatchFolder + "rename1", kWatchFolder + "rename3");
+    watcher.getNextEvent(evt);
+    EXPECT_EQ(IApprise::Event_addir, evt.id);
+    EXPECT_EQ(kWatchFolder + "rename3", evt.message);
+    outfile.close();
+    watcher.getNextEvent(evt);
+    EXPECT_EQ(IApprise::Event_add, evt.id);
+    EXPECT_EQ(kWatchFolder + "rename3/tmp.txt", evt.message);
+    watcher.stopWatching();
+    CFile::remove(kWatchFolder + "rename3/tmp.txt");
+    CFile::remove(kWatchFolder + "rename3");
+}
+//
+// Directory moved out of watch folder hierarchy no longer generates events.
+//
+TEST_F(ITCApprise, MoveDirectoryOut)
+{
+    CApprise watcher{kWatchFolder, watchDepth};
+    watcher.startWatching();
+    IApprise::Event evt;
+    CFile::createDirectory(kWatchFolder + "move1");
+    watcher.getNextEvent(evt);
+    EXPECT_EQ(IApprise::Event_addir, evt.id);
+    CFile::rename(kWatchFolder + "move1", kDestinationFolder + "move1");
+    createFile(kDestinationFolder + "move1/tmp.txt");
+    createFile(kWatchFolder + "tmp.txt");
+    watcher.getNextEvent(evt);
+    EXPECT_EQ(IApprise::Event_add, evt.id);
+    EXPECT_EQ(kWatchFolder + "tmp.txt", evt.message);
+    watcher.stopWatching();
+    CFile::remove(kDestinationFolder + "move1/tmp.txt");
+    CFile::remove(kDestinationFolder + "move1");
+    CFile::remove(kWatchFolder + "tmp.txt");
+}
+//
+// fanotify notifier generates the same events as inotify for files and directories
+// anywhere in the hierarchy (skipped if fanotify is unavailable/not permitted).
+//
+TEST_F(ITCApprise, FanotifyCreateDeleteFiles)
+{
+    std::shared_ptr<IFileEventNotifier> fileEventNotifier;
+    try
+    {
+        fileEventNotifier = std::make_shared<CFanotifyFileEventNotifier>();
+    }
+    catch (const std::system_error &e)
+    {
+        GTEST_SKIP() << e.what();
+    }
+    CApprise watcher{kWatchFolder, watchDepth, fileEventNotifier};
+    watcher.startWatching();
+    IApprise::Event evt;
+    CFile::createDirectory(kWatchFolder + "fanotify1/fanotify2");
+    createFile(kWatchFolder + "fanotify1/fanotify2/tmp.txt");
+    createFile(kDestinationFolder + "tmp.txt");
+    CFile::remove(kWatchFolder + "fanotify1/fanotify2/tmp.txt");
+    gatherEvents(watcher, evtTotals, 4);
+    watcher.stopWatching();
+    EXPECT_EQ(2, evtTotals.addir);
+    EXPECT_EQ(1, evtTotals.add);
+    EXPECT_EQ(1, evtTotals.unlink);
+    EXPECT_EQ(0, evtTotals.error);
+    CFile::remove(kDestinationFolder + "tmp.txt");
+    CFile::remove(kWatchFolder + "fanotify1/fanotify2");
+    CFile::remove(kWatchFolder + "fanotify1");
+}
+//
+// Polling notifier reports files added, changed and deleted between polls.
+//
+TEST_F(ITCApprise, PollingAddChangeDeleteFiles)
+{
+    IFileEventNotifier::Options options;
+    options.pollInterval = std::chrono::milliseconds(50);
+    createFile(kWatchFolder + "tmp.txt");
+    createFile(kWatchFolder + "tmp1.txt");
+    CApprise watcher{kWatchFolder, watchDepth, std::make_shared<CPollingFileEventNotifier>(options)};
+    watcher.startWatching();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    CFile::createDirectory(kWatchFolder + "poll1");
+    createFile(kWatchFolder + "poll1/tmp.txt");
+    std::ofstream fileToUpdate;
+    fileToUpdate.open(kWatchFolder + "tmp.txt", std::ios::out | std::ios::app);
+    fileToUpdate << "Writing this to a file.\n";
+    fileToUpdate.close();
+    CFile::remove(kWatchFolder + "tmp1.txt");
+    gatherEvents(watcher, evtTotals, 4);
+    watcher.stopWatching();
+    EXPECT_EQ(1, evtTotals.addir);
+    EXPECT_EQ(1, evtTotals.add);
+    EXPECT_EQ(1, evtTotals.change);
+    EXPECT_EQ(1, evtTotals.unlink);
+    EXPECT_EQ(0, evtTotals.error);
+    CFile::remove(kWatchFolder + "tmp.txt");
+    CFile::remove(kWatchFolder + "poll1/tmp.txt");
+    CFile::remove(kWatchFolder + "poll1");
+}
+//
+// Polling notifier watches removed and added back while polling; a directory whose
+// watch is removed is no longer reported and one added back is.
+//
+TEST_F(ITCApprise, PollingRemoveAddWatchWhilePolling)
+{
+    IFileEventNotifier::Options options;
+    options.pollInterval = std::chrono::milliseconds(1);
+    CFile::createDirectory(kWatchFolder + "poll2");
+    CApprise watcher{kWatchFolder, watchDepth, std::make_shared<CPollingFileEventNotifier>(options)};
+    watcher.startWatching();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    for (auto cnt01 = 0; cnt01 < 100; cnt01++)
+    {
+        watcher.removeWatch(kWatchFolder + "poll2");
+        watcher.addWatch(kWatchFolder + "poll2");
+    }
+    createFile(kWatchFolder + "poll2/tmp.txt");
+    watcher.removeWatch(kWatchFolder + "poll2");
+    createFile(kWatchFolder + "poll2/tmp1.txt");
+    createFile(kWatchFolder + "tmp.txt");
+    std::set<std::string> pathsAdded;
+    for (auto cnt01 = 0; (cnt01 < 100) && (pathsAdded.count(kWatchFolder + "tmp.txt") == 0); cnt01++)
+    {
+        IApprise::Event evt;
+        watcher.getNextEvent(evt, std::chrono::milliseconds(100));
+        EXPECT_NE(IApprise::Event_error, evt.id);
+        if (evt.id == IApprise::Event_add)
+        {
+            pathsAdded.insert(evt.message);
+        }
+    }
+    watcher.stopWatching();
+    EXPECT_EQ(1, pathsAdded.count(kWatchFolder + "tmp.txt"));
+    EXPECT_EQ(0, pathsAdded.count(kWatchFolder + "poll2/tmp1.txt"));
+    CFile::remove(kWatchFolder + "tmp.txt");
+    CFile::remove(kWatchFolder + "poll2/tmp.txt");
+    CFile::remove(kWatchFolder + "poll2/tmp1.txt");
+    CFile::remove(kWatchFolder + "poll2");
+}
+//
+// Sharded notifier reports each file/directory once whichever shard owns its top-level
+// directory (files directly in the watch folder belonging to shard zero).
+//
+TEST_F(ITCApprise, ShardedCreateDeleteFiles)
+{
+    auto fileEventNotifier = std::make_shared<CShardedFileEventNotifier>(4);
+    CApprise watcher{kWatchFolder, watchDepth, fileEventNotifier};
+    watcher.startWatching();
+    std::set<std::string> pathsAdded;
+    for (auto cnt01 = 0; cnt01 < 8; cnt01++)
+    {
+        CFile::createDirectory(kWatchFolder + "shard" + std::to_string(cnt01));
+    }
+    for (auto cnt01 = 0; cnt01 < 8; cnt01++)
+    {
+        IApprise::Event evt;
+        watcher.getNextEvent(evt);
+        EXPECT_EQ(IApprise::Event_addir, evt.id);
+        pathsAdded.insert(evt.message);
+    }
+    for (auto cnt01 = 0; cnt01 < 8; cnt01++)
+    {
+        createFile(kWatchFolder + "shard" + std::to_string(cnt01) + "/tmp.txt");
+    }
+    createFile(kWatchFolder + "tmp.txt");
+    gatherEvents(watcher, evtTotals, 9);
+    watcher.stopWatching();
+    EXPECT_EQ(8, pathsAdded.size());
+    EXPECT_EQ(9, evtTotals.add);
+    EXPECT_EQ(0, evtTotals.error);
+    auto counters = fileEventNotifier->getMetrics()->snapshot().counters;
+    EXPECT_EQ(counters["events_queued"], counters["shard0.events_queued"] + counters["shard1.events_queued"] +
+                                             counters["shard2.events_queued"] + counters["shard3.events_queued"]);
+    EXPECT_LT(counters["shard0.events_queued"], counters["events_queued"]);
+    CFile::remove(kWatchFolder + "tmp.txt");
+    for (auto cnt01 = 0; cnt01 < 8; cnt01++)
+    {
+        CFile::remove(kWatchFolder + "shard" + std::to_string(cnt01) + "/tmp.txt");
+        CFile::remove(kWatchFolder + "shard" + std::to_string(cnt01));
+    }
+}
+//
+// Directory renamed between top-level directories owned by different shards has
+// watches added for everything below it by its new shard; its contents being reported
+// even though the initial scan is not enabled.
+//
+TEST_F(ITCApprise, ShardedRenameDirectoryAcrossShards)
+{
+    const std::size_t kShards{4};
+    auto shardNo = [&](const std::string &name) { return (std::hash<std::string_view>{}(name) % kShards); };
+    std::string fromName{"move0"}, toName{"move1"};
+    for (auto cnt01 = 2; shardNo(fromName) == shardNo(toName); cnt01++)
+    {
+        toName = "move" + std::to_string(cnt01);
+    }
+    auto fileEventNotifier = std::make_shared<CShardedFileEventNotifier>(kShards);
+    CApprise watcher{kWatchFolder, watchDepth, fileEventNotifier};
+    watcher.startWatching();
+    std::set<std::string> pathsAdded;
+    auto waitForPath = [&](const std::string &filePath) {
+        for (auto cnt01 = 0; (cnt01 < 100) && (pathsAdded.count(filePath) == 0); cnt01++)
+        {
+            IApprise::Event evt;
+            watcher.getNextEvent(evt, std::chrono::milliseconds(20));
+            if ((evt.id == IApprise::Event_add) || (evt.id == IApprise::Event_addir))
+            {
+                pathsAdded.insert(evt.message);
+            }
+        }
+    };
+    CFile::createDirectory(kWatchFolder + fromName);
+    waitForPath(kWatchFolder + fromName);
+    CFile::createDirectory(kWatchFolder + fromName + "/sub");
+    waitForPath(kWatchFolder + fromName + "/sub");
+    createFile(kWatchFolder + fromName + "/sub/tmp.txt");
+    waitForPath(kWatchFolder + fromName + "/sub/tmp.txt");
+    CFile::rename(kWatchFolder + fromName, kWatchFolder + toName);
+    waitForPath(kWatchFolder + toName + "/sub/tmp.txt");
+    createFile(kWatchFolder + toName + "/sub/tmp2.txt");
+    waitForPath(kWatchFolder + toName + "/sub/tmp2.txt");
+    watcher.stopWatching();
+    EXPECT_EQ(1, pathsAdded.count(kWatchFolder + toName));
+    EXPECT_EQ(1, pathsAdded.count(kWatchFolder + toName + "/sub"));
+    EXPECT_EQ(1, pathsAdded.count(kWatchFolder + toName + "/sub/tmp.txt"));
+    EXPECT_EQ(1, pathsAdded.count(kWatchFolder + toName + "/sub/tmp2.txt"));
+    CFile::remove(kWatchFolder + toName + "/sub/tmp.txt");
+    CFile::remove(kWatchFolder + toName + "/sub/tmp2.txt");
+    CFile::remove(kWatchFolder + toName + "/sub");
+    CFile::remove(kWatchFolder + toName);
+}
+//
+// Files whose events are lost to an inotify queue overflow are found by reconciliation.
+// The overflow is forced without changing kernel settings by bounding the watcher queue
+// so event generation waits (and stops reading inotify) while more files are created
+// than the inotify queue can hold. Reconciliation may report a file more than once.
+//
+TEST_F(ITCApprise, ReconcileOverflow)
+{
+    std::size_t maxQueuedEvents{0};
+    std::ifstream{"/proc/sys/fs/inotify/max_queued_events"} >> maxQueuedEvents;
+    if ((maxQueuedEvents == 0) || (maxQueuedEvents > 65536))
+    {
+        GTEST_SKIP() << "inotify max_queued_events unknown or too large to overflow";
+    }
+    const std::size_t kFileCount{maxQueuedEvents + 4096};
+    IFileEventNotifier::Options options;
+    options.reconcileOverflow = true;
+    options.maxQueuedEvents = 1;
+    CApprise watcher{kWatchFolder, watchDepth, std::make_shared<CFileEventNotifier>(options)};
+    watcher.startWatching();
+    for (std::size_t fileNo = 0; fileNo < kFileCount; fileNo++)
+    {
+        createFile(kWatchFolder + "temp" + std::to_string(fileNo) + ".txt");
+    }
+    bool overflowed{false};
+    std::set<std::string> filesAdded;
+    while (!overflowed || (filesAdded.size() < kFileCount))
+    {
+        IApprise::Event evt;
+        watcher.getNextEvent(evt, std::chrono::milliseconds(5000));
+        if (evt.id == IApprise::Event_none)
+        {
+            break;
+        }
+        if (evt.id == IApprise::Event_overflow)
+        {
+            overflowed = true;
+        }
+        else if (evt.id == IApprise::Event_add)
+        {
+            filesAdded.insert(evt.message);
+        }
+    }
+    watcher.stopWatching();
+    EXPECT_TRUE(overflowed);
+    EXPECT_EQ(kFileCount, filesAdded.size());
+    for (std::size_t fileNo = 0; fileNo < kFileCount; fileNo++)
+    {
+        CFile::remove(kWatchFolder + "temp" + std::to_string(fileNo) + ".txt");
+    }
+}
@@ -0,0 +1,174 @@
+/*
+ * File:   UTCFTP.cpp
+ *
+ * Author: Robert Tizzard
+ *
+ * Created on October 18, 2026, 3:41 PM
+ *
+ * Description: Google unit tests for class CFTP response parsing and FTP utility
+ * segmented download progress (none of which need a server).
+ *
+ * Copyright 2021.
+ *
+ */
+// =============
+// INCLUDE FILES
+// =============
+// Google test
+#include "gtest/gtest.h"
+// C++ STL
+#include <stdexcept>
+#include <fstream>
+#include <cstdio>
+// CFTP class and FTP utility
+#include "CFTP.hpp"
+#include "FTPUtil.hpp"
+using namespace Antik::FTP;
+// =======================
+// UNIT TEST FIXTURE CLASS
+// =======================
+class UTCFTP : public ::testing::Test
+{
+protected:
+    // Empty constructor
+    UTCFTP()
+    {
+    }
+    // Empty destructor
+    ~UTCFTP() override
+    {
+    }
+    void SetUp() override
+    {
+    }
+    void TearDown() override
+    {
+        std::remove(kProgressFile.c_str());
+    }
+    static const std::string kProgressFile; // Segmented download progress file
+};
+// =================
+// FIXTURE CONSTANTS
+// =================
+const std::string UTCFTP::kProgressFile("/tmp/utcftp.segments");
+// ===============
+// FIXTURE METHODS
+// ===============
+// =====================
+// CFTP CLASS UNIT TESTS
+// =====================
+//
+// MLSD entry facts parsed (names/type lowercased) and name split at first "; ".
+//
+TEST_F(UTCFTP, ParseFacts)
+{
+    CFTP::FileInfo fileInfo;
+    CFTP::parseFacts("Type=DIR;Size=4096;Modify=20210304050607.123;Perm=flcdmpe; my dir; old\r\n", fileInfo);
+    EXPECT_EQ("my dir; old", fileInfo.name);
+    EXPECT_EQ("dir", fileInfo.type);
+    EXPECT_EQ(4096, fileInfo.size);
+    EXPECT_EQ("20210304050607", static_cast<std::string>(fileInfo.modify));
+    EXPECT_EQ("flcdmpe", fileInfo.perm);
+    EXPECT_TRUE(fileInfo.isDirectory());
+}
+//
+// MLST reply entry has a single leading space before its facts.
+//
+TEST_F(UTCFTP, ParseFactsMLSTEntry)
+{
+    CFTP::FileInfo fileInfo;
+    CFTP::parseFacts(" type=file;size=10; /remote/file.txt", fileInfo);
+    EXPECT_EQ("/remote/file.txt", fileInfo.name);
+    EXPECT_EQ("file", fileInfo.type);
+    EXPECT_EQ(10, fileInfo.size);
+}
+//
+// Entry without facts is just the space separator and a name (spaces and "; " kept).
+//
+TEST_F(UTCFTP, ParseFactsNoFacts)
+{
+    CFTP::FileInfo fileInfo;
+    CFTP::parseFacts(" file name; copy.txt", fileInfo);
+    EXPECT_EQ("file name; copy.txt", fileInfo.name);
+    EXPECT_TRUE(fileInfo.type.empty());
+    CFTP::parseFacts("  leading.txt", fileInfo);
+    EXPECT_EQ(" leading.txt", fileInfo.name);
+}
+//
+// Facts with bad values are skipped rather than failing the entry.
+//
+TEST_F(UTCFTP, ParseFactsBadValues)
+{
+    CFTP::FileInfo fileInfo;
+    EXPECT_NO_THROW(CFTP::parseFacts("type=file;size=12x;modify=2021XX04050607;perm=r; file.txt", fileInfo));
+    EXPECT_EQ("file.txt", fileInfo.name);
+    EXPECT_EQ("file", fileInfo.type);
+    EXPECT_EQ(0, fileInfo.size);
+    EXPECT_EQ(0, fileInfo.modify.year);
+    EXPECT_EQ("r", fileInfo.perm);
+    EXPECT_NO_THROW(CFTP::parseFacts("size=99999999999999999999999; file.txt", fileInfo));
+    EXPECT_EQ(0, fileInfo.size);
+}
+//
+// CRC32 field parsed as hex (quotes ignored); anything else rejected.
+//
+TEST_F(UTCFTP, ParseCRC)
+{
+    std::uint32_t crc{0};
+    EXPECT_TRUE(CFTP::parseCRC("\"CBF43926\"", crc));
+    EXPECT_EQ(0xCBF43926, crc);
+    EXPECT_TRUE(CFTP::parseCRC("1a", crc));
+    EXPECT_EQ(0x1A, crc);
+    EXPECT_FALSE(CFTP::parseCRC("", crc));
+    EXPECT_FALSE(CFTP::parseCRC("123456789", crc));
+    EXPECT_FALSE(CFTP::parseCRC("12G4", crc));
+    EXPECT_FALSE(CFTP::parseCRC("-1", crc));
+}
+// ======================
+// FTP UTILITY UNIT TESTS
+// ======================
+//
+// Segmented download progress saved is loaded back for the same file size and version.
+//
+TEST_F(UTCFTP, SaveLoadSegments)
+{
+    std::vector<FileSegment> segments(2);
+    segments[0] = {0, 1024, 512, 0};
+    segments[1] = {1024, 1024, 1024, 0};
+    saveSegments(kProgressFile, 2048, "MDTM:20210304050607", segments);
+    std::vector<FileSegment> loaded;
+    ASSERT_TRUE(loadSegments(kProgressFile, 2048, "MDTM:20210304050607", loaded));
+    ASSERT_EQ(2, loaded.size());
+    EXPECT_EQ(0, loaded[0].offset);
+    EXPECT_EQ(1024, loaded[0].length);
+    EXPECT_EQ(512, loaded[0].transferred);
+    EXPECT_EQ(1024, loaded[1].offset);
+    EXPECT_EQ(1024, loaded[1].transferred);
+}
+//
+// Progress for a different file size or version (or none at all) is not loaded.
+//
+TEST_F(UTCFTP, LoadSegmentsMismatch)
+{
+    std::vector<FileSegment> segments(1);
+    segments[0] = {0, 2048, 100, 0};
+    std::vector<FileSegment> loaded;
+    EXPECT_FALSE(loadSegments(kProgressFile, 2048, "-", loaded));
+    saveSegments(kProgressFile, 2048, "XCRC:1234ABCD", segments);
+    EXPECT_FALSE(loadSegments(kProgressFile, 4096, "XCRC:1234ABCD", loaded));
+    EXPECT_FALSE(loadSegments(kProgressFile, 2048, "XCRC:FFFFFFFF", loaded));
+    EXPECT_TRUE(loaded.empty());
+}
+//
+// Progress whose segments do not fit the file is not loaded.
+//
+TEST_F(UTCFTP, LoadSegmentsInvalid)
+{
+    std::vector<FileSegment> loaded;
+    std::ofstream{kProgressFile} << "2048 -\n0 1024 2000\n";
+    EXPECT_FALSE(loadSegments(kProgressFile, 2048, "-", loaded));
+    std::ofstream{kProgressFile} << "2048 -\n1024 2048 0\n";
+    EXPECT_FALSE(loadSegments(kProgressFile, 2048, "-", loaded));
+    std::ofstream{kProgressFile} << "2048 -\n";
+    EXPECT_FALSE(loadSegments(kProgressFile, 2048, "-", loaded));
+}
@@ -0,0 +1,146 @@
+/*
+ * File:   UTCMetrics.cpp
+ *
+ * Author: Robert Tizzard
+ *
+ * Created on October 18, 2026, 10:12 AM
+ *
+ * Description: Google unit tests for class CMetrics.
+ *
+ * Copyright 2021.
+ *
+ */
+// =============
+// INCLUDE FILES
+// =============
+// Google test
+#include "gtest/gtest.h"
+// C++ STL
+#include <thread>
+#include <vector>
+// CMetrics class
+#include "CMetrics.hpp"
+using namespace Antik::File;
+// =======================
+// UNIT TEST FIXTURE CLASS
+// =======================
+class UTCMetrics : public ::testing::Test
+{
+protected:
+    // Empty constructor
+    UTCMetrics()
+    {
+    }
+    // Empty destructor
+    ~UTCMetrics() override
+    {
+    }
+    // Keep initialization and cleanup code to SetUp() and TearDown() methods
+    void SetUp() override
+    {
+    }
+    void TearDown() override
+    {
+    }
+    CMetrics metrics; // Metrics under test
+};
+// =========================
+// METRICS CLASS UNIT TESTS
+// =========================
+//
+// Counter updated from many threads.
+//
+TEST_F(UTCMetrics, CounterMultipleThreads)
+{
+    CMetrics::Counter &counter{metrics.counter("count")};
+    std::vector<std::thread> threads;
+    for (auto thread = 0; thread < 4; thread++)
+    {
+        threads.emplace_back([&counter]() {
+            for (auto cnt01 = 0; cnt01 < 10000; cnt01++)
+            {
+                counter.add();
+            }
+        });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_EQ(40000, counter.value());
+    EXPECT_EQ(&counter, &metrics.counter("count"));
+    EXPECT_EQ(40000, metrics.snapshot().counters["count"]);
+}
+//
+// Gauge keeps high water mark.
+//
+TEST_F(UTCMetrics, GaugeMaximum)
+{
+    CMetrics::Gauge &gauge{metrics.gauge("depth")};
+    gauge.set(10);
+    gauge.add(5);
+    gauge.add(-12);
+    EXPECT_EQ(3, gauge.value());
+    EXPECT_EQ(15, gauge.maximum());
+}
+//
+// Every value is recorded in a bucket whose highest value is within 1/32 of it.
+//
+TEST_F(UTCMetrics, HistogramBucketPrecision)
+{
+    for (std::uint64_t value = 0; value < 100000; value++)
+    {
+        std::uint64_t highest{CMetrics::Histogram::bucketHighest(CMetrics::Histogram::bucketIndex(value))};
+        EXPECT_GE(highest, value);
+        EXPECT_LE(highest - value, value / CMetrics::Histogram::kSubBuckets);
+    }
+    EXPECT_EQ(CMetrics::Histogram::kBuckets - 1, CMetrics::Histogram::bucketIndex(UINT64_MAX));
+    EXPECT_EQ(UINT64_MAX, CMetrics::Histogram::bucketHighest(CMetrics::Histogram::kBuckets - 1));
+}
+//
+// Histogram percentiles.
+//
+TEST_F(UTCMetrics, HistogramPercentiles)
+{
+    CMetrics::Histogram &histogram{metrics.histogram("latency_us")};
+    for (std::uint64_t value = 1; value <= 1000; value++)
+    {
+        histogram.record(value);
+    }
+    CMetrics::HistogramSnapshot latency{metrics.snapshot().histograms["latency_us"]};
+    EXPECT_EQ(1000, latency.count);
+    EXPECT_EQ(500500, latency.sum);
+    EXPECT_EQ(1000, latency.maximum);
+    EXPECT_NEAR(500, latency.p50, 500 / 32);
+    EXPECT_NEAR(900, latency.p90, 900 / 32);
+    EXPECT_NEAR(990, latency.p99, 990 / 32);
+    EXPECT_EQ(1000, latency.p999);
+}
+//
+// Metrics of included sources are prefixed.
+//
+TEST_F(UTCMetrics, IncludedSource)
+{
+    auto source = std::make_shared<CMetrics>();
+    source->counter("events").add(3);
+    metrics.addSource("notifier", source);
+    metrics.counter("files").add(2);
+    CMetrics::Snapshot snapshot{metrics.snapshot()};
+    EXPECT_EQ(2, snapshot.counters["files"]);
+    EXPECT_EQ(3, snapshot.counters["notifier.events"]);
+}
+//
+// Text and JSON export.
+//
+TEST_F(UTCMetrics, Export)
+{
+    metrics.counter("files").add(2);
+    metrics.gauge("depth").set(4);
+    metrics.histogram("latency_us").record(7);
+    EXPECT_EQ("files 2\ndepth 4\ndepth.max 4\nlatency_us.count 1\nlatency_us.sum 7\nlatency_us.max 7\n"
+              "latency_us.p50 7\nlatency_us.p90 7\nlatency_us.p99 7\nlatency_us.p999 7\n",
+              metrics.exportText());
+    EXPECT_EQ("{\"counters\":{\"files\":2},\"gauges\":{\"depth\":{\"value\":4,\"max\":4}},"
+              "\"histograms\":{\"latency_us\":{\"count\":1,\"sum\":7,\"max\":7,\"p50\":7,\"p90\":7,\"p99\":7,\"p999\":7}}}",
+              metrics.exportJSON());
+}
@@ -19,8 +19,18 @@
 #include <stdexcept>
 #include <sstream>
 #include <fstream>
+#include <atomic>
+#include <mutex>
+#include <map>
 // CTask class
 #include "CTask.hpp"
+#include "CFileStabilizer.hpp"
+#include "CTaskJournal.hpp"
+#include "CDispatchQueue.hpp"
+#include "CDispatchPolicy.hpp"
+#include "CTokenBucket.hpp"
+#include "CConcurrencyLimiter.hpp"
+#include "CRetryQueue.hpp"
 // Used Antik classes
 #include "CFile.hpp"
 #include "CPath.hpp"
@@ -65,6 +75,104 @@ public:
 protected:
     std::string name; // Action name
 };
+class TestAction3 : public CTask::IAction
+{
+public:
+    explicit TestAction3(const std::string &taskName) : name{taskName}
+    {
+    }
+    void init(void) override{};
+    void term(void) override{};
+    bool process([[maybe_unused]] const std::string &file) override
+    {
+        fileCount++;
+        return true;
+    }
+    virtual ~TestAction3(){};
+    std::atomic<int> fileCount{0};
+
+protected:
+    std::string name; // Action name
+};
+class TestBatchAction : public CTask::IBatchAction
+{
+public:
+    explicit TestBatchAction(const std::string &taskName) : name{taskName}
+    {
+    }
+    void init(void) override{};
+    void term(void) override{};
+    bool processBatch(const std::vector<std::string> &files) override
+    {
+        std::unique_lock<std::mutex> locker(batchMutex);
+        batchSizes.push_back(files.size());
+        fileCount += static_cast<int>(files.size());
+        return true;
+    }
+    virtual ~TestBatchAction(){};
+    std::atomic<int> fileCount{0};
+    std::mutex batchMutex;
+    std::vector<std::size_t> batchSizes;
+
+protected:
+    std::string name; // Action name
+};
+class TestSlowAction : public CTask::IAction
+{
+public:
+    explicit TestSlowAction(const std::string &taskName, std::chrono::milliseconds processTime, bool result = true)
+        : name{taskName}, processTime{processTime}, result{result}
+    {
+    }
+    void init(void) override{};
+    void term(void) override{};
+    bool process([[maybe_unused]] const std::string &file) override
+    {
+        std::this_thread::sleep_for(processTime);
+        fileCount++;
+        return result;
+    }
+    virtual ~TestSlowAction(){};
+    std::atomic<int> fileCount{0};
+
+protected:
+    std::string name;                      // Action name
+    std::chrono::milliseconds processTime; // Time taken to process a file
+    bool result;                           // Result returned by process()
+};
+class TestFlakyAction : public CTask::IAction
+{
+public:
+    explicit TestFlakyAction(const std::string &taskName, int failures)
+        : name{taskName}, failures{failures}
+    {
+    }
+    void init(void) override{};
+    void term(void) override{};
+    bool process(const std::string &file) override
+    {
+        std::unique_lock<std::mutex> locker(attemptsMutex);
+        int attempt{++attempts[file]};
+        if ((file.find("poison") != std::string::npos) || (attempt <= failures))
+        {
+            if (attempt % 2)
+            {
+                throw std::runtime_error("Flaky failure.");
+            }
+            return false;
+        }
+        fileCount++;
+        return true;
+    }
+    virtual ~TestFlakyAction(){};
+    std::atomic<int> fileCount{0};
+    std::mutex attemptsMutex;
+    std::map<std::string, int> attempts;
+
+protected:
+    std::string name; // Action name
+    int failures;     // Failed attempts before each file is processed
+};
 class UTCTask : public ::testing::Test
 {
 protected:
@@ -105,6 +213,15 @@ protected:
         {
             CFile::remove(UTCTask::kDestinationFolder);
         }
+        // Remove journal folder.
+        if (CFile::exists(UTCTask::kJournalFolder))
+        {
+            for (auto &journalFile : CFile::directoryContentsList(UTCTask::kJournalFolder))
+            {
+                CFile::remove(journalFile);
+            }
+            CFile::remove(UTCTask::kJournalFolder);
+        }
     }
     void createFile(std::string fileName); // Create a test file.
     void createFiles(int fileCount);       // Create fileCount files and check action function call count
@@ -118,6 +235,7 @@ protected:
     std::shared_ptr<TestAction2> testTaskAction2; // Test Action 2
     static const std::string kWatchFolder;        // Test Watch Folder
     static const std::string kDestinationFolder;  // Test Destination folder
+    static const std::string kJournalFolder;      // Test Journal folder
     static const std::string kParamAssertion1;    // Missing parameter 1 Assert REGEX
     static const std::string kParamAssertion2;    // Missing parameter 2 Assert REGEX
     static const std::string kParamAssertion3;    // Missing parameter 3 Assert REGEX
@@ -129,6 +247,7 @@ protected:
 // =================
 const std::string UTCTask::kWatchFolder("/tmp/watch/");
 const std::string UTCTask::kDestinationFolder("/tmp/destination/");
+const std::string UTCTask::kJournalFolder("/tmp/journal/");
 const std::string UTCTask::kParamAssertion1("Assertion*"); // NEED TO MODIFY FOR SPECIFIC ASSERTS
 const std::string UTCTask::kParamAssertion2("Assertion*");
 const std::string UTCTask::kParamAssertion3("Assertion*");
@@ -310,4 +429,797 @@ TEST_F(UTCTask, ActionFunctionException)
     {
         CFile::remove(watchFolder + fileName);
     }
-}
\ No newline at end of file
+}
+//
+// Files added while a journaled task is not running are processed on restart
+// (and files already processed are not).
+//
+TEST_F(UTCTask, JournalResumeMissedFiles)
+{
+    watchFolder = kWatchFolder;
+    watchDepth = -1;
+    auto options = std::make_shared<CTask::Options>();
+    options->journalFolder = kJournalFolder;
+    // Process one file then stop
+    {
+        CTask task{watchFolder, testTaskAction1, watchDepth, 1, options};
+        std::unique_ptr<std::thread> taskThread;
+        taskThread = std::make_unique<std::thread>(&CTask::monitor, &task);
+        createFile(watchFolder + "first.txt");
+        taskThread->join();
+        generateException(task.getThrownException());
+    }
+    EXPECT_EQ(1, testTaskAction1->fileCount);
+    // Add files while task not running
+    for (auto cnt01 = 0; cnt01 < 5; cnt01++)
+    {
+        createFile(watchFolder + "missed" + std::to_string(cnt01) + ".txt");
+    }
+    // Restarted task should process only the missed files
+    {
+        CTask task{watchFolder, testTaskAction1, watchDepth, 5, options};
+        task.monitor();
+        generateException(task.getThrownException());
+    }
+    EXPECT_EQ(6, testTaskAction1->fileCount);
+    CFile::remove(watchFolder + "first.txt");
+    for (auto cnt01 = 0; cnt01 < 5; cnt01++)
+    {
+        CFile::remove(watchFolder + "missed" + std::to_string(cnt01) + ".txt");
+    }
+}
+//
+// A file received but not completed by a journaled task is processed again on restart.
+//
+TEST_F(UTCTask, JournalResumeOutstandingFile)
+{
+    watchFolder = kWatchFolder;
+    fileName = "tmp.txt";
+    watchDepth = -1;
+    auto options = std::make_shared<CTask::Options>();
+    options->journalFolder = kJournalFolder;
+    // Action throws so file not completed
+    {
+        CTask task{watchFolder, testTaskAction2, watchDepth, 0, options};
+        std::unique_ptr<std::thread> taskThread;
+        taskThread = std::make_unique<std::thread>(&CTask::monitor, &task);
+        createFile(watchFolder + fileName);
+        taskThread->join();
+        EXPECT_THROW(generateException(task.getThrownException()), std::logic_error);
+    }
+    // Restarted task should process outstanding file
+    {
+        CTask task{watchFolder, testTaskAction1, watchDepth, 1, options};
+        task.monitor();
+        generateException(task.getThrownException());
+    }
+    EXPECT_EQ(1, testTaskAction1->fileCount);
+    CFile::remove(watchFolder + fileName);
+}
+//
+// A file processed on resume and then added again once the restarted task is running
+// is processed again.
+//
+TEST_F(UTCTask, JournalResumedFileAddedAgain)
+{
+    watchFolder = kWatchFolder;
+    fileName = "tmp.txt";
+    watchDepth = -1;
+    auto options = std::make_shared<CTask::Options>();
+    options->journalFolder = kJournalFolder;
+    // Action throws so file not completed
+    {
+        CTask task{watchFolder, testTaskAction2, watchDepth, 0, options};
+        std::unique_ptr<std::thread> taskThread;
+        taskThread = std::make_unique<std::thread>(&CTask::monitor, &task);
+        createFile(watchFolder + fileName);
+        taskThread->join();
+        EXPECT_THROW(generateException(task.getThrownException()), std::logic_error);
+    }
+    // Restarted task processes outstanding file and then the file added again
+    {
+        CTask task{watchFolder, testTaskAction1, watchDepth, 2, options};
+        std::unique_ptr<std::thread> taskThread;
+        taskThread = std::make_unique<std::thread>(&CTask::monitor, &task);
+        for (auto cnt01 = 0; (cnt01 < 100) && (task.getMetrics()->snapshot().counters["files_processed"] != 1); cnt01++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        CFile::remove(watchFolder + fileName);
+        createFile(watchFolder + fileName);
+        for (auto cnt01 = 0; (cnt01 < 100) && (task.getMetrics()->snapshot().counters["files_processed"] != 2); cnt01++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        task.stop();
+        taskThread->join();
+        generateException(task.getThrownException());
+    }
+    EXPECT_EQ(2, testTaskAction1->fileCount);
+    CFile::remove(watchFolder + fileName);
+}
+//
+// Journal with small segments (forcing segment rollover) still resumes correctly.
+//
+TEST_F(UTCTask, JournalSegmentRollover)
+{
+    watchFolder = kWatchFolder;
+    watchDepth = -1;
+    auto options = std::make_shared<CTask::Options>();
+    options->journalFolder = kJournalFolder;
+    options->journalSegmentSize = 4096;
+    {
+        CTask task{watchFolder, testTaskAction1, watchDepth, 100, options};
+        std::unique_ptr<std::thread> taskThread;
+        taskThread = std::make_unique<std::thread>(&CTask::monitor, &task);
+        for (auto cnt01 = 0; cnt01 < 100; cnt01++)
+        {
+            createFile(watchFolder + "temp" + std::to_string(cnt01) + ".txt");
+        }
+        taskThread->join();
+        generateException(task.getThrownException());
+    }
+    EXPECT_EQ(100, testTaskAction1->fileCount);
+    EXPECT_EQ(1, CFile::directoryContentsList(kJournalFolder).size());
+    for (auto cnt01 = 0; cnt01 < 3; cnt01++)
+    {
+        createFile(watchFolder + "missed" + std::to_string(cnt01) + ".txt");
+    }
+    {
+        CTask task{watchFolder, testTaskAction1, watchDepth, 3, options};
+        task.monitor();
+        generateException(task.getThrownException());
+    }
+    EXPECT_EQ(103, testTaskAction1->fileCount);
+    for (auto &watchFile : CFile::directoryContentsList(watchFolder))
+    {
+        CFile::remove(watchFile);
+    }
+}
+//
+// A file still waiting out its stability period when a journaled task is stopped is
+// journaled as received and so processed on restart.
+//
+TEST_F(UTCTask, JournalResumeStabilizingFile)
+{
+    watchFolder = kWatchFolder;
+    fileName = "tmp.txt";
+    watchDepth = -1;
+    auto options = std::make_shared<CTask::Options>();
+    options->journalFolder = kJournalFolder;
+    options->stabilityPeriod = std::chrono::minutes(10);
+    // Stop task while file stabilizing
+    {
+        CTask task{watchFolder, testTaskAction1, watchDepth, 1, options};
+        std::unique_ptr<std::thread> taskThread;
+        taskThread = std::make_unique<std::thread>(&CTask::monitor, &task);
+        createFile(watchFolder + fileName);
+        for (auto cnt01 = 0; (cnt01 < 100) && (task.getMetrics()->snapshot().gauges["files_stabilizing"].value != 1); cnt01++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        task.stop();
+        taskThread->join();
+        generateException(task.getThrownException());
+    }
+    EXPECT_EQ(0, testTaskAction1->fileCount);
+    // File journaled as outstanding
+    {
+        CTaskJournal journal{kJournalFolder, 4096, std::chrono::milliseconds(100), 1};
+        journal.open();
+        EXPECT_EQ(std::vector<std::string>{watchFolder + fileName}, journal.outstanding());
+        journal.close();
+    }
+    // Restarted task should pass stabilizing file through its quiet period and process it
+    options->stabilityPeriod = std::chrono::milliseconds(100);
+    {
+        CTask task{watchFolder, testTaskAction1, watchDepth, 1, options};
+        task.monitor();
+        generateException(task.getThrownException());
+    }
+    EXPECT_EQ(1, testTaskAction1->fileCount);
+    CFile::remove(watchFolder + fileName);
+}
+//
+// Task metrics include those of its watcher and file event notifier.
+//
+TEST_F(UTCTask, TaskMetrics)
+{
+    watchFolder = kWatchFolder;
+    watchDepth = -1;
+    CTask task{watchFolder, testTaskAction1, watchDepth, 10};
+    std::unique_ptr<std::thread> taskThread;
+    taskThread = std::make_unique<std::thread>(&CTask::monitor, &task);
+    for (auto cnt01 = 0; cnt01 < 10; cnt01++)
+    {
+        createFile(watchFolder + "temp" + std::to_string(cnt01) + ".txt");
+    }
+    taskThread->join();
+    CMetrics::Snapshot metrics{task.getMetrics()->snapshot()};
+    EXPECT_EQ(10, metrics.counters["files_processed"]);
+    EXPECT_EQ(10, metrics.histograms["action_duration_us"].count);
+    EXPECT_EQ(10, metrics.histograms["process_latency_us"].count);
+    EXPECT_LE(10, metrics.counters["watcher.events_delivered"]);
+    EXPECT_LE(10, metrics.counters["watcher.notifier.events_queued"]);
+    EXPECT_LE(1, metrics.histograms["watcher.notifier.read_batch_bytes"].count);
+    EXPECT_NE(std::string::npos, task.getMetrics()->exportJSON().find("\"watcher.notifier.queue_depth\""));
+    for (auto cnt01 = 0; cnt01 < 10; cnt01++)
+    {
+        CFile::remove(watchFolder + "temp" + std::to_string(cnt01) + ".txt");
+    }
+}
+//
+// Task only processes a file rewritten by its producer once it has been quiet for the stability period.
+//
+TEST_F(UTCTask, StabilizeRewrittenFile)
+{
+    watchFolder = kWatchFolder;
+    watchDepth = -1;
+    auto options = std::make_shared<CTask::Options>();
+    options->stabilityPeriod = std::chrono::milliseconds(200);
+    CTask task{watchFolder, testTaskAction1, watchDepth, 2, options};
+    std::unique_ptr<std::thread> taskThread;
+    taskThread = std::make_unique<std::thread>(&CTask::monitor, &task);
+    createFile(watchFolder + "temp1.txt");
+    for (auto cnt01 = 0; cnt01 < 5; cnt01++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        std::ofstream fileToUpdate(watchFolder + "temp1.txt", std::ios::out | std::ios::app);
+        fileToUpdate << "MORE TEST TEXT" << std::endl;
+    }
+    EXPECT_EQ(0, testTaskAction1->fileCount);
+    createFile(watchFolder + "temp2.txt");
+    taskThread->join();
+    generateException(task.getThrownException());
+    EXPECT_EQ(2, testTaskAction1->fileCount);
+    CMetrics::Snapshot metrics{task.getMetrics()->snapshot()};
+    EXPECT_LE(5, metrics.counters["stability_restarts"]);
+    EXPECT_EQ(2, metrics.histograms["process_latency_us"].count);
+    EXPECT_LE(200000, metrics.histograms["process_latency_us"].p50);
+    CFile::remove(watchFolder + "temp1.txt");
+    CFile::remove(watchFolder + "temp2.txt");
+}
+//
+// Stabilizer passes on a file at the end of its quiet period; restarting it on a change
+// event and cancelling it on unlink.
+//
+TEST(UTCFileStabilizer, QuietPeriod)
+{
+    std::string stabilizeFolder{"/tmp/stabilize/"};
+    CFile::createDirectory(stabilizeFolder);
+    std::ofstream(stabilizeFolder + "temp1.txt") << "TEST TEXT" << std::endl;
+    std::ofstream(stabilizeFolder + "temp2.txt") << "TEST TEXT" << std::endl;
+    CFileStabilizer::Clock::time_point start{CFileStabilizer::Clock::now()};
+    CFileStabilizer stabilizer{std::chrono::milliseconds(100), true, start};
+    std::vector<IApprise::Event> stable;
+    EXPECT_FALSE(stabilizer.add(IApprise::Event(IApprise::Event_add, stabilizeFolder + "temp1.txt"), start));
+    EXPECT_FALSE(stabilizer.add(IApprise::Event(IApprise::Event_add, stabilizeFolder + "temp2.txt"), start));
+    EXPECT_FALSE(stabilizer.add(IApprise::Event(IApprise::Event_change, stabilizeFolder + "temp3.txt"), start));
+    EXPECT_EQ(2, stabilizer.size());
+    stabilizer.expire(stable, start + std::chrono::milliseconds(50));
+    EXPECT_TRUE(stable.empty());
+    EXPECT_TRUE(stabilizer.add(IApprise::Event(IApprise::Event_change, stabilizeFolder + "temp1.txt"), start + std::chrono::milliseconds(60)));
+    EXPECT_FALSE(stabilizer.add(IApprise::Event(IApprise::Event_unlink, stabilizeFolder + "temp2.txt"), start + std::chrono::milliseconds(60)));
+    stabilizer.expire(stable, start + std::chrono::milliseconds(120));
+    EXPECT_TRUE(stable.empty());
+    stabilizer.expire(stable, start + std::chrono::milliseconds(170));
+    ASSERT_EQ(1, stable.size());
+    EXPECT_EQ(IApprise::Event_add, stable[0].id);
+    EXPECT_EQ(stabilizeFolder + "temp1.txt", stable[0].message);
+    EXPECT_TRUE(stabilizer.empty());
+    CFile::remove(stabilizeFolder + "temp1.txt");
+    CFile::remove(stabilizeFolder + "temp2.txt");
+    CFile::remove(stabilizeFolder);
+}
+//
+// Stabilizer restarts the quiet period of a file whose size changed during it and
+// cascades files with long quiet periods down the time wheel.
+//
+TEST(UTCFileStabilizer, StatusChangeAndLongPeriod)
+{
+    std::string stabilizeFolder{"/tmp/stabilize/"};
+    CFile::createDirectory(stabilizeFolder);
+    std::ofstream(stabilizeFolder + "temp1.txt") << "TEST TEXT" << std::endl;
+    CFileStabilizer::Clock::time_point start{CFileStabilizer::Clock::now()};
+    CFileStabilizer stabilizer{std::chrono::minutes(10), true, start};
+    std::vector<IApprise::Event> stable;
+    IApprise::Event firstAdd{IApprise::Event_add, stabilizeFolder + "temp1.txt"};
+    stabilizer.add(firstAdd, start);
+    for (auto cnt01 = 1; cnt01 < 1000; cnt01++)
+    {
+        stabilizer.add(IApprise::Event(IApprise::Event_add, stabilizeFolder + "temp1.txt"), start + std::chrono::milliseconds(cnt01));
+    }
+    std::ofstream(stabilizeFolder + "temp1.txt", std::ios::app) << "MORE TEST TEXT" << std::endl;
+    EXPECT_EQ(0, stabilizer.expire(stable, start + std::chrono::minutes(5)));
+    EXPECT_TRUE(stable.empty());
+    EXPECT_EQ(1, stabilizer.expire(stable, start + std::chrono::minutes(11)));
+    EXPECT_TRUE(stable.empty());
+    EXPECT_EQ(0, stabilizer.expire(stable, start + std::chrono::minutes(20)));
+    EXPECT_TRUE(stable.empty());
+    EXPECT_EQ(0, stabilizer.expire(stable, start + std::chrono::minutes(22)));
+    ASSERT_EQ(1, stable.size());
+    EXPECT_EQ(firstAdd.time, stable[0].time);
+    EXPECT_TRUE(stabilizer.empty());
+    CFile::remove(stabilizeFolder + "temp1.txt");
+    CFile::remove(stabilizeFolder);
+}
+//
+// Action workers process files concurrently.
+//
+TEST_F(UTCTask, ActionWorkers)
+{
+    watchFolder = kWatchFolder;
+    watchDepth = -1;
+    auto testTaskAction3 = std::make_shared<TestAction3>("Test3");
+    auto options = std::make_shared<CTask::Options>();
+    options->actionWorkers = 4;
+    options->dispatchPolicy = std::make_shared<CFairDispatchPolicy>();
+    CTask task{watchFolder, testTaskAction3, watchDepth, 100, options};
+    std::unique_ptr<std::thread> taskThread;
+    taskThread = std::make_unique<std::thread>(&CTask::monitor, &task);
+    for (auto cnt01 = 0; cnt01 < 100; cnt01++)
+    {
+        createFile(watchFolder + "temp" + std::to_string(cnt01) + ".txt");
+    }
+    taskThread->join();
+    generateException(task.getThrownException());
+    EXPECT_EQ(100, testTaskAction3->fileCount);
+    EXPECT_EQ(100, task.getMetrics()->snapshot().counters["files_processed"]);
+    for (auto cnt01 = 0; cnt01 < 100; cnt01++)
+    {
+        CFile::remove(watchFolder + "temp" + std::to_string(cnt01) + ".txt");
+    }
+}
+//
+// Exception thrown by action in a worker is passed up chain.
+//
+TEST_F(UTCTask, ActionWorkerException)
+{
+    watchFolder = kWatchFolder;
+    watchDepth = -1;
+    auto options = std::make_shared<CTask::Options>();
+    options->actionWorkers = 2;
+    CTask task{watchFolder, testTaskAction2, watchDepth, 0, options};
+    std::unique_ptr<std::thread> taskThread;
+    taskThread = std::make_unique<std::thread>(&CTask::monitor, &task);
+    createFile(watchFolder + "temp1.txt");
+    taskThread->join();
+    EXPECT_THROW(generateException(task.getThrownException()), std::logic_error);
+    CFile::remove(watchFolder + "temp1.txt");
+}
+//
+// Batch action is passed full batches with the last cut short by the kill count.
+//
+TEST_F(UTCTask, BatchAction)
+{
+    watchFolder = kWatchFolder;
+    watchDepth = -1;
+    auto testBatchAction = std::make_shared<TestBatchAction>("TestBatch");
+    auto options = std::make_shared<CTask::Options>();
+    options->batchSize = 4;
+    options->batchDelay = std::chrono::seconds(10);
+    CTask task{watchFolder, testBatchAction, watchDepth, 10, options};
+    std::unique_ptr<std::thread> taskThread;
+    taskThread = std::make_unique<std::thread>(&CTask::monitor, &task);
+    for (auto cnt01 = 0; cnt01 < 10; cnt01++)
+    {
+        createFile(watchFolder + "temp" + std::to_string(cnt01) + ".txt");
+    }
+    taskThread->join();
+    generateException(task.getThrownException());
+    EXPECT_EQ(10, testBatchAction->fileCount);
+    EXPECT_EQ((std::vector<std::size_t>{4, 4, 2}), testBatchAction->batchSizes);
+    CMetrics::Snapshot metrics{task.getMetrics()->snapshot()};
+    EXPECT_EQ(10, metrics.counters["files_processed"]);
+    EXPECT_EQ(3, metrics.histograms["batch_size"].count);
+    for (auto cnt01 = 0; cnt01 < 10; cnt01++)
+    {
+        CFile::remove(watchFolder + "temp" + std::to_string(cnt01) + ".txt");
+    }
+}
+//
+// Batch that does not fill is processed once its first file has waited the batch delay.
+//
+TEST_F(UTCTask, BatchActionDelay)
+{
+    watchFolder = kWatchFolder;
+    watchDepth = -1;
+    auto testBatchAction = std::make_shared<TestBatchAction>("TestBatch");
+    auto options = std::make_shared<CTask::Options>();
+    options->batchSize = 100;
+    options->batchDelay = std::chrono::milliseconds(200);
+    CTask task{watchFolder, testBatchAction, watchDepth, 0, options};
+    std::unique_ptr<std::thread> taskThread;
+    taskThread = std::make_unique<std::thread>(&CTask::monitor, &task);
+    for (auto cnt01 = 0; cnt01 < 3; cnt01++)
+    {
+        createFile(watchFolder + "temp" + std::to_string(cnt01) + ".txt");
+    }
+    EXPECT_EQ(0, testBatchAction->fileCount);
+    for (auto cnt01 = 0; (cnt01 < 100) && (testBatchAction->fileCount != 3); cnt01++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    task.stop();
+    taskThread->join();
+    generateException(task.getThrownException());
+    EXPECT_EQ(3, testBatchAction->fileCount);
+    EXPECT_EQ((std::vector<std::size_t>{3}), testBatchAction->batchSizes);
+    EXPECT_LE(200000, task.getMetrics()->snapshot().histograms["process_latency_us"].p50);
+    for (auto cnt01 = 0; cnt01 < 3; cnt01++)
+    {
+        CFile::remove(watchFolder + "temp" + std::to_string(cnt01) + ".txt");
+    }
+}
+//
+// Action workers each fill their own batches from the dispatch queue.
+//
+TEST_F(UTCTask, BatchActionWorkers)
+{
+    watchFolder = kWatchFolder;
+    watchDepth = -1;
+    auto testBatchAction = std::make_shared<TestBatchAction>("TestBatch");
+    auto options = std::make_shared<CTask::Options>();
+    options->actionWorkers = 2;
+    options->batchSize = 10;
+    options->batchDelay = std::chrono::milliseconds(50);
+    CTask task{watchFolder, testBatchAction, watchDepth, 50, options};
+    std::unique_ptr<std::thread> taskThread;
+    taskThread = std::make_unique<std::thread>(&CTask::monitor, &task);
+    for (auto cnt01 = 0; cnt01 < 50; cnt01++)
+    {
+        createFile(watchFolder + "temp" + std::to_string(cnt01) + ".txt");
+    }
+    taskThread->join();
+    generateException(task.getThrownException());
+    EXPECT_EQ(50, testBatchAction->fileCount);
+    for (auto batchSize : testBatchAction->batchSizes)
+    {
+        EXPECT_GE(10, batchSize);
+    }
+    for (auto cnt01 = 0; cnt01 < 50; cnt01++)
+    {
+        CFile::remove(watchFolder + "temp" + std::to_string(cnt01) + ".txt");
+    }
+}
+//
+// Files are processed no faster than the action rate.
+//
+TEST_F(UTCTask, ActionRateLimit)
+{
+    watchFolder = kWatchFolder;
+    watchDepth = -1;
+    auto options = std::make_shared<CTask::Options>();
+    options->actionRate = 20.0;
+    CTask task{watchFolder, testTaskAction1, watchDepth, 10, options};
+    std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+    std::unique_ptr<std::thread> taskThread;
+    taskThread = std::make_unique<std::thread>(&CTask::monitor, &task);
+    for (auto cnt01 = 0; cnt01 < 10; cnt01++)
+    {
+        createFile(watchFolder + "temp" + std::to_string(cnt01) + ".txt");
+    }
+    taskThread->join();
+    generateException(task.getThrownException());
+    EXPECT_EQ(10, testTaskAction1->fileCount);
+    EXPECT_LE(std::chrono::milliseconds(400), std::chrono::steady_clock::now() - start);
+    for (auto cnt01 = 0; cnt01 < 10; cnt01++)
+    {
+        CFile::remove(watchFolder + "temp" + std::to_string(cnt01) + ".txt");
+    }
+}
+//
+// Bounded dispatch and watcher event queues hold up event generation behind a slow
+// action without losing files.
+//
+TEST_F(UTCTask, QueueBackpressure)
+{
+    watchFolder = kWatchFolder;
+    watchDepth = -1;
+    auto testSlowAction = std::make_shared<TestSlowAction>("TestSlow", std::chrono::milliseconds(10));
+    auto options = std::make_shared<CTask::Options>();
+    options->actionWorkers = 2;
+    options->maxQueuedFiles = 2;
+    options->maxQueuedEvents = 4;
+    CTask task{watchFolder, testSlowAction, watchDepth, 50, options};
+    std::unique_ptr<std::thread> taskThread;
+    taskThread = std::make_unique<std::thread>(&CTask::monitor, &task);
+    for (auto cnt01 = 0; cnt01 < 50; cnt01++)
+    {
+        createFile(watchFolder + "temp" + std::to_string(cnt01) + ".txt");
+    }
+    taskThread->join();
+    generateException(task.getThrownException());
+    EXPECT_EQ(50, testSlowAction->fileCount);
+    CMetrics::Snapshot metrics{task.getMetrics()->snapshot()};
+    EXPECT_LT(0, metrics.counters["watcher.notifier.backpressure_waits"]);
+    EXPECT_GE(4, metrics.gauges["watcher.notifier.queue_depth"].maximum);
+    EXPECT_GE(2, metrics.gauges["dispatch_queue_depth"].maximum);
+    for (auto cnt01 = 0; cnt01 < 50; cnt01++)
+    {
+        CFile::remove(watchFolder + "temp" + std::to_string(cnt01) + ".txt");
+    }
+}
+//
+// Failing action calls cut the adaptive concurrency limit down to one worker.
+//
+TEST_F(UTCTask, AdaptiveConcurrency)
+{
+    watchFolder = kWatchFolder;
+    watchDepth = -1;
+    auto testSlowAction = std::make_shared<TestSlowAction>("TestSlow", std::chrono::milliseconds(1), false);
+    auto options = std::make_shared<CTask::Options>();
+    options->actionWorkers = 4;
+    options->adaptiveConcurrency = true;
+    CTask task{watchFolder, testSlowAction, watchDepth, 20, options};
+    EXPECT_EQ(4, task.getMetrics()->snapshot().gauges["concurrency_limit"].value);
+    std::unique_ptr<std::thread> taskThread;
+    taskThread = std::make_unique<std::thread>(&CTask::monitor, &task);
+    for (auto cnt01 = 0; cnt01 < 20; cnt01++)
+    {
+        createFile(watchFolder + "temp" + std::to_string(cnt01) + ".txt");
+    }
+    taskThread->join();
+    generateException(task.getThrownException());
+    EXPECT_EQ(20, testSlowAction->fileCount);
+    CMetrics::Snapshot metrics{task.getMetrics()->snapshot()};
+    EXPECT_EQ(20, metrics.counters["action_failures"]);
+    EXPECT_EQ(1, metrics.gauges["concurrency_limit"].value);
+    for (auto cnt01 = 0; cnt01 < 20; cnt01++)
+    {
+        CFile::remove(watchFolder + "temp" + std::to_string(cnt01) + ".txt");
+    }
+}
+//
+// Token bucket lets a burst through and then spaces tokens at its rate; a batch
+// larger than the burst goes into debt. Closing releases a waiting acquire.
+//
+TEST(UTCTokenBucket, ReserveAndClose)
+{
+    CTokenBucket::Clock::time_point start{CTokenBucket::Clock::now()};
+    CTokenBucket tokenBucket{10.0, 2, start};
+    EXPECT_EQ(CTokenBucket::Clock::duration::zero(), tokenBucket.reserve(1, start));
+    EXPECT_EQ(CTokenBucket::Clock::duration::zero(), tokenBucket.reserve(1, start));
+    EXPECT_EQ(std::chrono::milliseconds(100), std::chrono::round<std::chrono::milliseconds>(tokenBucket.reserve(1, start)));
+    EXPECT_EQ(std::chrono::milliseconds(100), std::chrono::round<std::chrono::milliseconds>(tokenBucket.reserve(1, start + std::chrono::milliseconds(100))));
+    EXPECT_EQ(std::chrono::milliseconds(300), std::chrono::round<std::chrono::milliseconds>(tokenBucket.reserve(5, start + std::chrono::seconds(1))));
+    CTokenBucket slowBucket{0.001};
+    EXPECT_TRUE(slowBucket.acquire());
+    std::thread closer([&slowBucket]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        slowBucket.close();
+    });
+    EXPECT_FALSE(slowBucket.acquire());
+    closer.join();
+}
+//
+// Concurrency limit backs off on slow or failed calls (not below its minimum) and
+// creeps back up on calls near the baseline latency.
+//
+TEST(UTCConcurrencyLimiter, IncreaseAndBackoff)
+{
+    CConcurrencyLimiter limiter{1, 4};
+    EXPECT_EQ(4, limiter.limit());
+    for (auto cnt01 = 0; cnt01 < 10; cnt01++)
+    {
+        limiter.sample(std::chrono::milliseconds(1), false);
+    }
+    EXPECT_EQ(4, limiter.limit());
+    limiter.sample(std::chrono::milliseconds(50), false);
+    EXPECT_EQ(3, limiter.limit());
+    for (auto cnt01 = 0; cnt01 < 20; cnt01++)
+    {
+        limiter.sample(std::chrono::milliseconds(1), true);
+    }
+    EXPECT_EQ(1, limiter.limit());
+    for (auto cnt01 = 0; cnt01 < 5; cnt01++)
+    {
+        limiter.sample(std::chrono::microseconds(1500), false);
+    }
+    EXPECT_EQ(3, limiter.limit());
+    EXPECT_TRUE(limiter.acquire());
+    EXPECT_TRUE(limiter.acquire());
+    EXPECT_TRUE(limiter.acquire());
+    std::thread closer([&limiter]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        limiter.close();
+    });
+    EXPECT_FALSE(limiter.acquire());
+    closer.join();
+}
+//
+// Failed files (action returning false or throwing) are retried until processed
+// without the task stopping.
+//
+TEST_F(UTCTask, RetryFailedFiles)
+{
+    watchFolder = kWatchFolder;
+    watchDepth = -1;
+    auto testFlakyAction = std::make_shared<TestFlakyAction>("TestFlaky", 2);
+    auto options = std::make_shared<CTask::Options>();
+    options->maxAttempts = 3;
+    options->retryDelay = std::chrono::milliseconds(10);
+    CTask task{watchFolder, testFlakyAction, watchDepth, 5, options};
+    std::unique_ptr<std::thread> taskThread;
+    taskThread = std::make_unique<std::thread>(&CTask::monitor, &task);
+    for (auto cnt01 = 0; cnt01 < 5; cnt01++)
+    {
+        createFile(watchFolder + "temp" + std::to_string(cnt01) + ".txt");
+    }
+    taskThread->join();
+    generateException(task.getThrownException());
+    EXPECT_EQ(5, testFlakyAction->fileCount);
+    for (auto &attempts : testFlakyAction->attempts)
+    {
+        EXPECT_EQ(3, attempts.second);
+    }
+    CMetrics::Snapshot metrics{task.getMetrics()->snapshot()};
+    EXPECT_EQ(10, metrics.counters["action_retries"]);
+    EXPECT_EQ(0, metrics.counters["files_failed"]);
+    EXPECT_EQ(5, metrics.counters["files_processed"]);
+    for (auto cnt01 = 0; cnt01 < 5; cnt01++)
+    {
+        CFile::remove(watchFolder + "temp" + std::to_string(cnt01) + ".txt");
+    }
+}
+//
+// File failing every attempt is moved to the dead-letter folder while action workers
+// carry on processing the other files.
+//
+TEST_F(UTCTask, DeadLetterPoisonFile)
+{
+    watchFolder = kWatchFolder;
+    watchDepth = -1;
+    auto testFlakyAction = std::make_shared<TestFlakyAction>("TestFlaky", 0);
+    auto options = std::make_shared<CTask::Options>();
+    options->actionWorkers = 2;
+    options->maxAttempts = 2;
+    options->retryDelay = std::chrono::milliseconds(10);
+    options->deadLetterFolder = kDestinationFolder + "deadletter";
+    CTask task{watchFolder, testFlakyAction, watchDepth, 5, options};
+    std::unique_ptr<std::thread> taskThread;
+    taskThread = std::make_unique<std::thread>(&CTask::monitor, &task);
+    createFile(watchFolder + "poison.txt");
+    for (auto cnt01 = 0; cnt01 < 4; cnt01++)
+    {
+        createFile(watchFolder + "temp" + std::to_string(cnt01) + ".txt");
+    }
+    taskThread->join();
+    generateException(task.getThrownException());
+    EXPECT_EQ(4, testFlakyAction->fileCount);
+    EXPECT_EQ(2, testFlakyAction->attempts[watchFolder + "poison.txt"]);
+    EXPECT_FALSE(CFile::exists(watchFolder + "poison.txt"));
+    EXPECT_TRUE(CFile::exists(kDestinationFolder + "deadletter/poison.txt"));
+    CMetrics::Snapshot metrics{task.getMetrics()->snapshot()};
+    EXPECT_EQ(1, metrics.counters["files_failed"]);
+    EXPECT_EQ(1, metrics.counters["files_dead_lettered"]);
+    CFile::remove(kDestinationFolder + "deadletter/poison.txt");
+    CFile::remove(kDestinationFolder + "deadletter");
+    for (auto cnt01 = 0; cnt01 < 4; cnt01++)
+    {
+        CFile::remove(watchFolder + "temp" + std::to_string(cnt01) + ".txt");
+    }
+}
+//
+// Retry backoff doubles per attempt (up to its maximum) less up to half in jitter and
+// a file is not retried once out of attempts.
+//
+TEST(UTCRetryQueue, BackoffAndAttempts)
+{
+    CRetryQueue retryQueue{3, std::chrono::milliseconds(100), std::chrono::milliseconds(300)};
+    const std::vector<std::pair<int, int>> kBackoffRanges{{1, 100}, {2, 200}, {3, 300}, {10, 300}};
+    for (auto &backoffRange : kBackoffRanges)
+    {
+        for (auto cnt01 = 0; cnt01 < 20; cnt01++)
+        {
+            auto delay{retryQueue.backoff(backoffRange.first).count()};
+            EXPECT_LE(backoffRange.second / 2, delay);
+            EXPECT_GE(backoffRange.second, delay);
+        }
+    }
+    std::string filePath;
+    CRetryQueue::Clock::time_point now{CRetryQueue::Clock::now()};
+    EXPECT_TRUE(retryQueue.retry("/tmp/watch/temp.txt", now));
+    EXPECT_EQ(1, retryQueue.size());
+    EXPECT_FALSE(retryQueue.pop(filePath, now));
+    EXPECT_GE(std::chrono::milliseconds(100), retryQueue.tick(now));
+    ASSERT_TRUE(retryQueue.pop(filePath, now + std::chrono::milliseconds(100)));
+    EXPECT_EQ("/tmp/watch/temp.txt", filePath);
+    EXPECT_TRUE(retryQueue.retry("/tmp/watch/temp.txt", now));
+    EXPECT_FALSE(retryQueue.retry("/tmp/watch/temp.txt", now));
+    EXPECT_TRUE(retryQueue.retry("/tmp/watch/temp.txt", now));
+    retryQueue.completed("/tmp/watch/temp.txt");
+    EXPECT_TRUE(retryQueue.retry("/tmp/watch/temp.txt", now));
+    EXPECT_TRUE(retryQueue.retry("/tmp/watch/temp.txt", now));
+}
+//
+// Dispatch queue without a policy is first in first out and closes at its dispatch limit.
+//
+TEST(UTCDispatchQueue, FIFOAndLimit)
+{
+    CDispatchQueue dispatchQueue{nullptr, 3};
+    CDispatchQueue::QueuedFile queuedFile;
+    for (auto cnt01 = 0; cnt01 < 4; cnt01++)
+    {
+        dispatchQueue.push("/tmp/watch/temp" + std::to_string(cnt01) + ".txt", CDispatchQueue::Clock::now());
+    }
+    for (auto cnt01 = 0; cnt01 < 3; cnt01++)
+    {
+        ASSERT_TRUE(dispatchQueue.pop(queuedFile));
+        EXPECT_EQ("/tmp/watch/temp" + std::to_string(cnt01) + ".txt", queuedFile.filePath);
+    }
+    EXPECT_FALSE(dispatchQueue.pop(queuedFile));
+    EXPECT_EQ(1, dispatchQueue.size());
+}
+//
+// Pop with a deadline times out on an empty queue.
+//
+TEST(UTCDispatchQueue, PopDeadline)
+{
+    CDispatchQueue dispatchQueue;
+    CDispatchQueue::QueuedFile queuedFile;
+    CDispatchQueue::Clock::time_point start{CDispatchQueue::Clock::now()};
+    EXPECT_FALSE(dispatchQueue.pop(queuedFile, start + std::chrono::milliseconds(50)));
+    EXPECT_LE(start + std::chrono::milliseconds(50), CDispatchQueue::Clock::now());
+    dispatchQueue.push("/tmp/watch/temp0.txt", CDispatchQueue::Clock::now());
+    ASSERT_TRUE(dispatchQueue.pop(queuedFile, CDispatchQueue::Clock::now() + std::chrono::milliseconds(50)));
+    EXPECT_EQ("/tmp/watch/temp0.txt", queuedFile.filePath);
+    dispatchQueue.close();
+    EXPECT_FALSE(dispatchQueue.pop(queuedFile, CDispatchQueue::Clock::now() + std::chrono::milliseconds(50)));
+}
+//
+// Fair policy round-robins between directories (a directory first queued from part
+// way through joins the current round).
+//
+TEST(UTCDispatchQueue, FairPolicy)
+{
+    CDispatchQueue dispatchQueue{std::make_shared<CFairDispatchPolicy>()};
+    CDispatchQueue::QueuedFile queuedFile;
+    std::vector<std::string> dispatched;
+    for (auto cnt01 = 0; cnt01 < 5; cnt01++)
+    {
+        dispatchQueue.push("/tmp/watch/a/temp" + std::to_string(cnt01) + ".txt", CDispatchQueue::Clock::now());
+    }
+    ASSERT_TRUE(dispatchQueue.pop(queuedFile));
+    dispatched.push_back(queuedFile.filePath);
+    dispatchQueue.push("/tmp/watch/b/temp0.txt", CDispatchQueue::Clock::now());
+    dispatchQueue.push("/tmp/watch/b/temp1.txt", CDispatchQueue::Clock::now());
+    dispatchQueue.push("/tmp/watch/c/temp0.txt", CDispatchQueue::Clock::now());
+    while (dispatchQueue.size() != 0)
+    {
+        ASSERT_TRUE(dispatchQueue.pop(queuedFile));
+        dispatched.push_back(queuedFile.filePath);
+    }
+    std::vector<std::string> expected{"/tmp/watch/a/temp0.txt", "/tmp/watch/b/temp0.txt", "/tmp/watch/c/temp0.txt",
+                                      "/tmp/watch/a/temp1.txt", "/tmp/watch/b/temp1.txt", "/tmp/watch/a/temp2.txt",
+                                      "/tmp/watch/a/temp3.txt", "/tmp/watch/a/temp4.txt"};
+    EXPECT_EQ(expected, dispatched);
+}
+//
+// Priority policy orders by extension priority and deadline policy by deadline.
+//
+TEST(UTCDispatchQueue, PriorityAndDeadlinePolicies)
+{
+    CDispatchQueue::QueuedFile queuedFile;
+    CDispatchQueue priorityQueue{std::make_shared<CPriorityDispatchPolicy>(std::unordered_map<std::string, int>{{".csv", 0}, {".log", 1}}, 2)};
+    priorityQueue.push("/tmp/watch/a.txt", CDispatchQueue::Clock::now());
+    priorityQueue.push("/tmp/watch/b.log", CDispatchQueue::Clock::now());
+    priorityQueue.push("/tmp/watch/c.csv", CDispatchQueue::Clock::now());
+    priorityQueue.push("/tmp/watch/d.csv", CDispatchQueue::Clock::now());
+    for (auto &expected : {"/tmp/watch/c.csv", "/tmp/watch/d.csv", "/tmp/watch/b.log", "/tmp/watch/a.txt"})
+    {
+        ASSERT_TRUE(priorityQueue.pop(queuedFile));
+        EXPECT_EQ(expected, queuedFile.filePath);
+    }
+    CDispatchQueue::Clock::time_point now{CDispatchQueue::Clock::now()};
+    CDispatchQueue deadlineQueue{std::make_shared<CDeadlineDispatchPolicy>(std::chrono::milliseconds(1000),
+                                                                           std::unordered_map<std::string, std::chrono::milliseconds>{{".urgent", std::chrono::milliseconds(10)}})};
+    deadlineQueue.push("/tmp/watch/a.txt", now);
+    deadlineQueue.push("/tmp/watch/b.urgent", now + std::chrono::milliseconds(100));
+    deadlineQueue.push("/tmp/watch/c.urgent", now + std::chrono::milliseconds(2000));
+    for (auto &expected : {"/tmp/watch/b.urgent", "/tmp/watch/a.txt", "/tmp/watch/c.urgent"})
+    {
+        ASSERT_TRUE(deadlineQueue.pop(queuedFile));
+        EXPECT_EQ(expected, queuedFile.filePath);
+    }
+}
@@ -10,6 +10,7 @@
 // C20++              : Use of C20++ features.
 // Antik Classes      : CFTP, CFile, CPath
 // Boost              : String, iterators.
+// Threads            : Parallel transfers over more than one connection.
 //
 // =============
 // INCLUDE FILES
@@ -18,6 +19,20 @@
 // C++ STL
 //
 #include <iostream>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <set>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cstdio>
+//
+// Linux
+//
+#include <fcntl.h>
+#include <unistd.h>
 //
 // FTP utility definitions
 //
@@ -42,6 +57,17 @@ namespace Antik ::FTP
     // =======
     using namespace Antik::File;
     // ===============
+    // LOCAL CONSTANTS
+    // ===============
+    // Smallest segment of a segmented download
+    static const std::uint64_t kMinSegmentSize{1024 * 1024};
+    // Segments per connection of a segmented download
+    static const std::uint64_t kSegmentsPerConnection{4};
+    // Failed attempts (in a row without progress) before a download segment is given up on
+    static const int kMaxSegmentAttempts{3};
+    // Postfix of segmented download progress file
+    static const std::string kSegmentProgressPostfix{".segments"};
+    // ===============
     // LOCAL FUNCTIONS
     // ===============
     //
@@ -75,16 +101,224 @@ namespace Antik ::FTP
             return (constructRemotePathName("", remotePath, remoteFileName));
         }
     }
+    //
+    // Recursively list a remote directory using MLSD; the type fact of each entry saying
+    // whether it is a directory to descend into (no per entry probe needed).
+    //
+    static void listRemoteRecursiveMLSD(CFTP &ftpServer, const std::string &remoteDirectory, FileList &remoteFileList, FileFeedBackFn remoteFileFeedbackFn)
+    {
+        CFTP::FileInfoList serverFileInfoList;
+        if (ftpServer.listDirectory(remoteDirectory, serverFileInfoList) == 226)
+        {
+            for (auto &fileInfo : serverFileInfoList)
+            {
+                if ((fileInfo.type == "cdir") || (fileInfo.type == "pdir"))
+                {
+                    continue;
+                }
+                remoteFileList.push_back(constructRemotePathName(remoteDirectory, fileInfo.name));
+                if (remoteFileFeedbackFn)
+                {
+                    remoteFileFeedbackFn(remoteFileList.back());
+                }
+                if (fileInfo.isDirectory())
+                {
+                    listRemoteRecursiveMLSD(ftpServer, constructRemotePathName(remoteDirectory, fileInfo.name), remoteFileList, remoteFileFeedbackFn);
+                }
+            }
+        }
+    }
+    //
+    // Open another session to the server of a connected CFTP (same settings, transfer type
+    // and working directory). Returns nullptr (after reporting why) if it cannot be opened.
+    //
+    static std::unique_ptr<CFTP> openSession(CFTP &ftpServer, const std::string &workingDirectory)
+    {
+        try
+        {
+            auto session{std::make_unique<CFTP>()};
+            session->copySettings(ftpServer);
+            if (session->connect() == 230)
+            {
+                if (ftpServer.isBinaryTransfer())
+                {
+                    session->setBinaryTransfer(true);
+                }
+                session->changeWorkingDirectory(workingDirectory);
+                return (session);
+            }
+        }
+        catch (const CFTP::Exception &e)
+        {
+            std::cerr << e.what() << std::endl;
+        }
+        return (nullptr);
+    }
+    //
+    // Close a session opened by openSession() (any error is reported).
+    //
+    static void closeSession(CFTP &session)
+    {
+        try
+        {
+            if (session.isConnected())
+            {
+                session.disconnect();
+            }
+        }
+        catch (const CFTP::Exception &e)
+        {
+            std::cerr << e.what() << std::endl;
+        }
+    }
+    //
+    // Queue of files (indexes) a transfer worker is to transfer. Workers that run out of
+    // files of their own steal from the back of other workers queues.
+    //
+    struct TransferQueue
+    {
+        std::mutex queueMutex;
+        std::deque<std::size_t> files;
+    };
+    //
+    // Get next file for a transfer worker; from the front of its own queue or else stolen
+    // from the back of another's. Returns false when there are none left anywhere.
+    //
+    static bool nextTransfer(std::vector<TransferQueue> &transferQueues, std::size_t worker, std::size_t &fileNo)
+    {
+        for (std::size_t queueNo = 0; queueNo < transferQueues.size(); queueNo++)
+        {
+            TransferQueue &transferQueue{transferQueues[(worker + queueNo) % transferQueues.size()]};
+            std::unique_lock<std::mutex> locker(transferQueue.queueMutex);
+            if (!transferQueue.files.empty())
+            {
+                if (queueNo == 0)
+                {
+                    fileNo = transferQueue.files.front();
+                    transferQueue.files.pop_front();
+                }
+                else
+                {
+                    fileNo = transferQueue.files.back();
+                    transferQueue.files.pop_back();
+                }
+                return (true);
+            }
+        }
+        return (false);
+    }
+    //
+    // Transfer files over a number of connections to the server, the one passed in and
+    // others opened with the same settings (and working directory). Each connection has
+    // a worker thread which is given a contiguous run of the files to start with and which
+    // steals from other workers once its own run is done. If a worker hits an exception it
+    // is reported and all workers stop.
+    //
+    static void transferFiles(CFTP &ftpServer, std::size_t connections, const std::string &workingDirectory, const std::vector<std::size_t> &files, std::function<void(CFTP &, std::size_t)> transferFn)
+    {
+        std::vector<std::unique_ptr<CFTP>> sessions;
+        std::vector<CFTP *> workers{&ftpServer};
+        std::atomic<bool> stopTransfers{false};
+        // Open extra sessions (any that cannot be opened are not used)
+        for (std::size_t sessionNo = 1; (sessionNo < connections) && (sessionNo < files.size()); sessionNo++)
+        {
+            auto session{openSession(ftpServer, workingDirectory)};
+            if (session)
+            {
+                workers.push_back(session.get());
+                sessions.push_back(std::move(session));
+            }
+        }
+        // Give each worker a contiguous run of files
+        std::vector<TransferQueue> transferQueues(workers.size());
+        for (std::size_t transferNo = 0; transferNo < files.size(); transferNo++)
+        {
+            transferQueues[transferNo * workers.size() / files.size()].files.push_back(files[transferNo]);
+        }
+        // Run workers until all files transferred
+        std::vector<std::thread> workerThreads;
+        for (std::size_t worker = 0; worker < workers.size(); worker++)
+        {
+            workerThreads.emplace_back([&, worker]() {
+                try
+                {
+                    std::size_t fileNo;
+                    while (!stopTransfers.load() && nextTransfer(transferQueues, worker, fileNo))
+                    {
+                        transferFn(*workers[worker], fileNo);
+                    }
+                }
+                catch (const std::exception &e)
+                {
+                    std::cerr << e.what() << std::endl;
+                    stopTransfers = true;
+                }
+            });
+        }
+        for (auto &workerThread : workerThreads)
+        {
+            workerThread.join();
+        }
+        // Close extra sessions
+        for (auto &session : sessions)
+        {
+            closeSession(*session);
+        }
+    }
+    //
+    // Return a version of a remote file that changes if it is replaced; its modification
+    // time (MDTM) or failing that its CRC32 (XCRC) and "-" if neither is available.
+    //
+    static std::string remoteFileVersion(CFTP &ftpServer, const std::string &remoteFilePath)
+    {
+        CFTP::DateTime modifiedDateTime;
+        if (ftpServer.getModifiedDateTime(remoteFilePath, modifiedDateTime) == 213)
+        {
+            return ("MDTM:" + static_cast<std::string>(modifiedDateTime));
+        }
+        std::vector<CFTP::CommandReply> replies;
+        if (ftpServer.serverFeature("XCRC") && (ftpServer.pipelineCommands({"XCRC " + remoteFilePath}, replies) == 250))
+        {
+            std::string crc;
+            std::string replyField;
+            std::istringstream replyStream{replies.front().response};
+            while (replyStream >> replyField)
+            {
+                crc = replyField;
+            }
+            return ("XCRC:" + crc);
+        }
+        return ("-");
+    }
+    //
+    // Flatten per file success lists (in file list order).
+    //
+    static FileList successesInOrder(const std::vector<FileList> &successes)
+    {
+        FileList successList;
+        for (auto &fileSuccesses : successes)
+        {
+            successList.insert(successList.end(), fileSuccesses.begin(), fileSuccesses.end());
+        }
+        return (successList);
+    }
     // ================
     // PUBLIC FUNCTIONS
     // ================
     //
     // Recursively parse a remote server path passed in and pass back a list of directories/files found.
     // For servers that do not return a fully qualified path name create one. If a feedback function has
-    // been passed in then it is called for each file found.
+    // been passed in then it is called for each file found. If the server supports MLSD then its entry
+    // facts say which files are directories; otherwise which are is found with a single pipelined batch
+    // of commands per directory listed.
     //
     void listRemoteRecursive(CFTP &ftpServer, const std::string &remoteDirectory, FileList &remoteFileList, FileFeedBackFn remoteFileFeedbackFn)
     {
+        if (ftpServer.isMLSTSupported())
+        {
+            listRemoteRecursiveMLSD(ftpServer, remoteDirectory, remoteFileList, remoteFileFeedbackFn);
+            return;
+        }
         FileList serverFileList;
         std::string currentWorkingDirectory;
         // Save current working directory
@@ -92,17 +326,22 @@ namespace Antik ::FTP
         ftpServer.changeWorkingDirectory(remoteDirectory);
         if (ftpServer.listFiles("", serverFileList) == 226)
         {
-            for (auto file : serverFileList)
+            FileList fullFilePaths;
+            for (auto &file : serverFileList)
+            {
+                fullFilePaths.push_back(constructRemotePathName(remoteDirectory, file));
+            }
+            std::vector<bool> directories{ftpServer.isDirectory(fullFilePaths)};
+            for (std::size_t fileNo = 0; fileNo < fullFilePaths.size(); fileNo++)
             {
-                std::string fullFilePath{constructRemotePathName(remoteDirectory, file)};
-                remoteFileList.push_back(fullFilePath);
+                remoteFileList.push_back(fullFilePaths[fileNo]);
                 if (remoteFileFeedbackFn)
                 {
                     remoteFileFeedbackFn(remoteFileList.back());
                 }
-                if (ftpServer.isDirectory(fullFilePath))
+                if (directories[fileNo])
                 {
-                    listRemoteRecursive(ftpServer, fullFilePath, remoteFileList, remoteFileFeedbackFn);
+                    listRemoteRecursive(ftpServer, fullFilePaths[fileNo], remoteFileList, remoteFileFeedbackFn);
                 }
             }
         }
@@ -142,12 +381,13 @@ namespace Antik ::FTP
     }
     //
     // Download all files passed in file list from server to the local directory passed in; recreating any server directory
-    // structure in situ. If safe == true then the file is downloaded to a filename with a postfix then the file is renamed
+    // structure in situ (which files are directories is found up front with one pipelined batch of commands). If safe == true then the file is downloaded to a filename with a postfix then the file is renamed
     // to its correct value on success. Returns a list of successfully downloaded files and directories created in the local
     // directory. The local file name is calculated by removing the current working directory from each file in the list and
-    // appending it to the passed in local directory to get the full local file path.
+    // appending it to the passed in local directory to get the full local file path. If resume == true then any partial
+    // (eg. postfixed) file left by an earlier download that failed is resumed rather than downloaded again.
     //
-    FileList getFiles(CFTP &ftpServer, const std::string &localDirectory, const FileList &fileList, FileCompletionFn completionFn, bool safe, char postFix)
+    FileList getFiles(CFTP &ftpServer, const std::string &localDirectory, const FileList &fileList, FileCompletionFn completionFn, bool safe, char postFix, bool resume)
     {
         FileList successList;
         std::string currentWorkingDirectory;
@@ -155,8 +395,10 @@ namespace Antik ::FTP
         ftpServer.getCurrentWoringDirectory(currentWorkingDirectory);
         try
         {
-            for (auto file : fileList)
+            std::vector<bool> directories{ftpServer.isDirectory(fileList)};
+            for (std::size_t fileNo = 0; fileNo < fileList.size(); fileNo++)
             {
+                const std::string &file{fileList[fileNo]};
                 CPath destination{localDirectory};
                 destination.join(file.substr(currentWorkingDirectory.size()));
                 destination.normalize();
@@ -164,14 +406,14 @@ namespace Antik ::FTP
                 {
                     CFile::createDirectory(destination.parentPath());
                 }
-                if (!ftpServer.isDirectory(file))
+                if (!directories[fileNo])
                 {
                     std::string destinationFileName{destination.toString() + postFix};
                     if (!safe)
                     {
                         destinationFileName.pop_back();
                     }
-                    if (ftpServer.getFile(file, destinationFileName) == 226)
+                    if ((resume ? ftpServer.resumeGetFile(file, destinationFileName) : ftpServer.getFile(file, destinationFileName)) == 226)
                     {
                         if (safe)
                         {
@@ -216,9 +458,10 @@ namespace Antik ::FTP
     // any local directory structure in situ on the server. Returns a list of successfully
     // uploaded files and directories created.If safe == true then the file is uploaded to a
     // filename with a postfix then the file is renamed to its correct value on success.
-    // All files/directories are placed/created relative to the server current working directory.
+    // All files/directories are placed/created relative to the server current working directory. If resume == true then
+    // any partial remote file left by an earlier upload that failed is appended to rather than uploaded again.
     //
-    FileList putFiles(CFTP &ftpServer, const std::string &localDirectory, const FileList &fileList, FileCompletionFn completionFn, bool safe, char postFix)
+    FileList putFiles(CFTP &ftpServer, const std::string &localDirectory, const FileList &fileList, FileCompletionFn completionFn, bool safe, char postFix, bool resume)
     {
         FileList successList;
         size_t localPathLength{0};
@@ -280,7 +523,7 @@ namespace Antik ::FTP
                         {
                             destinationFileName.pop_back();
                         }
-                        if (ftpServer.putFile(destinationFileName, filePath.toString()) == 226)
+                        if ((resume ? ftpServer.resumePutFile(destinationFileName, filePath.toString()) : ftpServer.putFile(destinationFileName, filePath.toString())) == 226)
                         {
                             if (safe)
                             {
@@ -309,4 +552,410 @@ namespace Antik ::FTP
         }
         return (successList);
     }
+    //
+    // Download all files passed in file list from server to the local directory passed in, as getFiles()
+    // but with the files transferred in parallel over a number of connections to the server (the one passed
+    // in and others opened with its settings). Directories are created up front and the completion function
+    // is called (one call at a time) as each file finishes. The list of successfully downloaded files and
+    // directories created is returned in file list order.
+    //
+    FileList getFilesParallel(CFTP &ftpServer, std::size_t connections, const std::string &localDirectory, const FileList &fileList, FileCompletionFn completionFn, bool safe, char postFix, bool resume)
+    {
+        if (connections <= 1)
+        {
+            return (getFiles(ftpServer, localDirectory, fileList, completionFn, safe, postFix, resume));
+        }
+        std::vector<FileList> successes(fileList.size());
+        std::string currentWorkingDirectory;
+        // Save current working directory
+        ftpServer.getCurrentWoringDirectory(currentWorkingDirectory);
+        try
+        {
+            std::vector<bool> directories{ftpServer.isDirectory(fileList)};
+            std::vector<std::string> destinations(fileList.size());
+            std::vector<std::size_t> transfers;
+            std::mutex completionMutex;
+            // Create local directory structure and list files to transfer
+            for (std::size_t fileNo = 0; fileNo < fileList.size(); fileNo++)
+            {
+                CPath destination{localDirectory};
+                destination.join(fileList[fileNo].substr(currentWorkingDirectory.size()));
+                destination.normalize();
+                if (!CFile::exists(destination.parentPath()))
+                {
+                    CFile::createDirectory(destination.parentPath());
+                }
+                destinations[fileNo] = destination.toString();
+                if (!directories[fileNo])
+                {
+                    transfers.push_back(fileNo);
+                }
+                else
+                {
+                    if (!CFile::exists(destination))
+                    {
+                        CFile::createDirectory(destination);
+                    }
+                    successes[fileNo].push_back(destinations[fileNo]);
+                    if (completionFn)
+                    {
+                        completionFn(successes[fileNo].back());
+                    }
+                }
+            }
+            // Download files
+            transferFiles(ftpServer, connections, currentWorkingDirectory, transfers, [&](CFTP &session, std::size_t fileNo) {
+                std::string destinationFileName{destinations[fileNo] + postFix};
+                if (!safe)
+                {
+                    destinationFileName.pop_back();
+                }
+                if ((resume ? session.resumeGetFile(fileList[fileNo], destinationFileName) : session.getFile(fileList[fileNo], destinationFileName)) == 226)
+                {
+                    if (safe)
+                    {
+                        CFile::rename(destinationFileName, destinations[fileNo]);
+                    }
+                    std::unique_lock<std::mutex> locker(completionMutex);
+                    successes[fileNo].push_back(destinations[fileNo]);
+                    if (completionFn)
+                    {
+                        completionFn(successes[fileNo].back());
+                    }
+                }
+            });
+            // Restore saved current working directory
+            ftpServer.changeWorkingDirectory(currentWorkingDirectory);
+            // On exception report and return with files that where successfully downloaded.
+        }
+        catch (const CFTP::Exception &e)
+        {
+            std::cerr << e.what() << std::endl;
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << std::endl;
+        }
+        return (successesInOrder(successes));
+    }
+    //
+    // Take local directory, file list and upload all files to server, as putFiles() but with the files
+    // transferred in parallel over a number of connections to the server (the one passed in and others
+    // opened with its settings). Remote directories are created up front and the completion function is
+    // called (one call at a time) as each file finishes. The list of successfully uploaded files and
+    // directories created is returned in file list order.
+    //
+    FileList putFilesParallel(CFTP &ftpServer, std::size_t connections, const std::string &localDirectory, const FileList &fileList, FileCompletionFn completionFn, bool safe, char postFix, bool resume)
+    {
+        if (connections <= 1)
+        {
+            return (putFiles(ftpServer, localDirectory, fileList, completionFn, safe, postFix, resume));
+        }
+        std::vector<FileList> successes(fileList.size());
+        size_t localPathLength{0};
+        std::string currentWorkingDirectory;
+        // Determine local path length for creating remote paths.
+        localPathLength = localDirectory.size();
+        if (localDirectory.back() != kServerPathSep)
+            localPathLength++;
+        // Save current working directory
+        ftpServer.getCurrentWoringDirectory(currentWorkingDirectory);
+        try
+        {
+            std::vector<std::string> remoteDirectories(fileList.size());
+            std::set<std::string> checkedDirectories;
+            std::vector<std::size_t> transfers;
+            std::mutex completionMutex;
+            // Create remote directory structure and list files to transfer
+            for (std::size_t fileNo = 0; fileNo < fileList.size(); fileNo++)
+            {
+                CPath filePath{fileList[fileNo]};
+                if (CFile::exists(filePath))
+                {
+                    std::string remoteDirectory;
+                    bool transferFile{false};
+                    if (CFile::isDirectory(filePath))
+                    {
+                        remoteDirectory = filePath.toString();
+                    }
+                    else if (CFile::isFile(filePath))
+                    {
+                        remoteDirectory = filePath.parentPath().toString() + kServerPathSep;
+                        transferFile = true;
+                    }
+                    else
+                    {
+                        continue; // Not valid for transfer NEXT FILE!
+                    }
+                    remoteDirectory = remoteDirectory.substr(localPathLength);
+                    if (!remoteDirectory.empty() && (checkedDirectories.count(remoteDirectory) == 0))
+                    {
+                        ftpServer.changeWorkingDirectory(currentWorkingDirectory);
+                        if (!ftpServer.isDirectory(remoteDirectory))
+                        {
+                            makeRemotePath(ftpServer, remoteDirectory, false);
+                            successes[fileNo].push_back(constructRemotePathName(currentWorkingDirectory, remoteDirectory, ""));
+                            if (!transferFile && completionFn)
+                            {
+                                completionFn(successes[fileNo].back());
+                            }
+                        }
+                        checkedDirectories.insert(remoteDirectory);
+                    }
+                    if (transferFile)
+                    {
+                        remoteDirectories[fileNo] = remoteDirectory;
+                        transfers.push_back(fileNo);
+                    }
+                }
+            }
+            ftpServer.changeWorkingDirectory(currentWorkingDirectory);
+            // Upload files (paths relative to the working directory)
+            transferFiles(ftpServer, connections, currentWorkingDirectory, transfers, [&](CFTP &session, std::size_t fileNo) {
+                CPath filePath{fileList[fileNo]};
+                std::string destinationFileName{remoteDirectories[fileNo] + filePath.fileName() + postFix};
+                if (!safe)
+                {
+                    destinationFileName.pop_back();
+                }
+                if ((resume ? session.resumePutFile(destinationFileName, filePath.toString()) : session.putFile(destinationFileName, filePath.toString())) == 226)
+                {
+                    if (safe)
+                    {
+                        session.renameFile(destinationFileName, remoteDirectories[fileNo] + filePath.fileName());
+                    }
+                    std::unique_lock<std::mutex> locker(completionMutex);
+                    successes[fileNo].push_back(constructRemotePathName(currentWorkingDirectory, remoteDirectories[fileNo], filePath.fileName()));
+                    if (completionFn)
+                    {
+                        completionFn(successes[fileNo].back());
+                    }
+                }
+            });
+            // Restore saved current working directory
+            ftpServer.changeWorkingDirectory(currentWorkingDirectory);
+            // On exception report and return with files that where successfully uploaded.
+        }
+        catch (const CFTP::Exception &e)
+        {
+            std::cerr << e.what() << std::endl;
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << std::endl;
+        }
+        return (successesInOrder(successes));
+    }
+    //
+    // Download a single file from the server in segments (byte ranges) fetched in parallel over a number of
+    // connections (the one passed in and others opened with its settings) into a preallocated local file;
+    // each segment using REST/RETR and aborting the transfer at the segment end. Failed segments are retried
+    // (from where they got to, over a new connection) and progress is kept in a file alongside the local file
+    // so that a download that does not complete is resumed by the next call (unless the remote file has since
+    // been replaced; its modification time or CRC is kept with the progress). Falls back to a plain getFile()
+    // if the file is small, the transfer type is not binary or the server does not support REST STREAM.
+    // Returns 226 on success or 426 if some segments could not be downloaded.
+    //
+    std::uint16_t getFileSegmented(CFTP &ftpServer, std::size_t connections, const std::string &remoteFilePath, const std::string &localFilePath)
+    {
+        std::size_t fileSize{0};
+        if ((connections <= 1) || !ftpServer.isBinaryTransfer() || !ftpServer.serverFeature("REST STREAM") ||
+            (ftpServer.fileSize(remoteFilePath, fileSize) != 213) || (fileSize < 2 * kMinSegmentSize))
+        {
+            return (ftpServer.getFile(remoteFilePath, localFilePath));
+        }
+        // Resume any previous download or split file into segments
+        std::string progressFile{localFilePath + kSegmentProgressPostfix};
+        std::string fileVersion{remoteFileVersion(ftpServer, remoteFilePath)};
+        std::vector<FileSegment> segments;
+        bool resume{CFile::exists(localFilePath) && loadSegments(progressFile, fileSize, fileVersion, segments)};
+        if (!resume)
+        {
+            std::uint64_t segmentSize{std::max<std::uint64_t>(kMinSegmentSize, (fileSize + connections * kSegmentsPerConnection - 1) / (connections * kSegmentsPerConnection))};
+            for (std::uint64_t offset = 0; offset < fileSize; offset += segmentSize)
+            {
+                segments.push_back({offset, std::min<std::uint64_t>(segmentSize, fileSize - offset), 0, 0});
+            }
+        }
+        // Open and preallocate local file
+        int localFile = ::open(localFilePath.c_str(), O_WRONLY | O_CREAT, 0644);
+        if (localFile == -1)
+        {
+            throw std::runtime_error("Local file " + localFilePath + " could not be created: " + std::strerror(errno));
+        }
+        if (!resume)
+        {
+            if ((ftruncate(localFile, static_cast<off_t>(fileSize)) == -1))
+            {
+                ::close(localFile);
+                throw std::runtime_error("Local file " + localFilePath + " could not be allocated: " + std::strerror(errno));
+            }
+            posix_fallocate(localFile, 0, static_cast<off_t>(fileSize)); // Not all file systems support (file already sized)
+            saveSegments(progressFile, fileSize, fileVersion, segments);
+        }
+        // Queue segments still to download
+        std::deque<std::size_t> pendingSegments;
+        for (std::size_t segmentNo = 0; segmentNo < segments.size(); segmentNo++)
+        {
+            if (segments[segmentNo].transferred < segments[segmentNo].length)
+            {
+                pendingSegments.push_back(segmentNo);
+            }
+        }
+        std::mutex segmentMutex;
+        std::atomic<bool> stopDownload{false};
+        std::string currentWorkingDirectory;
+        ftpServer.getCurrentWoringDirectory(currentWorkingDirectory);
+        // Download segments; a worker per connection taking the next segment queued
+        auto segmentWorker = [&](CFTP *session, std::unique_ptr<CFTP> ownSession) {
+            for (;;)
+            {
+                std::size_t segmentNo;
+                {
+                    std::unique_lock<std::mutex> locker(segmentMutex);
+                    if (stopDownload.load() || pendingSegments.empty())
+                    {
+                        break;
+                    }
+                    segmentNo = pendingSegments.front();
+                    pendingSegments.pop_front();
+                }
+                FileSegment &segment{segments[segmentNo]};
+                std::uint64_t transferred{0};
+                bool sessionFailed{false};
+                try
+                {
+                    session->getFileSegment(remoteFilePath, localFile, segment.offset + segment.transferred, segment.length - segment.transferred, transferred);
+                }
+                catch (const CFTP::Exception &e)
+                {
+                    std::cerr << e.what() << std::endl;
+                    sessionFailed = true;
+                }
+                // Data written must reach disk before progress recording it is saved
+                if ((transferred != 0) && (fdatasync(localFile) == -1))
+                {
+                    std::cerr << "Local file " << localFilePath << " could not be synced: " << std::strerror(errno) << std::endl;
+                    transferred = 0;
+                }
+                {
+                    std::unique_lock<std::mutex> locker(segmentMutex);
+                    segment.transferred += transferred;
+                    if (segment.transferred < segment.length)
+                    {
+                        if (transferred != 0)
+                        {
+                            segment.attempts = 0; // Only give up on a segment that makes no progress
+                        }
+                        if (++segment.attempts < kMaxSegmentAttempts)
+                        {
+                            pendingSegments.push_back(segmentNo);
+                        }
+                        else
+                        {
+                            stopDownload = true;
+                        }
+                    }
+                    saveSegments(progressFile, fileSize, fileVersion, segments);
+                }
+                // Replace a failed session with a new one (the one passed in is not replaced)
+                if (sessionFailed)
+                {
+                    if (!ownSession)
+                    {
+                        break;
+                    }
+                    closeSession(*ownSession);
+                    ownSession = openSession(ftpServer, currentWorkingDirectory);
+                    if (!ownSession)
+                    {
+                        break;
+                    }
+                    session = ownSession.get();
+                }
+            }
+            if (ownSession)
+            {
+                closeSession(*ownSession);
+            }
+        };
+        std::vector<std::thread> workerThreads;
+        for (std::size_t sessionNo = 1; (sessionNo < connections) && (sessionNo < pendingSegments.size()); sessionNo++)
+        {
+            auto session{openSession(ftpServer, currentWorkingDirectory)};
+            if (session)
+            {
+                CFTP *sessionPtr{session.get()};
+                workerThreads.emplace_back(segmentWorker, sessionPtr, std::move(session));
+            }
+        }
+        segmentWorker(&ftpServer, nullptr);
+        for (auto &workerThread : workerThreads)
+        {
+            workerThread.join();
+        }
+        ::close(localFile);
+        // Remove progress file once all segments downloaded
+        for (auto &segment : segments)
+        {
+            if (segment.transferred < segment.length)
+            {
+                return (426);
+            }
+        }
+        CFile::remove(progressFile);
+        return (226);
+    }
+    //
+    // Save segmented download progress (file size and version then the offset, length and
+    // bytes written of each segment) so that an interrupted download can be resumed. It is
+    // written to a temporary file renamed over the last so a partial record is never loaded.
+    //
+    void saveSegments(const std::string &progressFile, std::uint64_t fileSize, const std::string &fileVersion, const std::vector<FileSegment> &segments)
+    {
+        std::string progressTempFile{progressFile + "~"};
+        bool written{false};
+        {
+            std::ofstream progressStream{progressTempFile, std::ofstream::trunc};
+            progressStream << fileSize << " " << fileVersion << "\n";
+            for (auto &segment : segments)
+            {
+                progressStream << segment.offset << " " << segment.length << " " << segment.transferred << "\n";
+            }
+            written = static_cast<bool>(progressStream.flush());
+        }
+        if (written)
+        {
+            std::rename(progressTempFile.c_str(), progressFile.c_str());
+        }
+        else
+        {
+            std::remove(progressTempFile.c_str());
+        }
+    }
+    //
+    // Load segmented download progress. Returns false if there is none or it is not for a
+    // file of the size and version passed in.
+    //
+    bool loadSegments(const std::string &progressFile, std::uint64_t fileSize, const std::string &fileVersion, std::vector<FileSegment> &segments)
+    {
+        std::ifstream progressStream{progressFile};
+        std::uint64_t savedFileSize{0};
+        std::string savedFileVersion;
+        FileSegment segment;
+        segments.clear();
+        if (!(progressStream >> savedFileSize >> savedFileVersion) || (savedFileSize != fileSize) || (savedFileVersion != fileVersion))
+        {
+            return (false);
+        }
+        while (progressStream >> segment.offset >> segment.length >> segment.transferred)
+        {
+            if ((segment.transferred > segment.length) || (segment.offset + segment.length > fileSize))
+            {
+                return (false);
+            }
+            segments.push_back(segment);
+        }
+        return (!segments.empty());
+    }
 } // namespace Antik::FTP